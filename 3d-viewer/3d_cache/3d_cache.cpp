@@ -23,11 +23,15 @@
 
 #define GLM_FORCE_RADIANS
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <fstream>
 #include <utility>
 #include <iterator>
+#include <mutex>
+#include <thread>
+#include <set>
 
 #include <wx/datetime.h>
 #include <wx/filename.h>
@@ -45,12 +49,14 @@
 #include "sg/scenegraph.h"
 #include "3d_filename_resolver.h"
 #include "3d_plugin_manager.h"
+#include "3d_render_cache.h"
 #include "plugins/3dapi/ifsg_api.h"
+#include "sync_queue.h"
 
 
 #define MASK_3D_CACHE "3D_CACHE"
 
-static wxCriticalSection lock3D_cache;
+static std::mutex lock3D_cacheFile;
 
 static bool isSHA1Same( const unsigned char* shaA, const unsigned char* shaB )
 {
@@ -61,14 +67,22 @@ static bool isSHA1Same( const unsigned char* shaA, const unsigned char* shaB )
     return true;
 }
 
-static bool checkTag( const char* aTag, void* aPluginMgrPtr )
+// passed to the cache file readers with checkTag(), which keeps the tag of the file
+struct CACHE_TAG_CHECK
 {
-    if( NULL == aTag || NULL == aPluginMgrPtr )
+    S3D_PLUGIN_MANAGER* plugins;
+    std::string         tag;
+};
+
+static bool checkTag( const char* aTag, void* aTagCheckPtr )
+{
+    if( NULL == aTag || NULL == aTagCheckPtr )
         return false;
 
-    S3D_PLUGIN_MANAGER *pp = (S3D_PLUGIN_MANAGER*) aPluginMgrPtr;
+    CACHE_TAG_CHECK* check = (CACHE_TAG_CHECK*) aTagCheckPtr;
+    check->tag = aTag;
 
-    return pp->CheckTag( aTag );
+    return check->plugins->CheckTag( aTag );
 }
 
 static const wxString sha1ToWXString( const unsigned char* aSHA1Sum )
@@ -126,6 +140,14 @@ public:
     std::string   pluginInfo;   // PluginName:Version string
     SCENEGRAPH*   sceneData;
     S3DMODEL*     renderData;
+
+    // true if renderData was read from a render cache file and sceneData
+    // was not loaded yet; it is loaded when a scene graph is requested
+    bool          sceneDeferred;
+
+    // held while the entry is loaded, reloaded or its render data is created;
+    // other threads requesting the same model wait on it
+    std::mutex    mutex;
 };
 
 
@@ -133,6 +155,7 @@ S3D_CACHE_ENTRY::S3D_CACHE_ENTRY()
 {
     sceneData = NULL;
     renderData = NULL;
+    sceneDeferred = false;
     memset( sha1sum, 0, 20 );
 }
 
@@ -200,7 +223,8 @@ S3D_CACHE::~S3D_CACHE()
 }
 
 
-SCENEGRAPH* S3D_CACHE::load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCachePtr )
+SCENEGRAPH* S3D_CACHE::load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCachePtr,
+                             bool aRenderOnly )
 {
     if( aCachePtr )
         *aCachePtr = NULL;
@@ -215,56 +239,7 @@ SCENEGRAPH* S3D_CACHE::load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCach
         return NULL;
     }
 
-    // check cache if file is already loaded
-    wxCriticalSectionLocker lock( lock3D_cache );
-    std::map< wxString, S3D_CACHE_ENTRY*, S3D::rsort_wxString >::iterator mi;
-    mi = m_CacheMap.find( full3Dpath );
-
-    if( mi != m_CacheMap.end() )
-    {
-        wxFileName fname( full3Dpath );
-
-        if( fname.FileExists() )    // Only check if file exists. If not, it will
-        {                           // use the same model in cache.
-            bool reload = false;
-            wxDateTime fmdate = fname.GetModificationTime();
-
-            if( fmdate != mi->second->modTime )
-            {
-                unsigned char hashSum[20];
-                getSHA1( full3Dpath, hashSum );
-                mi->second->modTime = fmdate;
-
-                if( !isSHA1Same( hashSum, mi->second->sha1sum ) )
-                {
-                    mi->second->SetSHA1( hashSum );
-                    reload = true;
-                }
-            }
-
-            if( reload )
-            {
-                if( NULL != mi->second->sceneData )
-                {
-                    S3D::DestroyNode( mi->second->sceneData );
-                    mi->second->sceneData = NULL;
-                }
-
-                if( NULL != mi->second->renderData )
-                    S3D::Destroy3DModel( &mi->second->renderData );
-
-                mi->second->sceneData = m_Plugins->Load3DModel( full3Dpath, mi->second->pluginInfo );
-            }
-        }
-
-        if( NULL != aCachePtr )
-            *aCachePtr = mi->second;
-
-        return mi->second->sceneData;
-    }
-
-    // a cache item does not exist; search the Filename->Cachename map
-    return checkCache( full3Dpath, aCachePtr );
+    return checkCache( full3Dpath, aCachePtr, true, aRenderOnly );
 }
 
 
@@ -274,89 +249,143 @@ SCENEGRAPH* S3D_CACHE::Load( const wxString& aModelFile )
 }
 
 
-SCENEGRAPH* S3D_CACHE::checkCache( const wxString& aFileName, S3D_CACHE_ENTRY** aCachePtr )
+SCENEGRAPH* S3D_CACHE::checkCache( const wxString& aFileName, S3D_CACHE_ENTRY** aCachePtr,
+                                   bool aCheckModified, bool aRenderOnly )
 {
     if( aCachePtr )
         *aCachePtr = NULL;
 
-    unsigned char sha1sum[20];
+    S3D_CACHE_ENTRY* ep = NULL;
+    bool isNewEntry = false;
+    std::unique_lock< std::mutex > entryLock;
 
-    if( !getSHA1( aFileName, sha1sum ) || m_CacheDir.empty() )
+    // The cache map is only locked to find or insert the entry; a new entry is
+    // locked before it is visible to other threads, so the requests of the same
+    // file wait for it to be loaded instead of loading it again
     {
-        // just in case we can't get a hash digest (for example, on access issues)
-        // or we do not have a configured cache file directory, we create an
-        // entry to prevent further attempts at loading the file
-        S3D_CACHE_ENTRY* ep = new S3D_CACHE_ENTRY;
-        m_CacheList.push_back( ep );
-        wxFileName fname( aFileName );
-        ep->modTime = fname.GetModificationTime();
-
-        if( m_CacheMap.insert( std::pair< wxString, S3D_CACHE_ENTRY* >
-            ( aFileName, ep ) ).second == false )
+        std::lock_guard< std::mutex > cacheLock( m_CacheMutex );
+
+        std::map< wxString, S3D_CACHE_ENTRY*, S3D::rsort_wxString >::iterator mi;
+        mi = m_CacheMap.find( aFileName );
+
+        if( mi != m_CacheMap.end() )
         {
-            #ifdef DEBUG
-            do {
-                std::ostringstream ostr;
-                ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
-                ostr << " * [BUG] duplicate entry in map file; key = '";
-                ostr << aFileName.ToUTF8() << "'";
-                wxLogTrace( MASK_3D_CACHE, "%s\n", ostr.str().c_str() );
-            } while( 0 );
-            #endif
-
-            m_CacheList.pop_back();
-            delete ep;
+            ep = mi->second;
         }
         else
         {
-            if( aCachePtr )
-                *aCachePtr = ep;
-
+            ep = new S3D_CACHE_ENTRY;
+            m_CacheList.push_back( ep );
+            m_CacheMap.insert( std::pair< wxString, S3D_CACHE_ENTRY* >( aFileName, ep ) );
+            entryLock = std::unique_lock< std::mutex >( ep->mutex );
+            isNewEntry = true;
         }
+    }
 
-        return NULL;
+    if( isNewEntry )
+        loadEntry( aFileName, ep, aRenderOnly );
+    else
+    {
+        entryLock = std::unique_lock< std::mutex >( ep->mutex );
+
+        if( aCheckModified )
+            reloadEntry( aFileName, ep );
+
+        if( !aRenderOnly && ep->sceneDeferred )
+            loadScene( aFileName, ep );
     }
 
-    S3D_CACHE_ENTRY* ep = new S3D_CACHE_ENTRY;
-    m_CacheList.push_back( ep );
+    if( aCachePtr )
+        *aCachePtr = ep;
+
+    return ep->sceneData;
+}
+
+
+void S3D_CACHE::loadEntry( const wxString& aFileName, S3D_CACHE_ENTRY* aCacheItem,
+                           bool aRenderOnly )
+{
     wxFileName fname( aFileName );
-    ep->modTime = fname.GetModificationTime();
+    aCacheItem->modTime = fname.GetModificationTime();
+
+    unsigned char sha1sum[20];
 
-    if( m_CacheMap.insert( std::pair< wxString, S3D_CACHE_ENTRY* >
-                               ( aFileName, ep ) ).second == false )
+    if( !getSHA1( aFileName, sha1sum ) || m_CacheDir.empty() )
     {
-        #ifdef DEBUG
-        do {
-            std::ostringstream ostr;
-            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
-            ostr << " * [BUG] duplicate entry in map file; key = '";
-            ostr << aFileName.ToUTF8() << "'";
-            wxLogTrace( MASK_3D_CACHE, "%s\n", ostr.str().c_str() );
-        } while( 0 );
-        #endif
+        // just in case we can't get a hash digest (for example, on access issues)
+        // or we do not have a configured cache file directory, the entry is
+        // kept empty to prevent further attempts at loading the file
+        return;
+    }
 
-        m_CacheList.pop_back();
-        delete ep;
-        return NULL;
+    aCacheItem->SetSHA1( sha1sum );
+
+    // the render data is enough for the renderers; reading it from its cache
+    // file avoids loading and converting the scene graph
+    if( aRenderOnly && loadRenderCacheData( aCacheItem ) )
+    {
+        aCacheItem->sceneDeferred = true;
+        return;
     }
 
-    if( aCachePtr )
-        *aCachePtr = ep;
+    loadScene( aFileName, aCacheItem );
+}
 
-    ep->SetSHA1( sha1sum );
 
-    wxString bname = ep->GetCacheBaseName();
+void S3D_CACHE::loadScene( const wxString& aFileName, S3D_CACHE_ENTRY* aCacheItem )
+{
+    aCacheItem->sceneDeferred = false;
+
+    wxString bname = aCacheItem->GetCacheBaseName();
     wxString cachename = m_CacheDir + bname + wxT( ".3dc" );
 
-    if( wxFileName::FileExists( cachename ) && loadCacheData( ep ) )
-        return ep->sceneData;
+    if( wxFileName::FileExists( cachename ) && loadCacheData( aCacheItem ) )
+        return;
 
-    ep->sceneData = m_Plugins->Load3DModel( aFileName, ep->pluginInfo );
+    aCacheItem->sceneData = m_Plugins->Load3DModel( aFileName, aCacheItem->pluginInfo );
 
-    if( NULL != ep->sceneData )
-        saveCacheData( ep );
+    if( NULL != aCacheItem->sceneData )
+        saveCacheData( aCacheItem );
+}
 
-    return ep->sceneData;
+
+void S3D_CACHE::reloadEntry( const wxString& aFileName, S3D_CACHE_ENTRY* aCacheItem )
+{
+    wxFileName fname( aFileName );
+
+    if( !fname.FileExists() )   // Only check if file exists. If not, it will
+        return;                 // use the same model in cache.
+
+    bool reload = false;
+    wxDateTime fmdate = fname.GetModificationTime();
+
+    if( fmdate != aCacheItem->modTime )
+    {
+        unsigned char hashSum[20];
+        getSHA1( aFileName, hashSum );
+        aCacheItem->modTime = fmdate;
+
+        if( !isSHA1Same( hashSum, aCacheItem->sha1sum ) )
+        {
+            aCacheItem->SetSHA1( hashSum );
+            reload = true;
+        }
+    }
+
+    if( reload )
+    {
+        if( NULL != aCacheItem->sceneData )
+        {
+            S3D::DestroyNode( aCacheItem->sceneData );
+            aCacheItem->sceneData = NULL;
+        }
+
+        if( NULL != aCacheItem->renderData )
+            S3D::Destroy3DModel( &aCacheItem->renderData );
+
+        aCacheItem->sceneDeferred = false;
+        aCacheItem->sceneData = m_Plugins->Load3DModel( aFileName, aCacheItem->pluginInfo );
+    }
 }
 
 
@@ -462,11 +491,15 @@ bool S3D_CACHE::loadCacheData( S3D_CACHE_ENTRY* aCacheItem )
     if( NULL != aCacheItem->sceneData )
         S3D::DestroyNode( (SGNODE*) aCacheItem->sceneData );
 
-    aCacheItem->sceneData = (SCENEGRAPH*)S3D::ReadCache( fname.ToUTF8(), m_Plugins, checkTag );
+    CACHE_TAG_CHECK check = { m_Plugins, std::string() };
+    aCacheItem->sceneData = (SCENEGRAPH*)S3D::ReadCache( fname.ToUTF8(), &check, checkTag );
 
     if( NULL == aCacheItem->sceneData )
         return false;
 
+    // the render cache file written from this scene carries the same tag
+    aCacheItem->pluginInfo = check.tag;
+
     return true;
 }
 
@@ -534,11 +567,70 @@ bool S3D_CACHE::saveCacheData( S3D_CACHE_ENTRY* aCacheItem )
         }
     }
 
+    // writing a cache file renames the nodes using a global counter, so the
+    // cache files are written one at a time
+    std::lock_guard< std::mutex > lock( lock3D_cacheFile );
+
     return S3D::WriteCache( fname.ToUTF8(), true, (SGNODE*)aCacheItem->sceneData,
         aCacheItem->pluginInfo.c_str() );
 }
 
 
+bool S3D_CACHE::loadRenderCacheData( S3D_CACHE_ENTRY* aCacheItem )
+{
+    wxString bname = aCacheItem->GetCacheBaseName();
+
+    if( bname.empty() || m_CacheDir.empty() )
+        return false;
+
+    wxString fname = m_CacheDir + bname + wxT( ".3dc2" );
+
+    if( !wxFileName::FileExists( fname ) )
+        return false;
+
+    if( NULL != aCacheItem->renderData )
+        S3D::Destroy3DModel( &aCacheItem->renderData );
+
+    CACHE_TAG_CHECK check = { m_Plugins, std::string() };
+    aCacheItem->renderData = S3D::ReadRenderCache( fname, &check, checkTag );
+
+    if( NULL == aCacheItem->renderData )
+    {
+        // the file is stale (older format, other plugin version): remove it so that
+        // saveRenderCacheData() writes it again
+        std::lock_guard< std::mutex > lock( lock3D_cacheFile );
+        wxRemoveFile( fname );
+
+        return false;
+    }
+
+    aCacheItem->pluginInfo = check.tag;
+
+    return true;
+}
+
+
+bool S3D_CACHE::saveRenderCacheData( S3D_CACHE_ENTRY* aCacheItem )
+{
+    wxString bname = aCacheItem->GetCacheBaseName();
+
+    if( NULL == aCacheItem->renderData || aCacheItem->pluginInfo.empty()
+        || bname.empty() || m_CacheDir.empty() )
+        return false;
+
+    wxString fname = m_CacheDir + bname + wxT( ".3dc2" );
+
+    // identical models found at different paths share the same cache file
+    std::lock_guard< std::mutex > lock( lock3D_cacheFile );
+
+    if( wxFileName::FileExists( fname ) )
+        return true;
+
+    return S3D::WriteRenderCache( fname, *aCacheItem->renderData,
+                                  aCacheItem->pluginInfo.c_str() );
+}
+
+
 bool S3D_CACHE::Set3DConfigDir( const wxString& aConfigDir )
 {
     if( !m_ConfigDir.empty() )
@@ -750,6 +842,8 @@ std::list< wxString > const* S3D_CACHE::GetFileFilters( void ) const
 
 void S3D_CACHE::FlushCache( bool closePlugins )
 {
+    std::lock_guard< std::mutex > cacheLock( m_CacheMutex );
+
     std::list< S3D_CACHE_ENTRY* >::iterator sCL = m_CacheList.begin();
     std::list< S3D_CACHE_ENTRY* >::iterator eCL = m_CacheList.end();
 
@@ -781,35 +875,72 @@ void S3D_CACHE::ClosePlugins( void )
 S3DMODEL* S3D_CACHE::GetModel( const wxString& aModelFileName )
 {
     S3D_CACHE_ENTRY* cp = NULL;
-    SCENEGRAPH* sp = load( aModelFileName, &cp );
-
-    if( !sp )
-        return NULL;
+    load( aModelFileName, &cp, true );
 
     if( !cp )
-    {
-        #ifdef DEBUG
-        do {
-            std::ostringstream ostr;
-            ostr << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
-            ostr << " * [BUG] model loaded with no associated S3D_CACHE_ENTRY";
-            wxLogTrace( MASK_3D_CACHE, "%s\n", ostr.str().c_str() );
-        } while( 0 );
-        #endif
-
         return NULL;
-    }
+
+    std::lock_guard< std::mutex > lock( cp->mutex );
 
     if( cp->renderData )
         return cp->renderData;
 
-    S3DMODEL* mp = S3D::GetModel( sp );
+    if( !cp->sceneData )
+        return NULL;
+
+    S3DMODEL* mp = S3D::GetModel( cp->sceneData );
     cp->renderData = mp;
 
+    if( NULL != mp )
+        saveRenderCacheData( cp );
+
     return mp;
 }
 
 
+void S3D_CACHE::PreloadModels( const std::vector< wxString >& aModelFileNames )
+{
+    SYNC_QUEUE< wxString > queue;
+    std::set< wxString > queued;
+
+    for( const wxString& name : aModelFileNames )
+    {
+        if( !name.empty() && queued.insert( name ).second )
+            queue.push( name );
+    }
+
+    size_t nThreads = std::min< size_t >( std::thread::hardware_concurrency(), queue.size() );
+
+    if( nThreads <= 1 )
+    {
+        wxString name;
+
+        while( queue.pop( name ) )
+            GetModel( name );
+
+        return;
+    }
+
+    // the locale is global to the process: set the "C" locale once for all
+    // the workers, the plugins do not switch it when it is already set
+    LOCALE_IO toggle;
+    std::vector< std::thread > threads;
+
+    for( size_t i = 0; i < nThreads; ++i )
+    {
+        threads.push_back( std::thread( [this, &queue]() {
+            wxString name;
+
+            while( queue.pop( name ) )
+                GetModel( name );
+        } ) );
+    }
+
+    for( auto& thr : threads )
+        thr.join();
+}
+
+
 wxString S3D_CACHE::GetModelHash( const wxString& aModelFileName )
 {
     wxString full3Dpath = m_FNResolver->ResolvePath( aModelFileName );
@@ -817,16 +948,9 @@ wxString S3D_CACHE::GetModelHash( const wxString& aModelFileName )
     if( full3Dpath.empty() || !wxFileName::FileExists( full3Dpath ) )
         return wxEmptyString;
 
-    // check cache if file is already loaded
-    std::map< wxString, S3D_CACHE_ENTRY*, S3D::rsort_wxString >::iterator mi;
-    mi = m_CacheMap.find( full3Dpath );
-
-    if( mi != m_CacheMap.end() )
-        return mi->second->GetCacheBaseName();
-
-    // a cache item does not exist; search the Filename->Cachename map
+    // find the cache entry, or create and load it
     S3D_CACHE_ENTRY* cp = NULL;
-    checkCache( full3Dpath, &cp );
+    checkCache( full3Dpath, &cp, false, true );
 
     if( NULL != cp )
         return cp->GetCacheBaseName();
@@ -31,6 +31,8 @@
 
 #include <list>
 #include <map>
+#include <mutex>
+#include <vector>
 #include <wx/string.h>
 #include "str_rsort.h"
 #include "3d_filename_resolver.h"
@@ -56,6 +58,10 @@ private:
     /// mapping of file names to cache names and data
     std::map< wxString, S3D_CACHE_ENTRY*, S3D::rsort_wxString > m_CacheMap;
 
+    /// protects m_CacheList and m_CacheMap; it is not held while a model is
+    /// hashed or loaded, each entry has its own lock for that
+    std::mutex m_CacheMutex;
+
     /// object to resolve file names
     S3D_FILENAME_RESOLVER* m_FNResolver;
 
@@ -78,14 +84,30 @@ private:
      *
      * Searches the cache list for the given filename and retrieves
      * the cache data; a cache entry is created if one does not
-     * already exist.
+     * already exist. It is safe to call it from several threads; the
+     * requests of a file being loaded by another thread wait for it.
      *
      * @param[in]   aFileName   file name (full or partial path)
      * @param[out]  aCachePtr   optional return address for cache entry pointer
+     * @param[in]   aCheckModified  reload an existing entry if its file changed
+     * @param[in]   aRenderOnly     only the render data is needed; the scene data
+     *                              is not loaded if the render cache file exists
      * @return      SCENEGRAPH object associated with file name
-     * @retval      NULL    on error
+     * @retval      NULL    on error or if the scene data was not loaded
      */
-    SCENEGRAPH* checkCache( const wxString& aFileName, S3D_CACHE_ENTRY** aCachePtr = NULL );
+    SCENEGRAPH* checkCache( const wxString& aFileName, S3D_CACHE_ENTRY** aCachePtr = NULL,
+                            bool aCheckModified = false, bool aRenderOnly = false );
+
+    // load the data of a new cache entry; with aRenderOnly the render data is
+    // read from its cache file if possible, otherwise the scene data is loaded
+    void loadEntry( const wxString& aFileName, S3D_CACHE_ENTRY* aCacheItem,
+                    bool aRenderOnly );
+
+    // load the scene data of a cache entry, from the cache file or the plugins
+    void loadScene( const wxString& aFileName, S3D_CACHE_ENTRY* aCacheItem );
+
+    // reload the scene data of a cache entry if its file was modified
+    void reloadEntry( const wxString& aFileName, S3D_CACHE_ENTRY* aCacheItem );
 
     /**
      * Function getSHA1
@@ -104,8 +126,15 @@ private:
     // save scene data to a cache file
     bool saveCacheData( S3D_CACHE_ENTRY* aCacheItem );
 
+    // load render data from a render cache file (.3dc2)
+    bool loadRenderCacheData( S3D_CACHE_ENTRY* aCacheItem );
+
+    // save render data to a render cache file (.3dc2)
+    bool saveRenderCacheData( S3D_CACHE_ENTRY* aCacheItem );
+
     // the real load function (can supply a cache entry pointer to member functions)
-    SCENEGRAPH* load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCachePtr = NULL );
+    SCENEGRAPH* load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCachePtr = NULL,
+                      bool aRenderOnly = false );
 
 public:
     S3D_CACHE();
@@ -194,13 +223,24 @@ public:
     /**
      * Function GetModel
      * attempts to load the scene data for a model and to translate it
-     * into an S3D_MODEL structure for display by a renderer
+     * into an S3D_MODEL structure for display by a renderer. The render
+     * data is read from the render cache file of the model when it exists,
+     * without loading the scene data.
      *
      * @param aModelFileName is the full path to the model to be loaded
      * @return is a pointer to the render data or NULL if not available
      */
     S3DMODEL* GetModel( const wxString& aModelFileName );
 
+    /**
+     * Function PreloadModels
+     * loads the given models and their render data using several threads,
+     * so the following calls to GetModel() find them in the cache.
+     *
+     * @param aModelFileNames   list of model file names, duplicates are allowed
+     */
+    void PreloadModels( const std::vector< wxString >& aModelFileNames );
+
     wxString GetModelHash( const wxString& aModelFileName );
 };
 
@@ -110,6 +110,7 @@ S3D_PLUGIN_MANAGER::~S3D_PLUGIN_MANAGER()
     }
 
     m_Plugins.clear();
+    m_PluginLocks.clear();
     return;
 }
 
@@ -222,6 +223,7 @@ void S3D_PLUGIN_MANAGER::loadPlugins( void )
             } while( 0 );
 #endif
             m_Plugins.push_back( pp );
+            m_PluginLocks[pp];
             int nf = pp->GetNFilters();
 
             #ifdef DEBUG
@@ -489,13 +491,26 @@ SCENEGRAPH* S3D_PLUGIN_MANAGER::Load3DModel( const wxString& aFileName, std::str
 
     while( sL != items.second )
     {
-        if( sL->second->CanRender() )
+        KICAD_PLUGIN_LDR_3D* plugin = sL->second;
+        // the map of locks is not modified after the plugins are loaded
+        std::mutex& pluginLock = m_PluginLocks.find( plugin )->second;
+        bool canRender;
+
+        {
+            std::lock_guard< std::mutex > lock( pluginLock );
+            canRender = plugin->CanRender();
+        }
+
+        // CanRender() has reopened the plugin if needed; the model itself is
+        // parsed without the lock so that several models load concurrently
+        if( canRender )
         {
-            SCENEGRAPH* sp = sL->second->Load( aFileName.ToUTF8() );
+            SCENEGRAPH* sp = plugin->Load( aFileName.ToUTF8() );
 
             if( NULL != sp )
             {
-                sL->second->GetPluginInfo( aPluginInfo );
+                std::lock_guard< std::mutex > lock( pluginLock );
+                plugin->GetPluginInfo( aPluginInfo );
                 return sp;
             }
         }
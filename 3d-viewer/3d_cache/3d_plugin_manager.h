@@ -31,6 +31,7 @@
 
 #include <map>
 #include <list>
+#include <mutex>
 #include <string>
 #include <wx/string.h>
 
@@ -51,6 +52,11 @@ private:
     /// list of file filters
     std::list< wxString > m_FileFilters;
 
+    /// one lock per plugin, guarding the loader state (reopening a closed
+    /// plugin, the last error); the plugins' Load() is reentrant and is
+    /// called without it
+    std::map< const KICAD_PLUGIN_LDR_3D*, std::mutex > m_PluginLocks;
+
     /// load plugins
     void loadPlugins( void );
 
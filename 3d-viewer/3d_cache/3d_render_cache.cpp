@@ -0,0 +1,369 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <wx/filefn.h>
+#include <wx/log.h>
+
+#include "3d_render_cache.h"
+#include "plugins/3dapi/ifsg_api.h"
+
+
+#define MASK_3D_CACHE "3D_CACHE"
+
+// Identifies the render cache files; the byte order and layout tags reject
+// the files written by a build with another memory layout
+static const char     RENDER_CACHE_MAGIC[8] = { 'K', 'i', 'C', 'a', 'd', '3', 'D', 'R' };
+static const uint32_t RENDER_CACHE_VERSION = 2;
+static const uint32_t RENDER_CACHE_BYTE_ORDER = 0x01020304;
+
+// The plugin tag is short (PluginName:Version); a longer one means a corrupt file
+static const uint32_t RENDER_CACHE_MAX_TAG = 1024;
+
+enum RENDER_CACHE_MESH_FLAGS
+{
+    MESH_HAS_NORMALS   = 1,
+    MESH_HAS_TEXCOORDS = 2,
+    MESH_HAS_COLORS    = 4
+};
+
+
+struct RENDER_CACHE_HEADER
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t vec3Size;          // sizeof( SFVEC3F )
+    uint32_t vec2Size;          // sizeof( SFVEC2F )
+    uint32_t materialSize;      // sizeof( SMATERIAL )
+    uint32_t materialsCount;
+    uint32_t meshesCount;
+    uint32_t pluginTagSize;     // length of the plugin tag following the header
+};
+
+
+struct RENDER_CACHE_MESH
+{
+    uint32_t vertexCount;
+    uint32_t faceIdxCount;
+    uint32_t materialIdx;
+    uint32_t flags;             // RENDER_CACHE_MESH_FLAGS
+};
+
+
+/**
+ * Reads the arrays of a render cache file loaded in memory, checking
+ * that they do not exceed the file size.
+ */
+class RENDER_CACHE_READER
+{
+public:
+    RENDER_CACHE_READER( const std::vector< char >& aData ) :
+        m_pos( aData.data() ), m_end( aData.data() + aData.size() )
+    {
+    }
+
+    bool Read( void* aDest, size_t aCount, size_t aItemSize )
+    {
+        if( aCount > (size_t)( m_end - m_pos ) / aItemSize )
+            return false;
+
+        size_t size = aCount * aItemSize;
+        memcpy( aDest, m_pos, size );
+        m_pos += size;
+
+        return true;
+    }
+
+    /// Allocate an array of aCount items and read it; NULL is returned on error
+    template <typename T> T* ReadArray( size_t aCount )
+    {
+        if( aCount > (size_t)( m_end - m_pos ) / sizeof( T ) )
+            return NULL;
+
+        T* array = new T[aCount];
+        Read( array, aCount, sizeof( T ) );
+
+        return array;
+    }
+
+    bool AtEnd() const { return m_pos == m_end; }
+
+private:
+    const char* m_pos;
+    const char* m_end;
+};
+
+
+static bool readModel( RENDER_CACHE_READER& aReader, S3DMODEL& aModel, void* aPluginMgr,
+                       bool (*aTagCheck)( const char*, void* ) )
+{
+    RENDER_CACHE_HEADER header;
+
+    if( !aReader.Read( &header, 1, sizeof( header ) ) )
+        return false;
+
+    if( memcmp( header.magic, RENDER_CACHE_MAGIC, sizeof( header.magic ) )
+        || header.version != RENDER_CACHE_VERSION
+        || header.byteOrder != RENDER_CACHE_BYTE_ORDER
+        || header.vec3Size != sizeof( SFVEC3F )
+        || header.vec2Size != sizeof( SFVEC2F )
+        || header.materialSize != sizeof( SMATERIAL )
+        || header.meshesCount == 0
+        || header.pluginTagSize == 0
+        || header.pluginTagSize > RENDER_CACHE_MAX_TAG )
+        return false;
+
+    // the model must have been loaded by the plugin (and version) which
+    // would load it now
+    std::string tag( header.pluginTagSize, '\0' );
+
+    if( !aReader.Read( &tag[0], tag.size(), 1 ) )
+        return false;
+
+    if( NULL != aTagCheck && NULL != aPluginMgr && !aTagCheck( tag.c_str(), aPluginMgr ) )
+        return false;
+
+    if( header.materialsCount )
+    {
+        aModel.m_Materials = aReader.ReadArray< SMATERIAL >( header.materialsCount );
+
+        if( NULL == aModel.m_Materials )
+            return false;
+
+        aModel.m_MaterialsSize = header.materialsCount;
+    }
+
+    std::vector< RENDER_CACHE_MESH > meshes( header.meshesCount );
+
+    if( !aReader.Read( meshes.data(), meshes.size(), sizeof( RENDER_CACHE_MESH ) ) )
+        return false;
+
+    aModel.m_Meshes = new SMESH[meshes.size()];
+    aModel.m_MeshesSize = meshes.size();
+
+    for( unsigned int i = 0; i < aModel.m_MeshesSize; ++i )
+        S3D::Init3DMesh( aModel.m_Meshes[i] );
+
+    for( unsigned int i = 0; i < aModel.m_MeshesSize; ++i )
+    {
+        const RENDER_CACHE_MESH& desc = meshes[i];
+        SMESH& mesh = aModel.m_Meshes[i];
+
+        if( desc.vertexCount == 0 || desc.faceIdxCount == 0
+            || desc.materialIdx >= aModel.m_MaterialsSize )
+            return false;
+
+        mesh.m_VertexSize = desc.vertexCount;
+        mesh.m_FaceIdxSize = desc.faceIdxCount;
+        mesh.m_MaterialIdx = desc.materialIdx;
+
+        mesh.m_Positions = aReader.ReadArray< SFVEC3F >( desc.vertexCount );
+
+        if( NULL == mesh.m_Positions )
+            return false;
+
+        if( desc.flags & MESH_HAS_NORMALS )
+        {
+            mesh.m_Normals = aReader.ReadArray< SFVEC3F >( desc.vertexCount );
+
+            if( NULL == mesh.m_Normals )
+                return false;
+        }
+
+        if( desc.flags & MESH_HAS_TEXCOORDS )
+        {
+            mesh.m_Texcoords = aReader.ReadArray< SFVEC2F >( desc.vertexCount );
+
+            if( NULL == mesh.m_Texcoords )
+                return false;
+        }
+
+        if( desc.flags & MESH_HAS_COLORS )
+        {
+            mesh.m_Color = aReader.ReadArray< SFVEC3F >( desc.vertexCount );
+
+            if( NULL == mesh.m_Color )
+                return false;
+        }
+
+        mesh.m_FaceIdx = aReader.ReadArray< unsigned int >( desc.faceIdxCount );
+
+        if( NULL == mesh.m_FaceIdx )
+            return false;
+
+        // the renderers use the indexes without checking them
+        for( unsigned int j = 0; j < mesh.m_FaceIdxSize; ++j )
+        {
+            if( mesh.m_FaceIdx[j] >= mesh.m_VertexSize )
+                return false;
+        }
+    }
+
+    return aReader.AtEnd();
+}
+
+
+S3DMODEL* S3D::ReadRenderCache( const wxString& aFileName, void* aPluginMgr,
+                                bool (*aTagCheck)( const char*, void* ) )
+{
+    #ifdef WIN32
+    FILE* fp = _wfopen( aFileName.wc_str(), L"rb" );
+    #else
+    FILE* fp = fopen( aFileName.ToUTF8(), "rb" );
+    #endif
+
+    if( NULL == fp )
+        return NULL;
+
+    // the whole file is read at once, it is then only a matter of
+    // copying the arrays
+    std::vector< char > data;
+    bool ok = false;
+
+    if( fseek( fp, 0, SEEK_END ) == 0 )
+    {
+        long size = ftell( fp );
+
+        if( size > 0 && fseek( fp, 0, SEEK_SET ) == 0 )
+        {
+            data.resize( size );
+            ok = fread( data.data(), 1, data.size(), fp ) == data.size();
+        }
+    }
+
+    fclose( fp );
+
+    if( !ok )
+        return NULL;
+
+    RENDER_CACHE_READER reader( data );
+    S3DMODEL* model = S3D::New3DModel();
+
+    if( !readModel( reader, *model, aPluginMgr, aTagCheck ) )
+    {
+        wxLogTrace( MASK_3D_CACHE, " * [3D model] invalid render cache file '%s'\n",
+                    aFileName.GetData() );
+
+        S3D::Destroy3DModel( &model );
+        return NULL;
+    }
+
+    return model;
+}
+
+
+bool S3D::WriteRenderCache( const wxString& aFileName, const S3DMODEL& aModel,
+                            const char* aPluginInfo )
+{
+    if( 0 == aModel.m_MeshesSize || NULL == aModel.m_Meshes )
+        return false;
+
+    // without the tag, the file could not be checked against the plugins
+    size_t tagSize = aPluginInfo ? strlen( aPluginInfo ) : 0;
+
+    if( 0 == tagSize || tagSize > RENDER_CACHE_MAX_TAG )
+        return false;
+
+    RENDER_CACHE_HEADER header;
+
+    memcpy( header.magic, RENDER_CACHE_MAGIC, sizeof( header.magic ) );
+    header.version = RENDER_CACHE_VERSION;
+    header.byteOrder = RENDER_CACHE_BYTE_ORDER;
+    header.vec3Size = sizeof( SFVEC3F );
+    header.vec2Size = sizeof( SFVEC2F );
+    header.materialSize = sizeof( SMATERIAL );
+    header.materialsCount = aModel.m_Materials ? aModel.m_MaterialsSize : 0;
+    header.meshesCount = aModel.m_MeshesSize;
+    header.pluginTagSize = tagSize;
+
+    std::vector< RENDER_CACHE_MESH > meshes( aModel.m_MeshesSize );
+
+    for( unsigned int i = 0; i < aModel.m_MeshesSize; ++i )
+    {
+        const SMESH& mesh = aModel.m_Meshes[i];
+
+        if( NULL == mesh.m_Positions || NULL == mesh.m_FaceIdx )
+            return false;
+
+        meshes[i].vertexCount = mesh.m_VertexSize;
+        meshes[i].faceIdxCount = mesh.m_FaceIdxSize;
+        meshes[i].materialIdx = mesh.m_MaterialIdx;
+        meshes[i].flags = ( mesh.m_Normals ? MESH_HAS_NORMALS : 0 )
+                          | ( mesh.m_Texcoords ? MESH_HAS_TEXCOORDS : 0 )
+                          | ( mesh.m_Color ? MESH_HAS_COLORS : 0 );
+    }
+
+    #ifdef WIN32
+    FILE* fp = _wfopen( aFileName.wc_str(), L"wb" );
+    #else
+    FILE* fp = fopen( aFileName.ToUTF8(), "wb" );
+    #endif
+
+    if( NULL == fp )
+        return false;
+
+    bool ok = fwrite( &header, sizeof( header ), 1, fp ) == 1
+              && fwrite( aPluginInfo, 1, tagSize, fp ) == tagSize;
+
+    if( ok && header.materialsCount )
+        ok = fwrite( aModel.m_Materials, sizeof( SMATERIAL ), header.materialsCount, fp )
+             == header.materialsCount;
+
+    ok = ok && fwrite( meshes.data(), sizeof( RENDER_CACHE_MESH ), meshes.size(), fp )
+               == meshes.size();
+
+    for( unsigned int i = 0; ok && i < aModel.m_MeshesSize; ++i )
+    {
+        const SMESH& mesh = aModel.m_Meshes[i];
+        size_t nv = mesh.m_VertexSize;
+
+        ok = fwrite( mesh.m_Positions, sizeof( SFVEC3F ), nv, fp ) == nv;
+
+        if( ok && mesh.m_Normals )
+            ok = fwrite( mesh.m_Normals, sizeof( SFVEC3F ), nv, fp ) == nv;
+
+        if( ok && mesh.m_Texcoords )
+            ok = fwrite( mesh.m_Texcoords, sizeof( SFVEC2F ), nv, fp ) == nv;
+
+        if( ok && mesh.m_Color )
+            ok = fwrite( mesh.m_Color, sizeof( SFVEC3F ), nv, fp ) == nv;
+
+        ok = ok && fwrite( mesh.m_FaceIdx, sizeof( unsigned int ), mesh.m_FaceIdxSize, fp )
+                   == mesh.m_FaceIdxSize;
+    }
+
+    if( fclose( fp ) != 0 )
+        ok = false;
+
+    // do not leave a truncated file; it would be rejected anyway
+    if( !ok )
+        wxRemoveFile( aFileName );
+
+    return ok;
+}
@@ -0,0 +1,72 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file 3d_render_cache.h
+ * reads and writes the render cache files (.3dc2) of 3D models.
+ *
+ * A render cache file stores the S3DMODEL built from the scene graph of a
+ * model, as flat arrays: a header, the tag of the plugin which loaded the
+ * model, the materials, the mesh descriptors, then the vertex and index
+ * arrays of each mesh. Loading a model from it does not
+ * need the plugins nor the scene graph.
+ */
+
+#ifndef RENDER_CACHE_3D_H
+#define RENDER_CACHE_3D_H
+
+#include <wx/string.h>
+#include "plugins/3dapi/c3dmodel.h"
+
+namespace S3D
+{
+    /**
+     * Function WriteRenderCache
+     * writes a model to a render cache file
+     *
+     * @param aFileName is the full path of the file to write
+     * @param aModel is the model to write
+     * @param aPluginInfo is the tag (PluginName:Version) of the plugin which
+     * loaded the model
+     * @return true on success
+     */
+    bool WriteRenderCache( const wxString& aFileName, const S3DMODEL& aModel,
+                           const char* aPluginInfo );
+
+    /**
+     * Function ReadRenderCache
+     * reads a model from a render cache file. The file is read at once and
+     * checked before the model is created.
+     *
+     * @param aFileName is the full path of the file to read
+     * @param aPluginMgr is passed to aTagCheck
+     * @param aTagCheck checks the plugin tag stored in the file, as for
+     * S3D::ReadCache(); the file is rejected if it returns false
+     * @return a new model, to be released with S3D::Destroy3DModel(), or NULL
+     * if the file cannot be read or is not a valid render cache file
+     */
+    S3DMODEL* ReadRenderCache( const wxString& aFileName, void* aPluginMgr,
+                               bool (*aTagCheck)( const char*, void* ) );
+};
+
+#endif  // RENDER_CACHE_3D_H
@@ -422,6 +422,16 @@ class CINFO3D_VISU
     void createLayers( REPORTER *aStatusTextReporter );
     void destroyLayers();
 
+    // Jobs of createLayers, run concurrently: each one fills only the
+    // containers and polygon sets of its layer, created by createLayers
+    void createCopperLayer( PCB_LAYER_ID aLayerId,
+                            const std::vector< const TRACK* >& aTrackList );
+    void createTechLayer( PCB_LAYER_ID aLayerId );
+
+    // Fills the through holes containers and polygon sets, shared by all layers
+    void createThroughHoles( const std::vector< const TRACK* >& aTrackList,
+                             PCB_LAYER_ID aFirstCopperLayer );
+
     // Helper functions to create the board
     COBJECT2D *createNewTrack( const TRACK* aTrack , int aClearanceValue ) const;
 
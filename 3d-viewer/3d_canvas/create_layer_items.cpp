@@ -56,14 +56,25 @@
 
 
 
+// Number of segments to draw a circle using segments (used on countour zones
+// and text copper elements )
+#define SEGCOUNT_CIRCLE         12
+
+// segments to draw a circle to build texts. Is is used only to build
+// the shape of each segment of the stroke font, therefore no need to have
+// many segments per circle.
+#define SEGCOUNT_STROKE_FONT    12
+
+
 // These variables are parameters used in addTextSegmToContainer.
 // But addTextSegmToContainer is a call-back function,
 // so we cannot send them as arguments.
-static int s_textWidth;
-static CGENERICCONTAINER2D *s_dstcontainer = NULL;
-static float s_biuTo3Dunits;
-static const CBBOX2D *s_boardBBox3DU = NULL;
-static const BOARD_ITEM *s_boardItem = NULL;
+// They are thread local because the layers are built by several threads.
+static thread_local int s_textWidth;
+static thread_local CGENERICCONTAINER2D *s_dstcontainer = NULL;
+static thread_local float s_biuTo3Dunits;
+static thread_local const CBBOX2D *s_boardBBox3DU = NULL;
+static thread_local const BOARD_ITEM *s_boardItem = NULL;
 
 // This is a call back function, used by DrawGraphicText to draw the 3D text shape:
 void addTextSegmToContainer( int x0, int y0, int xf, int yf )
@@ -1141,27 +1152,16 @@ void CINFO3D_VISU::destroyLayers()
 
 void CINFO3D_VISU::createLayers( REPORTER *aStatusTextReporter )
 {
-    // Number of segments to draw a circle using segments (used on countour zones
-    // and text copper elements )
-    const int    segcountforcircle = 12;
-    const double correctionFactor  = GetCircleCorrectionFactor( segcountforcircle );
-
-    // segments to draw a circle to build texts. Is is used only to build
-    // the shape of each segment of the stroke font, therefore no need to have
-    // many segments per circle.
-    const int segcountInStrokeFont  = 12;
-    const double correctionFactorStroke = GetCircleCorrectionFactor( segcountInStrokeFont );
-
     destroyLayers();
 
     // Build Copper layers
     // Based on: https://github.com/KiCad/kicad-source-mirror/blob/master/3d-viewer/3d_draw.cpp#L692
     // /////////////////////////////////////////////////////////////////////////
 
-    #ifdef PRINT_STATISTICS_3D_VIEWER
-    unsigned stats_startCopperLayersTime = GetRunningMicroSecs();
+#ifdef PRINT_STATISTICS_3D_VIEWER
+    unsigned stats_startLayersTime = GetRunningMicroSecs();
 
-    unsigned start_Time = stats_startCopperLayersTime;
+    unsigned start_Time = stats_startLayersTime;
 #endif
 
     PCB_LAYER_ID cu_seq[MAX_CU_LAYERS];
@@ -1243,477 +1243,405 @@ void CINFO3D_VISU::createLayers( REPORTER *aStatusTextReporter )
         }
     }
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T02: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
-
-    if( aStatusTextReporter )
-        aStatusTextReporter->Report( _( "Create tracks and vias" ) );
-
-    // Create tracks as objects and add it to container
-    // /////////////////////////////////////////////////////////////////////////
-    for( unsigned int lIdx = 0; lIdx < layer_id.size(); ++lIdx )
+    // The holes of the blind and buried vias are only created on the layers
+    // that have some
+    for( unsigned int trackIdx = 0; trackIdx < trackList.size(); ++trackIdx )
     {
-        const PCB_LAYER_ID curr_layer_id = layer_id[lIdx];
-
-        wxASSERT( m_layers_container2D.find( curr_layer_id ) != m_layers_container2D.end() );
+        const TRACK *track = trackList[trackIdx];
 
-        CBVHCONTAINER2D *layerContainer = m_layers_container2D[curr_layer_id];
-
-        // ADD TRACKS
-        unsigned int nTracks = trackList.size();
+        if( track->Type() != PCB_VIA_T ||
+            static_cast< const VIA*>( track )->GetViaType() == VIA_THROUGH )
+            continue;
 
-        for( unsigned int trackIdx = 0; trackIdx < nTracks; ++trackIdx )
+        for( unsigned int lIdx = 0; lIdx < layer_id.size(); ++lIdx )
         {
-            const TRACK *track = trackList[trackIdx];
+            const PCB_LAYER_ID curr_layer_id = layer_id[lIdx];
 
-            // NOTE: Vias can be on multiple layers
-            if( !track->IsOnLayer( curr_layer_id ) )
+            if( !track->IsOnLayer( curr_layer_id ) ||
+                m_layers_holes2D.find( curr_layer_id ) != m_layers_holes2D.end() )
                 continue;
 
-            // Add object item to layer container
-            layerContainer->Add( createNewTrack( track, 0.0f ) );
+            m_layers_holes2D[curr_layer_id] = new CBVHCONTAINER2D;
+            m_layers_outer_holes_poly[curr_layer_id] = new SHAPE_POLY_SET;
+            m_layers_inner_holes_poly[curr_layer_id] = new SHAPE_POLY_SET;
         }
     }
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T03: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time  ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
-
-    // Create VIAS and THTs objects and add it to holes containers
+    // Prepare tech layers index and containers
     // /////////////////////////////////////////////////////////////////////////
-    for( unsigned int lIdx = 0; lIdx < layer_id.size(); ++lIdx )
-    {
-        const PCB_LAYER_ID curr_layer_id = layer_id[lIdx];
-
-        // ADD TRACKS
-        unsigned int nTracks = trackList.size();
-
-        for( unsigned int trackIdx = 0; trackIdx < nTracks; ++trackIdx )
-        {
-            const TRACK *track = trackList[trackIdx];
 
-            if( !track->IsOnLayer( curr_layer_id ) )
-                continue;
+    // draw graphic items, on technical layers
+    static const PCB_LAYER_ID teckLayerList[] = {
+            B_Adhes,
+            F_Adhes,
+            B_Paste,
+            F_Paste,
+            B_SilkS,
+            F_SilkS,
+            B_Mask,
+            F_Mask,
 
-            // ADD VIAS and THT
-            if( track->Type() == PCB_VIA_T )
-            {
-                const VIA *via = static_cast< const VIA*>( track );
-                const VIATYPE_T viatype = via->GetViaType();
-                const float holediameter = via->GetDrillValue() * BiuTo3Dunits();
-                const float thickness = GetCopperThickness3DU();
-                const float hole_inner_radius = ( holediameter / 2.0f );
+            // Aux Layers
+            Dwgs_User,
+            Cmts_User,
+            Eco1_User,
+            Eco2_User,
+            Edge_Cuts,
+            Margin
+        };
 
-                const SFVEC2F via_center(  via->GetStart().x * m_biuTo3Dunits,
-                                          -via->GetStart().y * m_biuTo3Dunits );
+    std::vector< PCB_LAYER_ID > tech_layer_id;
 
-                if( viatype != VIA_THROUGH )
-                {
+    // User layers are not drawn here, only technical layers
+    for( LSEQ seq = LSET::AllNonCuMask().Seq( teckLayerList, DIM( teckLayerList ) );
+         seq;
+         ++seq )
+    {
+        const PCB_LAYER_ID curr_layer_id = *seq;
 
-                    // Add hole objects
-                    // /////////////////////////////////////////////////////////
+        if( !Is3DLayerEnabled( curr_layer_id ) )
+            continue;
 
-                    CBVHCONTAINER2D *layerHoleContainer = NULL;
+        tech_layer_id.push_back( curr_layer_id );
 
-                    // Check if the layer is already created
-                    if( m_layers_holes2D.find( curr_layer_id ) == m_layers_holes2D.end() )
-                    {
-                        // not found, create a new container
-                        layerHoleContainer = new CBVHCONTAINER2D;
-                        m_layers_holes2D[curr_layer_id] = layerHoleContainer;
-                    }
-                    else
-                    {
-                        // found
-                        layerHoleContainer = m_layers_holes2D[curr_layer_id];
-                    }
+        CBVHCONTAINER2D *layerContainer = new CBVHCONTAINER2D;
+        m_layers_container2D[curr_layer_id] = layerContainer;
 
-                    // Add a hole for this layer
-                    layerHoleContainer->Add( new CFILLEDCIRCLE2D( via_center,
-                                                                  hole_inner_radius + thickness,
-                                                                  *track ) );
-                }
-                else if( lIdx == 0 ) // it only adds once the THT holes
-                {
-                    // Add through hole object
-                    // /////////////////////////////////////////////////////////
-                    m_through_holes_outer.Add( new CFILLEDCIRCLE2D( via_center,
-                                                                    hole_inner_radius + thickness,
-                                                                    *track ) );
-
-                    m_through_holes_vias_outer.Add(
-                                new CFILLEDCIRCLE2D( via_center,
-                                                     hole_inner_radius + thickness,
-                                                     *track ) );
-
-                    m_through_holes_inner.Add( new CFILLEDCIRCLE2D( via_center,
-                                                                    hole_inner_radius,
-                                                                    *track ) );
-
-                    //m_through_holes_vias_inner.Add( new CFILLEDCIRCLE2D( via_center,
-                    //                                                     hole_inner_radius,
-                    //                                                     *track ) );
-                }
-            }
-        }
+        SHAPE_POLY_SET *layerPoly = new SHAPE_POLY_SET;
+        m_layers_poly[curr_layer_id] = layerPoly;
     }
 
 #ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T04: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time  ) / 1e3 );
+    printf( "T02: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time ) / 1e3 );
     start_Time = GetRunningMicroSecs();
 #endif
 
-    // Create VIAS and THTs objects and add it to holes containers
+    if( aStatusTextReporter )
+        aStatusTextReporter->Report( _( "Build copper and tech layers" ) );
+
+    // Every copper layer, every tech layer and the through holes shared by all
+    // the layers are built by independent jobs. All the containers and polygon
+    // sets were created above and each of them is filled by a single job, in the
+    // same order as a serial build, so the result does not depend on the
+    // scheduling of the jobs.
     // /////////////////////////////////////////////////////////////////////////
-    for( unsigned int lIdx = 0; lIdx < layer_id.size(); ++lIdx )
+    const PCB_LAYER_ID firstCopperLayer = layer_id.empty() ? UNDEFINED_LAYER : layer_id[0];
+    const signed int nCopperLayers = layer_id.size();
+    const signed int nTechLayers = tech_layer_id.size();
+    const signed int nJobs = nCopperLayers + nTechLayers + 1;
+
+    #pragma omp parallel for schedule(dynamic)
+    for( signed int job = 0; job < nJobs; ++job )
     {
-        const PCB_LAYER_ID curr_layer_id = layer_id[lIdx];
+        if( job < nCopperLayers )
+            createCopperLayer( layer_id[job], trackList );
+        else if( job < nCopperLayers + nTechLayers )
+            createTechLayer( tech_layer_id[job - nCopperLayers] );
+        else
+            createThroughHoles( trackList, firstCopperLayer );
+    }
 
-        // ADD TRACKS
-        const unsigned int nTracks = trackList.size();
+#ifdef PRINT_STATISTICS_3D_VIEWER
+    printf( "T03: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time ) / 1e3 );
 
-        for( unsigned int trackIdx = 0; trackIdx < nTracks; ++trackIdx )
-        {
-            const TRACK *track = trackList[trackIdx];
+    unsigned stats_endLayersTime = GetRunningMicroSecs();
+#endif
 
-            if( !track->IsOnLayer( curr_layer_id ) )
-                continue;
 
-            // ADD VIAS and THT
-            if( track->Type() == PCB_VIA_T )
-            {
-                const VIA *via = static_cast< const VIA*>( track );
-                const VIATYPE_T viatype = via->GetViaType();
+    // Build BVH for holes and vias
+    // /////////////////////////////////////////////////////////////////////////
 
-                if( viatype != VIA_THROUGH )
-                {
+#ifdef PRINT_STATISTICS_3D_VIEWER
+    unsigned stats_startHolesBVHTime = GetRunningMicroSecs();
+#endif
 
-                    // Add VIA hole contourns
-                    // /////////////////////////////////////////////////////////
+    m_through_holes_inner.BuildBVH();
+    m_through_holes_outer.BuildBVH();
 
-                    // Add outter holes of VIAs
-                    SHAPE_POLY_SET *layerOuterHolesPoly = NULL;
-                    SHAPE_POLY_SET *layerInnerHolesPoly = NULL;
+    if( !m_layers_holes2D.empty() )
+    {
+        for( MAP_CONTAINER_2D::iterator ii = m_layers_holes2D.begin();
+             ii != m_layers_holes2D.end();
+             ++ii )
+        {
+            ((CBVHCONTAINER2D *)(ii->second))->BuildBVH();
+        }
+    }
 
-                    // Check if the layer is already created
-                    if( m_layers_outer_holes_poly.find( curr_layer_id ) ==
-                        m_layers_outer_holes_poly.end() )
-                    {
-                        // not found, create a new container
-                        layerOuterHolesPoly = new SHAPE_POLY_SET;
-                        m_layers_outer_holes_poly[curr_layer_id] = layerOuterHolesPoly;
+    // We only need the Solder mask to initialize the BVH
+    // because..?
+    if( (CBVHCONTAINER2D *)m_layers_container2D[B_Mask] )
+        ((CBVHCONTAINER2D *)m_layers_container2D[B_Mask])->BuildBVH();
 
-                        wxASSERT( m_layers_inner_holes_poly.find( curr_layer_id ) ==
-                                  m_layers_inner_holes_poly.end() );
+    if( (CBVHCONTAINER2D *)m_layers_container2D[F_Mask] )
+        ((CBVHCONTAINER2D *)m_layers_container2D[F_Mask])->BuildBVH();
 
-                        layerInnerHolesPoly = new SHAPE_POLY_SET;
-                        m_layers_inner_holes_poly[curr_layer_id] = layerInnerHolesPoly;
-                    }
-                    else
-                    {
-                        // found
-                        layerOuterHolesPoly = m_layers_outer_holes_poly[curr_layer_id];
+#ifdef PRINT_STATISTICS_3D_VIEWER
+    unsigned stats_endHolesBVHTime = GetRunningMicroSecs();
 
-                        wxASSERT( m_layers_inner_holes_poly.find( curr_layer_id ) !=
-                                  m_layers_inner_holes_poly.end() );
+    printf( "CINFO3D_VISU::createLayers times\n" );
+    printf( "  Copper and Tech Layers: %.3f ms\n",
+            (float)( stats_endLayersTime        - stats_startLayersTime        ) / 1e3 );
+    printf( "  Holes BVH creation:     %.3f ms\n",
+            (float)( stats_endHolesBVHTime      - stats_startHolesBVHTime      ) / 1e3 );
+    printf( "Statistics:\n" );
+    printf( "  m_stats_nr_tracks                   %u\n", m_stats_nr_tracks );
+    printf( "  m_stats_nr_vias                     %u\n", m_stats_nr_vias );
+    printf( "  m_stats_nr_holes                    %u\n", m_stats_nr_holes );
+    printf( "  m_stats_via_med_hole_diameter (3DU) %f\n", m_stats_via_med_hole_diameter );
+    printf( "  m_stats_hole_med_diameter     (3DU) %f\n", m_stats_hole_med_diameter );
+    printf( "  m_calc_seg_min_factor3DU      (3DU) %f\n", m_calc_seg_min_factor3DU );
+    printf( "  m_calc_seg_max_factor3DU      (3DU) %f\n", m_calc_seg_max_factor3DU );
+#endif
+}
 
-                        layerInnerHolesPoly = m_layers_inner_holes_poly[curr_layer_id];
-                    }
 
-                    const int holediameter = via->GetDrillValue();
-                    const int hole_outer_radius = (holediameter / 2) + GetCopperThicknessBIU();
+void CINFO3D_VISU::createCopperLayer( PCB_LAYER_ID aLayerId,
+                                      const std::vector< const TRACK* >& aTrackList )
+{
+    const double correctionFactor = GetCircleCorrectionFactor( SEGCOUNT_CIRCLE );
 
-                    TransformCircleToPolygon( *layerOuterHolesPoly,
-                                              via->GetStart(),
-                                              hole_outer_radius,
-                                              GetNrSegmentsCircle( hole_outer_radius * 2 ) );
+    wxASSERT( m_layers_container2D.find( aLayerId ) != m_layers_container2D.end() );
 
-                    TransformCircleToPolygon( *layerInnerHolesPoly,
-                                              via->GetStart(),
-                                              holediameter / 2,
-                                              GetNrSegmentsCircle( holediameter ) );
-                }
-                else if( lIdx == 0 ) // it only adds once the THT holes
-                {
-                    const int holediameter = via->GetDrillValue();
-                    const int hole_outer_radius = (holediameter / 2)+ GetCopperThicknessBIU();
-
-                    // Add through hole contourns
-                    // /////////////////////////////////////////////////////////
-                    TransformCircleToPolygon( m_through_outer_holes_poly,
-                                              via->GetStart(),
-                                              hole_outer_radius,
-                                              GetNrSegmentsCircle( hole_outer_radius * 2 ) );
-
-                    TransformCircleToPolygon( m_through_inner_holes_poly,
-                                              via->GetStart(),
-                                              holediameter / 2,
-                                              GetNrSegmentsCircle( holediameter ) );
-
-                    // Add samething for vias only
-
-                    TransformCircleToPolygon( m_through_outer_holes_vias_poly,
-                                              via->GetStart(),
-                                              hole_outer_radius,
-                                              GetNrSegmentsCircle( hole_outer_radius * 2 ) );
-
-                    //TransformCircleToPolygon( m_through_inner_holes_vias_poly,
-                    //                          via->GetStart(),
-                    //                          holediameter / 2,
-                    //                          GetNrSegmentsCircle( holediameter ) );
-                }
-            }
-        }
-    }
+    CBVHCONTAINER2D *layerContainer = m_layers_container2D.find( aLayerId )->second;
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T05: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time  ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
+    // The layer polygon exists only if the copper thickness is rendered
+    SHAPE_POLY_SET *layerPoly = NULL;
 
-    // Creates outline contours of the tracks and add it to the poly of the layer
-    // /////////////////////////////////////////////////////////////////////////
     if( GetFlag( FL_RENDER_OPENGL_COPPER_THICKNESS ) &&
         (m_render_engine == RENDER_ENGINE_OPENGL_LEGACY) )
     {
-        for( unsigned int lIdx = 0; lIdx < layer_id.size(); ++lIdx )
-        {
-            const PCB_LAYER_ID curr_layer_id = layer_id[lIdx];
+        wxASSERT( m_layers_poly.find( aLayerId ) != m_layers_poly.end() );
 
-            wxASSERT( m_layers_poly.find( curr_layer_id ) != m_layers_poly.end() );
+        layerPoly = m_layers_poly.find( aLayerId )->second;
+    }
 
-            SHAPE_POLY_SET *layerPoly = m_layers_poly[curr_layer_id];
+    // The containers of the blind and buried vias holes, if the layer has some
+    CBVHCONTAINER2D *layerHoleContainer = NULL;
+    SHAPE_POLY_SET  *layerOuterHolesPoly = NULL;
+    SHAPE_POLY_SET  *layerInnerHolesPoly = NULL;
 
-            // ADD TRACKS
-            unsigned int nTracks = trackList.size();
+    if( m_layers_holes2D.find( aLayerId ) != m_layers_holes2D.end() )
+    {
+        layerHoleContainer = m_layers_holes2D.find( aLayerId )->second;
 
-            for( unsigned int trackIdx = 0; trackIdx < nTracks; ++trackIdx )
-            {
-                const TRACK *track = trackList[trackIdx];
+        wxASSERT( m_layers_outer_holes_poly.find( aLayerId ) !=
+                  m_layers_outer_holes_poly.end() );
+        wxASSERT( m_layers_inner_holes_poly.find( aLayerId ) !=
+                  m_layers_inner_holes_poly.end() );
 
-                if( !track->IsOnLayer( curr_layer_id ) )
-                    continue;
+        layerOuterHolesPoly = m_layers_outer_holes_poly.find( aLayerId )->second;
+        layerInnerHolesPoly = m_layers_inner_holes_poly.find( aLayerId )->second;
+    }
 
-                // Add the track contour
-                int nrSegments = GetNrSegmentsCircle( track->GetWidth() );
+    // Create tracks as objects and add it to container
+    // /////////////////////////////////////////////////////////////////////////
+    const unsigned int nTracks = aTrackList.size();
 
-                track->TransformShapeWithClearanceToPolygon(
-                            *layerPoly,
-                            0,
-                            nrSegments,
-                            GetCircleCorrectionFactor( nrSegments ) );
-            }
-        }
-    }
+    for( unsigned int trackIdx = 0; trackIdx < nTracks; ++trackIdx )
+    {
+        const TRACK *track = aTrackList[trackIdx];
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T06: %.3f ms\n", (float)( GetRunningMicroSecs()  - start_Time  ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
+        // NOTE: Vias can be on multiple layers
+        if( !track->IsOnLayer( aLayerId ) )
+            continue;
 
-    // Add holes of modules
+        // Add object item to layer container
+        layerContainer->Add( createNewTrack( track, 0.0f ) );
+    }
+
+    // Create blind and buried VIAS holes objects and contours
     // /////////////////////////////////////////////////////////////////////////
-    for( const MODULE* module = m_board->m_Modules; module; module = module->Next() )
+    for( unsigned int trackIdx = 0; trackIdx < nTracks; ++trackIdx )
     {
-        const D_PAD* pad = module->PadsList();
+        const TRACK *track = aTrackList[trackIdx];
 
-        for( ; pad; pad = pad->Next() )
-        {
-            const wxSize padHole = pad->GetDrillSize();
+        if( !track->IsOnLayer( aLayerId ) || track->Type() != PCB_VIA_T )
+            continue;
 
-            if( !padHole.x )    // Not drilled pad like SMD pad
-                continue;
+        const VIA *via = static_cast< const VIA*>( track );
 
-            // The hole in the body is inflated by copper thickness,
-            // if not plated, no copper
-            const int inflate = (pad->GetAttribute () != PAD_ATTRIB_HOLE_NOT_PLATED) ?
-                                GetCopperThicknessBIU() : 0;
+        if( via->GetViaType() == VIA_THROUGH )
+            continue;
 
-            m_stats_nr_holes++;
-            m_stats_hole_med_diameter += ( ( pad->GetDrillSize().x +
-                                             pad->GetDrillSize().y ) / 2.0f ) * m_biuTo3Dunits;
+        wxASSERT( layerHoleContainer != NULL );
 
-            m_through_holes_outer.Add( createNewPadDrill( pad, inflate ) );
-            m_through_holes_inner.Add( createNewPadDrill( pad,       0 ) );
-        }
-    }
-    if( m_stats_nr_holes )
-        m_stats_hole_med_diameter /= (float)m_stats_nr_holes;
+        const float holediameter = via->GetDrillValue() * BiuTo3Dunits();
+        const float thickness = GetCopperThickness3DU();
+        const float hole_inner_radius = ( holediameter / 2.0f );
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T07: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time  ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
+        const SFVEC2F via_center(  via->GetStart().x * m_biuTo3Dunits,
+                                  -via->GetStart().y * m_biuTo3Dunits );
 
-    // Add contours of the pad holes (pads can be Circle or Segment holes)
-    // /////////////////////////////////////////////////////////////////////////
-    for( const MODULE* module = m_board->m_Modules; module; module = module->Next() )
+        // Add a hole for this layer
+        layerHoleContainer->Add( new CFILLEDCIRCLE2D( via_center,
+                                                      hole_inner_radius + thickness,
+                                                      *track ) );
+    }
+
+    for( unsigned int trackIdx = 0; trackIdx < nTracks; ++trackIdx )
     {
-        const D_PAD* pad = module->PadsList();
+        const TRACK *track = aTrackList[trackIdx];
 
-        for( ; pad; pad = pad->Next() )
-        {
-            const wxSize padHole = pad->GetDrillSize();
+        if( !track->IsOnLayer( aLayerId ) || track->Type() != PCB_VIA_T )
+            continue;
 
-            if( !padHole.x ) // Not drilled pad like SMD pad
-                continue;
+        const VIA *via = static_cast< const VIA*>( track );
 
-            // The hole in the body is inflated by copper thickness.
-            const int inflate = GetCopperThicknessBIU();
+        if( via->GetViaType() == VIA_THROUGH )
+            continue;
 
-            // we use the hole diameter to calculate the seg count.
-            // for round holes, padHole.x == padHole.y
-            // for oblong holes, the diameter is the smaller of (padHole.x, padHole.y)
-            const int diam = std::min( padHole.x, padHole.y );
+        // Add VIA hole contourns
+        const int holediameter = via->GetDrillValue();
+        const int hole_outer_radius = (holediameter / 2) + GetCopperThicknessBIU();
 
+        TransformCircleToPolygon( *layerOuterHolesPoly,
+                                  via->GetStart(),
+                                  hole_outer_radius,
+                                  GetNrSegmentsCircle( hole_outer_radius * 2 ) );
 
-            if( pad->GetAttribute () != PAD_ATTRIB_HOLE_NOT_PLATED )
-            {
-                pad->BuildPadDrillShapePolygon( m_through_outer_holes_poly,
-                                                inflate,
-                                                GetNrSegmentsCircle( diam ) );
+        TransformCircleToPolygon( *layerInnerHolesPoly,
+                                  via->GetStart(),
+                                  holediameter / 2,
+                                  GetNrSegmentsCircle( holediameter ) );
+    }
 
-                pad->BuildPadDrillShapePolygon( m_through_inner_holes_poly,
-                                                0,
-                                                GetNrSegmentsCircle( diam ) );
-            }
-            else
-            {
-                // If not plated, no copper.
-                pad->BuildPadDrillShapePolygon( m_through_outer_holes_poly_NPTH,
-                                                inflate,
-                                                GetNrSegmentsCircle( diam ) );
-            }
+    // Creates outline contours of the tracks and add it to the poly of the layer
+    // /////////////////////////////////////////////////////////////////////////
+    if( layerPoly )
+    {
+        for( unsigned int trackIdx = 0; trackIdx < nTracks; ++trackIdx )
+        {
+            const TRACK *track = aTrackList[trackIdx];
+
+            if( !track->IsOnLayer( aLayerId ) )
+                continue;
+
+            // Add the track contour
+            int nrSegments = GetNrSegmentsCircle( track->GetWidth() );
+
+            track->TransformShapeWithClearanceToPolygon(
+                        *layerPoly,
+                        0,
+                        nrSegments,
+                        GetCircleCorrectionFactor( nrSegments ) );
         }
     }
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T08: %.3f ms\n", (float)( GetRunningMicroSecs()  - start_Time  ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
-
     // Add modules PADs objects to containers
     // /////////////////////////////////////////////////////////////////////////
-    for( unsigned int lIdx = 0; lIdx < layer_id.size(); ++lIdx )
+    for( const MODULE* module = m_board->m_Modules; module; module = module->Next() )
     {
-        const PCB_LAYER_ID curr_layer_id = layer_id[lIdx];
-
-        wxASSERT( m_layers_container2D.find( curr_layer_id ) != m_layers_container2D.end() );
-
-        CBVHCONTAINER2D *layerContainer = m_layers_container2D[curr_layer_id];
+        // Note: NPTH pads are not drawn on copper layers when the pad
+        // has same shape as its hole
+        AddPadsShapesWithClearanceToContainer( module,
+                                               layerContainer,
+                                               aLayerId,
+                                               0,
+                                               true );
+
+        // Micro-wave modules may have items on copper layers
+        AddGraphicsShapesWithClearanceToContainer( module,
+                                                   layerContainer,
+                                                   aLayerId,
+                                                   0 );
+    }
 
-        // ADD PADS
+    // Add modules PADs poly contourns
+    // /////////////////////////////////////////////////////////////////////////
+    if( layerPoly )
+    {
         for( const MODULE* module = m_board->m_Modules; module; module = module->Next() )
         {
             // Note: NPTH pads are not drawn on copper layers when the pad
             // has same shape as its hole
-            AddPadsShapesWithClearanceToContainer( module,
-                                                   layerContainer,
-                                                   curr_layer_id,
-                                                   0,
-                                                   true );
+            transformPadsShapesWithClearanceToPolygon( module->PadsList(),
+                                                       aLayerId,
+                                                       *layerPoly,
+                                                       0,
+                                                       true );
 
             // Micro-wave modules may have items on copper layers
-            AddGraphicsShapesWithClearanceToContainer( module,
-                                                       layerContainer,
-                                                       curr_layer_id,
-                                                       0 );
+            module->TransformGraphicTextWithClearanceToPolygonSet( aLayerId,
+                                                                    *layerPoly,
+                                                                    0,
+                                                                    SEGCOUNT_CIRCLE,
+                                                                    correctionFactor );
+
+            transformGraphicModuleEdgeToPolygonSet( module, aLayerId, *layerPoly );
         }
     }
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T09: %.3f ms\n", (float)( GetRunningMicroSecs()  - start_Time  ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
-
-    // Add modules PADs poly contourns
+    // Add graphic item on copper layers to object containers
     // /////////////////////////////////////////////////////////////////////////
-    if( GetFlag( FL_RENDER_OPENGL_COPPER_THICKNESS ) &&
-        (m_render_engine == RENDER_ENGINE_OPENGL_LEGACY) )
+    for( auto item : m_board->Drawings() )
     {
-        for( unsigned int lIdx = 0; lIdx < layer_id.size(); ++lIdx )
+        if( !item->IsOnLayer( aLayerId ) )
+            continue;
+
+        switch( item->Type() )
         {
-            const PCB_LAYER_ID curr_layer_id = layer_id[lIdx];
+        case PCB_LINE_T:  // should not exist on copper layers
+        {
+            AddShapeWithClearanceToContainer( (DRAWSEGMENT*)item,
+                                              layerContainer,
+                                              aLayerId,
+                                              0 );
+        }
+        break;
 
-            wxASSERT( m_layers_poly.find( curr_layer_id ) != m_layers_poly.end() );
+        case PCB_TEXT_T:
+            AddShapeWithClearanceToContainer( (TEXTE_PCB*) item,
+                                              layerContainer,
+                                              aLayerId,
+                                              0 );
+        break;
 
-            SHAPE_POLY_SET *layerPoly = m_layers_poly[curr_layer_id];
+        case PCB_DIMENSION_T:
+            AddShapeWithClearanceToContainer( (DIMENSION*) item,
+                                              layerContainer,
+                                              aLayerId,
+                                              0 );
+        break;
 
-            // ADD PADS
-            for( const MODULE* module = m_board->m_Modules;
-                 module;
-                 module = module->Next() )
-            {
-                // Construct polys
-                // /////////////////////////////////////////////////////////////
-
-                // Note: NPTH pads are not drawn on copper layers when the pad
-                // has same shape as its hole
-                transformPadsShapesWithClearanceToPolygon( module->PadsList(),
-                                                           curr_layer_id,
-                                                           *layerPoly,
-                                                           0,
-                                                           true );
-
-                // Micro-wave modules may have items on copper layers
-                module->TransformGraphicTextWithClearanceToPolygonSet( curr_layer_id,
-                                                                        *layerPoly,
-                                                                        0,
-                                                                        segcountforcircle,
-                                                                        correctionFactor );
-
-                transformGraphicModuleEdgeToPolygonSet( module, curr_layer_id, *layerPoly );
-            }
+        default:
+            wxLogTrace( m_logTrace,
+                        wxT( "createLayers: item type: %d not implemented" ),
+                        item->Type() );
+        break;
         }
     }
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T10: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time  ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
-
-    // Add graphic item on copper layers to object containers
+    // Add graphic item on copper layers to poly contourns
     // /////////////////////////////////////////////////////////////////////////
-    for( unsigned int lIdx = 0; lIdx < layer_id.size(); ++lIdx )
+    if( layerPoly )
     {
-        const PCB_LAYER_ID curr_layer_id = layer_id[lIdx];
-
-        wxASSERT( m_layers_container2D.find( curr_layer_id ) != m_layers_container2D.end() );
-
-        CBVHCONTAINER2D *layerContainer = m_layers_container2D[curr_layer_id];
-
-        // ADD GRAPHIC ITEMS ON COPPER LAYERS (texts)
         for( auto item : m_board->Drawings() )
         {
-            if( !item->IsOnLayer( curr_layer_id ) )
+            if( !item->IsOnLayer( aLayerId ) )
                 continue;
 
             switch( item->Type() )
             {
-            case PCB_LINE_T:  // should not exist on copper layers
+            case PCB_LINE_T: // should not exist on copper layers
             {
-                AddShapeWithClearanceToContainer( (DRAWSEGMENT*)item,
-                                                  layerContainer,
-                                                  curr_layer_id,
-                                                  0 );
+                const int nrSegments =
+                        GetNrSegmentsCircle( item->GetBoundingBox().GetSizeMax() );
+
+                ( (DRAWSEGMENT*) item )->TransformShapeWithClearanceToPolygon(
+                            *layerPoly,
+                            0,
+                            nrSegments,
+                            GetCircleCorrectionFactor( nrSegments ) );
             }
             break;
 
             case PCB_TEXT_T:
-                AddShapeWithClearanceToContainer( (TEXTE_PCB*) item,
-                                                  layerContainer,
-                                                  curr_layer_id,
-                                                  0 );
-            break;
-
-            case PCB_DIMENSION_T:
-                AddShapeWithClearanceToContainer( (DIMENSION*) item,
-                                                  layerContainer,
-                                                  curr_layer_id,
-                                                  0 );
+                ( (TEXTE_PCB*) item )->TransformShapeWithClearanceToPolygonSet(
+                            *layerPoly,
+                            0,
+                            SEGCOUNT_CIRCLE,
+                            correctionFactor );
             break;
 
             default:
@@ -1725,204 +1653,206 @@ void CINFO3D_VISU::createLayers( REPORTER *aStatusTextReporter )
         }
     }
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T11: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time  ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
-
-    // Add graphic item on copper layers to poly contourns
-    // /////////////////////////////////////////////////////////////////////////
-    if( GetFlag( FL_RENDER_OPENGL_COPPER_THICKNESS ) &&
-        (m_render_engine == RENDER_ENGINE_OPENGL_LEGACY) )
+    if( GetFlag( FL_ZONE ) )
     {
-        for( unsigned int lIdx = 0; lIdx < layer_id.size(); ++lIdx )
+        // Add zones objects
+        // /////////////////////////////////////////////////////////////////////
+        for( int ii = 0; ii < m_board->GetAreaCount(); ++ii )
         {
-            const PCB_LAYER_ID curr_layer_id = layer_id[lIdx];
-
-            wxASSERT( m_layers_poly.find( curr_layer_id ) != m_layers_poly.end() );
+            const ZONE_CONTAINER* zone = m_board->GetArea( ii );
 
-            SHAPE_POLY_SET *layerPoly = m_layers_poly[curr_layer_id];
+            if( zone->GetLayer() == aLayerId )
+                AddSolidAreasShapesToContainer( zone, layerContainer, aLayerId );
+        }
 
-            // ADD GRAPHIC ITEMS ON COPPER LAYERS (texts)
-            for( auto item : m_board->Drawings() )
+        // Add zones poly contourns
+        // /////////////////////////////////////////////////////////////////////
+        if( layerPoly )
+        {
+            for( int ii = 0; ii < m_board->GetAreaCount(); ++ii )
             {
-                if( !item->IsOnLayer( curr_layer_id ) )
-                    continue;
+                const ZONE_CONTAINER* zone = m_board->GetArea( ii );
 
-                switch( item->Type() )
-                {
-                case PCB_LINE_T: // should not exist on copper layers
+                if( zone->GetLayer() == aLayerId )
                 {
-                    const int nrSegments =
-                            GetNrSegmentsCircle( item->GetBoundingBox().GetSizeMax() );
-
-                    ( (DRAWSEGMENT*) item )->TransformShapeWithClearanceToPolygon(
-                                *layerPoly,
-                                0,
-                                nrSegments,
-                                GetCircleCorrectionFactor( nrSegments ) );
-                }
-                break;
-
-                case PCB_TEXT_T:
-                    ( (TEXTE_PCB*) item )->TransformShapeWithClearanceToPolygonSet(
-                                *layerPoly,
-                                0,
-                                segcountforcircle,
-                                correctionFactor );
-                break;
-
-                default:
-                    wxLogTrace( m_logTrace,
-                                wxT( "createLayers: item type: %d not implemented" ),
-                                item->Type() );
-                break;
+                    zone->TransformSolidAreasShapesToPolygonSet( *layerPoly,
+                                                                 SEGCOUNT_CIRCLE,
+                                                                 correctionFactor );
                 }
             }
         }
     }
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T12: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time  ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
+    // Simplify layer polygons
+    // /////////////////////////////////////////////////////////////////////////
 
-    if( GetFlag( FL_ZONE ) )
+    // This will make a union of all added contourns
+    if( layerPoly )
+        layerPoly->Simplify( SHAPE_POLY_SET::PM_FAST );
+
+    if( layerOuterHolesPoly )
     {
-        if( aStatusTextReporter )
-            aStatusTextReporter->Report( _( "Create zones" ) );
+        layerOuterHolesPoly->Simplify( SHAPE_POLY_SET::PM_FAST );
+        layerInnerHolesPoly->Simplify( SHAPE_POLY_SET::PM_FAST );
+    }
+}
 
-        // Add zones objects
-        // /////////////////////////////////////////////////////////////////////
-        for( unsigned int lIdx = 0; lIdx < layer_id.size(); ++lIdx )
-        {
-            const PCB_LAYER_ID curr_layer_id = layer_id[lIdx];
 
-            if( aStatusTextReporter )
-                aStatusTextReporter->Report( wxString::Format( _( "Create zones of layer %s" ),
-                                                               LSET::Name( curr_layer_id ) ) );
+void CINFO3D_VISU::createThroughHoles( const std::vector< const TRACK* >& aTrackList,
+                                       PCB_LAYER_ID aFirstCopperLayer )
+{
+    // Create through VIAS objects and contours
+    // /////////////////////////////////////////////////////////////////////////
+    for( unsigned int trackIdx = 0; trackIdx < aTrackList.size(); ++trackIdx )
+    {
+        const TRACK *track = aTrackList[trackIdx];
 
-            wxASSERT( m_layers_container2D.find( curr_layer_id ) != m_layers_container2D.end() );
+        // The through holes are added once, for the first copper layer
+        if( track->Type() != PCB_VIA_T || !track->IsOnLayer( aFirstCopperLayer ) )
+            continue;
 
-            CBVHCONTAINER2D *layerContainer = m_layers_container2D[curr_layer_id];
+        const VIA *via = static_cast< const VIA*>( track );
 
-            // ADD COPPER ZONES
-            for( int ii = 0; ii < m_board->GetAreaCount(); ++ii )
-            {
-                const ZONE_CONTAINER* zone = m_board->GetArea( ii );
-                const PCB_LAYER_ID zonelayer = zone->GetLayer();
+        if( via->GetViaType() != VIA_THROUGH )
+            continue;
 
-                if( zonelayer == curr_layer_id )
-                {
-                    AddSolidAreasShapesToContainer( zone,
-                                                    layerContainer,
-                                                    curr_layer_id );
-                }
-            }
-        }
-    }
+        const float holediameter = via->GetDrillValue() * BiuTo3Dunits();
+        const float thickness = GetCopperThickness3DU();
+        const float hole_inner_radius = ( holediameter / 2.0f );
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T13: %.3f ms\n", (float)( GetRunningMicroSecs()  - start_Time  ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
+        const SFVEC2F via_center(  via->GetStart().x * m_biuTo3Dunits,
+                                  -via->GetStart().y * m_biuTo3Dunits );
 
-    if( GetFlag( FL_ZONE ) &&
-        GetFlag( FL_RENDER_OPENGL_COPPER_THICKNESS ) &&
-        (m_render_engine == RENDER_ENGINE_OPENGL_LEGACY) )
-    {
-        // Add zones poly contourns
+        // Add through hole object
         // /////////////////////////////////////////////////////////////////////
-        for( unsigned int lIdx = 0; lIdx < layer_id.size(); ++lIdx )
-        {
-            const PCB_LAYER_ID curr_layer_id = layer_id[lIdx];
-
-            wxASSERT( m_layers_poly.find( curr_layer_id ) != m_layers_poly.end() );
+        m_through_holes_outer.Add( new CFILLEDCIRCLE2D( via_center,
+                                                        hole_inner_radius + thickness,
+                                                        *track ) );
+
+        m_through_holes_vias_outer.Add(
+                    new CFILLEDCIRCLE2D( via_center,
+                                         hole_inner_radius + thickness,
+                                         *track ) );
+
+        m_through_holes_inner.Add( new CFILLEDCIRCLE2D( via_center,
+                                                        hole_inner_radius,
+                                                        *track ) );
+
+        //m_through_holes_vias_inner.Add( new CFILLEDCIRCLE2D( via_center,
+        //                                                     hole_inner_radius,
+        //                                                     *track ) );
+    }
 
-            SHAPE_POLY_SET *layerPoly = m_layers_poly[curr_layer_id];
+    for( unsigned int trackIdx = 0; trackIdx < aTrackList.size(); ++trackIdx )
+    {
+        const TRACK *track = aTrackList[trackIdx];
 
-            // ADD COPPER ZONES
-            for( int ii = 0; ii < m_board->GetAreaCount(); ++ii )
-            {
-                const ZONE_CONTAINER* zone = m_board->GetArea( ii );
-                const LAYER_NUM zonelayer = zone->GetLayer();
+        if( track->Type() != PCB_VIA_T || !track->IsOnLayer( aFirstCopperLayer ) )
+            continue;
 
-                if( zonelayer == curr_layer_id )
-                {
-                    zone->TransformSolidAreasShapesToPolygonSet( *layerPoly,
-                                                                 segcountforcircle,
-                                                                 correctionFactor );
-                }
-            }
-        }
-    }
+        const VIA *via = static_cast< const VIA*>( track );
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T14: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time  ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
+        if( via->GetViaType() != VIA_THROUGH )
+            continue;
 
-    // Simplify layer polygons
-    // /////////////////////////////////////////////////////////////////////////
+        const int holediameter = via->GetDrillValue();
+        const int hole_outer_radius = (holediameter / 2)+ GetCopperThicknessBIU();
 
-    if( aStatusTextReporter )
-        aStatusTextReporter->Report( _( "Simplifying polygons" ) );
+        // Add through hole contourns
+        // /////////////////////////////////////////////////////////////////////
+        TransformCircleToPolygon( m_through_outer_holes_poly,
+                                  via->GetStart(),
+                                  hole_outer_radius,
+                                  GetNrSegmentsCircle( hole_outer_radius * 2 ) );
+
+        TransformCircleToPolygon( m_through_inner_holes_poly,
+                                  via->GetStart(),
+                                  holediameter / 2,
+                                  GetNrSegmentsCircle( holediameter ) );
+
+        // Add samething for vias only
+
+        TransformCircleToPolygon( m_through_outer_holes_vias_poly,
+                                  via->GetStart(),
+                                  hole_outer_radius,
+                                  GetNrSegmentsCircle( hole_outer_radius * 2 ) );
+
+        //TransformCircleToPolygon( m_through_inner_holes_vias_poly,
+        //                          via->GetStart(),
+        //                          holediameter / 2,
+        //                          GetNrSegmentsCircle( holediameter ) );
+    }
 
-    if( GetFlag( FL_RENDER_OPENGL_COPPER_THICKNESS ) &&
-        (m_render_engine == RENDER_ENGINE_OPENGL_LEGACY) )
+    // Add holes of modules
+    // /////////////////////////////////////////////////////////////////////////
+    for( const MODULE* module = m_board->m_Modules; module; module = module->Next() )
     {
-        const int nLayers = layer_id.size();
+        const D_PAD* pad = module->PadsList();
 
-        #pragma omp parallel for
-        for( signed int lIdx = 0; lIdx < nLayers; ++lIdx )
+        for( ; pad; pad = pad->Next() )
         {
-            const PCB_LAYER_ID curr_layer_id = layer_id[lIdx];
+            const wxSize padHole = pad->GetDrillSize();
 
-            wxASSERT( m_layers_poly.find( curr_layer_id ) != m_layers_poly.end() );
+            if( !padHole.x )    // Not drilled pad like SMD pad
+                continue;
 
-            SHAPE_POLY_SET *layerPoly = m_layers_poly[curr_layer_id];
+            // The hole in the body is inflated by copper thickness,
+            // if not plated, no copper
+            const int inflate = (pad->GetAttribute () != PAD_ATTRIB_HOLE_NOT_PLATED) ?
+                                GetCopperThicknessBIU() : 0;
 
-            wxASSERT( layerPoly != NULL );
+            m_stats_nr_holes++;
+            m_stats_hole_med_diameter += ( ( pad->GetDrillSize().x +
+                                             pad->GetDrillSize().y ) / 2.0f ) * m_biuTo3Dunits;
 
-            // This will make a union of all added contourns
-            layerPoly->Simplify( SHAPE_POLY_SET::PM_FAST );
+            m_through_holes_outer.Add( createNewPadDrill( pad, inflate ) );
+            m_through_holes_inner.Add( createNewPadDrill( pad,       0 ) );
         }
     }
+    if( m_stats_nr_holes )
+        m_stats_hole_med_diameter /= (float)m_stats_nr_holes;
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T15: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
-
-    // Simplify holes polygon contours
+    // Add contours of the pad holes (pads can be Circle or Segment holes)
     // /////////////////////////////////////////////////////////////////////////
-    if( aStatusTextReporter )
-        aStatusTextReporter->Report( _( "Simplify holes contours" ) );
-
-    for( unsigned int lIdx = 0; lIdx < layer_id.size(); ++lIdx )
+    for( const MODULE* module = m_board->m_Modules; module; module = module->Next() )
     {
-        const PCB_LAYER_ID curr_layer_id = layer_id[lIdx];
+        const D_PAD* pad = module->PadsList();
 
-        if( m_layers_outer_holes_poly.find( curr_layer_id ) !=
-            m_layers_outer_holes_poly.end() )
+        for( ; pad; pad = pad->Next() )
         {
-            // found
-            SHAPE_POLY_SET *polyLayer = m_layers_outer_holes_poly[curr_layer_id];
-            polyLayer->Simplify( SHAPE_POLY_SET::PM_FAST );
+            const wxSize padHole = pad->GetDrillSize();
 
-            wxASSERT( m_layers_inner_holes_poly.find( curr_layer_id ) !=
-                      m_layers_inner_holes_poly.end() );
+            if( !padHole.x ) // Not drilled pad like SMD pad
+                continue;
 
-            polyLayer = m_layers_inner_holes_poly[curr_layer_id];
-            polyLayer->Simplify( SHAPE_POLY_SET::PM_FAST );
-        }
-    }
+            // The hole in the body is inflated by copper thickness.
+            const int inflate = GetCopperThicknessBIU();
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T16: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time ) / 1e3 );
-#endif
-    // End Build Copper layers
+            // we use the hole diameter to calculate the seg count.
+            // for round holes, padHole.x == padHole.y
+            // for oblong holes, the diameter is the smaller of (padHole.x, padHole.y)
+            const int diam = std::min( padHole.x, padHole.y );
+
+
+            if( pad->GetAttribute () != PAD_ATTRIB_HOLE_NOT_PLATED )
+            {
+                pad->BuildPadDrillShapePolygon( m_through_outer_holes_poly,
+                                                inflate,
+                                                GetNrSegmentsCircle( diam ) );
 
+                pad->BuildPadDrillShapePolygon( m_through_inner_holes_poly,
+                                                0,
+                                                GetNrSegmentsCircle( diam ) );
+            }
+            else
+            {
+                // If not plated, no copper.
+                pad->BuildPadDrillShapePolygon( m_through_outer_holes_poly_NPTH,
+                                                inflate,
+                                                GetNrSegmentsCircle( diam ) );
+            }
+        }
+    }
 
     // This will make a union of all added contourns
     m_through_inner_holes_poly.Simplify( SHAPE_POLY_SET::PM_FAST );
@@ -1930,287 +1860,195 @@ void CINFO3D_VISU::createLayers( REPORTER *aStatusTextReporter )
     m_through_outer_holes_poly_NPTH.Simplify( SHAPE_POLY_SET::PM_FAST );
     m_through_outer_holes_vias_poly.Simplify( SHAPE_POLY_SET::PM_FAST );
     //m_through_inner_holes_vias_poly.Simplify( SHAPE_POLY_SET::PM_FAST ); // Not in use
+}
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    unsigned stats_endCopperLayersTime = GetRunningMicroSecs();
-#endif
-
-
-    // Build Tech layers
-    // Based on: https://github.com/KiCad/kicad-source-mirror/blob/master/3d-viewer/3d_draw.cpp#L1059
-    // /////////////////////////////////////////////////////////////////////////
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    unsigned stats_startTechLayersTime = GetRunningMicroSecs();
-#endif
 
-    if( aStatusTextReporter )
-        aStatusTextReporter->Report( _( "Build Tech layers" ) );
+// Build Tech layers
+// Based on: https://github.com/KiCad/kicad-source-mirror/blob/master/3d-viewer/3d_draw.cpp#L1059
+void CINFO3D_VISU::createTechLayer( PCB_LAYER_ID aLayerId )
+{
+    const double correctionFactorStroke = GetCircleCorrectionFactor( SEGCOUNT_STROKE_FONT );
 
-    // draw graphic items, on technical layers
-    static const PCB_LAYER_ID teckLayerList[] = {
-            B_Adhes,
-            F_Adhes,
-            B_Paste,
-            F_Paste,
-            B_SilkS,
-            F_SilkS,
-            B_Mask,
-            F_Mask,
+    wxASSERT( m_layers_container2D.find( aLayerId ) != m_layers_container2D.end() );
+    wxASSERT( m_layers_poly.find( aLayerId ) != m_layers_poly.end() );
 
-            // Aux Layers
-            Dwgs_User,
-            Cmts_User,
-            Eco1_User,
-            Eco2_User,
-            Edge_Cuts,
-            Margin
-        };
+    CBVHCONTAINER2D *layerContainer = m_layers_container2D.find( aLayerId )->second;
+    SHAPE_POLY_SET *layerPoly = m_layers_poly.find( aLayerId )->second;
 
-    // User layers are not drawn here, only technical layers
-    for( LSEQ seq = LSET::AllNonCuMask().Seq( teckLayerList, DIM( teckLayerList ) );
-         seq;
-         ++seq )
+    // Add drawing objects
+    // /////////////////////////////////////////////////////////////////////////
+    for( auto item : m_board->Drawings() )
     {
-        const PCB_LAYER_ID curr_layer_id = *seq;
-
-        if( !Is3DLayerEnabled( curr_layer_id ) )
-                    continue;
-
-        CBVHCONTAINER2D *layerContainer = new CBVHCONTAINER2D;
-        m_layers_container2D[curr_layer_id] = layerContainer;
-
-        SHAPE_POLY_SET *layerPoly = new SHAPE_POLY_SET;
-        m_layers_poly[curr_layer_id] = layerPoly;
+        if( !item->IsOnLayer( aLayerId ) )
+            continue;
 
-        // Add drawing objects
-        // /////////////////////////////////////////////////////////////////////
-        for( auto item : m_board->Drawings() )
+        switch( item->Type() )
         {
-            if( !item->IsOnLayer( curr_layer_id ) )
-                continue;
-
-            switch( item->Type() )
-            {
-            case PCB_LINE_T:
-                AddShapeWithClearanceToContainer( (DRAWSEGMENT*)item,
-                                                  layerContainer,
-                                                  curr_layer_id,
-                                                  0 );
-                break;
+        case PCB_LINE_T:
+            AddShapeWithClearanceToContainer( (DRAWSEGMENT*)item,
+                                              layerContainer,
+                                              aLayerId,
+                                              0 );
+            break;
 
-            case PCB_TEXT_T:
-                AddShapeWithClearanceToContainer( (TEXTE_PCB*) item,
-                                                  layerContainer,
-                                                  curr_layer_id,
-                                                  0 );
-                break;
+        case PCB_TEXT_T:
+            AddShapeWithClearanceToContainer( (TEXTE_PCB*) item,
+                                              layerContainer,
+                                              aLayerId,
+                                              0 );
+            break;
 
-            case PCB_DIMENSION_T:
-                AddShapeWithClearanceToContainer( (DIMENSION*) item,
-                                                  layerContainer,
-                                                  curr_layer_id,
-                                                  0 );
-                break;
+        case PCB_DIMENSION_T:
+            AddShapeWithClearanceToContainer( (DIMENSION*) item,
+                                              layerContainer,
+                                              aLayerId,
+                                              0 );
+            break;
 
-            default:
-                break;
-            }
+        default:
+            break;
         }
+    }
 
 
-        // Add drawing contours
-        // /////////////////////////////////////////////////////////////////////
-        for( auto item : m_board->Drawings() )
-        {
-            if( !item->IsOnLayer( curr_layer_id ) )
-                continue;
+    // Add drawing contours
+    // /////////////////////////////////////////////////////////////////////////
+    for( auto item : m_board->Drawings() )
+    {
+        if( !item->IsOnLayer( aLayerId ) )
+            continue;
 
-            switch( item->Type() )
-            {
-            case PCB_LINE_T:
-            {
-                const unsigned int nr_segments =
-                        GetNrSegmentsCircle( item->GetBoundingBox().GetSizeMax() );
+        switch( item->Type() )
+        {
+        case PCB_LINE_T:
+        {
+            const unsigned int nr_segments =
+                    GetNrSegmentsCircle( item->GetBoundingBox().GetSizeMax() );
 
-                ((DRAWSEGMENT*) item)->TransformShapeWithClearanceToPolygon( *layerPoly,
-                                                                             0,
-                                                                             nr_segments,
-                                                                             0.0 );
-            }
-                break;
+            ((DRAWSEGMENT*) item)->TransformShapeWithClearanceToPolygon( *layerPoly,
+                                                                         0,
+                                                                         nr_segments,
+                                                                         0.0 );
+        }
+            break;
 
-            case PCB_TEXT_T:
-                ((TEXTE_PCB*) item)->TransformShapeWithClearanceToPolygonSet( *layerPoly,
-                                                                              0,
-                                                                              segcountInStrokeFont,
-                                                                              1.0 );
-                break;
+        case PCB_TEXT_T:
+            ((TEXTE_PCB*) item)->TransformShapeWithClearanceToPolygonSet( *layerPoly,
+                                                                          0,
+                                                                          SEGCOUNT_STROKE_FONT,
+                                                                          1.0 );
+            break;
 
-            default:
-                break;
-            }
+        default:
+            break;
         }
+    }
 
 
-        // Add modules tech layers - objects
-        // /////////////////////////////////////////////////////////////////////
-        for( MODULE* module = m_board->m_Modules; module; module = module->Next() )
+    // Add modules tech layers - objects
+    // /////////////////////////////////////////////////////////////////////////
+    for( MODULE* module = m_board->m_Modules; module; module = module->Next() )
+    {
+        if( (aLayerId == F_SilkS) || (aLayerId == B_SilkS) )
         {
-            if( (curr_layer_id == F_SilkS) || (curr_layer_id == B_SilkS) )
-            {
-                D_PAD*  pad = module->PadsList();
-                int     linewidth = g_DrawDefaultLineThickness;
-
-                for( ; pad; pad = pad->Next() )
-                {
-                    if( !pad->IsOnLayer( curr_layer_id ) )
-                        continue;
+            D_PAD*  pad = module->PadsList();
+            int     linewidth = g_DrawDefaultLineThickness;
 
-                    buildPadShapeThickOutlineAsSegments( pad,
-                                                         layerContainer,
-                                                         linewidth );
-                }
-            }
-            else
+            for( ; pad; pad = pad->Next() )
             {
-                AddPadsShapesWithClearanceToContainer( module,
-                                                       layerContainer,
-                                                       curr_layer_id,
-                                                       0,
-                                                       false );
-            }
+                if( !pad->IsOnLayer( aLayerId ) )
+                    continue;
 
-            AddGraphicsShapesWithClearanceToContainer( module,
-                                                       layerContainer,
-                                                       curr_layer_id,
-                                                       0 );
+                buildPadShapeThickOutlineAsSegments( pad,
+                                                     layerContainer,
+                                                     linewidth );
+            }
         }
-
-
-        // Add modules tech layers - contours
-        // /////////////////////////////////////////////////////////////////////
-        for( MODULE* module = m_board->m_Modules; module; module = module->Next() )
+        else
         {
-            if( (curr_layer_id == F_SilkS) || (curr_layer_id == B_SilkS) )
-            {
-                D_PAD*  pad = module->PadsList();
-                const int linewidth = g_DrawDefaultLineThickness;
-
-                for( ; pad; pad = pad->Next() )
-                {
-                    if( !pad->IsOnLayer( curr_layer_id ) )
-                        continue;
-
-                    buildPadShapeThickOutlineAsPolygon( pad, *layerPoly, linewidth );
-                }
-            }
-            else
-            {
-                transformPadsShapesWithClearanceToPolygon( module->PadsList(),
-                                                           curr_layer_id,
-                                                           *layerPoly,
-                                                           0,
-                                                           false );
-            }
-
-            // On tech layers, use a poor circle approximation, only for texts (stroke font)
-            module->TransformGraphicTextWithClearanceToPolygonSet( curr_layer_id,
-                                                                   *layerPoly,
-                                                                   0,
-                                                                   segcountInStrokeFont,
-                                                                   correctionFactorStroke,
-                                                                   segcountInStrokeFont );
-
-            // Add the remaining things with dynamic seg count for circles
-            transformGraphicModuleEdgeToPolygonSet( module, curr_layer_id, *layerPoly );
+            AddPadsShapesWithClearanceToContainer( module,
+                                                   layerContainer,
+                                                   aLayerId,
+                                                   0,
+                                                   false );
         }
 
+        AddGraphicsShapesWithClearanceToContainer( module,
+                                                   layerContainer,
+                                                   aLayerId,
+                                                   0 );
+    }
 
-        // Draw non copper zones
-        // /////////////////////////////////////////////////////////////////////
-        if( GetFlag( FL_ZONE ) )
-        {
-            for( int ii = 0; ii < m_board->GetAreaCount(); ++ii )
-            {
-                ZONE_CONTAINER* zone = m_board->GetArea( ii );
-
-                if( !zone->IsOnLayer( curr_layer_id ) )
-                    continue;
 
-                AddSolidAreasShapesToContainer( zone,
-                                                layerContainer,
-                                                curr_layer_id );
-            }
+    // Add modules tech layers - contours
+    // /////////////////////////////////////////////////////////////////////////
+    for( MODULE* module = m_board->m_Modules; module; module = module->Next() )
+    {
+        if( (aLayerId == F_SilkS) || (aLayerId == B_SilkS) )
+        {
+            D_PAD*  pad = module->PadsList();
+            const int linewidth = g_DrawDefaultLineThickness;
 
-            for( int ii = 0; ii < m_board->GetAreaCount(); ++ii )
+            for( ; pad; pad = pad->Next() )
             {
-                ZONE_CONTAINER* zone = m_board->GetArea( ii );
-
-                if( !zone->IsOnLayer( curr_layer_id ) )
+                if( !pad->IsOnLayer( aLayerId ) )
                     continue;
 
-                zone->TransformSolidAreasShapesToPolygonSet( *layerPoly,
-                                                             // Use the same segcount as stroke font
-                                                             segcountInStrokeFont,
-                                                             correctionFactorStroke );
+                buildPadShapeThickOutlineAsPolygon( pad, *layerPoly, linewidth );
             }
         }
+        else
+        {
+            transformPadsShapesWithClearanceToPolygon( module->PadsList(),
+                                                       aLayerId,
+                                                       *layerPoly,
+                                                       0,
+                                                       false );
+        }
 
-        // This will make a union of all added contourns
-        layerPoly->Simplify( SHAPE_POLY_SET::PM_FAST );
-    }
-    // End Build Tech layers
+        // On tech layers, use a poor circle approximation, only for texts (stroke font)
+        module->TransformGraphicTextWithClearanceToPolygonSet( aLayerId,
+                                                               *layerPoly,
+                                                               0,
+                                                               SEGCOUNT_STROKE_FONT,
+                                                               correctionFactorStroke,
+                                                               SEGCOUNT_STROKE_FONT );
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    unsigned stats_endTechLayersTime = GetRunningMicroSecs();
-#endif
+        // Add the remaining things with dynamic seg count for circles
+        transformGraphicModuleEdgeToPolygonSet( module, aLayerId, *layerPoly );
+    }
 
 
-    // Build BVH for holes and vias
+    // Draw non copper zones
     // /////////////////////////////////////////////////////////////////////////
-
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    unsigned stats_startHolesBVHTime = GetRunningMicroSecs();
-#endif
-
-    m_through_holes_inner.BuildBVH();
-    m_through_holes_outer.BuildBVH();
-
-    if( !m_layers_holes2D.empty() )
+    if( GetFlag( FL_ZONE ) )
     {
-        for( MAP_CONTAINER_2D::iterator ii = m_layers_holes2D.begin();
-             ii != m_layers_holes2D.end();
-             ++ii )
+        for( int ii = 0; ii < m_board->GetAreaCount(); ++ii )
         {
-            ((CBVHCONTAINER2D *)(ii->second))->BuildBVH();
+            ZONE_CONTAINER* zone = m_board->GetArea( ii );
+
+            if( !zone->IsOnLayer( aLayerId ) )
+                continue;
+
+            AddSolidAreasShapesToContainer( zone,
+                                            layerContainer,
+                                            aLayerId );
         }
-    }
 
-    // We only need the Solder mask to initialize the BVH
-    // because..?
-    if( (CBVHCONTAINER2D *)m_layers_container2D[B_Mask] )
-        ((CBVHCONTAINER2D *)m_layers_container2D[B_Mask])->BuildBVH();
+        for( int ii = 0; ii < m_board->GetAreaCount(); ++ii )
+        {
+            ZONE_CONTAINER* zone = m_board->GetArea( ii );
 
-    if( (CBVHCONTAINER2D *)m_layers_container2D[F_Mask] )
-        ((CBVHCONTAINER2D *)m_layers_container2D[F_Mask])->BuildBVH();
+            if( !zone->IsOnLayer( aLayerId ) )
+                continue;
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    unsigned stats_endHolesBVHTime = GetRunningMicroSecs();
+            zone->TransformSolidAreasShapesToPolygonSet( *layerPoly,
+                                                         // Use the same segcount as stroke font
+                                                         SEGCOUNT_STROKE_FONT,
+                                                         correctionFactorStroke );
+        }
+    }
 
-    printf( "CINFO3D_VISU::createLayers times\n" );
-    printf( "  Copper Layers:          %.3f ms\n",
-            (float)( stats_endCopperLayersTime  - stats_startCopperLayersTime  ) / 1e3 );
-    printf( "  Holes BVH creation:     %.3f ms\n",
-            (float)( stats_endHolesBVHTime      - stats_startHolesBVHTime      ) / 1e3 );
-    printf( "  Tech Layers:            %.3f ms\n",
-            (float)( stats_endTechLayersTime    - stats_startTechLayersTime    ) / 1e3 );
-    printf( "Statistics:\n" );
-    printf( "  m_stats_nr_tracks                   %u\n", m_stats_nr_tracks );
-    printf( "  m_stats_nr_vias                     %u\n", m_stats_nr_vias );
-    printf( "  m_stats_nr_holes                    %u\n", m_stats_nr_holes );
-    printf( "  m_stats_via_med_hole_diameter (3DU) %f\n", m_stats_via_med_hole_diameter );
-    printf( "  m_stats_hole_med_diameter     (3DU) %f\n", m_stats_hole_med_diameter );
-    printf( "  m_calc_seg_min_factor3DU      (3DU) %f\n", m_calc_seg_min_factor3DU );
-    printf( "  m_calc_seg_max_factor3DU      (3DU) %f\n", m_calc_seg_max_factor3DU );
-#endif
+    // This will make a union of all added contourns
+    layerPoly->Simplify( SHAPE_POLY_SET::PM_FAST );
 }
@@ -36,6 +36,12 @@
 #include <trigo.h>
 #include <project.h>
 #include <profile.h>        // To use GetRunningMicroSecs or an other profiling utility
+#include <base_units.h>
+
+/**
+  * Scale convertion from 3d model units to pcb units
+  */
+#define UNITS3D_TO_UNITSPCB (IU_PER_MM)
 
 
 void C3D_RENDER_OGL_LEGACY::add_object_to_triangle_layer( const CFILLEDCIRCLE2D * aFilledCircle,
@@ -641,6 +647,7 @@ void C3D_RENDER_OGL_LEGACY::reload( REPORTER *aStatusTextReporter )
         aStatusTextReporter->Report( _( "Loading 3D models" ) );
 
     load_3D_models();
+    generate_3D_models_batches();
 
 #ifdef PRINT_STATISTICS_3D_VIEWER
     unsigned stats_end_models_Load_Time = GetRunningMicroSecs();
@@ -926,6 +933,28 @@ void C3D_RENDER_OGL_LEGACY::load_3D_models()
         (!m_settings.GetFlag( FL_MODULE_ATTRIBUTES_VIRTUAL )) )
         return;
 
+    // Without a cache manager, the model files cannot be resolved
+    if( !m_settings.Get3DCacheManager() )
+        return;
+
+    // Load the models that are not in our cache map in parallel, so the
+    // following GetModel calls find them in the cache
+    std::vector< wxString > modelFiles;
+
+    for( const MODULE* module = m_settings.GetBoard()->m_Modules;
+         module;
+         module = module->Next() )
+    {
+        for( const S3D_INFO& model : module->Models() )
+        {
+            if( !model.m_Filename.empty() &&
+                m_3dmodel_map.find( model.m_Filename ) == m_3dmodel_map.end() )
+                modelFiles.push_back( model.m_Filename );
+        }
+    }
+
+    m_settings.Get3DCacheManager()->PreloadModels( modelFiles );
+
     // Go for all modules
     for( const MODULE* module = m_settings.GetBoard()->m_Modules;
          module;
@@ -966,3 +995,187 @@ void C3D_RENDER_OGL_LEGACY::load_3D_models()
         }
     }
 }
+
+
+void C3D_RENDER_OGL_LEGACY::generate_3D_models_batches()
+{
+    free_3D_models_batches();
+
+    // Index of the batch of each model, for each side of the board
+    std::map< const C_OGL_3DMODEL*, unsigned int > batchIndex[2];
+
+    for( const MODULE* module = m_settings.GetBoard()->m_Modules;
+         module;
+         module = module->Next() )
+    {
+        if( module->Models().empty() ||
+            !m_settings.ShouldModuleBeDisplayed( (MODULE_ATTR_T)module->GetAttributes() ) )
+            continue;
+
+        const unsigned int side = module->IsFlipped() ? 0 : 1;
+
+        const double zpos = m_settings.GetModulesZcoord3DIU( module->IsFlipped() );
+
+        const wxPoint pos = module->GetPosition();
+
+        glm::mat4 moduleMatrix = glm::mat4();
+
+        moduleMatrix = glm::translate( moduleMatrix,
+                                       SFVEC3F( pos.x * m_settings.BiuTo3Dunits(),
+                                               -pos.y * m_settings.BiuTo3Dunits(),
+                                                zpos ) );
+
+        if( module->GetOrientation() )
+        {
+            moduleMatrix = glm::rotate( moduleMatrix,
+                                        ( (float)(module->GetOrientation() / 10.0f) / 180.0f ) *
+                                        glm::pi<float>(),
+                                        SFVEC3F( 0.0f, 0.0f, 1.0f ) );
+        }
+
+        if( module->IsFlipped() )
+        {
+            moduleMatrix = glm::rotate( moduleMatrix,
+                                        glm::pi<float>(),
+                                        SFVEC3F( 0.0f, 1.0f, 0.0f ) );
+
+            moduleMatrix = glm::rotate( moduleMatrix,
+                                        glm::pi<float>(),
+                                        SFVEC3F( 0.0f, 0.0f, 1.0f ) );
+        }
+
+        const double modelunit_to_3d_units_factor = m_settings.BiuTo3Dunits() *
+                                                    UNITS3D_TO_UNITSPCB;
+
+        moduleMatrix = glm::scale( moduleMatrix,
+                                   SFVEC3F( modelunit_to_3d_units_factor,
+                                            modelunit_to_3d_units_factor,
+                                            modelunit_to_3d_units_factor ) );
+
+        // Get the list of model files for this model
+        std::list<S3D_INFO>::const_iterator sM = module->Models().begin();
+        std::list<S3D_INFO>::const_iterator eM = module->Models().end();
+
+        for( ; sM != eM; ++sM )
+        {
+            MAP_3DMODEL::const_iterator ii = m_3dmodel_map.find( sM->m_Filename );
+
+            if( ( ii == m_3dmodel_map.end() ) || ( ii->second == NULL ) )
+                continue;
+
+            const C_OGL_3DMODEL *modelPtr = ii->second;
+
+            glm::mat4 modelMatrix = moduleMatrix;
+
+            modelMatrix = glm::translate( modelMatrix,
+                                          SFVEC3F( sM->m_Offset.x * 25.4f,
+                                                   sM->m_Offset.y * 25.4f,
+                                                   sM->m_Offset.z * 25.4f ) );
+
+            modelMatrix = glm::rotate( modelMatrix,
+                                       (float)-( sM->m_Rotation.z / 180.0f ) *
+                                       glm::pi<float>(),
+                                       SFVEC3F( 0.0f, 0.0f, 1.0f ) );
+
+            modelMatrix = glm::rotate( modelMatrix,
+                                       (float)-( sM->m_Rotation.y / 180.0f ) *
+                                       glm::pi<float>(),
+                                       SFVEC3F( 0.0f, 1.0f, 0.0f ) );
+
+            modelMatrix = glm::rotate( modelMatrix,
+                                       (float)-( sM->m_Rotation.x / 180.0f ) *
+                                       glm::pi<float>(),
+                                       SFVEC3F( 1.0f, 0.0f, 0.0f ) );
+
+            modelMatrix = glm::scale( modelMatrix,
+                                      SFVEC3F( sM->m_Scale.x,
+                                               sM->m_Scale.y,
+                                               sM->m_Scale.z ) );
+
+            std::map< const C_OGL_3DMODEL*, unsigned int >::const_iterator bi =
+                    batchIndex[side].find( modelPtr );
+
+            if( bi == batchIndex[side].end() )
+            {
+                OGL_MODEL_BATCH batch;
+
+                batch.m_model = modelPtr;
+                batch.m_ogl_list_opaque = 0;
+                batch.m_ogl_list_transparent = 0;
+
+                bi = batchIndex[side].insert(
+                        std::make_pair( modelPtr, m_3dmodel_batches[side].size() ) ).first;
+
+                m_3dmodel_batches[side].push_back( batch );
+            }
+
+            m_3dmodel_batches[side][bi->second].m_transforms.push_back( modelMatrix );
+        }
+    }
+
+    // Compile the transforms of the instances and the calls of the model
+    // display lists
+    for( unsigned int side = 0; side < 2; ++side )
+    {
+        for( unsigned int i = 0; i < m_3dmodel_batches[side].size(); ++i )
+        {
+            OGL_MODEL_BATCH &batch = m_3dmodel_batches[side][i];
+
+            for( unsigned int pass = 0; pass < 2; ++pass )
+            {
+                const bool transparent = ( pass == 1 );
+
+                if( ( !transparent && !batch.m_model->Have_opaque() ) ||
+                    (  transparent && !batch.m_model->Have_transparent() ) )
+                    continue;
+
+                GLuint list = glGenLists( 1 );
+
+                if( !glIsList( list ) )
+                    continue;
+
+                glNewList( list, GL_COMPILE );
+
+                for( unsigned int t = 0; t < batch.m_transforms.size(); ++t )
+                {
+                    glPushMatrix();
+                    glMultMatrixf( glm::value_ptr( batch.m_transforms[t] ) );
+
+                    if( transparent )
+                        batch.m_model->Draw_transparent();
+                    else
+                        batch.m_model->Draw_opaque();
+
+                    glPopMatrix();
+                }
+
+                glEndList();
+
+                if( transparent )
+                    batch.m_ogl_list_transparent = list;
+                else
+                    batch.m_ogl_list_opaque = list;
+            }
+        }
+    }
+}
+
+
+void C3D_RENDER_OGL_LEGACY::free_3D_models_batches()
+{
+    for( unsigned int side = 0; side < 2; ++side )
+    {
+        for( unsigned int i = 0; i < m_3dmodel_batches[side].size(); ++i )
+        {
+            const OGL_MODEL_BATCH &batch = m_3dmodel_batches[side][i];
+
+            if( glIsList( batch.m_ogl_list_opaque ) )
+                glDeleteLists( batch.m_ogl_list_opaque, 1 );
+
+            if( glIsList( batch.m_ogl_list_transparent ) )
+                glDeleteLists( batch.m_ogl_list_transparent, 1 );
+        }
+
+        m_3dmodel_batches[side].clear();
+    }
+}
@@ -68,6 +68,8 @@ C3D_RENDER_OGL_LEGACY::C3D_RENDER_OGL_LEGACY( CINFO3D_VISU &aSettings ) :
     m_last_grid_type = GRID3D_NONE;
 
     m_3dmodel_map.clear();
+
+    m_models_stats = OGL_MODELS_RENDER_STATS();
 }
 
 
@@ -688,6 +690,7 @@ bool C3D_RENDER_OGL_LEGACY::Redraw( bool aIsMoving,
 
     // Render 3D Models (Non-transparent)
     // /////////////////////////////////////////////////////////////////////////
+    m_models_stats = OGL_MODELS_RENDER_STATS();
 
     //setLight_Top( false );
     //setLight_Bottom( true );
@@ -735,6 +738,13 @@ bool C3D_RENDER_OGL_LEGACY::Redraw( bool aIsMoving,
     //setLight_Bottom( false );
     render_3D_models( true, true );
 
+    wxLogTrace( m_logTrace,
+                wxT( "C3D_RENDER_OGL_LEGACY::Redraw 3D models: %u draw calls, "
+                     "%u instances, %u triangles" ),
+                m_models_stats.m_draw_calls,
+                m_models_stats.m_instances,
+                m_models_stats.m_triangles );
+
 
     // Render Grid
     // /////////////////////////////////////////////////////////////////////////
@@ -881,6 +891,8 @@ void C3D_RENDER_OGL_LEGACY::ogl_free_all_display_lists()
     m_triangles.clear();
 
 
+    free_3D_models_batches();
+
     for( MAP_3DMODEL::const_iterator ii = m_3dmodel_map.begin();
          ii != m_3dmodel_map.end();
          ++ii )
@@ -978,9 +990,11 @@ void C3D_RENDER_OGL_LEGACY::render_solder_mask_layer( PCB_LAYER_ID aLayerID,
 void C3D_RENDER_OGL_LEGACY::render_3D_models( bool aRenderTopOrBot,
                                               bool aRenderTransparentOnly )
 {
-    // Go for all modules
-    if( m_settings.GetBoard()->m_Modules.GetCount() )
+    // The bounding boxes are drawn around each instance, so this debug view
+    // renders the modules one by one
+    if( m_settings.GetFlag( FL_RENDER_OPENGL_SHOW_MODEL_BBOX ) )
     {
+        // Go for all modules
         for( const MODULE* module = m_settings.GetBoard()->m_Modules;
              module;
              module = module->Next() )
@@ -991,6 +1005,32 @@ void C3D_RENDER_OGL_LEGACY::render_3D_models( bool aRenderTopOrBot,
                         (!aRenderTopOrBot &&  module->IsFlipped()) )
                         render_3D_module( module, aRenderTransparentOnly );
         }
+
+        return;
+    }
+
+    // Render all the instances of each model with a single call
+    const std::vector< OGL_MODEL_BATCH > &batches = m_3dmodel_batches[aRenderTopOrBot ? 1 : 0];
+
+    for( unsigned int i = 0; i < batches.size(); ++i )
+    {
+        const OGL_MODEL_BATCH &batch = batches[i];
+
+        const GLuint list = aRenderTransparentOnly ? batch.m_ogl_list_transparent :
+                                                     batch.m_ogl_list_opaque;
+
+        if( list == 0 )
+            continue;
+
+        glCallList( list );
+
+        const unsigned int nInstances = batch.m_transforms.size();
+
+        m_models_stats.m_draw_calls++;
+        m_models_stats.m_instances += nInstances;
+        m_models_stats.m_triangles += nInstances *
+                ( aRenderTransparentOnly ? batch.m_model->GetNrTrianglesTransparent() :
+                                           batch.m_model->GetNrTrianglesOpaque() );
     }
 }
 
@@ -1061,6 +1101,12 @@ void C3D_RENDER_OGL_LEGACY::render_3D_module( const MODULE* module,
                             else
                                 modelPtr->Draw_opaque();
 
+                            m_models_stats.m_draw_calls++;
+                            m_models_stats.m_instances++;
+                            m_models_stats.m_triangles += aRenderTransparentOnly ?
+                                                    modelPtr->GetNrTrianglesTransparent() :
+                                                    modelPtr->GetNrTrianglesOpaque();
+
                             if( m_settings.GetFlag( FL_RENDER_OPENGL_SHOW_MODEL_BBOX ) )
                             {
                                 glEnable( GL_BLEND );
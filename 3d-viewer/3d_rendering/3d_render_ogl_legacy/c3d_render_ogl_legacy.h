@@ -45,6 +45,7 @@
 #include "3d_cache/3d_info.h"
 
 #include <map>
+#include <vector>
 
 
 typedef std::map< PCB_LAYER_ID, CLAYERS_OGL_DISP_LISTS* > MAP_OGL_DISP_LISTS;
@@ -53,6 +54,32 @@ typedef std::map< wxString, C_OGL_3DMODEL * > MAP_3DMODEL;
 
 #define SIZE_OF_CIRCLE_TEXTURE 1024
 
+/**
+ * @brief The OGL_MODEL_BATCH struct - all the instances of a 3D model on one
+ * side of the board. The transforms of the instances are compiled, with the
+ * calls of the model display lists, in a display list of the batch, so a
+ * single call renders all the instances.
+ */
+struct OGL_MODEL_BATCH
+{
+    const C_OGL_3DMODEL      *m_model;
+    std::vector< glm::mat4 >  m_transforms;             ///< one per instance
+    GLuint                    m_ogl_list_opaque;
+    GLuint                    m_ogl_list_transparent;
+};
+
+/**
+ * @brief The OGL_MODELS_RENDER_STATS struct - counters of the 3D models of the
+ * last rendered frame. They are counted by the renderer, so they are available
+ * without querying openGL.
+ */
+struct OGL_MODELS_RENDER_STATS
+{
+    unsigned int m_draw_calls;      ///< display lists called to render the models
+    unsigned int m_instances;       ///< model instances rendered
+    unsigned int m_triangles;       ///< triangles of the rendered models
+};
+
 /**
  * @brief The C3D_RENDER_OGL_LEGACY class render the board using openGL legacy mode
  */
@@ -69,6 +96,12 @@ public:
 
     int GetWaitForEditingTimeOut() override;
 
+    /**
+     * @brief GetModelsRenderStats
+     * @return the counters of the 3D models of the last rendered frame
+     */
+    const OGL_MODELS_RENDER_STATS &GetModelsRenderStats() const { return m_models_stats; }
+
 private:
     bool initializeOpenGL();
     void reload( REPORTER *aStatusTextReporter );
@@ -106,6 +139,11 @@ private:
 
     MAP_3DMODEL m_3dmodel_map;
 
+    /// Batches of model instances, [0] for the bottom side and [1] for the top side
+    std::vector< OGL_MODEL_BATCH > m_3dmodel_batches[2];
+
+    OGL_MODELS_RENDER_STATS m_models_stats;
+
 private:
     void generate_through_outer_holes();
     void generate_through_inner_holes();
@@ -176,6 +214,14 @@ private:
 
     void load_3D_models();
 
+    /**
+     * @brief generate_3D_models_batches - group the instances of the loaded
+     * models by model and side, and compile the display lists of the batches
+     */
+    void generate_3D_models_batches();
+
+    void free_3D_models_batches();
+
     /**
      * @brief render_3D_models
      * @param aRenderTopOrBot - true will render Top, false will render bottom
@@ -40,6 +40,8 @@ C_OGL_3DMODEL::C_OGL_3DMODEL( const S3DMODEL &a3DModel,
     m_ogl_idx_list_opaque = 0;
     m_ogl_idx_list_transparent = 0;
     m_nr_meshes = 0;
+    m_nr_triangles_opaque = 0;
+    m_nr_triangles_transparent = 0;
     m_meshs_bbox = NULL;
 
     // Validate a3DModel pointers
@@ -250,6 +252,7 @@ C_OGL_3DMODEL::C_OGL_3DMODEL( const S3DMODEL &a3DModel,
                     {
                         have_opaque_meshes = true; // Flag that we have at least one opaque mesh
                         glCallList( m_ogl_idx_list_meshes + mesh_i );
+                        m_nr_triangles_opaque += mesh.m_FaceIdxSize / 3;
                     }
                     else
                     {
@@ -292,7 +295,10 @@ C_OGL_3DMODEL::C_OGL_3DMODEL( const S3DMODEL &a3DModel,
 
                             // Render the transparent mesh if it have a transparency value
                             if( material.m_Transparency != 0.0f )
+                            {
                                 glCallList( m_ogl_idx_list_meshes + mesh_i );
+                                m_nr_triangles_transparent += mesh.m_FaceIdxSize / 3;
+                            }
                         }
                     }
 
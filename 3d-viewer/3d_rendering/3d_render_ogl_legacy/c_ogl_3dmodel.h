@@ -84,11 +84,23 @@ public:
      */
     const CBBOX &GetBBox() const { return m_model_bbox; }
 
+    /**
+     * @brief GetNrTrianglesOpaque - number of triangles rendered by Draw_opaque
+     */
+    unsigned int GetNrTrianglesOpaque() const { return m_nr_triangles_opaque; }
+
+    /**
+     * @brief GetNrTrianglesTransparent - number of triangles rendered by Draw_transparent
+     */
+    unsigned int GetNrTrianglesTransparent() const { return m_nr_triangles_transparent; }
+
 private:
     GLuint  m_ogl_idx_list_opaque;      ///< display list for rendering opaque meshes
     GLuint  m_ogl_idx_list_transparent; ///< display list for rendering transparent meshes
     GLuint  m_ogl_idx_list_meshes;      ///< display lists for all meshes.
     unsigned int m_nr_meshes;           ///< number of meshes of this model
+    unsigned int m_nr_triangles_opaque;      ///< triangles of the opaque meshes
+    unsigned int m_nr_triangles_transparent; ///< triangles of the transparent meshes
 
     CBBOX   m_model_bbox;               ///< global bounding box for this model
     CBBOX  *m_meshs_bbox;               ///< individual bbox for each mesh
@@ -0,0 +1,437 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 1992-2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file  cbvh_packet_simd.cpp
+ * @brief Slab tests of the rays of a packet against a bounding box, 4 (SSE2)
+ * or 8 (AVX2) rays at a time. The instruction set is selected at runtime.
+ */
+
+#include "cbvh_packet_simd.h"
+#include <algorithm>
+#include <cfloat>
+#include <wx/debug.h>
+
+#if ( defined( __x86_64__ ) || defined( _M_X64 ) || defined( __SSE2__ ) )
+#define RAYPACKET_HAVE_SSE2
+#include <emmintrin.h>
+
+// The AVX2 kernels are compiled with a function target attribute, so the rest
+// of the code does not require a CPU with AVX2
+#if defined( __GNUC__ ) || defined( __clang__ )
+#define RAYPACKET_HAVE_AVX2
+#define RAYPACKET_TARGET_AVX2 __attribute__(( target( "avx2" ) ))
+#include <immintrin.h>
+#endif
+#endif
+
+
+// Small enlargement of the far distance, so a ray that grazes a box is
+// never missed because of rounding errors
+#define SLAB_ROBUST_FACTOR 1.0000004f
+
+
+void RAYPACKET_SOA::Init( const RAYPACKET &aRayPacket, const HITINFO_PACKET *aHitInfoPacket )
+{
+    for( unsigned int i = 0; i < RAYPACKET_RAYS_PER_PACKET; ++i )
+    {
+        const RAY &ray = aRayPacket.m_ray[i];
+
+        m_origin[0][i] = ray.m_Origin.x;
+        m_origin[1][i] = ray.m_Origin.y;
+        m_origin[2][i] = ray.m_Origin.z;
+
+        m_invDir[0][i] = ray.m_InvDir.x;
+        m_invDir[1][i] = ray.m_InvDir.y;
+        m_invDir[2][i] = ray.m_InvDir.z;
+
+        m_tHit[i] = aHitInfoPacket[i].m_HitInfo.m_tHit;
+    }
+}
+
+
+// Scalar kernels
+
+static inline bool slabHit( const RAYPACKET_SOA &aRays, const CBBOX &aBBox, unsigned int i )
+{
+    float tNear = -FLT_MAX;
+    float tFar  =  FLT_MAX;
+
+    for( unsigned int axis = 0; axis < 3; ++axis )
+    {
+        const float t0 = ( aBBox.Min()[axis] - aRays.m_origin[axis][i] ) * aRays.m_invDir[axis][i];
+        const float t1 = ( aBBox.Max()[axis] - aRays.m_origin[axis][i] ) * aRays.m_invDir[axis][i];
+
+        tNear = std::max( tNear, std::min( t0, t1 ) );
+        tFar  = std::min( tFar,  std::max( t0, t1 ) );
+    }
+
+    tFar *= SLAB_ROBUST_FACTOR;
+
+    return ( tFar >= tNear ) && ( tFar >= 0.0f ) && ( tNear < aRays.m_tHit[i] );
+}
+
+
+static unsigned int firstHitScalar( const RAYPACKET_SOA &aRays,
+                                    const CBBOX &aBBox,
+                                    unsigned int aFirst,
+                                    const CFRUSTUM *aFrustum )
+{
+    if( slabHit( aRays, aBBox, aFirst ) )
+        return aFirst;
+
+    if( aFrustum && !aFrustum->Intersect( aBBox ) )
+        return RAYPACKET_RAYS_PER_PACKET;
+
+    for( unsigned int i = aFirst + 1; i < RAYPACKET_RAYS_PER_PACKET; ++i )
+        if( slabHit( aRays, aBBox, i ) )
+            return i;
+
+    return RAYPACKET_RAYS_PER_PACKET;
+}
+
+
+static unsigned int lastHitScalar( const RAYPACKET_SOA &aRays,
+                                   const CBBOX &aBBox,
+                                   unsigned int aFirst )
+{
+    for( unsigned int i = ( RAYPACKET_RAYS_PER_PACKET - 1 ); i > aFirst; --i )
+        if( slabHit( aRays, aBBox, i ) )
+            return i + 1;
+
+    return aFirst + 1;
+}
+
+
+// SSE2 kernels
+
+#ifdef RAYPACKET_HAVE_SSE2
+
+/**
+ * @return a 4 bit mask of the rays aFirst .. aFirst + 3 that hit the box
+ */
+static inline int slabHitMask4( const RAYPACKET_SOA &aRays,
+                                const __m128 aMin[3],
+                                const __m128 aMax[3],
+                                unsigned int aFirst )
+{
+    __m128 tNear = _mm_set1_ps( -FLT_MAX );
+    __m128 tFar  = _mm_set1_ps(  FLT_MAX );
+
+    for( unsigned int axis = 0; axis < 3; ++axis )
+    {
+        const __m128 o    = _mm_load_ps( &aRays.m_origin[axis][aFirst] );
+        const __m128 invD = _mm_load_ps( &aRays.m_invDir[axis][aFirst] );
+
+        const __m128 t0 = _mm_mul_ps( _mm_sub_ps( aMin[axis], o ), invD );
+        const __m128 t1 = _mm_mul_ps( _mm_sub_ps( aMax[axis], o ), invD );
+
+        tNear = _mm_max_ps( _mm_min_ps( t0, t1 ), tNear );
+        tFar  = _mm_min_ps( _mm_max_ps( t0, t1 ), tFar );
+    }
+
+    tFar = _mm_mul_ps( tFar, _mm_set1_ps( SLAB_ROBUST_FACTOR ) );
+
+    const __m128 hit = _mm_and_ps( _mm_and_ps( _mm_cmpge_ps( tFar, tNear ),
+                                               _mm_cmpge_ps( tFar, _mm_setzero_ps() ) ),
+                                   _mm_cmplt_ps( tNear, _mm_load_ps( &aRays.m_tHit[aFirst] ) ) );
+
+    return _mm_movemask_ps( hit );
+}
+
+
+static inline void loadBBox4( const CBBOX &aBBox, __m128 aMin[3], __m128 aMax[3] )
+{
+    for( unsigned int axis = 0; axis < 3; ++axis )
+    {
+        aMin[axis] = _mm_set1_ps( aBBox.Min()[axis] );
+        aMax[axis] = _mm_set1_ps( aBBox.Max()[axis] );
+    }
+}
+
+
+static unsigned int firstHitSSE2( const RAYPACKET_SOA &aRays,
+                                  const CBBOX &aBBox,
+                                  unsigned int aFirst,
+                                  const CFRUSTUM *aFrustum )
+{
+    __m128 bmin[3], bmax[3];
+    loadBBox4( aBBox, bmin, bmax );
+
+    unsigned int group = aFirst & ~3u;
+
+    // Ignore the rays of the first group that are before aFirst
+    int mask = slabHitMask4( aRays, bmin, bmax, group ) & ( 0xF << ( aFirst - group ) );
+
+    if( !mask && aFrustum && !aFrustum->Intersect( aBBox ) )
+        return RAYPACKET_RAYS_PER_PACKET;
+
+    while( true )
+    {
+        if( mask )
+        {
+            unsigned int lane = 0;
+
+            while( !( mask & ( 1 << lane ) ) )
+                lane++;
+
+            return group + lane;
+        }
+
+        group += 4;
+
+        if( group >= RAYPACKET_RAYS_PER_PACKET )
+            return RAYPACKET_RAYS_PER_PACKET;
+
+        mask = slabHitMask4( aRays, bmin, bmax, group );
+    }
+}
+
+
+static unsigned int lastHitSSE2( const RAYPACKET_SOA &aRays,
+                                 const CBBOX &aBBox,
+                                 unsigned int aFirst )
+{
+    __m128 bmin[3], bmax[3];
+    loadBBox4( aBBox, bmin, bmax );
+
+    const unsigned int firstGroup = aFirst & ~3u;
+
+    for( int group = RAYPACKET_RAYS_PER_PACKET - 4; group >= (int)firstGroup; group -= 4 )
+    {
+        int mask = slabHitMask4( aRays, bmin, bmax, group );
+
+        // Only the rays after aFirst are searched
+        if( group == (int)firstGroup )
+            mask &= ~( 0xF >> ( 3 - ( aFirst - firstGroup ) ) );
+
+        if( mask )
+        {
+            unsigned int lane = 3;
+
+            while( !( mask & ( 1 << lane ) ) )
+                lane--;
+
+            return group + lane + 1;
+        }
+    }
+
+    return aFirst + 1;
+}
+
+#endif // RAYPACKET_HAVE_SSE2
+
+
+// AVX2 kernels
+
+#ifdef RAYPACKET_HAVE_AVX2
+
+/**
+ * @return a 8 bit mask of the rays aFirst .. aFirst + 7 that hit the box
+ */
+RAYPACKET_TARGET_AVX2
+static inline int slabHitMask8( const RAYPACKET_SOA &aRays,
+                                const __m256 aMin[3],
+                                const __m256 aMax[3],
+                                unsigned int aFirst )
+{
+    __m256 tNear = _mm256_set1_ps( -FLT_MAX );
+    __m256 tFar  = _mm256_set1_ps(  FLT_MAX );
+
+    for( unsigned int axis = 0; axis < 3; ++axis )
+    {
+        const __m256 o    = _mm256_load_ps( &aRays.m_origin[axis][aFirst] );
+        const __m256 invD = _mm256_load_ps( &aRays.m_invDir[axis][aFirst] );
+
+        const __m256 t0 = _mm256_mul_ps( _mm256_sub_ps( aMin[axis], o ), invD );
+        const __m256 t1 = _mm256_mul_ps( _mm256_sub_ps( aMax[axis], o ), invD );
+
+        tNear = _mm256_max_ps( _mm256_min_ps( t0, t1 ), tNear );
+        tFar  = _mm256_min_ps( _mm256_max_ps( t0, t1 ), tFar );
+    }
+
+    tFar = _mm256_mul_ps( tFar, _mm256_set1_ps( SLAB_ROBUST_FACTOR ) );
+
+    const __m256 hit = _mm256_and_ps(
+            _mm256_and_ps( _mm256_cmp_ps( tFar, tNear, _CMP_GE_OQ ),
+                           _mm256_cmp_ps( tFar, _mm256_setzero_ps(), _CMP_GE_OQ ) ),
+            _mm256_cmp_ps( tNear, _mm256_load_ps( &aRays.m_tHit[aFirst] ), _CMP_LT_OQ ) );
+
+    return _mm256_movemask_ps( hit );
+}
+
+
+RAYPACKET_TARGET_AVX2
+static inline void loadBBox8( const CBBOX &aBBox, __m256 aMin[3], __m256 aMax[3] )
+{
+    for( unsigned int axis = 0; axis < 3; ++axis )
+    {
+        aMin[axis] = _mm256_set1_ps( aBBox.Min()[axis] );
+        aMax[axis] = _mm256_set1_ps( aBBox.Max()[axis] );
+    }
+}
+
+
+RAYPACKET_TARGET_AVX2
+static unsigned int firstHitAVX2( const RAYPACKET_SOA &aRays,
+                                  const CBBOX &aBBox,
+                                  unsigned int aFirst,
+                                  const CFRUSTUM *aFrustum )
+{
+    __m256 bmin[3], bmax[3];
+    loadBBox8( aBBox, bmin, bmax );
+
+    unsigned int group = aFirst & ~7u;
+
+    // Ignore the rays of the first group that are before aFirst
+    int mask = slabHitMask8( aRays, bmin, bmax, group ) & ( 0xFF << ( aFirst - group ) );
+
+    if( !mask && aFrustum && !aFrustum->Intersect( aBBox ) )
+        return RAYPACKET_RAYS_PER_PACKET;
+
+    while( true )
+    {
+        if( mask )
+            return group + __builtin_ctz( mask );
+
+        group += 8;
+
+        if( group >= RAYPACKET_RAYS_PER_PACKET )
+            return RAYPACKET_RAYS_PER_PACKET;
+
+        mask = slabHitMask8( aRays, bmin, bmax, group );
+    }
+}
+
+
+RAYPACKET_TARGET_AVX2
+static unsigned int lastHitAVX2( const RAYPACKET_SOA &aRays,
+                                 const CBBOX &aBBox,
+                                 unsigned int aFirst )
+{
+    __m256 bmin[3], bmax[3];
+    loadBBox8( aBBox, bmin, bmax );
+
+    const unsigned int firstGroup = aFirst & ~7u;
+
+    for( int group = RAYPACKET_RAYS_PER_PACKET - 8; group >= (int)firstGroup; group -= 8 )
+    {
+        int mask = slabHitMask8( aRays, bmin, bmax, group );
+
+        // Only the rays after aFirst are searched
+        if( group == (int)firstGroup )
+            mask &= ~( 0xFF >> ( 7 - ( aFirst - firstGroup ) ) );
+
+        if( mask )
+            return group + ( 31 - __builtin_clz( mask ) ) + 1;
+    }
+
+    return aFirst + 1;
+}
+
+#endif // RAYPACKET_HAVE_AVX2
+
+
+// Runtime selection
+
+static RAYPACKET_SIMD_LEVEL bestSupportedLevel()
+{
+#ifdef RAYPACKET_HAVE_AVX2
+    __builtin_cpu_init();
+
+    if( __builtin_cpu_supports( "avx2" ) )
+        return RAYPACKET_SIMD_AVX2;
+#endif
+
+#ifdef RAYPACKET_HAVE_SSE2
+    return RAYPACKET_SIMD_SSE2;
+#else
+    return RAYPACKET_SIMD_NONE;
+#endif
+}
+
+
+static RAYPACKET_SIMD_LEVEL s_simdLevel = bestSupportedLevel();
+
+
+RAYPACKET_SIMD_LEVEL RAYPACKET_GetSimdLevel()
+{
+    return s_simdLevel;
+}
+
+
+RAYPACKET_SIMD_LEVEL RAYPACKET_SetSimdLevel( RAYPACKET_SIMD_LEVEL aLevel )
+{
+    s_simdLevel = std::min( aLevel, bestSupportedLevel() );
+
+    return s_simdLevel;
+}
+
+
+unsigned int RAYPACKET_FirstHit( const RAYPACKET_SOA &aRays,
+                                 const CBBOX &aBBox,
+                                 unsigned int aFirst,
+                                 const CFRUSTUM *aFrustum )
+{
+    wxASSERT( aFirst < RAYPACKET_RAYS_PER_PACKET );
+
+    switch( s_simdLevel )
+    {
+#ifdef RAYPACKET_HAVE_AVX2
+    case RAYPACKET_SIMD_AVX2:
+        return firstHitAVX2( aRays, aBBox, aFirst, aFrustum );
+#endif
+
+#ifdef RAYPACKET_HAVE_SSE2
+    case RAYPACKET_SIMD_SSE2:
+        return firstHitSSE2( aRays, aBBox, aFirst, aFrustum );
+#endif
+
+    default:
+        return firstHitScalar( aRays, aBBox, aFirst, aFrustum );
+    }
+}
+
+
+unsigned int RAYPACKET_LastHit( const RAYPACKET_SOA &aRays,
+                                const CBBOX &aBBox,
+                                unsigned int aFirst )
+{
+    wxASSERT( aFirst < RAYPACKET_RAYS_PER_PACKET );
+
+    switch( s_simdLevel )
+    {
+#ifdef RAYPACKET_HAVE_AVX2
+    case RAYPACKET_SIMD_AVX2:
+        return lastHitAVX2( aRays, aBBox, aFirst );
+#endif
+
+#ifdef RAYPACKET_HAVE_SSE2
+    case RAYPACKET_SIMD_SSE2:
+        return lastHitSSE2( aRays, aBBox, aFirst );
+#endif
+
+    default:
+        return lastHitScalar( aRays, aBBox, aFirst );
+    }
+}
@@ -0,0 +1,111 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 1992-2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file  cbvh_packet_simd.h
+ * @brief Vectorized ray packet / bounding box tests used by the packet
+ * traversal of the BVH.
+ *
+ * Only the node tests are vectorized: the BVH keeps its binary node layout,
+ * and the primitives are still intersected one ray at a time through the
+ * COBJECT interface. tools/bvh_benchmark checks that the scalar and SIMD
+ * tests render the same image and measures the speedup.
+ */
+
+#ifndef _CBVH_PACKET_SIMD_H_
+#define _CBVH_PACKET_SIMD_H_
+
+#include "../raypacket.h"
+#include "../hitinfo.h"
+#include "../shapes3D/cbbox.h"
+
+
+/**
+ * Instruction sets that can be used to test the rays of a packet against a
+ * bounding box.
+ */
+enum RAYPACKET_SIMD_LEVEL
+{
+    RAYPACKET_SIMD_NONE,    ///< Scalar tests, one ray at a time
+    RAYPACKET_SIMD_SSE2,    ///< 4 rays at a time
+    RAYPACKET_SIMD_AVX2     ///< 8 rays at a time
+};
+
+
+/**
+ * Structure of arrays copy of the rays of a packet, as needed by the
+ * vectorized slab tests.
+ */
+struct RAYPACKET_SOA
+{
+    alignas( 32 ) float m_origin[3][RAYPACKET_RAYS_PER_PACKET];
+    alignas( 32 ) float m_invDir[3][RAYPACKET_RAYS_PER_PACKET];
+
+    /// Current nearest hit distance of each ray, it must be kept in sync with
+    /// the HITINFO_PACKET while the packet is traversed
+    alignas( 32 ) float m_tHit[RAYPACKET_RAYS_PER_PACKET];
+
+    void Init( const RAYPACKET &aRayPacket, const HITINFO_PACKET *aHitInfoPacket );
+};
+
+
+/**
+ * @brief RAYPACKET_GetSimdLevel
+ * @return the instruction set used by the packet traversal. On first use it
+ * is the best one supported by the running CPU.
+ */
+RAYPACKET_SIMD_LEVEL RAYPACKET_GetSimdLevel();
+
+/**
+ * @brief RAYPACKET_SetSimdLevel - select the instruction set used by the
+ * packet traversal, e.g. to compare the output with the scalar path.
+ * A level not supported by the running CPU is downgraded to the best one
+ * supported.
+ * @param aLevel: requested level
+ * @return the level that will be used
+ */
+RAYPACKET_SIMD_LEVEL RAYPACKET_SetSimdLevel( RAYPACKET_SIMD_LEVEL aLevel );
+
+
+/**
+ * @brief RAYPACKET_FirstHit - find the first ray, starting at index aFirst,
+ * that hits aBBox before its current nearest hit.
+ * @param aFrustum: if not NULL, it is tested against aBBox when the first rays
+ * tested miss, so the search can stop early
+ * @return the index of the ray or RAYPACKET_RAYS_PER_PACKET if none hits
+ */
+unsigned int RAYPACKET_FirstHit( const RAYPACKET_SOA &aRays,
+                                 const CBBOX &aBBox,
+                                 unsigned int aFirst,
+                                 const CFRUSTUM *aFrustum );
+
+/**
+ * @brief RAYPACKET_LastHit - find the last ray, after index aFirst, that hits
+ * aBBox before its current nearest hit.
+ * @return one past the index of the ray, or aFirst + 1 if none hits
+ */
+unsigned int RAYPACKET_LastHit( const RAYPACKET_SOA &aRays,
+                                const CBBOX &aBBox,
+                                unsigned int aFirst );
+
+#endif // _CBVH_PACKET_SIMD_H_
@@ -28,6 +28,7 @@
  */
 
 #include "cbvh_pbrt.h"
+#include "cbvh_packet_simd.h"
 #include <wx/debug.h>
 
 
@@ -109,11 +110,23 @@ bool CBVH_PBRT::Intersect( const RAYPACKET &aRayPacket,
 
     unsigned int ia = 0;
 
+    // The bounding boxes are tested several rays at a time when the CPU
+    // supports it, the primitives are still tested one ray at a time
+    const bool useSimd = RAYPACKET_GetSimdLevel() != RAYPACKET_SIMD_NONE;
+
+    RAYPACKET_SOA rays;
+
+    if( useSimd )
+        rays.Init( aRayPacket, aHitInfoPacket );
+
     while( true )
     {
         const LinearBVHNode *curCell = &m_nodes[nodeNum];
 
-        ia = getFirstHit( aRayPacket, curCell->bounds, ia, aHitInfoPacket );
+        if( useSimd )
+            ia = RAYPACKET_FirstHit( rays, curCell->bounds, ia, &aRayPacket.m_Frustum );
+        else
+            ia = getFirstHit( aRayPacket, curCell->bounds, ia, aHitInfoPacket );
 
         if( ia < RAYPACKET_RAYS_PER_PACKET )
         {
@@ -127,7 +140,9 @@ bool CBVH_PBRT::Intersect( const RAYPACKET &aRayPacket,
             }
             else
             {
-                const unsigned int ie = getLastHit( aRayPacket,
+                const unsigned int ie = useSimd ?
+                                        RAYPACKET_LastHit( rays, curCell->bounds, ia ) :
+                                        getLastHit( aRayPacket,
                                                     curCell->bounds,
                                                     ia,
                                                     aHitInfoPacket );
@@ -148,6 +163,7 @@ bool CBVH_PBRT::Intersect( const RAYPACKET &aRayPacket,
                                 anyHitted |= hitted;
                                 aHitInfoPacket[i].m_hitresult |= hitted;
                                 aHitInfoPacket[i].m_HitInfo.m_acc_node_info = nodeNum;
+                                rays.m_tHit[i] = aHitInfoPacket[i].m_HitInfo.m_tHit;
                             }
                         }
                     }
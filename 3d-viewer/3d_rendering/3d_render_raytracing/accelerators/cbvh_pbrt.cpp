@@ -74,8 +74,13 @@
 #include <stdlib.h>
 
 #include <stack>
+#include <algorithm>
 #include <wx/debug.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #ifdef PRINT_STATISTICS_3D_VIEWER
 #include <stdio.h>
 #endif
@@ -142,6 +147,13 @@ struct LBVHTreelet
 };
 
 
+/// Subtrees with more primitives than this are built as separate OpenMP tasks
+#define BVH_PARALLEL_BUILD_MIN_PRIMITIVES   4096
+
+/// Minimum number of morton primitives handled by each thread of the radix sort
+#define RADIXSORT_MIN_CHUNK_SIZE            16384
+
+
 // BVHAccel Utility Functions
 inline uint32_t LeftShift3( uint32_t x )
 {
@@ -183,6 +195,22 @@ static void RadixSort( std::vector<MortonPrimitive> *v )
     wxASSERT( (nBits % bitsPerPass) == 0 );
 
     const int nPasses = nBits / bitsPerPass;
+    const int nBuckets = 1 << bitsPerPass;
+    const int bitMask = (1 << bitsPerPass) - 1;
+
+    // The input is split in contiguous chunks, that are counted and scattered
+    // in parallel. The chunks are processed in order for each bucket, so the
+    // sort remains stable and the result is the same of the serial version.
+    const int nItems = (int)v->size();
+    int nChunks = 1;
+
+#ifdef _OPENMP
+    nChunks = std::max( 1, std::min( omp_get_max_threads(),
+                                     nItems / RADIXSORT_MIN_CHUNK_SIZE ) );
+#endif
+
+    // Holds the bucket counters of each chunk, and then its starting indexes
+    std::vector<int> chunkBuckets( nChunks * nBuckets );
 
     for( int pass = 0; pass < nPasses; ++pass )
     {
@@ -193,34 +221,57 @@ static void RadixSort( std::vector<MortonPrimitive> *v )
         std::vector<MortonPrimitive> &in  = (pass & 1) ? tempVector : *v;
         std::vector<MortonPrimitive> &out = (pass & 1) ? *v : tempVector;
 
-        // Count number of zero bits in array for current radix sort bit
-        const int nBuckets = 1 << bitsPerPass;
-        int bucketCount[nBuckets] = {0};
-        const int bitMask = (1 << bitsPerPass) - 1;
+        std::fill( chunkBuckets.begin(), chunkBuckets.end(), 0 );
 
-        for( uint32_t i = 0; i < in.size(); ++i )
+        // Count number of items of each bucket in each chunk
+        #pragma omp parallel for schedule(static)
+        for( int chunk = 0; chunk < nChunks; ++chunk )
         {
-            const MortonPrimitive &mp = in[i];
-            int bucket = (mp.mortonCode >> lowBit) & bitMask;
+            const int chunkStart = (int)( ( (int64_t)nItems * chunk ) / nChunks );
+            const int chunkEnd   = (int)( ( (int64_t)nItems * (chunk + 1) ) / nChunks );
 
-            wxASSERT( (bucket >= 0) && (bucket < nBuckets) );
+            int *bucketCount = &chunkBuckets[chunk * nBuckets];
 
-            ++bucketCount[bucket];
+            for( int i = chunkStart; i < chunkEnd; ++i )
+            {
+                const int bucket = (in[i].mortonCode >> lowBit) & bitMask;
+
+                wxASSERT( (bucket >= 0) && (bucket < nBuckets) );
+
+                ++bucketCount[bucket];
+            }
         }
 
-        // Compute starting index in output array for each bucket
-        int startIndex[nBuckets];
-        startIndex[0] = 0;
+        // Compute starting index in output array for each bucket of each chunk
+        int startIndex = 0;
+
+        for( int bucket = 0; bucket < nBuckets; ++bucket )
+        {
+            for( int chunk = 0; chunk < nChunks; ++chunk )
+            {
+                const int count = chunkBuckets[chunk * nBuckets + bucket];
 
-        for( int i = 1; i < nBuckets; ++i )
-            startIndex[i] = startIndex[i - 1] + bucketCount[i - 1];
+                chunkBuckets[chunk * nBuckets + bucket] = startIndex;
+                startIndex += count;
+            }
+        }
 
         // Store sorted values in output array
-        for( uint32_t i = 0; i < in.size(); ++i )
+        #pragma omp parallel for schedule(static)
+        for( int chunk = 0; chunk < nChunks; ++chunk )
         {
-            const MortonPrimitive &mp = in[i];
-            int bucket = (mp.mortonCode >> lowBit) & bitMask;
-            out[startIndex[bucket]++] = mp;
+            const int chunkStart = (int)( ( (int64_t)nItems * chunk ) / nChunks );
+            const int chunkEnd   = (int)( ( (int64_t)nItems * (chunk + 1) ) / nChunks );
+
+            int *bucketStart = &chunkBuckets[chunk * nBuckets];
+
+            for( int i = chunkStart; i < chunkEnd; ++i )
+            {
+                const MortonPrimitive &mp = in[i];
+                const int bucket = (mp.mortonCode >> lowBit) & bitMask;
+
+                out[bucketStart[bucket]++] = mp;
+            }
         }
     }
 
@@ -259,7 +310,8 @@ CBVH_PBRT::CBVH_PBRT( const CGENERICCONTAINER &aObjectContainer,
     // /////////////////////////////////////////////////////////////////////////
     std::vector<BVHPrimitiveInfo> primitiveInfo( m_primitives.size() );
 
-    for( size_t i = 0; i < m_primitives.size(); ++i )
+    #pragma omp parallel for
+    for( int i = 0; i < (int)m_primitives.size(); ++i )
     {
         wxASSERT( m_primitives[i]->GetBBox().IsInitialized() );
 
@@ -271,15 +323,30 @@ CBVH_PBRT::CBVH_PBRT( const CGENERICCONTAINER &aObjectContainer,
 
     CONST_VECTOR_OBJECT orderedPrims;
     orderedPrims.clear();
-    orderedPrims.reserve( m_primitives.size() );
+    orderedPrims.resize( m_primitives.size() );
 
     BVHBuildNode *root;
 
     if( m_splitMethod == SPLIT_HLBVH )
         root = HLBVHBuild( primitiveInfo, &totalNodes, orderedPrims);
     else
-        root = recursiveBuild( primitiveInfo, 0, m_primitives.size(),
-                               &totalNodes, orderedPrims);
+    {
+        // A binary tree with N leaves has at most 2 * N - 1 nodes
+        const int maxBVHNodes = 2 * m_primitives.size() - 1;
+
+        BVHBuildNode *buildNodes = static_cast<BVHBuildNode *>( malloc( maxBVHNodes *
+                                                                        sizeof( BVHBuildNode ) ) );
+        m_addresses_pointer_to_mm_free.push_back( buildNodes );
+
+        // The top of the tree is built by the thread that enters the single
+        // region, the big subtrees are then spawned as tasks to the others
+        #pragma omp parallel
+        {
+            #pragma omp single
+            root = recursiveBuild( primitiveInfo, 0, m_primitives.size(),
+                                   buildNodes, &totalNodes, orderedPrims );
+        }
+    }
 
     wxASSERT( m_primitives.size() == orderedPrims.size() );
 
@@ -445,10 +512,12 @@ struct BucketInfo
 BVHBuildNode *CBVH_PBRT::recursiveBuild ( std::vector<BVHPrimitiveInfo> &primitiveInfo,
                                           int start,
                                           int end,
+                                          BVHBuildNode *buildNodes,
                                           int *totalNodes,
                                           CONST_VECTOR_OBJECT &orderedPrims )
 {
     wxASSERT( totalNodes != NULL );
+    wxASSERT( buildNodes != NULL );
     wxASSERT( start >= 0 );
     wxASSERT( end   >= 0 );
     wxASSERT( start != end );
@@ -456,11 +525,12 @@ BVHBuildNode *CBVH_PBRT::recursiveBuild ( std::vector<BVHPrimitiveInfo> &primiti
     wxASSERT( start <= (int)primitiveInfo.size() );
     wxASSERT( end   <= (int)primitiveInfo.size() );
 
+    #pragma omp atomic
     (*totalNodes)++;
 
-    // !TODO: implement an memory Arena
-    BVHBuildNode *node = static_cast<BVHBuildNode *>( malloc( sizeof( BVHBuildNode ) ) );
-    m_addresses_pointer_to_mm_free.push_back( node );
+    // The node of this subtree is the first of its slice, the left subtree
+    // uses the following 2 * nLeft - 1 nodes and the right subtree the rest
+    BVHBuildNode *node = buildNodes;
 
     node->bounds.Reset();
     node->firstPrimOffset = 0;
@@ -481,13 +551,15 @@ BVHBuildNode *CBVH_PBRT::recursiveBuild ( std::vector<BVHPrimitiveInfo> &primiti
     if( nPrimitives == 1 )
     {
         // Create leaf _BVHBuildNode_
-        int firstPrimOffset = orderedPrims.size();
+        // The leaves are emitted in the order of primitiveInfo, so the
+        // primitives of this leaf go to the same range in orderedPrims
+        const int firstPrimOffset = start;
 
         for( int i = start; i < end; ++i )
         {
             int primitiveNr = primitiveInfo[i].primitiveNumber;
             wxASSERT( primitiveNr < (int)m_primitives.size() );
-            orderedPrims.push_back( m_primitives[ primitiveNr ] );
+            orderedPrims[i] = m_primitives[ primitiveNr ];
         }
 
         node->InitLeaf( firstPrimOffset, nPrimitives, bounds );
@@ -510,7 +582,7 @@ BVHBuildNode *CBVH_PBRT::recursiveBuild ( std::vector<BVHPrimitiveInfo> &primiti
                   centroidBounds.Min()[dim] ) < (FLT_EPSILON + FLT_EPSILON) )
         {
             // Create leaf _BVHBuildNode_
-            const int firstPrimOffset = orderedPrims.size();
+            const int firstPrimOffset = start;
 
             for( int i = start; i < end; ++i )
             {
@@ -523,7 +595,7 @@ BVHBuildNode *CBVH_PBRT::recursiveBuild ( std::vector<BVHPrimitiveInfo> &primiti
 
                 wxASSERT( obj != NULL );
 
-                orderedPrims.push_back( obj );
+                orderedPrims[i] = obj;
             }
 
             node->InitLeaf( firstPrimOffset, nPrimitives, bounds );
@@ -678,7 +750,7 @@ BVHBuildNode *CBVH_PBRT::recursiveBuild ( std::vector<BVHPrimitiveInfo> &primiti
                     else
                     {
                         // Create leaf _BVHBuildNode_
-                        const int firstPrimOffset = orderedPrims.size();
+                        const int firstPrimOffset = start;
 
                         for( int i = start; i < end; ++i )
                         {
@@ -686,7 +758,7 @@ BVHBuildNode *CBVH_PBRT::recursiveBuild ( std::vector<BVHPrimitiveInfo> &primiti
 
                             wxASSERT( primitiveNr < (int)m_primitives.size() );
 
-                            orderedPrims.push_back( m_primitives[ primitiveNr ] );
+                            orderedPrims[i] = m_primitives[ primitiveNr ];
                         }
 
                         node->InitLeaf( firstPrimOffset, nPrimitives, bounds );
@@ -698,17 +770,50 @@ BVHBuildNode *CBVH_PBRT::recursiveBuild ( std::vector<BVHPrimitiveInfo> &primiti
             }
             }
 
-            node->InitInterior( dim,
-                                recursiveBuild( primitiveInfo,
-                                                start,
-                                                mid,
-                                                totalNodes,
-                                                orderedPrims ),
-                                recursiveBuild( primitiveInfo,
-                                                mid,
-                                                end,
-                                                totalNodes,
-                                                orderedPrims) );
+            BVHBuildNode *children[2];
+
+            BVHBuildNode *leftNodes  = buildNodes + 1;
+            BVHBuildNode *rightNodes = buildNodes + 2 * (mid - start);
+
+            if( nPrimitives > BVH_PARALLEL_BUILD_MIN_PRIMITIVES )
+            {
+                // Both subtrees work on disjoint ranges of primitiveInfo,
+                // orderedPrims and buildNodes, so they can be built in parallel
+                #pragma omp task shared( primitiveInfo, orderedPrims, children )
+                children[0] = recursiveBuild( primitiveInfo,
+                                              start,
+                                              mid,
+                                              leftNodes,
+                                              totalNodes,
+                                              orderedPrims );
+
+                children[1] = recursiveBuild( primitiveInfo,
+                                              mid,
+                                              end,
+                                              rightNodes,
+                                              totalNodes,
+                                              orderedPrims );
+
+                #pragma omp taskwait
+            }
+            else
+            {
+                children[0] = recursiveBuild( primitiveInfo,
+                                              start,
+                                              mid,
+                                              leftNodes,
+                                              totalNodes,
+                                              orderedPrims );
+
+                children[1] = recursiveBuild( primitiveInfo,
+                                              mid,
+                                              end,
+                                              rightNodes,
+                                              totalNodes,
+                                              orderedPrims );
+            }
+
+            node->InitInterior( dim, children[0], children[1] );
         }
     }
 
@@ -730,6 +835,7 @@ BVHBuildNode *CBVH_PBRT::HLBVHBuild( const std::vector<BVHPrimitiveInfo> &primit
     // Compute Morton indices of primitives
     std::vector<MortonPrimitive> mortonPrims( primitiveInfo.size() );
 
+    #pragma omp parallel for
     for( int i = 0; i < (int)primitiveInfo.size(); ++i )
     {
         // Initialize _mortonPrims[i]_ for _i_th primitive
@@ -758,6 +864,26 @@ BVHBuildNode *CBVH_PBRT::HLBVHBuild( const std::vector<BVHPrimitiveInfo> &primit
     // Find intervals of primitives for each treelet
     std::vector<LBVHTreelet> treeletsToBuild;
 
+    // Each treelet takes 2 * numPrimitives nodes from a single block,
+    // starting at twice the index of its first primitive
+    const int maxBVHNodes = 2 * mortonPrims.size();
+
+    BVHBuildNode *buildNodes = static_cast<BVHBuildNode *>( malloc( maxBVHNodes *
+                                                                    sizeof( BVHBuildNode ) ) );
+
+    m_addresses_pointer_to_mm_free.push_back( buildNodes );
+
+    #pragma omp parallel for
+    for( int i = 0; i < maxBVHNodes; ++i )
+    {
+        buildNodes[i].bounds.Reset();
+        buildNodes[i].firstPrimOffset = 0;
+        buildNodes[i].nPrimitives = 0;
+        buildNodes[i].splitAxis = 0;
+        buildNodes[i].children[0] = NULL;
+        buildNodes[i].children[1] = NULL;
+    }
+
     for( int start = 0, end = 1; end <= (int)mortonPrims.size(); ++end )
     {
         const uint32_t mask = 0b00111111111111000000000000000000;
@@ -767,30 +893,11 @@ BVHBuildNode *CBVH_PBRT::HLBVHBuild( const std::vector<BVHPrimitiveInfo> &primit
               (mortonPrims[end].mortonCode & mask) ) )
         {
             // Add entry to _treeletsToBuild_ for this treelet
-            const int numPrimitives = end - start;
-            const int maxBVHNodes = 2 * numPrimitives;
-
-            // !TODO: implement a memory arena
-            BVHBuildNode *nodes = static_cast<BVHBuildNode *>( malloc( maxBVHNodes *
-                                                                           sizeof( BVHBuildNode ) ) );
-
-            m_addresses_pointer_to_mm_free.push_back( nodes );
-
-            for( int i = 0; i < maxBVHNodes; ++i )
-            {
-                nodes[i].bounds.Reset();
-                nodes[i].firstPrimOffset = 0;
-                nodes[i].nPrimitives = 0;
-                nodes[i].splitAxis = 0;
-                nodes[i].children[0] = NULL;
-                nodes[i].children[1] = NULL;
-            }
-
             LBVHTreelet tmpTreelet;
 
             tmpTreelet.startIndex = start;
-            tmpTreelet.numPrimitives = numPrimitives;
-            tmpTreelet.buildNodes = nodes;
+            tmpTreelet.numPrimitives = end - start;
+            tmpTreelet.buildNodes = &buildNodes[2 * start];
 
             treeletsToBuild.push_back( tmpTreelet );
 
@@ -800,10 +907,10 @@ BVHBuildNode *CBVH_PBRT::HLBVHBuild( const std::vector<BVHPrimitiveInfo> &primit
 
     // Create LBVHs for treelets in parallel
     int atomicTotal = 0;
-    int orderedPrimsOffset = 0;
 
     orderedPrims.resize( m_primitives.size() );
 
+    #pragma omp parallel for schedule(dynamic) reduction(+:atomicTotal)
     for( int index = 0; index < (int)treeletsToBuild.size(); ++index )
     {
         // Generate _index_th LBVH treelet
@@ -814,6 +921,10 @@ BVHBuildNode *CBVH_PBRT::HLBVHBuild( const std::vector<BVHPrimitiveInfo> &primit
 
         wxASSERT( tr.startIndex < (int)mortonPrims.size() );
 
+        // The treelets are sorted by morton code, so the primitives of each
+        // treelet go to the same range in orderedPrims
+        int orderedPrimsOffset = tr.startIndex;
+
         tr.buildNodes = emitLBVH( tr.buildNodes,
                                   primitiveInfo,
                                   &mortonPrims[tr.startIndex],
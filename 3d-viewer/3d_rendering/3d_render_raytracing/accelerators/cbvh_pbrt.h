@@ -125,9 +125,16 @@ public:
 
 private:
 
+    /**
+     * Build the subtree for the primitives in [start, end). The nodes of the
+     * subtree are taken from the buildNodes slice, that must have room for
+     * 2 * (end - start) - 1 nodes. Disjoint ranges use disjoint slices, so
+     * large subtrees are built in parallel.
+     */
     BVHBuildNode *recursiveBuild( std::vector<BVHPrimitiveInfo> &primitiveInfo,
                                   int start,
                                   int end,
+                                  BVHBuildNode *buildNodes,
                                   int *totalNodes,
                                   CONST_VECTOR_OBJECT &orderedPrims );
 
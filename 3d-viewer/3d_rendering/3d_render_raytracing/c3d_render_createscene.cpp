@@ -1199,13 +1199,38 @@ void C3D_RENDER_RAYTRACING::add_3D_vias_and_pads_to_container()
 
 void C3D_RENDER_RAYTRACING::load_3D_models()
 {
+    // Without a cache manager, the model files cannot be resolved
+    if( !m_settings.Get3DCacheManager() )
+        return;
+
+    // Only the models of the displayed modules are added to the scene
+    auto hasDisplayedModels = [&]( const MODULE* aModule )
+    {
+        return (!aModule->Models().empty() ) &&
+               m_settings.ShouldModuleBeDisplayed( (MODULE_ATTR_T)aModule->GetAttributes() );
+    };
+
+    // Load these models in parallel, so the following GetModel calls find
+    // them in the cache
+    std::vector< wxString > modelFiles;
+
+    for( const MODULE* module = m_settings.GetBoard()->m_Modules;
+         module;
+         module = module->Next() )
+    {
+        if( hasDisplayedModels( module ) )
+            for( const S3D_INFO& model : module->Models() )
+                modelFiles.push_back( model.m_Filename );
+    }
+
+    m_settings.Get3DCacheManager()->PreloadModels( modelFiles );
+
     // Go for all modules
     for( const MODULE* module = m_settings.GetBoard()->m_Modules;
          module;
          module = module->Next() )
     {
-        if( (!module->Models().empty() ) &&
-            m_settings.ShouldModuleBeDisplayed( (MODULE_ATTR_T)module->GetAttributes() ) )
+        if( hasDisplayedModels( module ) )
         {
             double zpos = m_settings.GetModulesZcoord3DIU( module->IsFlipped() );
 
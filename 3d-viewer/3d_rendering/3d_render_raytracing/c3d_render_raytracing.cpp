@@ -138,6 +138,14 @@ void C3D_RENDER_RAYTRACING::restart_render_state()
     std::fill( m_blockPositionsWasProcessed.begin(),
                m_blockPositionsWasProcessed.end(),
                false );
+
+    m_blockNeedsRefine.assign( m_blockPositions.size(), 0 );
+    m_blocksToRefine.clear();
+
+    if( m_settings.GetFlag( FL_RENDER_RAYTRACING_ANTI_ALIASING ) )
+        m_pixelSamples.resize( m_blockPositions.size() * RAYPACKET_RAYS_PER_PACKET );
+    else
+        m_pixelSamples.clear();
 }
 
 
@@ -165,6 +173,7 @@ bool C3D_RENDER_RAYTRACING::Redraw( bool aIsMoving, REPORTER *aStatusTextReporte
         // revert to preview mode the first time the Redraw is called
         m_oldWindowsSize = m_windowSize;
         initialize_block_positions();
+        opengl_init_pbo();
     }
 
 
@@ -190,6 +199,7 @@ bool C3D_RENDER_RAYTRACING::Redraw( bool aIsMoving, REPORTER *aStatusTextReporte
         requestRedraw = true;
 
         initialize_block_positions();
+        opengl_init_pbo();
     }
 
 
@@ -297,6 +307,94 @@ bool C3D_RENDER_RAYTRACING::Redraw( bool aIsMoving, REPORTER *aStatusTextReporte
 }
 
 
+void C3D_RENDER_RAYTRACING::RenderToImage( wxImage &aDstImage,
+                                           const wxSize &aSize,
+                                           REPORTER *aStatusTextReporter )
+{
+    wxLogTrace( m_logTrace, wxT( "C3D_RENDER_RAYTRACING::RenderToImage %dx%d" ),
+                aSize.x, aSize.y );
+
+    if( m_reloadRequested )
+    {
+        if( aStatusTextReporter )
+            aStatusTextReporter->Report( _( "Loading..." ) );
+
+        reload( aStatusTextReporter );
+    }
+
+    // Render with the requested size, the canvas size and the block positions
+    // are restored in the end so an interactive view can continue to use it
+    const wxSize canvasWindowSize = m_windowSize;
+
+    CCAMERA &camera = m_settings.CameraGet();
+
+    camera.SetCurWindowSize( aSize );
+
+    m_windowSize = aSize;
+    initialize_block_positions();
+
+    std::vector<GLubyte> rgbaBuffer( m_realBufferSize.x * m_realBufferSize.y * 4, 0 );
+
+    // Trace and post process the full frame, on all the available cores
+    m_rt_render_state = RT_RENDER_STATE_MAX;
+
+    do
+    {
+        render( &rgbaBuffer[0], aStatusTextReporter );
+    } while( m_rt_render_state != RT_RENDER_STATE_FINISH );
+
+    // Compose the final image: the traced buffer is centered on the window, as
+    // it is on the canvas, and the borders are filled with the background
+    aDstImage.Create( aSize.x, aSize.y, false );
+
+    unsigned char *dst = aDstImage.GetData();
+
+    for( int y = 0; y < aSize.y; ++y )
+    {
+        const float t = (aSize.y > 1) ? (float)y / (float)(aSize.y - 1) : 0.0f;
+        const SFVEC3F bgColor = (SFVEC3F)m_settings.m_BgColorTop * (1.0f - t) +
+                                (SFVEC3F)m_settings.m_BgColorBot * t;
+
+        // The traced buffer is stored bottom-up, as OpenGL does
+        const int bufferY = (aSize.y - 1 - y) - (int)m_yoffset;
+
+        for( int x = 0; x < aSize.x; ++x )
+        {
+            const int bufferX = x - (int)m_xoffset;
+
+            if( (bufferX >= 0) && (bufferX < (int)m_realBufferSize.x) &&
+                (bufferY >= 0) && (bufferY < (int)m_realBufferSize.y) )
+            {
+                const GLubyte *src = &rgbaBuffer[ (bufferX + bufferY * m_realBufferSize.x) * 4 ];
+
+                dst[0] = src[0];
+                dst[1] = src[1];
+                dst[2] = src[2];
+            }
+            else
+            {
+                dst[0] = (unsigned char)glm::clamp( (int)(bgColor.r * 255), 0, 255 );
+                dst[1] = (unsigned char)glm::clamp( (int)(bgColor.g * 255), 0, 255 );
+                dst[2] = (unsigned char)glm::clamp( (int)(bgColor.b * 255), 0, 255 );
+            }
+
+            dst += 3;
+        }
+    }
+
+    // Restore the canvas state, the next Redraw will restart the rendering
+    m_windowSize = canvasWindowSize;
+
+    if( m_is_opengl_initialized )
+        initialize_block_positions();
+
+    if( (canvasWindowSize.x > 0) && (canvasWindowSize.y > 0) )
+        camera.SetCurWindowSize( canvasWindowSize );
+
+    m_rt_render_state = RT_RENDER_STATE_MAX;
+}
+
+
 void C3D_RENDER_RAYTRACING::render( GLubyte *ptrPBO , REPORTER *aStatusTextReporter )
 {
     if( (m_rt_render_state == RT_RENDER_STATE_FINISH) ||
@@ -330,6 +428,7 @@ void C3D_RENDER_RAYTRACING::render( GLubyte *ptrPBO , REPORTER *aStatusTextRepor
     switch( m_rt_render_state )
     {
     case RT_RENDER_STATE_TRACING:
+    case RT_RENDER_STATE_REFINING:
             rt_render_tracing( ptrPBO, aStatusTextReporter );
         break;
 
@@ -365,13 +464,18 @@ void C3D_RENDER_RAYTRACING::rt_render_tracing( GLubyte *ptrPBO ,
     m_isPreview = false;
     wxASSERT( m_blockPositions.size() <= LONG_MAX );
 
-    const long nrBlocks = (long) m_blockPositions.size();
+    // The first pass traces all the blocks, the refining pass only the ones
+    // that need more anti-aliasing samples
+    const bool isRefining = m_rt_render_state == RT_RENDER_STATE_REFINING;
+    const long nrBlocks = isRefining ? (long) m_blocksToRefine.size() :
+                                       (long) m_blockPositions.size();
     const unsigned startTime = GetRunningMicroSecs();
     bool breakLoop = false;
     int numBlocksRendered = 0;
 
     #pragma omp parallel for schedule(dynamic) shared(breakLoop) \
-        firstprivate(ptrPBO, nrBlocks, startTime) reduction(+:numBlocksRendered) default(none)
+        firstprivate(ptrPBO, nrBlocks, startTime, isRefining) \
+        reduction(+:numBlocksRendered) default(none)
     for( long iBlock = 0; iBlock < nrBlocks; iBlock++ )
     {
 
@@ -390,7 +494,11 @@ void C3D_RENDER_RAYTRACING::rt_render_tracing( GLubyte *ptrPBO ,
 
             if( process_block )
             {
-                rt_render_trace_block( ptrPBO, iBlock );
+                if( isRefining )
+                    rt_render_refine_block( ptrPBO, m_blocksToRefine[iBlock] );
+                else
+                    rt_render_trace_block( ptrPBO, iBlock );
+
                 numBlocksRendered++;
 
 
@@ -411,21 +519,48 @@ void C3D_RENDER_RAYTRACING::rt_render_tracing( GLubyte *ptrPBO ,
     m_nrBlocksRenderProgress += numBlocksRendered;
 
     if( aStatusTextReporter )
-        aStatusTextReporter->Report( wxString::Format( _( "Rendering: %.0f %%" ),
+        aStatusTextReporter->Report( wxString::Format( isRefining ?
+                                                       _( "Rendering: Refining %.0f %%" ) :
+                                                       _( "Rendering: %.0f %%" ),
                                                        (float)(m_nrBlocksRenderProgress * 100) /
                                                        (float)nrBlocks ) );
 
     // Check if it finish the rendering and if should continue to a post processing
     // or mark it as finished
     if( m_nrBlocksRenderProgress >= nrBlocks )
+        rt_tracing_finished();
+}
+
+
+void C3D_RENDER_RAYTRACING::rt_tracing_finished()
+{
+    // After the first pass, the blocks that did not converge get more
+    // anti-aliasing samples
+    if( m_rt_render_state == RT_RENDER_STATE_TRACING )
     {
-        if( m_settings.GetFlag( FL_RENDER_RAYTRACING_POST_PROCESSING ) )
-            m_rt_render_state = RT_RENDER_STATE_POST_PROCESS_SHADE;
-        else
+        m_blocksToRefine.clear();
+
+        for( long iBlock = 0; iBlock < (long)m_blockNeedsRefine.size(); ++iBlock )
+            if( m_blockNeedsRefine[iBlock] )
+                m_blocksToRefine.push_back( iBlock );
+
+        if( !m_blocksToRefine.empty() )
         {
-            m_rt_render_state = RT_RENDER_STATE_FINISH;
+            m_rt_render_state = RT_RENDER_STATE_REFINING;
+            m_nrBlocksRenderProgress = 0;
+
+            m_blockPositionsWasProcessed.assign( m_blocksToRefine.size(), false );
+
+            return;
         }
     }
+
+    if( m_settings.GetFlag( FL_RENDER_RAYTRACING_POST_PROCESSING ) )
+        m_rt_render_state = RT_RENDER_STATE_POST_PROCESS_SHADE;
+    else
+    {
+        m_rt_render_state = RT_RENDER_STATE_FINISH;
+    }
 }
 
 #ifdef USE_SRGB_SPACE
@@ -488,6 +623,23 @@ void C3D_RENDER_RAYTRACING::rt_final_color( GLubyte *ptrPBO,
 }
 
 
+// Maximum difference, in display color space, of the two first samples of each
+// pixel of a block to consider it converged (so it does not need more samples)
+#define AA_CONVERGENCE_THRESHOLD ( 2.0f / 255.0f )
+
+static inline bool samplesConverged( const SFVEC3F &aColorA, const SFVEC3F &aColorB )
+{
+#ifdef USE_SRGB_SPACE
+    const SFVEC3F diff = glm::abs( convertLinearToSRGB( aColorA ) -
+                                   convertLinearToSRGB( aColorB ) );
+#else
+    const SFVEC3F diff = glm::abs( aColorA - aColorB );
+#endif
+
+    return glm::max( diff.r, glm::max( diff.g, diff.b ) ) <= AA_CONVERGENCE_THRESHOLD;
+}
+
+
 static void HITINFO_PACKET_init( HITINFO_PACKET *aHitPacket )
 {
     // Initialize hitPacket with a "not hit" information
@@ -657,6 +809,86 @@ void C3D_RENDER_RAYTRACING::rt_trace_AA_packet( const SFVEC3F *aBgColorY,
 
 #define DISP_FACTOR 0.075f
 
+void C3D_RENDER_RAYTRACING::rt_trace_AA_samples( const SFVEC3F *aBgColorY,
+                                                 const SFVEC2I &aBlockPosI,
+                                                 const HITINFO_PACKET *aHitPck_X0Y0,
+                                                 const HITINFO_PACKET *aHitPck_AA_X1Y1,
+                                                 const SFVEC3F *aHitColor_AA_X1Y1,
+                                                 SFVEC3F *aInOutHitColor )
+{
+    SFVEC3F hitColor_AA_X1Y0[RAYPACKET_RAYS_PER_PACKET];
+    SFVEC3F hitColor_AA_X0Y1[RAYPACKET_RAYS_PER_PACKET];
+    SFVEC3F hitColor_AA_X0Y1_half[RAYPACKET_RAYS_PER_PACKET];
+
+    for( unsigned int i = 0; i < RAYPACKET_RAYS_PER_PACKET; ++i )
+    {
+        const SFVEC3F color_average = ( aInOutHitColor[i] +
+                                        aHitColor_AA_X1Y1[i] ) * SFVEC3F(0.5f);
+
+        hitColor_AA_X1Y0[i] = color_average;
+        hitColor_AA_X0Y1[i] = color_average;
+        hitColor_AA_X0Y1_half[i] = color_average;
+    }
+
+    RAY blockRayPck_AA_X1Y0[RAYPACKET_RAYS_PER_PACKET];
+    RAY blockRayPck_AA_X0Y1[RAYPACKET_RAYS_PER_PACKET];
+    RAY blockRayPck_AA_X1Y1_half[RAYPACKET_RAYS_PER_PACKET];
+
+    RAYPACKET_InitRays_with2DDisplacement( m_settings.CameraGet(),
+                                           (SFVEC2F)aBlockPosI + SFVEC2F(0.5f - DISP_FACTOR, DISP_FACTOR),
+                                           SFVEC2F(DISP_FACTOR, DISP_FACTOR), // Displacement random factor
+                                           blockRayPck_AA_X1Y0 );
+
+    RAYPACKET_InitRays_with2DDisplacement( m_settings.CameraGet(),
+                                           (SFVEC2F)aBlockPosI + SFVEC2F(DISP_FACTOR, 0.5f - DISP_FACTOR),
+                                           SFVEC2F(DISP_FACTOR, DISP_FACTOR), // Displacement random factor
+                                           blockRayPck_AA_X0Y1 );
+
+    RAYPACKET_InitRays_with2DDisplacement( m_settings.CameraGet(),
+                                           (SFVEC2F)aBlockPosI + SFVEC2F(0.25f - DISP_FACTOR, 0.25f - DISP_FACTOR),
+                                           SFVEC2F(DISP_FACTOR, DISP_FACTOR), // Displacement random factor
+                                           blockRayPck_AA_X1Y1_half );
+
+    rt_trace_AA_packet( aBgColorY,
+                        aHitPck_X0Y0, aHitPck_AA_X1Y1,
+                        blockRayPck_AA_X1Y0,
+                        hitColor_AA_X1Y0 );
+
+    rt_trace_AA_packet( aBgColorY,
+                        aHitPck_X0Y0, aHitPck_AA_X1Y1,
+                        blockRayPck_AA_X0Y1,
+                        hitColor_AA_X0Y1 );
+
+    rt_trace_AA_packet( aBgColorY,
+                        aHitPck_X0Y0, aHitPck_AA_X1Y1,
+                        blockRayPck_AA_X1Y1_half,
+                        hitColor_AA_X0Y1_half );
+
+    // Average the result
+    for( unsigned int i = 0; i < RAYPACKET_RAYS_PER_PACKET; ++i )
+    {
+        aInOutHitColor[i] = ( aInOutHitColor[i] +
+                              aHitColor_AA_X1Y1[i] +
+                              hitColor_AA_X1Y0[i] +
+                              hitColor_AA_X0Y1[i] +
+                              hitColor_AA_X0Y1_half[i]
+                              ) * SFVEC3F(1.0f / 5.0f);
+    }
+}
+
+
+void C3D_RENDER_RAYTRACING::rt_background_colors( int aPosY, SFVEC3F *aOutBgColorY ) const
+{
+    for( unsigned int y = 0; y < RAYPACKET_DIM; ++y )
+    {
+        const float posYfactor = (float)(aPosY + y) / (float)m_windowSize.y;
+
+        aOutBgColorY[y] = m_BgColorTop_LinearRGB * SFVEC3F(posYfactor) +
+                          m_BgColorBot_LinearRGB * ( SFVEC3F(1.0f) - SFVEC3F(posYfactor) );
+    }
+}
+
+
 void C3D_RENDER_RAYTRACING::rt_render_trace_block( GLubyte *ptrPBO ,
                                                    signed int iBlock )
 {
@@ -679,13 +911,7 @@ void C3D_RENDER_RAYTRACING::rt_render_trace_block( GLubyte *ptrPBO ,
     // /////////////////////////////////////////////////////////////////////////
     SFVEC3F bgColor[RAYPACKET_DIM];// Store a vertical gradient color
 
-    for( unsigned int y = 0; y < RAYPACKET_DIM; ++y )
-    {
-        const float posYfactor = (float)(blockPosI.y + y) / (float)m_windowSize.y;
-
-        bgColor[y] = m_BgColorTop_LinearRGB * SFVEC3F(posYfactor) +
-                     m_BgColorBot_LinearRGB * ( SFVEC3F(1.0f) - SFVEC3F(posYfactor) );
-    }
+    rt_background_colors( blockPosI.y, bgColor );
 
     // Intersect ray packets (calculate the intersection with rays and objects)
     // /////////////////////////////////////////////////////////////////////////
@@ -790,64 +1016,25 @@ void C3D_RENDER_RAYTRACING::rt_render_trace_block( GLubyte *ptrPBO ,
                               );
         }
 
-        SFVEC3F hitColor_AA_X1Y0[RAYPACKET_RAYS_PER_PACKET];
-        SFVEC3F hitColor_AA_X0Y1[RAYPACKET_RAYS_PER_PACKET];
-        SFVEC3F hitColor_AA_X0Y1_half[RAYPACKET_RAYS_PER_PACKET];
+        // Keep the first samples. The anti-aliasing is completed on the
+        // refining pass, only for the blocks that did not converge
+        // /////////////////////////////////////////////////////////////////////
+        RT_PIXEL_SAMPLES *samples = &m_pixelSamples[iBlock * RAYPACKET_RAYS_PER_PACKET];
+        bool converged = true;
 
         for( unsigned int i = 0; i < RAYPACKET_RAYS_PER_PACKET; ++i )
         {
-            const SFVEC3F color_average = ( hitColor_X0Y0[i] +
-                                            hitColor_AA_X1Y1[i] ) * SFVEC3F(0.5f);
+            samples[i].m_color_X0Y0    = hitColor_X0Y0[i];
+            samples[i].m_color_AA_X1Y1 = hitColor_AA_X1Y1[i];
+            samples[i].m_node_X0Y0     = hitPacket_X0Y0[i].m_HitInfo.m_acc_node_info;
+            samples[i].m_node_AA_X1Y1  = hitPacket_AA_X1Y1[i].m_HitInfo.m_acc_node_info;
 
-            hitColor_AA_X1Y0[i] = color_average;
-            hitColor_AA_X0Y1[i] = color_average;
-            hitColor_AA_X0Y1_half[i] = color_average;
-        }
+            converged = converged && samplesConverged( hitColor_X0Y0[i], hitColor_AA_X1Y1[i] );
 
-        RAY blockRayPck_AA_X1Y0[RAYPACKET_RAYS_PER_PACKET];
-        RAY blockRayPck_AA_X0Y1[RAYPACKET_RAYS_PER_PACKET];
-        RAY blockRayPck_AA_X1Y1_half[RAYPACKET_RAYS_PER_PACKET];
-
-        RAYPACKET_InitRays_with2DDisplacement( m_settings.CameraGet(),
-                                               (SFVEC2F)blockPosI + SFVEC2F(0.5f - DISP_FACTOR, DISP_FACTOR),
-                                               SFVEC2F(DISP_FACTOR, DISP_FACTOR), // Displacement random factor
-                                               blockRayPck_AA_X1Y0 );
-
-        RAYPACKET_InitRays_with2DDisplacement( m_settings.CameraGet(),
-                                               (SFVEC2F)blockPosI + SFVEC2F(DISP_FACTOR, 0.5f - DISP_FACTOR),
-                                               SFVEC2F(DISP_FACTOR, DISP_FACTOR), // Displacement random factor
-                                               blockRayPck_AA_X0Y1 );
-
-        RAYPACKET_InitRays_with2DDisplacement( m_settings.CameraGet(),
-                                               (SFVEC2F)blockPosI + SFVEC2F(0.25f - DISP_FACTOR, 0.25f - DISP_FACTOR),
-                                               SFVEC2F(DISP_FACTOR, DISP_FACTOR), // Displacement random factor
-                                               blockRayPck_AA_X1Y1_half );
-
-        rt_trace_AA_packet( bgColor,
-                            hitPacket_X0Y0, hitPacket_AA_X1Y1,
-                            blockRayPck_AA_X1Y0,
-                            hitColor_AA_X1Y0 );
-
-        rt_trace_AA_packet( bgColor,
-                            hitPacket_X0Y0, hitPacket_AA_X1Y1,
-                            blockRayPck_AA_X0Y1,
-                            hitColor_AA_X0Y1 );
-
-        rt_trace_AA_packet( bgColor,
-                            hitPacket_X0Y0, hitPacket_AA_X1Y1,
-                            blockRayPck_AA_X1Y1_half,
-                            hitColor_AA_X0Y1_half );
-
-        // Average the result
-        for( unsigned int i = 0; i < RAYPACKET_RAYS_PER_PACKET; ++i )
-        {
-            hitColor_X0Y0[i] = ( hitColor_X0Y0[i] +
-                                 hitColor_AA_X1Y1[i] +
-                                 hitColor_AA_X1Y0[i] +
-                                 hitColor_AA_X0Y1[i] +
-                                 hitColor_AA_X0Y1_half[i]
-                                 ) * SFVEC3F(1.0f / 5.0f);
+            hitColor_X0Y0[i] = ( hitColor_X0Y0[i] + hitColor_AA_X1Y1[i] ) * SFVEC3F(0.5f);
         }
+
+        m_blockNeedsRefine[iBlock] = !converged;
     }
 
 
@@ -914,6 +1101,69 @@ void C3D_RENDER_RAYTRACING::rt_render_trace_block( GLubyte *ptrPBO ,
 }
 
 
+void C3D_RENDER_RAYTRACING::rt_render_refine_block( GLubyte *ptrPBO ,
+                                                    signed int iBlock )
+{
+    const SFVEC2UI &blockPos = m_blockPositions[iBlock];
+    const SFVEC2I blockPosI = SFVEC2I( blockPos.x + m_xoffset,
+                                       blockPos.y + m_yoffset );
+
+    SFVEC3F bgColor[RAYPACKET_DIM];// Store a vertical gradient color
+
+    rt_background_colors( blockPosI.y, bgColor );
+
+    // Restore the samples traced on the first pass. Only the node information
+    // of the hits is needed to trace the new samples
+    // /////////////////////////////////////////////////////////////////////////
+    const RT_PIXEL_SAMPLES *samples = &m_pixelSamples[iBlock * RAYPACKET_RAYS_PER_PACKET];
+
+    HITINFO_PACKET hitPacket_X0Y0[RAYPACKET_RAYS_PER_PACKET];
+    HITINFO_PACKET hitPacket_AA_X1Y1[RAYPACKET_RAYS_PER_PACKET];
+
+    SFVEC3F hitColor_X0Y0[RAYPACKET_RAYS_PER_PACKET];
+    SFVEC3F hitColor_AA_X1Y1[RAYPACKET_RAYS_PER_PACKET];
+
+    for( unsigned int i = 0; i < RAYPACKET_RAYS_PER_PACKET; ++i )
+    {
+        hitPacket_X0Y0[i].m_HitInfo.m_acc_node_info    = samples[i].m_node_X0Y0;
+        hitPacket_AA_X1Y1[i].m_HitInfo.m_acc_node_info = samples[i].m_node_AA_X1Y1;
+
+        hitColor_X0Y0[i]    = samples[i].m_color_X0Y0;
+        hitColor_AA_X1Y1[i] = samples[i].m_color_AA_X1Y1;
+    }
+
+    rt_trace_AA_samples( bgColor, blockPosI,
+                         hitPacket_X0Y0, hitPacket_AA_X1Y1,
+                         hitColor_AA_X1Y1,
+                         hitColor_X0Y0 );
+
+    // Update the colors of the block
+    // /////////////////////////////////////////////////////////////////////////
+    const bool isPostProcessing = m_settings.GetFlag( FL_RENDER_RAYTRACING_POST_PROCESSING );
+
+    GLubyte *ptr = &ptrPBO[ ( blockPos.x +
+                              (blockPos.y * m_realBufferSize.x) ) * 4 ];
+
+    const uint32_t ptrInc = (m_realBufferSize.x - RAYPACKET_DIM) * 4;
+
+    for( unsigned int y = 0, i = 0; y < RAYPACKET_DIM; ++y )
+    {
+        for( unsigned int x = 0; x < RAYPACKET_DIM; ++x, ++i )
+        {
+            if( isPostProcessing )
+                m_postshader_ssao.SetPixelColor( blockPos.x + x,
+                                                 blockPos.y + y,
+                                                 hitColor_X0Y0[i] );
+
+            rt_final_color( ptr, hitColor_X0Y0[i], !isPostProcessing );
+            ptr += 4;
+        }
+
+        ptr += ptrInc;
+    }
+}
+
+
 void C3D_RENDER_RAYTRACING::rt_render_post_process_shade( GLubyte *ptrPBO,
                                                           REPORTER *aStatusTextReporter )
 {
@@ -2136,6 +2386,4 @@ void C3D_RENDER_RAYTRACING::initialize_block_positions()
     // Create m_shader buffer
     delete[] m_shaderBuffer;
     m_shaderBuffer = new SFVEC3F[m_realBufferSize.x * m_realBufferSize.y];
-
-    opengl_init_pbo();
 }
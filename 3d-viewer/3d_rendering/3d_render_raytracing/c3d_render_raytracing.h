@@ -40,6 +40,7 @@
 #include <plugins/3dapi/c3dmodel.h>
 
 #include <map>
+#include <wx/image.h>
 
 /// Vector of materials
 typedef std::vector< CBLINN_PHONG_MATERIAL > MODEL_MATERIALS;
@@ -47,9 +48,20 @@ typedef std::vector< CBLINN_PHONG_MATERIAL > MODEL_MATERIALS;
 /// Maps a S3DMODEL pointer with a created CBLINN_PHONG_MATERIAL vector
 typedef std::map< const S3DMODEL * , MODEL_MATERIALS > MAP_MODEL_MATERIALS;
 
+/// Samples of a pixel traced on the first pass, kept to refine the pixel
+/// if its block did not converge
+struct RT_PIXEL_SAMPLES
+{
+    SFVEC3F      m_color_X0Y0;
+    SFVEC3F      m_color_AA_X1Y1;
+    unsigned int m_node_X0Y0;
+    unsigned int m_node_AA_X1Y1;
+};
+
 typedef enum
 {
     RT_RENDER_STATE_TRACING = 0,
+    RT_RENDER_STATE_REFINING,
     RT_RENDER_STATE_POST_PROCESS_SHADE,
     RT_RENDER_STATE_POST_PROCESS_BLUR_AND_FINISH,
     RT_RENDER_STATE_FINISH,
@@ -69,6 +81,19 @@ public:
 
     int GetWaitForEditingTimeOut() override;
 
+    /**
+     * @brief RenderToImage - Render the full frame, including the post
+     * processing, to an image. It does not use OpenGL, so it can be used
+     * without a canvas or a display (eg: batch renders on a build server).
+     * The camera in use is the one of the settings.
+     * @param aDstImage: the image that will receive the render
+     * @param aSize: the resolution of the image
+     * @param aStatusTextReporter: a pointer to the status progress reporter
+     */
+    void RenderToImage( wxImage &aDstImage,
+                        const wxSize &aSize,
+                        REPORTER *aStatusTextReporter = NULL );
+
 private:
     bool initializeOpenGL();
     void initializeNewWindowSize();
@@ -81,6 +106,9 @@ private:
     void rt_render_post_process_shade( GLubyte *ptrPBO , REPORTER *aStatusTextReporter );
     void rt_render_post_process_blur_finish( GLubyte *ptrPBO , REPORTER *aStatusTextReporter );
     void rt_render_trace_block( GLubyte *ptrPBO , signed int iBlock );
+    void rt_render_refine_block( GLubyte *ptrPBO , signed int iBlock );
+    void rt_tracing_finished();
+    void rt_background_colors( int aPosY, SFVEC3F *aOutBgColorY ) const;
     void rt_final_color( GLubyte *ptrPBO, const SFVEC3F &rgbColor, bool applyColorSpaceConversion );
 
     void rt_shades_packet( const SFVEC3F *bgColorY,
@@ -95,6 +123,13 @@ private:
                              const RAY *aRayPck,
                              SFVEC3F *aOutHitColor );
 
+    void rt_trace_AA_samples( const SFVEC3F *aBgColorY,
+                              const SFVEC2I &aBlockPosI,
+                              const HITINFO_PACKET *aHitPck_X0Y0,
+                              const HITINFO_PACKET *aHitPck_AA_X1Y1,
+                              const SFVEC3F *aHitColor_AA_X1Y1,
+                              SFVEC3F *aInOutHitColor );
+
     // Materials
     void setupMaterials();
 
@@ -167,6 +202,16 @@ private:
     /// this flags if a position was already processed (cleared each new render)
     std::vector< bool > m_blockPositionsWasProcessed;
 
+    /// this flags the blocks that did not converge on the first pass and
+    /// need more anti-aliasing samples (cleared each new render)
+    std::vector< unsigned char > m_blockNeedsRefine;
+
+    /// index of the blocks processed on the refining pass
+    std::vector< long > m_blocksToRefine;
+
+    /// first pass samples of each block, RAYPACKET_RAYS_PER_PACKET per block
+    std::vector< RT_PIXEL_SAMPLES > m_pixelSamples;
+
     /// this encodes the Morton code positions (on fast preview mode)
     std::vector< SFVEC2UI > m_blockPositionsFast;
 
@@ -31,9 +31,6 @@
 #include <stdio.h>
 
 
-COBJECT2D_STATS *COBJECT2D_STATS::s_instance = 0;
-
-
 COBJECT2D::COBJECT2D( OBJECT2D_TYPE aObjType, const BOARD_ITEM &aBoardItem )
     : m_boardItem(aBoardItem)
 {
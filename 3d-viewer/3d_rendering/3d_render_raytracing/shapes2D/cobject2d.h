@@ -139,16 +139,20 @@ public:
         return m_counter[aObjType];
     }
 
-    void AddOne( OBJECT2D_TYPE aObjType ) { m_counter[aObjType]++; }
+    // The 2D objects of the layers are created by several threads
+    void AddOne( OBJECT2D_TYPE aObjType )
+    {
+        #pragma omp atomic
+        m_counter[aObjType]++;
+    }
 
     void PrintStats();
 
     static COBJECT2D_STATS &Instance()
     {
-        if( !s_instance )
-            s_instance = new COBJECT2D_STATS;
+        static COBJECT2D_STATS s_instance;
 
-        return *s_instance;
+        return s_instance;
     }
 
 private:
@@ -159,8 +163,6 @@ private:
 
 private:
     unsigned int m_counter[OBJ2D_MAX];
-
-    static COBJECT2D_STATS *s_instance;
 };
 
 #endif // _COBJECT2D_H_
@@ -107,6 +107,15 @@ void CPOSTSHADER::SetPixelData( unsigned int x,
 }
 
 
+void CPOSTSHADER::SetPixelColor( unsigned int x, unsigned int y, const SFVEC3F &aColor )
+{
+    wxASSERT( x < m_size.x );
+    wxASSERT( y < m_size.y );
+
+    m_color[ x + y * m_size.x ] = aColor;
+}
+
+
 void CPOSTSHADER::destroy_buffers()
 {
     delete[] m_normals;           m_normals = nullptr;
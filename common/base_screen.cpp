@@ -56,6 +56,7 @@ BASE_SCREEN::BASE_SCREEN( KICAD_T aType ) :
 
     m_FlagModified     = false;     // Set when any change is made on board.
     m_FlagSave         = false;     // Used in auto save set when an auto save is required.
+    m_modifyCount      = 0;
 
     SetCurItem( NULL );
 }
@@ -38,6 +38,7 @@
 #include <kicad_string.h>
 #include <convert_basic_shapes_to_polygon.h>
 #include <standalone_printf.h>
+#include <standalone_printf_extra.h>
 
 #include <build_version.h>
 
@@ -46,8 +47,6 @@
 
 GERBER_PLOTTER::GERBER_PLOTTER()
 {
-    workFile  = NULL;
-    finalFile = NULL;
     currentAperture = apertures.end();
     m_apertureAttribute = 0;
 
@@ -101,8 +100,7 @@ void GERBER_PLOTTER::SetGerberCoordinatesFormat( int aResolution, bool aUseInche
 
 void GERBER_PLOTTER::emitDcode( const DPOINT& pt, int dcode )
 {
-
-    standalone_fprintf( outputFile, "X%dY%dD%02d*\n",
+    emitFormatted( "X%dY%dD%02d*\n",
 	    KiROUND( pt.x ), KiROUND( pt.y ), dcode );
 }
 
@@ -114,7 +112,7 @@ void GERBER_PLOTTER::clearNetAttribute()
         return;
 
     // Remove all net attributes from object attributes dictionnary
-    fputs( "%TD*%\n", outputFile );
+    emitText( "%TD*%\n" );
 
     m_objectAttributesDictionnary.clear();
 }
@@ -153,7 +151,7 @@ void GERBER_PLOTTER::formatNetAttribute( GBR_NETLIST_METADATA* aData )
         clearNetAttribute();
 
     if( !short_attribute_string.empty() )
-        fputs( short_attribute_string.c_str(), outputFile );
+        emitText( short_attribute_string.c_str() );
 }
 
 
@@ -161,22 +159,19 @@ bool GERBER_PLOTTER::StartPlot()
 {
     wxASSERT( outputFile );
 
-    finalFile = outputFile;     // the actual gerber file will be created later
-
-    // Create a temporary filename to store gerber file
-    // note tmpfile() does not work under Vista and W7 in user mode
-    m_workFilename = filename + wxT(".tmp");
-    workFile   = wxFopen( m_workFilename, wxT( "wt" ));
-    outputFile = workFile;
-    wxASSERT( outputFile );
-
     if( outputFile == NULL )
         return false;
 
+    // The gerber file is built in memory, and written by EndPlot(), because
+    // the aperture list, known only at the end, must be inserted after the header.
+    // The first chunk of the buffer is the header.
+    m_fileChunks.clear();
+    m_fileChunks.emplace_back();
+
     for( unsigned ii = 0; ii < m_headerExtraLines.GetCount(); ii++ )
     {
         if( ! m_headerExtraLines[ii].IsEmpty() )
-            standalone_fprintf( outputFile, "%s\n", TO_UTF8( m_headerExtraLines[ii] ) );
+            emitFormatted( "%s\n", TO_UTF8( m_headerExtraLines[ii] ) );
     }
 
     // Set coordinate format to 3.6 or 4.5 absolute, leading zero omitted
@@ -185,31 +180,33 @@ bool GERBER_PLOTTER::StartPlot()
     // It is fixed here to 3 (inch) or 4 (mm), but is not actually used
     int leadingDigitCount = m_gerberUnitInch ? 3 : 4;
 
-    standalone_fprintf( outputFile, "%%FSLAX%d%dY%d%d*%%\n",
+    emitFormatted( "%%FSLAX%d%dY%d%d*%%\n",
              leadingDigitCount, m_gerberUnitFmt,
              leadingDigitCount, m_gerberUnitFmt );
-    standalone_fprintf( outputFile,
-             "G04 Gerber Fmt %d.%d, Leading zero omitted, Abs format (unit %s)*\n",
+    emitFormatted( "G04 Gerber Fmt %d.%d, Leading zero omitted, Abs format (unit %s)*\n",
              leadingDigitCount, m_gerberUnitFmt,
              m_gerberUnitInch ? "inch" : "mm" );
 
     wxString Title = creator + wxT( " " ) + GetBuildVersion();
-    standalone_fprintf( outputFile, "G04 Created by KiCad (%s) date %s*\n",
+    emitFormatted( "G04 Created by KiCad (%s) date %s*\n",
              TO_UTF8( Title ), TO_UTF8( DateAndTime() ) );
 
     /* Mass parameter: unit = INCHES/MM */
     if( m_gerberUnitInch )
-        fputs( "%MOIN*%\n", outputFile );
+        emitText( "%MOIN*%\n" );
     else
-        fputs( "%MOMM*%\n", outputFile );
+        emitText( "%MOMM*%\n" );
 
     // Be sure the usual dark polarity is selected:
-    fputs( "%LPD*%\n", outputFile );
+    emitText( "%LPD*%\n" );
 
     // Specify linear interpol (G01):
-    fputs( "G01*\n", outputFile );
+    emitText( "G01*\n" );
+
+    emitText( "G04 APERTURE LIST*\n" );
 
-    fputs( "G04 APERTURE LIST*\n", outputFile );
+    // The body of the file starts in a new chunk
+    newFileChunk();
 
     return true;
 }
@@ -217,38 +214,65 @@ bool GERBER_PLOTTER::StartPlot()
 
 bool GERBER_PLOTTER::EndPlot()
 {
-    char     line[1024];
-    wxString msg;
-
     wxASSERT( outputFile );
 
-    /* Outfile is actually a temporary file i.e. workFile */
-    fputs( "M02*\n", outputFile );
-    fflush( outputFile );
+    emitText( "M02*\n" );
 
-    fclose( workFile );
-    workFile   = wxFopen( m_workFilename, wxT( "rt" ));
-    wxASSERT( workFile );
-    outputFile = finalFile;
+    // Placement of apertures in RS274X, between the header and the body
+    std::string apertureList;
+    writeApertureList( apertureList );
+    apertureList += "G04 APERTURE END LIST*\n";
 
-    // Placement of apertures in RS274X
-    while( fgets( line, 1024, workFile ) )
-    {
-        fputs( line, outputFile );
+    bool success = fwrite( m_fileChunks[0].data(), 1, m_fileChunks[0].size(), outputFile )
+                        == m_fileChunks[0].size();
 
-        if( strcmp( strtok( line, "\n\r" ), "G04 APERTURE LIST*" ) == 0 )
-        {
-            writeApertureList();
-            fputs( "G04 APERTURE END LIST*\n", outputFile );
-        }
+    success = success && fwrite( apertureList.data(), 1, apertureList.size(), outputFile )
+                        == apertureList.size();
+
+    for( unsigned ii = 1; success && ii < m_fileChunks.size(); ii++ )
+    {
+        success = fwrite( m_fileChunks[ii].data(), 1, m_fileChunks[ii].size(), outputFile )
+                        == m_fileChunks[ii].size();
     }
 
-    fclose( workFile );
-    fclose( finalFile );
-    ::wxRemoveFile( m_workFilename );
+    m_fileChunks.clear();
+
+    fclose( outputFile );
     outputFile = 0;
 
-    return true;
+    return success;
+}
+
+
+void GERBER_PLOTTER::emitText( const char* aText )
+{
+    std::string& chunk = m_fileChunks.back();
+
+    chunk += aText;
+
+    if( chunk.size() >= GERBER_FILE_CHUNK_SIZE )
+        newFileChunk();
+}
+
+
+void GERBER_PLOTTER::emitFormatted( const char* aFormat, ... )
+{
+    std::string& chunk = m_fileChunks.back();
+
+    va_list args;
+    va_start( args, aFormat );
+    standalone_vstdstringprintf( &chunk, aFormat, args );
+    va_end( args );
+
+    if( chunk.size() >= GERBER_FILE_CHUNK_SIZE )
+        newFileChunk();
+}
+
+
+void GERBER_PLOTTER::newFileChunk()
+{
+    m_fileChunks.emplace_back();
+    m_fileChunks.back().reserve( GERBER_FILE_CHUNK_SIZE + 1024 );
 }
 
 
@@ -282,28 +306,22 @@ void GERBER_PLOTTER::SetCurrentLineWidth( int width, void* aData )
 std::vector<APERTURE>::iterator GERBER_PLOTTER::getAperture( const wxSize& aSize,
                         APERTURE::APERTURE_TYPE aType, int aApertureAttribute )
 {
-    int last_D_code = 9;
+    APERTURE new_tool;
+    new_tool.m_Size  = aSize;
+    new_tool.m_Type  = aType;
+    new_tool.m_ApertureAttribute = aApertureAttribute;
 
     // Search an existing aperture
-    std::vector<APERTURE>::iterator tool = apertures.begin();
-
-    while( tool != apertures.end() )
-    {
-        last_D_code = tool->m_DCode;
+    auto found = m_apertureIndex.find( new_tool );
 
-        if( (tool->m_Type == aType) && (tool->m_Size == aSize) && (tool->m_ApertureAttribute == aApertureAttribute) )
-            return tool;
-
-        ++tool;
-    }
+    if( found != m_apertureIndex.end() )
+        return apertures.begin() + found->second;
 
     // Allocate a new aperture
-    APERTURE new_tool;
-    new_tool.m_Size  = aSize;
-    new_tool.m_Type  = aType;
+    int last_D_code = apertures.empty() ? FIRST_DCODE_VALUE - 1 : apertures.back().m_DCode;
     new_tool.m_DCode = last_D_code + 1;
-    new_tool.m_ApertureAttribute = aApertureAttribute;
 
+    m_apertureIndex[new_tool] = apertures.size();
     apertures.push_back( new_tool );
 
     return apertures.end() - 1;
@@ -327,14 +345,13 @@ void GERBER_PLOTTER::selectAperture( const wxSize&           aSize,
     {
         // Pick an existing aperture or create a new one
         currentAperture = getAperture( aSize, aType, aApertureAttribute );
-        standalone_fprintf( outputFile, "D%d*\n", currentAperture->m_DCode );
+        emitFormatted( "D%d*\n", currentAperture->m_DCode );
     }
 }
 
 
-void GERBER_PLOTTER::writeApertureList()
+void GERBER_PLOTTER::writeApertureList( std::string& aText )
 {
-    wxASSERT( outputFile );
     char cbuf[1024];
 
     // Init
@@ -351,8 +368,8 @@ void GERBER_PLOTTER::writeApertureList()
         int attribute = tool->m_ApertureAttribute;
 
         if( attribute != m_apertureAttribute )
-            fputs( GBR_APERTURE_METADATA::FormatAttribute(
-                    (GBR_APERTURE_METADATA::GBR_APERTURE_ATTRIB) attribute ).c_str(), outputFile );
+            aText += GBR_APERTURE_METADATA::FormatAttribute(
+                    (GBR_APERTURE_METADATA::GBR_APERTURE_ATTRIB) attribute );
 
         char* text = cbuf + standalone_snprintf( cbuf, sizeof(cbuf), "%%ADD%d", tool->m_DCode );
 
@@ -388,7 +405,7 @@ void GERBER_PLOTTER::writeApertureList()
             break;
         }
 
-        fputs( cbuf, outputFile );
+        aText += cbuf;
 
         m_apertureAttribute = attribute;
 
@@ -396,7 +413,7 @@ void GERBER_PLOTTER::writeApertureList()
         // is to store the last attribute
         if( attribute )
         {
-            fputs( "%TD*%\n", outputFile );
+            aText += "%TD*%\n";
             m_apertureAttribute = 0;
         }
 
@@ -464,17 +481,17 @@ void GERBER_PLOTTER::Arc( const wxPoint& aCenter, double aStAngle, double aEndAn
     DPOINT devEnd = userToDeviceCoordinates( end );
     DPOINT devCenter = userToDeviceCoordinates( aCenter ) - userToDeviceCoordinates( start );
 
-    standalone_fprintf( outputFile, "G75*\n" ); // Multiquadrant mode
+    emitFormatted( "G75*\n" ); // Multiquadrant mode
 
     if( aStAngle < aEndAngle )
-        standalone_fprintf( outputFile, "G03" );
+        emitFormatted( "G03" );
     else
-        standalone_fprintf( outputFile, "G02" );
+        emitFormatted( "G02" );
 
-    standalone_fprintf( outputFile, "X%dY%dI%dJ%dD01*\n",
+    emitFormatted( "X%dY%dI%dJ%dD01*\n",
              KiROUND( devEnd.x ), KiROUND( devEnd.y ),
              KiROUND( devCenter.x ), KiROUND( devCenter.y ) );
-    standalone_fprintf( outputFile, "G01*\n" ); // Back to linear interp.
+    emitFormatted( "G01*\n" ); // Back to linear interp.
 }
 
 
@@ -496,7 +513,7 @@ void GERBER_PLOTTER:: PlotPoly( const std::vector< wxPoint >& aCornerList,
 
     if( aFill )
     {
-        fputs( "G36*\n", outputFile );
+        emitText( "G36*\n" );
 
         MoveTo( aCornerList[0] );
 
@@ -504,7 +521,7 @@ void GERBER_PLOTTER:: PlotPoly( const std::vector< wxPoint >& aCornerList,
             LineTo( aCornerList[ii] );
 
         FinishTo( aCornerList[0] );
-        fputs( "G37*\n", outputFile );
+        emitText( "G37*\n" );
     }
 
     if( aWidth > 0 )
@@ -971,7 +988,7 @@ void GERBER_PLOTTER::Text( const wxPoint& aPos, const COLOR4D aColor,
 void GERBER_PLOTTER::SetLayerPolarity( bool aPositive )
 {
     if( aPositive )
-        standalone_fprintf( outputFile, "%%LPD*%%\n" );
+        emitFormatted( "%%LPD*%%\n" );
     else
-        standalone_fprintf( outputFile, "%%LPC*%%\n" );
+        emitFormatted( "%%LPC*%%\n" );
 }
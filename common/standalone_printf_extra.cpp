@@ -16,7 +16,12 @@ int standalone_stdstringprintf(std::string *s, const char *fmt, ...)
     int ret;
     va_list ap;
     va_start(ap, fmt);
-    ret = standalone_vcbprintf(s, string_out, fmt, ap);
+    ret = standalone_vstdstringprintf(s, fmt, ap);
     va_end(ap);
     return ret;
 }
+
+int standalone_vstdstringprintf(std::string *s, const char *fmt, va_list ap)
+{
+    return standalone_vcbprintf(s, string_out, fmt, ap);
+}
@@ -990,7 +990,9 @@ void VIEW::Clear()
 
     m_nextDrawPriority = 0;
 
-    m_gal->ClearCache();
+    // A view can be used without GAL, only as a spatial index
+    if( m_gal )
+        m_gal->ClearCache();
 }
 
 
@@ -39,6 +39,7 @@
 #include <wx/image.h>
 #include <wx/tipwin.h>
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>   // used only for debug
 #include <ctime>    // used for representation of x axes involving date
@@ -692,53 +693,7 @@ void mpFXY::Plot( wxDC& dc, mpWindow& w )
         }
         else
         {
-            int n = 0;
-            // Old code
-            wxCoord x0  = 0, c0 = 0;
-            bool first  = true;
-
-            while( GetNextXY( x, y ) )
-            {
-                double  px = m_scaleX->TransformToPlot( x );
-                double  py = m_scaleY->TransformToPlot( y );
-
-                if( py >= 0.0 && py <= 1.0 )
-                    n++;
-
-                // printf("py %.1f\n", py);
-
-                wxCoord x1  = w.x2p( px );
-                wxCoord c1  = w.y2p( py );
-
-                // printf("px %.10f py %.10f c1 %d\n", px, py, c1);
-
-                // wxCoord x1 = XScale().X2p(w,x); // (wxCoord) ((x - w.GetPosX()) * w.GetScaleX());
-                // wxCoord c1 = YScale().X2p(w,y); // (wxCoord) ((w.GetPosY() - y) * w.GetScaleY());
-
-                if( first )
-                {
-                    first = false;
-                    x0 = x1; c0 = c1;
-                }
-
-                bool outUp, outDown;
-
-                if( (x1 >= startPx)&&(x0 <= endPx) )
-                {
-                    outDown = (c0 > maxYpx) && (c1 > maxYpx);
-                    outUp = (c0 < minYpx) && (c1 < minYpx);
-
-                    if( !outUp && !outDown )
-                    {
-                        dc.DrawLine( x0, c0, x1, c1 );
-                        // UpdateViewBoundary(x1, c1);
-                    }
-                }
-
-                x0 = x1; c0 = c1;
-            }
-
-            // printf("n %s %d\n", (const char *) m_name.c_str(), n);
+            PlotContinuous( dc, w, startPx, endPx, minYpx, maxYpx );
         }
 
         if( !m_name.IsEmpty() && m_showName )
@@ -784,6 +739,43 @@ void mpFXY::Plot( wxDC& dc, mpWindow& w )
 }
 
 
+void mpFXY::PlotContinuous( wxDC& dc, mpWindow& w, wxCoord startPx, wxCoord endPx,
+                            wxCoord minYpx, wxCoord maxYpx )
+{
+    double x, y;
+    wxCoord x0  = 0, c0 = 0;
+    bool first  = true;
+
+    while( GetNextXY( x, y ) )
+    {
+        double  px = m_scaleX->TransformToPlot( x );
+        double  py = m_scaleY->TransformToPlot( y );
+
+        wxCoord x1  = w.x2p( px );
+        wxCoord c1  = w.y2p( py );
+
+        if( first )
+        {
+            first = false;
+            x0 = x1; c0 = c1;
+        }
+
+        bool outUp, outDown;
+
+        if( (x1 >= startPx)&&(x0 <= endPx) )
+        {
+            outDown = (c0 > maxYpx) && (c1 > maxYpx);
+            outUp = (c0 < minYpx) && (c1 < minYpx);
+
+            if( !outUp && !outDown )
+                dc.DrawLine( x0, c0, x1, c1 );
+        }
+
+        x0 = x1; c0 = c1;
+    }
+}
+
+
 // -----------------------------------------------------------------------------
 // mpProfile implementation
 // -----------------------------------------------------------------------------
@@ -3276,6 +3268,7 @@ mpFXYVector::mpFXYVector( wxString name, int flags ) : mpFXY( name, flags )
     m_maxX  = 1;
     m_minY  = -1;
     m_maxY  = 1;
+    m_sortedX = false;
     m_type  = mpLAYER_PLOT;
 }
 
@@ -3355,6 +3348,8 @@ void mpFXYVector::Clear()
 {
     m_xs.clear();
     m_ys.clear();
+    m_levels.clear();
+    m_sortedX = false;
 }
 
 
@@ -3371,6 +3366,10 @@ void mpFXYVector::SetData( const std::vector<double>& xs, const std::vector<doub
     m_xs    = xs;
     m_ys    = ys;
 
+    // Simulation results are sorted along X, so they can be drawn decimated
+    m_sortedX = std::is_sorted( m_xs.begin(), m_xs.end() );
+    BuildLevels();
+
     // printf("FXYVector::setData %d %d\n", xs.size(), ys.size());
 
     // Update internal variables for the bounding box.
@@ -3414,6 +3413,182 @@ void mpFXYVector::SetData( const std::vector<double>& xs, const std::vector<doub
 }
 
 
+void mpFXYVector::BuildLevels()
+{
+    m_levels.clear();
+
+    // The cache is only used to draw decimated data
+    if( !m_sortedX )
+        return;
+
+    size_t count = 0;
+
+    for( size_t size = m_ys.size(); size > mpLOD_FACTOR;
+         size = ( size + mpLOD_FACTOR - 1 ) / mpLOD_FACTOR )
+        ++count;
+
+    m_levels.resize( count );
+
+    for( size_t level = 0; level < count; ++level )
+    {
+        const std::vector<double>& prevMin = level ? m_levels[level - 1].m_min : m_ys;
+        const std::vector<double>& prevMax = level ? m_levels[level - 1].m_max : m_ys;
+        const size_t prevSize = prevMin.size();
+        const size_t size = ( prevSize + mpLOD_FACTOR - 1 ) / mpLOD_FACTOR;
+
+        std::vector<double>& curMin = m_levels[level].m_min;
+        std::vector<double>& curMax = m_levels[level].m_max;
+        curMin.resize( size );
+        curMax.resize( size );
+
+        for( size_t i = 0; i < size; ++i )
+        {
+            size_t begin = i * mpLOD_FACTOR;
+            size_t end = std::min( begin + mpLOD_FACTOR, prevSize );
+            double minY = prevMin[begin];
+            double maxY = prevMax[begin];
+
+            for( size_t j = begin + 1; j < end; ++j )
+            {
+                minY = std::min( minY, prevMin[j] );
+                maxY = std::max( maxY, prevMax[j] );
+            }
+
+            curMin[i] = minY;
+            curMax[i] = maxY;
+        }
+    }
+}
+
+
+void mpFXYVector::GetRangeMinMax( size_t first, size_t last, double& minY, double& maxY ) const
+{
+    minY = maxY = m_ys[first];
+
+    // Half-open index range in the current level, level 0 being m_ys
+    size_t begin = first, end = last + 1;
+    size_t level = 0;
+
+    auto take = [&]( size_t i )
+    {
+        minY = std::min( minY, level ? m_levels[level - 1].m_min[i] : m_ys[i] );
+        maxY = std::max( maxY, level ? m_levels[level - 1].m_max[i] : m_ys[i] );
+    };
+
+    while( begin < end )
+    {
+        if( level == m_levels.size() )
+        {
+            while( begin < end )
+                take( begin++ );
+
+            break;
+        }
+
+        // Read the items that do not fill a block of the next level at both ends
+        // of the range, the remaining blocks are read from the next level
+        while( begin < end && begin % mpLOD_FACTOR )
+            take( begin++ );
+
+        while( begin < end && end % mpLOD_FACTOR )
+            take( --end );
+
+        begin /= mpLOD_FACTOR;
+        end /= mpLOD_FACTOR;
+        ++level;
+    }
+}
+
+
+void mpFXYVector::PlotContinuous( wxDC& dc, mpWindow& w, wxCoord startPx, wxCoord endPx,
+                                  wxCoord minYpx, wxCoord maxYpx )
+{
+    // X data range displayed in the plot area
+    double xStart = m_scaleX->TransformFromPlot( w.p2x( startPx ) );
+    double xEnd = m_scaleX->TransformFromPlot( w.p2x( endPx + 1 ) );
+
+    if( !m_sortedX || m_xs.empty() || !( xStart < xEnd ) )
+    {
+        mpFXY::PlotContinuous( dc, w, startPx, endPx, minYpx, maxYpx );
+        return;
+    }
+
+    // Visible points, with a point outside on each side, so the locus is drawn up to
+    // the borders of the plot area
+    size_t first = std::lower_bound( m_xs.begin(), m_xs.end(), xStart ) - m_xs.begin();
+    size_t last = std::lower_bound( m_xs.begin() + first, m_xs.end(), xEnd ) - m_xs.begin();
+
+    if( first > 0 )
+        --first;
+
+    if( last < m_xs.size() )
+        ++last;
+
+    auto xPixel = [&]( size_t i ) { return w.x2p( m_scaleX->TransformToPlot( m_xs[i] ) ); };
+    auto yPixel = [&]( double y ) { return w.y2p( m_scaleY->TransformToPlot( y ) ); };
+
+    auto drawLine = [&]( wxCoord x0, wxCoord c0, wxCoord x1, wxCoord c1 )
+    {
+        bool outDown = (c0 > maxYpx) && (c1 > maxYpx);
+        bool outUp = (c0 < minYpx) && (c1 < minYpx);
+
+        if( (x1 >= startPx) && (x0 <= endPx) && !outUp && !outDown )
+            dc.DrawLine( x0, c0, x1, c1 );
+    };
+
+    wxCoord x0 = xPixel( first );
+    wxCoord c0 = yPixel( m_ys[first] );
+
+    // Few points: draw all of them
+    if( last - first <= 2 * (size_t) ( endPx - startPx + 1 ) )
+    {
+        for( size_t i = first + 1; i < last; ++i )
+        {
+            wxCoord x1 = xPixel( i );
+            wxCoord c1 = yPixel( m_ys[i] );
+
+            drawLine( x0, c0, x1, c1 );
+            x0 = x1; c0 = c1;
+        }
+
+        return;
+    }
+
+    // Otherwise draw each pixel column as a vertical line between the extremes of its
+    // points, joined to the previous column by a line from its last point to the
+    // first point of the column
+    size_t i = m_xs[first] < xStart ? first + 1 : first;
+    bool hasPrev = i != first;
+
+    for( wxCoord col = startPx; col <= endPx && i < last; ++col )
+    {
+        double colEnd = m_scaleX->TransformFromPlot( w.p2x( col + 1 ) );
+        size_t end = std::lower_bound( m_xs.begin() + i, m_xs.begin() + last, colEnd )
+                     - m_xs.begin();
+
+        if( end == i )
+            continue;
+
+        double minY, maxY;
+        GetRangeMinMax( i, end - 1, minY, maxY );
+
+        if( hasPrev )
+            drawLine( x0, c0, col, yPixel( m_ys[i] ) );
+
+        drawLine( col, yPixel( minY ), col, yPixel( maxY ) );
+
+        x0 = col;
+        c0 = yPixel( m_ys[end - 1] );
+        hasPrev = true;
+        i = end;
+    }
+
+    // Join the point following the plot area
+    if( i < last && hasPrev )
+        drawLine( x0, c0, xPixel( last - 1 ), yPixel( m_ys[last - 1] ) );
+}
+
+
 // -----------------------------------------------------------------------------
 // mpText - provided by Val Greene
 // -----------------------------------------------------------------------------
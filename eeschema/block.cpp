@@ -62,6 +62,28 @@ static void DrawMovingBlockOutlines( EDA_DRAW_PANEL* aPanel, wxDC* aDC,
                                      const wxPoint& aPosition, bool aErase );
 
 
+/* Return the area covered by the items of aItemsList.  After an edit of these
+ * items, only the items inside the areas before and after the edit need a
+ * dangling ends test.
+ */
+static EDA_RECT getItemsArea( PICKED_ITEMS_LIST& aItemsList )
+{
+    EDA_RECT area;
+
+    for( unsigned ii = 0; ii < aItemsList.GetCount(); ii++ )
+    {
+        EDA_RECT bbox = aItemsList.GetPickedItem( ii )->GetBoundingBox();
+
+        if( ii == 0 )
+            area = bbox;
+        else
+            area.Merge( bbox );
+    }
+
+    return area;
+}
+
+
 int SCH_EDIT_FRAME::BlockCommand( EDA_KEY key )
 {
     int cmd = BLOCK_IDLE;
@@ -222,17 +244,20 @@ bool SCH_EDIT_FRAME::HandleBlockEnd( wxDC* aDC )
 
             if( block->GetCount() )
             {
+                EDA_RECT area = getItemsArea( block->GetItems() );
+
                 // Compute the rotation center and put it on grid:
                 wxPoint rotationPoint = block->Centre();
                 rotationPoint = GetNearestGridPosition( rotationPoint );
                 SetCrossHairPosition( rotationPoint );
                 SaveCopyInUndoList( block->GetItems(), UR_ROTATED, rotationPoint );
                 RotateListOfItems( block->GetItems(), rotationPoint );
+                area.Merge( getItemsArea( block->GetItems() ) );
+                GetScreen()->TestDanglingEnds( area );
                 OnModify();
             }
 
             block->ClearItemsList();
-            GetScreen()->TestDanglingEnds();
             m_canvas->Refresh();
             break;
 
@@ -282,11 +307,13 @@ bool SCH_EDIT_FRAME::HandleBlockEnd( wxDC* aDC )
 
             if( block->GetCount() )
             {
+                EDA_RECT area = getItemsArea( block->GetItems() );
+
                 DeleteItemsInList( m_canvas, block->GetItems() );
+                GetScreen()->TestDanglingEnds( area );
                 OnModify();
             }
             block->ClearItemsList();
-            GetScreen()->TestDanglingEnds();
             m_canvas->Refresh();
             break;
 
@@ -310,15 +337,17 @@ bool SCH_EDIT_FRAME::HandleBlockEnd( wxDC* aDC )
 
             if( block->GetCount() )
             {
+                EDA_RECT area = getItemsArea( block->GetItems() );
+
                 wxPoint move_vector = -GetScreen()->m_BlockLocate.GetLastCursorPosition();
                 copyBlockItems( block->GetItems() );
                 MoveItemsInList( m_blockItems.GetItems(), move_vector );
                 DeleteItemsInList( m_canvas, block->GetItems() );
+                GetScreen()->TestDanglingEnds( area );
                 OnModify();
             }
 
             block->ClearItemsList();
-            GetScreen()->TestDanglingEnds();
             m_canvas->Refresh();
             break;
 
@@ -340,12 +369,15 @@ bool SCH_EDIT_FRAME::HandleBlockEnd( wxDC* aDC )
                 wxPoint mirrorPoint = block->Centre();
                 mirrorPoint = GetNearestGridPosition( mirrorPoint );
                 SetCrossHairPosition( mirrorPoint );
+                EDA_RECT area = getItemsArea( block->GetItems() );
+
                 SaveCopyInUndoList( block->GetItems(), UR_MIRRORED_X, mirrorPoint );
                 MirrorX( block->GetItems(), mirrorPoint );
+                area.Merge( getItemsArea( block->GetItems() ) );
+                GetScreen()->TestDanglingEnds( area );
                 OnModify();
             }
 
-            GetScreen()->TestDanglingEnds();
             m_canvas->Refresh();
             break;
 
@@ -359,12 +391,15 @@ bool SCH_EDIT_FRAME::HandleBlockEnd( wxDC* aDC )
                 wxPoint mirrorPoint = block->Centre();
                 mirrorPoint = GetNearestGridPosition( mirrorPoint );
                 SetCrossHairPosition( mirrorPoint );
+                EDA_RECT area = getItemsArea( block->GetItems() );
+
                 SaveCopyInUndoList( block->GetItems(), UR_MIRRORED_Y, mirrorPoint );
                 MirrorY( block->GetItems(), mirrorPoint );
+                area.Merge( getItemsArea( block->GetItems() ) );
+                GetScreen()->TestDanglingEnds( area );
                 OnModify();
             }
 
-            GetScreen()->TestDanglingEnds();
             m_canvas->Refresh();
             break;
 
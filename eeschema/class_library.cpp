@@ -28,6 +28,8 @@
  */
 
 #include <algorithm>
+#include <set>
+#include <thread>
 #include <fctsys.h>
 #include <kiface_i.h>
 #include <gr_basic.h>
@@ -40,6 +42,7 @@
 #include <config_params.h>
 #include <wildcards_and_files_ext.h>
 #include <project_rescue.h>
+#include <sync_queue.h>
 #include <properties.h>
 
 #include <general.h>
@@ -161,6 +164,16 @@ void PART_LIB::GetAliases( std::vector<LIB_ALIAS*>& aAliases )
     std::sort( aAliases.begin(), aAliases.end(),
             [](LIB_ALIAS *lhs, LIB_ALIAS *rhs) -> bool
                 { return lhs->GetName() < rhs->GetName(); });
+
+    // Parts are loaded on demand by the plugin: set the library of the parts loaded here,
+    // as FindAlias() does.
+    for( size_t ii = 0; ii < aAliases.size(); ii++ )
+    {
+        LIB_PART* part = aAliases[ii]->GetPart();
+
+        if( part && !part->GetLib() )
+            part->SetLib( this );
+    }
 }
 
 
@@ -168,7 +181,7 @@ void PART_LIB::GetEntryTypePowerNames( wxArrayString& aNames )
 {
     std::vector<LIB_ALIAS*> aliases;
 
-    m_plugin->EnumerateSymbolLib( aliases, fileName.GetFullPath() );
+    GetAliases( aliases );
 
     for( size_t i = 0;  i < aliases.size();  i++ )
     {
@@ -216,7 +229,7 @@ bool PART_LIB::HasPowerParts()
     // return true if at least one power part is found in lib
     std::vector<LIB_ALIAS*> aliases;
 
-    m_plugin->EnumerateSymbolLib( aliases, fileName.GetFullPath(), m_properties.get() );
+    GetAliases( aliases );
 
     for( size_t i = 0;  i < aliases.size();  i++ )
     {
@@ -287,20 +300,11 @@ PART_LIB* PART_LIB::LoadLibrary( const wxString& aFileName )
 {
     std::unique_ptr<PART_LIB> lib( new PART_LIB( LIBRARY_TYPE_EESCHEMA, aFileName ) );
 
-    std::vector<LIB_ALIAS*> aliases;
-    // This loads the library.
-    lib->GetAliases( aliases );
-
-    // Now, set the LIB_PART m_library member but it will only be used
-    // when loading legacy libraries in the future. Once the symbols in the
-    // schematic have a full #LIB_ID, this will not get called.
-    for( size_t ii = 0; ii < aliases.size(); ii++ )
-    {
-        LIB_ALIAS* alias = aliases[ii];
+    wxArrayString names;
 
-        if( alias->GetPart() )
-            alias->GetPart()->SetLib( lib.get() );
-    }
+    // This loads the library index.  The parts are only read when they are used, and
+    // their m_library member is set then by FindAlias() or GetAliases().
+    lib->GetAliasNames( names );
 
     PART_LIB* ret = lib.release();
     return ret;
@@ -460,7 +464,7 @@ void PART_LIBS::FindLibraryNearEntries( std::vector<LIB_ALIAS*>& aCandidates,
 }
 
 
-int PART_LIBS::s_modify_generation = 1;     // starts at 1 and goes up
+std::atomic<int> PART_LIBS::s_modify_generation( 1 );     // starts at 1 and goes up
 
 
 int PART_LIBS::GetModifyHash()
@@ -570,26 +574,12 @@ void PART_LIBS::LoadAllLibraries( PROJECT* aProject, bool aShowProgress )
 
     wxASSERT( !size() );    // expect to load into "this" empty container.
 
-    wxProgressDialog lib_dialog( _( "Loading Symbol Libraries" ),
-                                 wxEmptyString,
-                                 lib_names.GetCount(),
-                                 NULL,
-                                 wxPD_APP_MODAL );
-
-    if( aShowProgress )
-    {
-        lib_dialog.Show();
-    }
-
-    wxString progress_message;
+    // Find the library files first: only the parsing is done by the worker threads.
+    std::vector<wxString> lib_files;
+    std::set<wxString>    lib_file_names;
 
     for( unsigned i = 0; i < lib_names.GetCount();  ++i )
     {
-        if( aShowProgress )
-        {
-            lib_dialog.Update( i, _( "Loading " + lib_names[i] ) );
-        }
-
         // lib_names[] does not store the file extension. Set it.
         // Remember lib_names[i] can contain a '.' in name, so using a wxFileName
         // before adding the extension can create incorrect full filename
@@ -623,15 +613,83 @@ void PART_LIBS::LoadAllLibraries( PROJECT* aProject, bool aShowProgress )
             filename = fn.GetFullPath();
         }
 
-        try
+        // Don't load the library twice: as in AddLibrary(), libraries are known by name.
+        if( !lib_file_names.insert( wxFileName( filename ).GetName() ).second )
+            continue;
+
+        lib_files.push_back( filename );
+    }
+
+    std::vector<std::unique_ptr<PART_LIB>> loaded_libs( lib_files.size() );
+    std::vector<wxString>                  load_errors( lib_files.size() );
+    SYNC_QUEUE<size_t>                     queue;
+    std::atomic<size_t>                    count_finished( 0 );
+    std::vector<std::thread>               threads;
+
+    for( size_t i = 0; i < lib_files.size(); ++i )
+        queue.push( i );
+
+    size_t thread_count = std::min<size_t>( lib_files.size(),
+                                            std::max( 1u, std::thread::hardware_concurrency() ) );
+
+    for( size_t i = 0; i < thread_count; ++i )
+    {
+        threads.push_back( std::thread( [&]() {
+            size_t idx;
+
+            while( queue.pop( idx ) )
+            {
+                try
+                {
+                    loaded_libs[idx].reset( PART_LIB::LoadLibrary( lib_files[idx] ) );
+                }
+                catch( const IO_ERROR& ioe )
+                {
+                    load_errors[idx] = ioe.What();
+                }
+                catch( const std::exception& se )
+                {
+                    // An exception cannot leave a thread: report it as a load error.
+                    load_errors[idx] = FROM_UTF8( se.what() );
+                }
+
+                count_finished.fetch_add( 1 );
+            }
+        } ) );
+    }
+
+    wxProgressDialog lib_dialog( _( "Loading Symbol Libraries" ),
+                                 wxEmptyString,
+                                 std::max<int>( lib_files.size(), 1 ),
+                                 NULL,
+                                 wxPD_APP_MODAL );
+
+    if( aShowProgress )
+    {
+        lib_dialog.Show();
+
+        while( count_finished.load() < lib_files.size() )
         {
-            AddLibrary( filename );
+            lib_dialog.Update( count_finished.load() );
+            wxMilliSleep( 20 );
         }
-        catch( const IO_ERROR& ioe )
+    }
+
+    for( std::thread& thread : threads )
+        thread.join();
+
+    // Publish the libraries in the project order, and report errors in the same order.
+    for( size_t i = 0; i < lib_files.size(); ++i )
+    {
+        if( loaded_libs[i] )
+        {
+            push_back( loaded_libs[i].release() );
+        }
+        else
         {
             wxString msg;
             msg.Printf( _( "Part library '%s' failed to load. Error:\n %s" ),
-                        GetChars( filename ), GetChars( ioe.What() ) );
+                        GetChars( lib_files[i] ), GetChars( load_errors[i] ) );
 
             wxLogError( msg );
         }
@@ -39,6 +39,7 @@
 #include <project.h>
 
 #include <map>
+#include <atomic>
 
 class LIB_ID;
 class LINE_READER;
@@ -193,7 +194,8 @@ class PART_LIBS : public PART_LIBS_BASE, public PROJECT::_ELEM
 {
 public:
 
-    static int s_modify_generation;     ///< helper for GetModifyHash()
+    /// helper for GetModifyHash(). Atomic: libraries are loaded by several threads.
+    static std::atomic<int> s_modify_generation;
 
     PART_LIBS()
     {
@@ -228,6 +230,11 @@ public:
      * Function LoadAllLibraries
      * loads all of the project's libraries into this container, which should
      * be cleared before calling it.
+     * <p>
+     * Libraries are independent, so they are parsed concurrently, each one into its own
+     * PART_LIB.  They are added to this container only when all of them are loaded, in
+     * the project order, which gives the priority of libraries when looking for a part.
+     * </p>
      */
     void LoadAllLibraries( PROJECT* aProject, bool aShowProgress=true );
 
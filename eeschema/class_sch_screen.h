@@ -38,9 +38,13 @@
 #include <class_page_info.h>
 #include <kiway_player.h>
 #include <sch_marker.h>
+#include <geometry/rtree.h>
 
 #include <../eeschema/general.h>
 
+#include <unordered_map>
+#include <vector>
+
 
 class LIB_PIN;
 class SCH_COMPONENT;
@@ -85,6 +89,61 @@ private:
     int     m_modification_sync;        ///< inequality with PART_LIBS::GetModificationHash()
                                         ///< will trigger ResolveAll().
 
+    typedef RTree<SCH_ITEM*, int, 2, float> ITEMS_RTREE;
+
+    /// Area and draw list rank of an item stored in #m_itemsIndex
+    struct INDEXED_ITEM
+    {
+        EDA_RECT m_area;
+        unsigned m_rank;
+    };
+
+    mutable ITEMS_RTREE m_itemsIndex;           ///< spatial index of m_drawList items
+    mutable std::unordered_map<const SCH_ITEM*, INDEXED_ITEM> m_indexedItems;
+    mutable bool        m_itemsIndexValid;      ///< false until m_itemsIndex is built
+    mutable unsigned    m_itemsIndexNextRank;   ///< rank given to the next appended item
+    mutable unsigned    m_itemsIndexModifyCount; ///< GetModifyCount() when the index was built
+
+    /**
+     * Function clearItemsIndex
+     * empties the spatial index and marks it as not built.
+     */
+    void clearItemsIndex() const;
+
+    /**
+     * Function addToItemsIndex
+     * adds \a aItem to the spatial index, if the index is built.  The item must be the
+     * last one of the draw list.
+     */
+    void addToItemsIndex( SCH_ITEM* aItem ) const;
+
+    /**
+     * Function removeFromItemsIndex
+     * removes \a aItem from the spatial index, if the index is built.  The area stored
+     * when the item was indexed is used, so the item can be removed after a move.
+     */
+    void removeFromItemsIndex( SCH_ITEM* aItem ) const;
+
+    /**
+     * Function queryItems
+     * finds the items which can be hit at \a aPosition, using the spatial index which is
+     * built on the first call after a change of the draw list or after SetModify().
+     * <p>
+     * The area of an item in the index includes its bounding box, its connection points
+     * and the pins of sheets, so every item passing HitTest(), IsConnected() or a pin
+     * test at \a aPosition is found.  Callers still have to run these tests.
+     * </p><p>
+     * The current item is always returned when it is in the draw list, because it may be
+     * moving and not be where it was indexed.
+     * </p>
+     * @param aPosition is the position to test.
+     * @param aAccuracy is the hit test accuracy.
+     * @param aItems receives the items found.  The whole vector is sorted in the draw
+     *               list order.
+     */
+    void queryItems( const wxPoint& aPosition, int aAccuracy,
+                     std::vector< SCH_ITEM* >& aItems ) const;
+
     /**
      * Function addConnectedItemsToBlock
      * add items connected at \a aPosition to the block pick list.
@@ -140,6 +199,7 @@ public:
     void Append( SCH_ITEM* aItem )
     {
         m_drawList.Append( aItem );
+        addToItemsIndex( aItem );
         --m_modification_sync;
     }
 
@@ -152,9 +212,19 @@ public:
     void Append( DLIST< SCH_ITEM >& aList )
     {
         m_drawList.Append( aList );
+        InvalidateItemsIndex();
         --m_modification_sync;
     }
 
+    /**
+     * Function InvalidateItemsIndex
+     * discards the spatial index used to find items by position.  It is rebuilt on the
+     * next search.  SetModify() has the same effect, this must be called when the
+     * geometry of items is changed without SetModify(): items only tell the screen when
+     * they are added or removed.
+     */
+    void InvalidateItemsIndex()    { clearItemsIndex(); }
+
     /**
      * Function GetCurItem
      * returns the currently selected SCH_ITEM, overriding BASE_SCREEN::GetCurItem().
@@ -267,6 +337,17 @@ public:
      */
     bool TestDanglingEnds();
 
+    /**
+     * Function TestDanglingEnds
+     * tests the connectible objects inside an area for unused connection points.
+     * Use it after an edit when the area covering the edited items before and after
+     * the edit is known: only the objects with a connection point inside this area
+     * can have their state changed.
+     * @param aArea is the area to test.
+     * @return True if any connection state changes were made.
+     */
+    bool TestDanglingEnds( const EDA_RECT& aArea );
+
     /**
      * Function ExtractWires
      * extracts the old wires, junctions and buses.  If \a aCreateCopy is true, replace
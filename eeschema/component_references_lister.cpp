@@ -31,6 +31,8 @@
 
 #include <wx/regex.h>
 #include <algorithm>
+#include <set>
+#include <tuple>
 #include <vector>
 
 #include <fctsys.h>
@@ -40,9 +42,6 @@
 #include <sch_component.h>
 
 
-//#define USE_OLD_ALGO
-
-
 void SCH_REFERENCE_LIST::RemoveItem( unsigned int aIndex )
 {
     if( aIndex < componentFlatList.size() )
@@ -283,6 +282,325 @@ int SCH_REFERENCE_LIST::CreateFirstFreeRefId( std::vector<int>& aIdList, int aFi
 }
 
 
+/**
+ * Class ANNOTATION_STATE
+ * indexes the references being annotated, so that SCH_REFERENCE_LIST::Annotate() finds
+ * free reference numbers, units in use and components to annotate without scanning the
+ * whole list for each component.  All the changes of the annotation of the references
+ * must be done by SetAnnotation() to keep the indexes up to date.
+ */
+class SCH_REFERENCE_LIST::ANNOTATION_STATE
+{
+public:
+    ANNOTATION_STATE( std::vector<SCH_REFERENCE>& aList,
+                      SCH_MULTI_UNIT_REFERENCE_MAP& aLockedUnitMap ) :
+        m_list( aList )
+    {
+        for( size_t ii = 0; ii < m_list.size(); ii++ )
+            add( ii );
+
+        // Keep the first list of an instance, as the search of all the lists would find.
+        for( SCH_MULTI_UNIT_REFERENCE_MAP::value_type& pair : aLockedUnitMap )
+        {
+            for( unsigned jj = 0; jj < pair.second.GetCount(); jj++ )
+                m_lockedLists.insert( std::make_pair( instance( pair.second[jj] ), &pair.second ) );
+        }
+
+        if( !m_lockedLists.empty() )
+        {
+            for( size_t ii = 0; ii < m_list.size(); ii++ )
+                m_instances[ instance( m_list[ii] ) ].push_back( ii );
+        }
+    }
+
+    /**
+     * Function ApplyFreedNumbers
+     * makes the reference numbers no longer used since the previous call available to
+     * CreateFirstFreeRefId().  Called for each new reference prefix, where the list of
+     * numbers in use was built again.
+     */
+    void ApplyFreedNumbers()
+    {
+        for( const std::pair<std::string, int>& freed : m_freedNumbers )
+        {
+            NUMBERS& numbers = m_numbers[ freed.first ];
+
+            if( !numbers.m_count.count( freed.second ) )
+                removeRange( numbers.m_ranges, freed.second );
+        }
+
+        m_freedNumbers.clear();
+    }
+
+    /**
+     * Function CreateFirstFreeRefId
+     * @return the first number not in use for the reference prefix of \a aIndex, greater
+     * than or equal to \a aFirstValue.
+     */
+    int CreateFirstFreeRefId( size_t aIndex, int aFirstValue )
+    {
+        const RANGES& ranges = m_numbers[ m_list[aIndex].m_Ref ].m_ranges;
+        RANGES::const_iterator it = ranges.upper_bound( aFirstValue );
+
+        if( it == ranges.begin() )
+            return aFirstValue;
+
+        --it;
+
+        return ( aFirstValue <= it->second ) ? it->second + 1 : aFirstValue;
+    }
+
+    /**
+     * Function HasUnit
+     * @return true if another annotated reference with the same reference as \a aIndex
+     * uses the unit \a aUnit (see FindUnit()).
+     */
+    bool HasUnit( size_t aIndex, int aUnit ) const
+    {
+        const SCH_REFERENCE& ref = m_list[aIndex];
+        auto units = m_units.find( std::make_pair( std::string( ref.m_Ref ), ref.m_NumRef ) );
+
+        return units != m_units.end() && units->second.count( aUnit );
+    }
+
+    /**
+     * Function FindNewUnit
+     * @return the index of the first reference after \a aIndex, with the same prefix, value
+     * and library symbol, not annotated yet, which can be used as unit \a aUnit, or -1.
+     */
+    int FindNewUnit( size_t aIndex, int aUnit )
+    {
+        auto candidates = m_candidates.find( candidateKey( m_list[aIndex] ) );
+
+        if( candidates == m_candidates.end() )
+            return -1;
+
+        for( auto it = candidates->second.upper_bound( aIndex );
+             it != candidates->second.end(); ++it )
+        {
+            if( !m_list[*it].IsUnitsLocked() || m_list[*it].m_Unit == aUnit )
+                return (int) *it;
+        }
+
+        return -1;
+    }
+
+    /**
+     * Function FindLockedList
+     * @return the list of locked units containing the instance of \a aIndex, or NULL.
+     */
+    SCH_REFERENCE_LIST* FindLockedList( size_t aIndex ) const
+    {
+        if( m_lockedLists.empty() )
+            return NULL;
+
+        auto it = m_lockedLists.find( instance( m_list[aIndex] ) );
+
+        return ( it != m_lockedLists.end() ) ? it->second : NULL;
+    }
+
+    /**
+     * Function FindInstance
+     * @return the index of the first reference after \a aIndex of the same instance as
+     * \a aRef, or -1.
+     */
+    int FindInstance( const SCH_REFERENCE& aRef, size_t aIndex ) const
+    {
+        auto indexes = m_instances.find( instance( aRef ) );
+
+        if( indexes == m_instances.end() )
+            return -1;
+
+        auto it = std::upper_bound( indexes->second.begin(), indexes->second.end(), aIndex );
+
+        return ( it != indexes->second.end() ) ? (int) *it : -1;
+    }
+
+    /**
+     * Function SetAnnotation
+     * changes the annotation of the reference \a aIndex.
+     */
+    void SetAnnotation( size_t aIndex, int aNumRef, int aUnit, bool aIsNew, int aFlag )
+    {
+        SCH_REFERENCE& ref = m_list[aIndex];
+
+        remove( aIndex, ref.m_NumRef != aNumRef );
+
+        ref.m_Unit   = aUnit;
+        ref.m_IsNew  = aIsNew;
+        ref.m_Flag   = aFlag;
+
+        if( ref.m_NumRef != aNumRef )
+        {
+            ref.m_NumRef = aNumRef;
+            addNumber( ref.m_Ref, aNumRef );
+        }
+
+        add( aIndex, false );
+    }
+
+private:
+    /// Ranges of consecutive numbers in use: first number -> last number.
+    typedef std::map<int, int> RANGES;
+
+    /// The reference numbers in use for a reference prefix.
+    struct NUMBERS
+    {
+        std::map<int, int>  m_count;    ///< The number of references using each number.
+        RANGES              m_ranges;   ///< The numbers in use, or freed but not applied.
+    };
+
+    typedef std::tuple<std::string, wxString, std::string>  CANDIDATE_KEY;
+    typedef std::pair<SCH_COMPONENT*, wxString>             INSTANCE_KEY;
+
+    std::vector<SCH_REFERENCE>&                     m_list;
+
+    /// Numbers in use by reference prefix, and the numbers no longer used.
+    std::map<std::string, NUMBERS>                  m_numbers;
+    std::vector<std::pair<std::string, int>>        m_freedNumbers;
+
+    /// Units of the annotated references, by reference prefix and number: unit -> count.
+    std::map<std::pair<std::string, int>, std::map<int, int>> m_units;
+
+    /// References not annotated yet and not flagged, by prefix, value and symbol name.
+    std::map<CANDIDATE_KEY, std::set<size_t>>       m_candidates;
+
+    std::map<INSTANCE_KEY, SCH_REFERENCE_LIST*>     m_lockedLists;
+    std::map<INSTANCE_KEY, std::vector<size_t>>     m_instances;
+
+    static CANDIDATE_KEY candidateKey( const SCH_REFERENCE& aRef )
+    {
+        return CANDIDATE_KEY( aRef.m_Ref, aRef.m_Value->GetText(),
+                              aRef.m_RootCmp->GetLibId().GetLibItemName() );
+    }
+
+    static INSTANCE_KEY instance( const SCH_REFERENCE& aRef )
+    {
+        return INSTANCE_KEY( aRef.GetComp(), aRef.GetSheetPath().Path() );
+    }
+
+    void add( size_t aIndex, bool aWithNumber = true )
+    {
+        const SCH_REFERENCE& ref = m_list[aIndex];
+
+        if( aWithNumber )
+            addNumber( ref.m_Ref, ref.m_NumRef );
+
+        if( !ref.m_IsNew )
+            m_units[ std::make_pair( std::string( ref.m_Ref ), ref.m_NumRef ) ][ ref.m_Unit ]++;
+        else if( !ref.m_Flag )
+            m_candidates[ candidateKey( ref ) ].insert( aIndex );
+    }
+
+    void remove( size_t aIndex, bool aWithNumber )
+    {
+        const SCH_REFERENCE& ref = m_list[aIndex];
+
+        if( aWithNumber && ref.m_NumRef >= 1 )
+        {
+            std::map<int, int>& count = m_numbers[ ref.m_Ref ].m_count;
+
+            // The list of numbers in use is only built again for the next reference
+            // prefix: the number is not free until then.
+            if( --count[ ref.m_NumRef ] == 0 )
+            {
+                count.erase( ref.m_NumRef );
+                m_freedNumbers.push_back( std::make_pair( std::string( ref.m_Ref ),
+                                                          ref.m_NumRef ) );
+            }
+        }
+
+        if( !ref.m_IsNew )
+        {
+            auto units = m_units.find( std::make_pair( std::string( ref.m_Ref ),
+                                                       ref.m_NumRef ) );
+
+            if( units != m_units.end() && --units->second[ ref.m_Unit ] == 0 )
+                units->second.erase( ref.m_Unit );
+        }
+        else if( !ref.m_Flag )
+        {
+            m_candidates[ candidateKey( ref ) ].erase( aIndex );
+        }
+    }
+
+    void addNumber( const std::string& aPrefix, int aNumber )
+    {
+        // Numbers lower than 1 are never used by the annotation.
+        if( aNumber < 1 )
+            return;
+
+        NUMBERS& numbers = m_numbers[ aPrefix ];
+
+        if( numbers.m_count[ aNumber ]++ == 0 )
+            addRange( numbers.m_ranges, aNumber );
+    }
+
+    static void addRange( RANGES& aRanges, int aNumber )
+    {
+        RANGES::iterator next = aRanges.upper_bound( aNumber );
+        RANGES::iterator prev = next;
+
+        if( prev != aRanges.begin() )
+        {
+            --prev;
+
+            if( aNumber <= prev->second )   // Freed, but not applied yet.
+                return;
+
+            if( prev->second == aNumber - 1 )
+            {
+                prev->second = aNumber;
+
+                if( next != aRanges.end() && next->first == aNumber + 1 )
+                {
+                    prev->second = next->second;
+                    aRanges.erase( next );
+                }
+
+                return;
+            }
+        }
+
+        if( next != aRanges.end() && next->first == aNumber + 1 )
+        {
+            int last = next->second;
+
+            aRanges.erase( next );
+            aRanges[ aNumber ] = last;
+        }
+        else
+        {
+            aRanges[ aNumber ] = aNumber;
+        }
+    }
+
+    static void removeRange( RANGES& aRanges, int aNumber )
+    {
+        RANGES::iterator it = aRanges.upper_bound( aNumber );
+
+        if( it == aRanges.begin() )
+            return;
+
+        --it;
+
+        if( aNumber > it->second )
+            return;
+
+        int first = it->first;
+        int last = it->second;
+
+        aRanges.erase( it );
+
+        if( first < aNumber )
+            aRanges[ first ] = aNumber - 1;
+
+        if( aNumber < last )
+            aRanges[ aNumber + 1 ] = last;
+    }
+};
+
+
 void SCH_REFERENCE_LIST::Annotate( bool aUseSheetNum, int aSheetIntervalId,
       SCH_MULTI_UNIT_REFERENCE_MAP aLockedUnitMap )
 {
@@ -295,6 +613,10 @@ void SCH_REFERENCE_LIST::Annotate( bool aUseSheetNum, int aSheetIntervalId,
     // Components with an invisible reference (power...) always are re-annotated.
     ResetHiddenReferences();
 
+    // The reference numbers and units in use are indexed once, and kept up to date
+    // while annotating, instead of being searched for each component.
+    ANNOTATION_STATE state( componentFlatList, aLockedUnitMap );
+
     /* calculate index of the first component with the same reference prefix
      * than the current component.  All components having the same reference
      * prefix will receive a reference number with consecutive values:
@@ -302,111 +624,59 @@ void SCH_REFERENCE_LIST::Annotate( bool aUseSheetNum, int aSheetIntervalId,
      */
     unsigned first = 0;
 
-    // calculate the last used number for this reference prefix:
-#ifdef USE_OLD_ALGO
-    int minRefId = 0;
-
-    // when using sheet number, ensure ref number >= sheet number* aSheetIntervalId
-    if( aUseSheetNum )
-        minRefId = componentFlatList[first].m_SheetNum * aSheetIntervalId;
-
-    LastReferenceNumber = GetLastReference( first, minRefId );
-#else
     int minRefId = 1;
 
     // when using sheet number, ensure ref number >= sheet number* aSheetIntervalId
     if( aUseSheetNum )
         minRefId = componentFlatList[first].m_SheetNum * aSheetIntervalId + 1;
 
-    // This is the list of all Id already in use for a given reference prefix.
-    // Will be refilled for each new reference prefix.
-    std::vector<int>idList;
-    GetRefsInUse( first, idList, minRefId );
-#endif
     for( unsigned ii = 0; ii < componentFlatList.size(); ii++ )
     {
-        if( componentFlatList[ii].m_Flag )
-            continue;
+        SCH_REFERENCE& ref = componentFlatList[ii];
 
-        // Check whether this component is in aLockedUnitMap.
-        SCH_REFERENCE_LIST* lockedList = NULL;
-        for( SCH_MULTI_UNIT_REFERENCE_MAP::value_type& pair : aLockedUnitMap )
-        {
-            unsigned n_refs = pair.second.GetCount();
-            for( unsigned thisRefI = 0; thisRefI < n_refs; ++thisRefI )
-            {
-                SCH_REFERENCE &thisRef = pair.second[thisRefI];
-
-                if( thisRef.IsSameInstance( componentFlatList[ii] ) )
-                {
-                    lockedList = &pair.second;
-                    break;
-                }
-            }
-            if( lockedList != NULL ) break;
-        }
+        if( ref.m_Flag )
+            continue;
 
-        if(  ( componentFlatList[first].CompareRef( componentFlatList[ii] ) != 0 )
-          || ( aUseSheetNum && ( componentFlatList[first].m_SheetNum != componentFlatList[ii].m_SheetNum ) )  )
+        if(  ( componentFlatList[first].CompareRef( ref ) != 0 )
+          || ( aUseSheetNum && ( componentFlatList[first].m_SheetNum != ref.m_SheetNum ) )  )
         {
             // New reference found: we need a new ref number for this reference
             first = ii;
-#ifdef USE_OLD_ALGO
-            minRefId = 0;
-
-            // when using sheet number, ensure ref number >= sheet number* aSheetIntervalId
-            if( aUseSheetNum )
-                minRefId = componentFlatList[ii].m_SheetNum * aSheetIntervalId;
-
-            LastReferenceNumber = componentFlatList.GetLastReference( ii, minRefId );
-#else
             minRefId = 1;
 
             // when using sheet number, ensure ref number >= sheet number* aSheetIntervalId
             if( aUseSheetNum )
-                minRefId = componentFlatList[ii].m_SheetNum * aSheetIntervalId + 1;
+                minRefId = ref.m_SheetNum * aSheetIntervalId + 1;
 
-            GetRefsInUse( first, idList, minRefId );
-#endif
+            state.ApplyFreedNumbers();
         }
 
         // Annotation of one part per package components (trivial case).
-        if( componentFlatList[ii].GetLibPart()->GetUnitCount() <= 1 )
+        if( ref.GetLibPart()->GetUnitCount() <= 1 )
         {
-            if( componentFlatList[ii].m_IsNew )
-            {
-#ifdef USE_OLD_ALGO
-                LastReferenceNumber++;
-#else
-                LastReferenceNumber = CreateFirstFreeRefId( idList, minRefId );
-#endif
-                componentFlatList[ii].m_NumRef = LastReferenceNumber;
-            }
+            int numRef = ref.m_NumRef;
+
+            if( ref.m_IsNew )
+                numRef = state.CreateFirstFreeRefId( ii, minRefId );
 
-            componentFlatList[ii].m_Unit  = 1;
-            componentFlatList[ii].m_Flag  = 1;
-            componentFlatList[ii].m_IsNew = false;
+            state.SetAnnotation( ii, numRef, 1, false, 1 );
             continue;
         }
 
         // Annotation of multi-unit parts ( n units per part ) (complex case)
-        NumberOfUnits = componentFlatList[ii].GetLibPart()->GetUnitCount();
+        NumberOfUnits = ref.GetLibPart()->GetUnitCount();
 
-        if( componentFlatList[ii].m_IsNew )
+        if( ref.m_IsNew )
         {
-#ifdef USE_OLD_ALGO
-            LastReferenceNumber++;
-#else
-            LastReferenceNumber = CreateFirstFreeRefId( idList, minRefId );
-#endif
-            componentFlatList[ii].m_NumRef = LastReferenceNumber;
+            LastReferenceNumber = state.CreateFirstFreeRefId( ii, minRefId );
 
-            if( !componentFlatList[ii].IsUnitsLocked() )
-                componentFlatList[ii].m_Unit = 1;
-
-            componentFlatList[ii].m_Flag = 1;
+            state.SetAnnotation( ii, LastReferenceNumber,
+                                 ref.IsUnitsLocked() ? ref.m_Unit : 1, ref.m_IsNew, 1 );
         }
 
+        // Check whether this component is in aLockedUnitMap.
+        SCH_REFERENCE_LIST* lockedList = state.FindLockedList( ii );
+
         // If this component is in aLockedUnitMap, copy the annotation to all
         // components that are not it
         if( lockedList != NULL )
@@ -415,25 +685,21 @@ void SCH_REFERENCE_LIST::Annotate( bool aUseSheetNum, int aSheetIntervalId,
             for( unsigned thisRefI = 0; thisRefI < n_refs; ++thisRefI )
             {
                 SCH_REFERENCE &thisRef = (*lockedList)[thisRefI];
-                if( thisRef.IsSameInstance( componentFlatList[ii] ) )
+                if( thisRef.IsSameInstance( ref ) )
                 {
                     // This is the component we're currently annotating. Hold the unit!
-                    componentFlatList[ii].m_Unit = thisRef.m_Unit;
+                    state.SetAnnotation( ii, ref.m_NumRef, thisRef.m_Unit, ref.m_IsNew,
+                                         ref.m_Flag );
                 }
 
-                if( thisRef.CompareValue( componentFlatList[ii] ) != 0 ) continue;
-                if( thisRef.CompareLibName( componentFlatList[ii] ) != 0 ) continue;
+                if( thisRef.CompareValue( ref ) != 0 ) continue;
+                if( thisRef.CompareLibName( ref ) != 0 ) continue;
 
                 // Find the matching component
-                for( unsigned jj = ii + 1; jj < componentFlatList.size(); jj++ )
-                {
-                    if( ! thisRef.IsSameInstance( componentFlatList[jj] ) ) continue;
-                    componentFlatList[jj].m_NumRef = componentFlatList[ii].m_NumRef;
-                    componentFlatList[jj].m_Unit = thisRef.m_Unit;
-                    componentFlatList[jj].m_IsNew = false;
-                    componentFlatList[jj].m_Flag = 1;
-                    break;
-                }
+                int jj = state.FindInstance( thisRef, ii );
+
+                if( jj >= 0 )
+                    state.SetAnnotation( jj, ref.m_NumRef, thisRef.m_Unit, false, 1 );
             }
         }
 
@@ -445,43 +711,18 @@ void SCH_REFERENCE_LIST::Annotate( bool aUseSheetNum, int aSheetIntervalId,
             */
             for( Unit = 1; Unit <= NumberOfUnits; Unit++ )
             {
-                if( componentFlatList[ii].m_Unit == Unit )
+                if( ref.m_Unit == Unit )
                     continue;
 
-                int found = FindUnit( ii, Unit );
-
-                if( found >= 0 )
+                if( state.HasUnit( ii, Unit ) )
                     continue; // this unit exists for this reference (unit already annotated)
 
                 // Search a component to annotate ( same prefix, same value, not annotated)
-                for( unsigned jj = ii + 1; jj < componentFlatList.size(); jj++ )
-                {
-                    if( componentFlatList[jj].m_Flag )    // already tested
-                        continue;
-
-                    if( componentFlatList[ii].CompareRef( componentFlatList[jj] ) != 0 )
-                        continue;
-
-                    if( componentFlatList[jj].CompareValue( componentFlatList[ii] ) != 0 )
-                        continue;
-
-                    if( componentFlatList[jj].CompareLibName( componentFlatList[ii] ) != 0 )
-                        continue;
-
-                    if( !componentFlatList[jj].m_IsNew )
-                        continue;
-
-                    // Component without reference number found, annotate it if possible
-                    if( !componentFlatList[jj].IsUnitsLocked()
-                        || ( componentFlatList[jj].m_Unit == Unit ) )
-                    {
-                        componentFlatList[jj].m_NumRef = componentFlatList[ii].m_NumRef;
-                        componentFlatList[jj].m_Unit   = Unit;
-                        componentFlatList[jj].m_Flag   = 1;
-                        componentFlatList[jj].m_IsNew  = false;
-                        break;
-                    }
-                }
+                // Component without reference number found, annotate it if possible
+                int jj = state.FindNewUnit( ii, Unit );
+
+                if( jj >= 0 )
+                    state.SetAnnotation( jj, ref.m_NumRef, Unit, false, 1 );
             }
         }
     }
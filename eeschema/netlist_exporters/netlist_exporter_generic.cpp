@@ -24,6 +24,8 @@
  */
 
 #include <build_version.h>
+#include <confirm.h>
+#include <richio.h>
 #include <sch_base_frame.h>
 #include <class_library.h>
 
@@ -32,45 +34,237 @@
 
 static bool sortPinsByNumber( LIB_PIN* aPin1, LIB_PIN* aPin2 );
 
+
+void XNODE_TREE_SINK::StartElement( const wxString& aName )
+{
+    XNODE* n = new XNODE( wxXML_ELEMENT_NODE, aName );
+
+    if( m_stack.empty() )
+    {
+        wxASSERT( !m_root );
+        m_root = n;
+    }
+    else
+    {
+        m_stack.back()->AddChild( n );
+    }
+
+    m_stack.push_back( n );
+}
+
+
+void XNODE_TREE_SINK::AddText( const wxString& aText )
+{
+    if( aText.Len() > 0 )
+        m_stack.back()->AddChild( new XNODE( wxXML_TEXT_NODE, wxEmptyString, aText ) );
+}
+
+
+XML_STREAM_SINK::XML_STREAM_SINK( OUTPUTFORMATTER* aOut ) :
+    m_out( aOut )
+{
+    m_buf = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+}
+
+
+void XML_STREAM_SINK::Flush()
+{
+    if( m_buf.size() )
+        m_out->Print( 0, "%s", m_buf.c_str() );
+
+    m_buf.clear();
+}
+
+
+void XML_STREAM_SINK::StartElement( const wxString& aName )
+{
+    if( !m_stack.empty() )
+    {
+        openContent();
+        indent( m_stack.size() );
+        m_stack.back().m_lastIsText = false;
+    }
+
+    OPEN_ELEMENT e;
+    e.m_name = TO_UTF8( aName );
+    e.m_hasContent = false;
+    e.m_lastIsText = false;
+
+    m_buf += '<';
+    m_buf += e.m_name;
+
+    m_stack.push_back( e );
+}
+
+
+void XML_STREAM_SINK::AddAttribute( const wxString& aName, const wxString& aValue )
+{
+    wxASSERT( !m_stack.back().m_hasContent );
+
+    m_buf += ' ';
+    m_buf += TO_UTF8( aName );
+    m_buf += "=\"";
+    escape( TO_UTF8( aValue ), true );
+    m_buf += '"';
+}
+
+
+void XML_STREAM_SINK::AddText( const wxString& aText )
+{
+    if( aText.Len() == 0 )
+        return;
+
+    openContent();
+    escape( TO_UTF8( aText ), false );
+    m_stack.back().m_lastIsText = true;
+}
+
+
+void XML_STREAM_SINK::EndElement()
+{
+    const OPEN_ELEMENT& e = m_stack.back();
+
+    if( !e.m_hasContent )
+    {
+        m_buf += "/>";
+    }
+    else
+    {
+        if( !e.m_lastIsText )
+            indent( m_stack.size() - 1 );
+
+        m_buf += "</";
+        m_buf += e.m_name;
+        m_buf += '>';
+    }
+
+    m_stack.pop_back();
+
+    if( m_stack.empty() )
+        m_buf += '\n';
+
+    if( m_buf.size() >= FLUSH_SIZE )
+        Flush();
+}
+
+
+void XML_STREAM_SINK::openContent()
+{
+    OPEN_ELEMENT& e = m_stack.back();
+
+    if( !e.m_hasContent )
+    {
+        m_buf += '>';
+        e.m_hasContent = true;
+    }
+}
+
+
+void XML_STREAM_SINK::indent( size_t aDepth )
+{
+    m_buf += '\n';
+    m_buf.append( aDepth * 2, ' ' );
+}
+
+
+void XML_STREAM_SINK::escape( const std::string& aText, bool aAttribute )
+{
+    // Working on the UTF8 bytes is safe, as none of the escaped characters can be
+    // a part of a multibyte sequence.
+    for( char c : aText )
+    {
+        switch( c )
+        {
+        case '<':   m_buf += "&lt;";    break;
+        case '>':   m_buf += "&gt;";    break;
+        case '&':   m_buf += "&amp;";   break;
+        case '\r':  m_buf += "&#xD;";   break;
+
+        case '"':
+            m_buf += aAttribute ? "&quot;" : "\"";
+            break;
+
+        case '\t':
+            m_buf += aAttribute ? "&#x9;" : "\t";
+            break;
+
+        case '\n':
+            m_buf += aAttribute ? "&#xA;" : "\n";
+            break;
+
+        default:
+            m_buf += c;
+        }
+    }
+}
+
+
 bool NETLIST_EXPORTER_GENERIC::WriteNetlist( const wxString& aOutFileName, unsigned aNetlistOptions )
 {
     // Prepare list of nets generation
     for( unsigned ii = 0; ii < m_masterList->size(); ii++ )
         m_masterList->GetItem( ii )->m_Flag = 0;
 
-    // output the XML format netlist.
-    wxXmlDocument   xdoc;
+    // output the XML format netlist, streamed without building the document tree.
+    // Binary mode keeps the '\n' line endings written by wxXmlDocument.
+    try
+    {
+        FILE_OUTPUTFORMATTER formatter( aOutFileName, wxT( "wb" ) );
+        FormatXml( &formatter, GNL_ALL );
+    }
 
-    xdoc.SetRoot( makeRoot( GNL_ALL ) );
+    catch( const IO_ERROR& ioe )
+    {
+        DisplayError( NULL, ioe.What() );
+        return false;
+    }
 
-    return xdoc.Save( aOutFileName, 2 /* indent bug, today was ignored by wxXml lib */ );
+    return true;
+}
+
+
+void NETLIST_EXPORTER_GENERIC::FormatXml( OUTPUTFORMATTER* aOut, int aCtl )
+{
+    XML_STREAM_SINK sink( aOut );
+
+    writeRoot( &sink, aCtl );
+    sink.Flush();
 }
 
 
 XNODE* NETLIST_EXPORTER_GENERIC::makeRoot( int aCtl )
 {
-    XNODE*      xroot = node( "export" );
+    XNODE_TREE_SINK sink;
+
+    writeRoot( &sink, aCtl );
+
+    return sink.ReleaseRoot();
+}
 
-    xroot->AddAttribute( "version", "D" );
+
+void NETLIST_EXPORTER_GENERIC::writeRoot( NETLIST_XML_SINK* aSink, int aCtl )
+{
+    aSink->StartElement( "export" );
+    aSink->AddAttribute( "version", "D" );
 
     if( aCtl & GNL_HEADER )
         // add the "design" header
-        xroot->AddChild( makeDesignHeader() );
+        writeDesignHeader( aSink );
 
     if( aCtl & GNL_COMPONENTS )
-        xroot->AddChild( makeComponents() );
+        writeComponents( aSink );
 
     if( aCtl & GNL_PARTS )
-        xroot->AddChild( makeLibParts() );
+        writeLibParts( aSink );
 
     if( aCtl & GNL_LIBRARIES )
-        // must follow makeGenericLibParts()
-        xroot->AddChild( makeLibraries() );
+        // must follow writeLibParts()
+        writeLibraries( aSink );
 
     if( aCtl & GNL_NETS )
-        xroot->AddChild( makeListOfNets() );
+        writeListOfNets( aSink );
 
-    return xroot;
+    aSink->EndElement();
 }
 
 
@@ -85,7 +279,8 @@ struct COMP_FIELDS
 };
 
 
-void NETLIST_EXPORTER_GENERIC::addComponentFields( XNODE* xcomp, SCH_COMPONENT* comp, SCH_SHEET_PATH* aSheet )
+void NETLIST_EXPORTER_GENERIC::addComponentFields( NETLIST_XML_SINK* aSink, SCH_COMPONENT* comp,
+                                                   SCH_SHEET_PATH* aSheet )
 {
     if( comp->GetUnitCount() > 1 )
     {
@@ -138,46 +333,47 @@ void NETLIST_EXPORTER_GENERIC::addComponentFields( XNODE* xcomp, SCH_COMPONENT*
             }
         }
 
-        xcomp->AddChild( node( "value", fields.value ) );
+        aSink->Element( "value", fields.value );
 
         if( fields.footprint.size() )
-            xcomp->AddChild( node( "footprint", fields.footprint ) );
+            aSink->Element( "footprint", fields.footprint );
 
         if( fields.datasheet.size() )
-            xcomp->AddChild( node( "datasheet", fields.datasheet ) );
+            aSink->Element( "datasheet", fields.datasheet );
 
         if( fields.f.size() )
         {
-            XNODE* xfields;
-            xcomp->AddChild( xfields = node( "fields" ) );
+            aSink->StartElement( "fields" );
 
             // non MANDATORY fields are output alphabetically
             for( std::map< wxString, wxString >::const_iterator it = fields.f.begin();
                     it != fields.f.end();  ++it )
             {
-                XNODE*  xfield;
-                xfields->AddChild( xfield = node( "field", it->second ) );
-                xfield->AddAttribute( "name", it->first );
+                aSink->StartElement( "field" );
+                aSink->AddAttribute( "name", it->first );
+                aSink->AddText( it->second );
+                aSink->EndElement();
             }
+
+            aSink->EndElement();
         }
     }
     else
     {
-        xcomp->AddChild( node( "value", comp->GetField( VALUE )->GetText() ) );
+        aSink->Element( "value", comp->GetField( VALUE )->GetText() );
 
         if( !comp->GetField( FOOTPRINT )->IsVoid() )
-            xcomp->AddChild( node( "footprint", comp->GetField( FOOTPRINT )->GetText() ) );
+            aSink->Element( "footprint", comp->GetField( FOOTPRINT )->GetText() );
 
         if( !comp->GetField( DATASHEET )->IsVoid() )
-            xcomp->AddChild( node( "datasheet", comp->GetField( DATASHEET )->GetText() ) );
+            aSink->Element( "datasheet", comp->GetField( DATASHEET )->GetText() );
 
         // Export all user defined fields within the component,
         // which start at field index MANDATORY_FIELDS.  Only output the <fields>
         // container element if there are any <field>s.
         if( comp->GetFieldCount() > MANDATORY_FIELDS )
         {
-            XNODE* xfields;
-            xcomp->AddChild( xfields = node( "fields" ) );
+            aSink->StartElement( "fields" );
 
             for( int fldNdx = MANDATORY_FIELDS; fldNdx < comp->GetFieldCount(); ++fldNdx )
             {
@@ -186,22 +382,25 @@ void NETLIST_EXPORTER_GENERIC::addComponentFields( XNODE* xcomp, SCH_COMPONENT*
                 // only output a field if non empty and not just "~"
                 if( !f->IsVoid() )
                 {
-                    XNODE*  xfield;
-                    xfields->AddChild( xfield = node( "field", f->GetText() ) );
-                    xfield->AddAttribute( "name", f->GetName() );
+                    aSink->StartElement( "field" );
+                    aSink->AddAttribute( "name", f->GetName() );
+                    aSink->AddText( f->GetText() );
+                    aSink->EndElement();
                 }
             }
+
+            aSink->EndElement();
         }
     }
 }
 
 
-XNODE* NETLIST_EXPORTER_GENERIC::makeComponents()
+void NETLIST_EXPORTER_GENERIC::writeComponents( NETLIST_XML_SINK* aSink )
 {
-    XNODE*      xcomps = node( "components" );
-
     wxString    timeStamp;
 
+    aSink->StartElement( "components" );
+
     m_ReferencesAlreadyFound.Clear();
 
     SCH_SHEET_LIST sheetList( g_RootSheet );
@@ -219,63 +418,60 @@ XNODE* NETLIST_EXPORTER_GENERIC::makeComponents()
 
             schItem = comp;
 
-            XNODE* xcomp;  // current component being constructed
-
             // Output the component's elements in order of expected access frequency.
             // This may not always look best, but it will allow faster execution
             // under XSL processing systems which do sequential searching within
             // an element.
 
-            xcomps->AddChild( xcomp = node( "comp" ) );
-            xcomp->AddAttribute( "ref", comp->GetRef( &sheetList[i] ) );
+            aSink->StartElement( "comp" );
+            aSink->AddAttribute( "ref", comp->GetRef( &sheetList[i] ) );
 
-            addComponentFields( xcomp, comp, &sheetList[i] );
+            addComponentFields( aSink, comp, &sheetList[i] );
 
-            XNODE*  xlibsource;
-            xcomp->AddChild( xlibsource = node( "libsource" ) );
+            aSink->StartElement( "libsource" );
 
             // "logical" library name, which is in anticipation of a better search
             // algorithm for parts based on "logical_lib.part" and where logical_lib
             // is merely the library name minus path and extension.
             LIB_PART* part = m_libs->FindLibPart( comp->GetLibId() );
             if( part )
-                xlibsource->AddAttribute( "lib", part->GetLib()->GetLogicalName() );
+                aSink->AddAttribute( "lib", part->GetLib()->GetLogicalName() );
 
             // We only want the symbol name, not the full LIB_ID.
-            xlibsource->AddAttribute( "part", FROM_UTF8( comp->GetLibId().GetLibItemName() ) );
-
-            XNODE* xsheetpath;
+            aSink->AddAttribute( "part", FROM_UTF8( comp->GetLibId().GetLibItemName() ) );
+            aSink->EndElement();
 
-            xcomp->AddChild( xsheetpath = node( "sheetpath" ) );
-            xsheetpath->AddAttribute( "names", sheetList[i].PathHumanReadable() );
-            xsheetpath->AddAttribute( "tstamps", sheetList[i].Path() );
+            aSink->StartElement( "sheetpath" );
+            aSink->AddAttribute( "names", sheetList[i].PathHumanReadable() );
+            aSink->AddAttribute( "tstamps", sheetList[i].Path() );
+            aSink->EndElement();
 
             timeStamp.Printf( "%8.8lX", (unsigned long)comp->GetTimeStamp() );
-            xcomp->AddChild( node( "tstamp", timeStamp ) );
+            aSink->Element( "tstamp", timeStamp );
+
+            aSink->EndElement();
         }
     }
 
-    return xcomps;
+    aSink->EndElement();
 }
 
 
-XNODE* NETLIST_EXPORTER_GENERIC::makeDesignHeader()
+void NETLIST_EXPORTER_GENERIC::writeDesignHeader( NETLIST_XML_SINK* aSink )
 {
     SCH_SCREEN* screen;
-    XNODE*     xdesign = node( "design" );
-    XNODE*     xtitleBlock;
-    XNODE*     xsheet;
-    XNODE*     xcomment;
     wxString   sheetTxt;
     wxFileName sourceFileName;
 
+    aSink->StartElement( "design" );
+
     // the root sheet is a special sheet, call it source
-    xdesign->AddChild( node( "source", g_RootSheet->GetScreen()->GetFileName() ) );
+    aSink->Element( "source", g_RootSheet->GetScreen()->GetFileName() );
 
-    xdesign->AddChild( node( "date", DateAndTime() ) );
+    aSink->Element( "date", DateAndTime() );
 
     // which Eeschema tool
-    xdesign->AddChild( node( "tool", wxString( "Eeschema " ) + GetBuildVersion() ) );
+    aSink->Element( "tool", wxString( "Eeschema " ) + GetBuildVersion() );
 
     /*
         Export the sheets information
@@ -286,80 +482,87 @@ XNODE* NETLIST_EXPORTER_GENERIC::makeDesignHeader()
     {
         screen = sheetList[i].LastScreen();
 
-        xdesign->AddChild( xsheet = node( "sheet" ) );
+        aSink->StartElement( "sheet" );
 
         // get the string representation of the sheet index number.
         // Note that sheet->GetIndex() is zero index base and we need to increment the
         // number by one to make it human readable
         sheetTxt.Printf( "%u", i + 1 );
-        xsheet->AddAttribute( "number", sheetTxt );
-        xsheet->AddAttribute( "name", sheetList[i].PathHumanReadable() );
-        xsheet->AddAttribute( "tstamps", sheetList[i].Path() );
+        aSink->AddAttribute( "number", sheetTxt );
+        aSink->AddAttribute( "name", sheetList[i].PathHumanReadable() );
+        aSink->AddAttribute( "tstamps", sheetList[i].Path() );
 
 
         TITLE_BLOCK tb = screen->GetTitleBlock();
 
-        xsheet->AddChild( xtitleBlock = node( "title_block" ) );
+        aSink->StartElement( "title_block" );
 
-        xtitleBlock->AddChild( node( "title", tb.GetTitle() ) );
-        xtitleBlock->AddChild( node( "company", tb.GetCompany() ) );
-        xtitleBlock->AddChild( node( "rev", tb.GetRevision() ) );
-        xtitleBlock->AddChild( node( "date", tb.GetDate() ) );
+        aSink->Element( "title", tb.GetTitle() );
+        aSink->Element( "company", tb.GetCompany() );
+        aSink->Element( "rev", tb.GetRevision() );
+        aSink->Element( "date", tb.GetDate() );
 
         // We are going to remove the fileName directories.
         sourceFileName = wxFileName( screen->GetFileName() );
-        xtitleBlock->AddChild( node( "source", sourceFileName.GetFullName() ) );
-
-        xtitleBlock->AddChild( xcomment = node( "comment" ) );
-        xcomment->AddAttribute( "number", "1" );
-        xcomment->AddAttribute( "value", tb.GetComment1() );
-
-        xtitleBlock->AddChild( xcomment = node( "comment" ) );
-        xcomment->AddAttribute( "number", "2" );
-        xcomment->AddAttribute( "value", tb.GetComment2() );
-
-        xtitleBlock->AddChild( xcomment = node( "comment" ) );
-        xcomment->AddAttribute( "number", "3" );
-        xcomment->AddAttribute( "value", tb.GetComment3() );
-
-        xtitleBlock->AddChild( xcomment = node( "comment" ) );
-        xcomment->AddAttribute( "number", "4" );
-        xcomment->AddAttribute( "value", tb.GetComment4() );
+        aSink->Element( "source", sourceFileName.GetFullName() );
+
+        aSink->StartElement( "comment" );
+        aSink->AddAttribute( "number", "1" );
+        aSink->AddAttribute( "value", tb.GetComment1() );
+        aSink->EndElement();
+
+        aSink->StartElement( "comment" );
+        aSink->AddAttribute( "number", "2" );
+        aSink->AddAttribute( "value", tb.GetComment2() );
+        aSink->EndElement();
+
+        aSink->StartElement( "comment" );
+        aSink->AddAttribute( "number", "3" );
+        aSink->AddAttribute( "value", tb.GetComment3() );
+        aSink->EndElement();
+
+        aSink->StartElement( "comment" );
+        aSink->AddAttribute( "number", "4" );
+        aSink->AddAttribute( "value", tb.GetComment4() );
+        aSink->EndElement();
+
+        aSink->EndElement();    // title_block
+        aSink->EndElement();    // sheet
     }
 
-    return xdesign;
+    aSink->EndElement();
 }
 
 
-XNODE* NETLIST_EXPORTER_GENERIC::makeLibraries()
+void NETLIST_EXPORTER_GENERIC::writeLibraries( NETLIST_XML_SINK* aSink )
 {
-    XNODE*  xlibs = node( "libraries" );     // auto_ptr
+    aSink->StartElement( "libraries" );
 
     for( std::set<void*>::iterator it = m_Libraries.begin(); it!=m_Libraries.end();  ++it )
     {
         PART_LIB*    lib = (PART_LIB*) *it;
-        XNODE*      xlibrary;
 
-        xlibs->AddChild( xlibrary = node( "library" ) );
-        xlibrary->AddAttribute( "logical", lib->GetLogicalName() );
-        xlibrary->AddChild( node( "uri",  lib->GetFullFileName() ) );
+        aSink->StartElement( "library" );
+        aSink->AddAttribute( "logical", lib->GetLogicalName() );
+        aSink->Element( "uri",  lib->GetFullFileName() );
 
         // @todo: add more fun stuff here
+        aSink->EndElement();
     }
 
-    return xlibs;
+    aSink->EndElement();
 }
 
 
-XNODE* NETLIST_EXPORTER_GENERIC::makeLibParts()
+void NETLIST_EXPORTER_GENERIC::writeLibParts( NETLIST_XML_SINK* aSink )
 {
-    XNODE*      xlibparts = node( "libparts" );   // auto_ptr
-
     LIB_PINS    pinList;
     LIB_FIELDS  fieldList;
 
     m_Libraries.clear();
 
+    aSink->StartElement( "libparts" );
+
     for( std::set<LIB_PART*>::iterator it = m_LibParts.begin(); it!=m_LibParts.end();  ++it )
     {
         LIB_PART* lcomp = *it;
@@ -367,61 +570,65 @@ XNODE* NETLIST_EXPORTER_GENERIC::makeLibParts()
 
         m_Libraries.insert( library );  // inserts component's library if unique
 
-        XNODE* xlibpart;
-        xlibparts->AddChild( xlibpart = node( "libpart" ) );
-        xlibpart->AddAttribute( "lib", library->GetLogicalName() );
-        xlibpart->AddAttribute( "part", lcomp->GetName()  );
+        aSink->StartElement( "libpart" );
+        aSink->AddAttribute( "lib", library->GetLogicalName() );
+        aSink->AddAttribute( "part", lcomp->GetName()  );
 
         if( lcomp->GetAliasCount() )
         {
             wxArrayString aliases = lcomp->GetAliasNames( false );
             if( aliases.GetCount() )
             {
-                XNODE* xaliases = node( "aliases" );
-                xlibpart->AddChild( xaliases );
+                aSink->StartElement( "aliases" );
+
                 for( unsigned i=0;  i<aliases.GetCount();  ++i )
                 {
-                    xaliases->AddChild( node( "alias", aliases[i] ) );
+                    aSink->Element( "alias", aliases[i] );
                 }
+
+                aSink->EndElement();
             }
         }
 
         //----- show the important properties -------------------------
         if( !lcomp->GetAlias( 0 )->GetDescription().IsEmpty() )
-            xlibpart->AddChild( node( "description", lcomp->GetAlias( 0 )->GetDescription() ) );
+            aSink->Element( "description", lcomp->GetAlias( 0 )->GetDescription() );
 
         if( !lcomp->GetAlias( 0 )->GetDocFileName().IsEmpty() )
-            xlibpart->AddChild( node( "docs",  lcomp->GetAlias( 0 )->GetDocFileName() ) );
+            aSink->Element( "docs",  lcomp->GetAlias( 0 )->GetDocFileName() );
 
         // Write the footprint list
         if( lcomp->GetFootPrints().GetCount() )
         {
-            XNODE*  xfootprints;
-            xlibpart->AddChild( xfootprints = node( "footprints" ) );
+            aSink->StartElement( "footprints" );
 
             for( unsigned i=0; i<lcomp->GetFootPrints().GetCount(); ++i )
             {
-                xfootprints->AddChild( node( "fp", lcomp->GetFootPrints()[i] ) );
+                aSink->Element( "fp", lcomp->GetFootPrints()[i] );
             }
+
+            aSink->EndElement();
         }
 
         //----- show the fields here ----------------------------------
         fieldList.clear();
         lcomp->GetFields( fieldList );
 
-        XNODE*     xfields;
-        xlibpart->AddChild( xfields = node( "fields" ) );
+        aSink->StartElement( "fields" );
 
         for( unsigned i=0;  i<fieldList.size();  ++i )
         {
             if( !fieldList[i].GetText().IsEmpty() )
             {
-                XNODE*     xfield;
-                xfields->AddChild( xfield = node( "field", fieldList[i].GetText() ) );
-                xfield->AddAttribute( "name", fieldList[i].GetName(false) );
+                aSink->StartElement( "field" );
+                aSink->AddAttribute( "name", fieldList[i].GetName(false) );
+                aSink->AddText( fieldList[i].GetText() );
+                aSink->EndElement();
             }
         }
 
+        aSink->EndElement();
+
         //----- show the pins here ------------------------------------
         pinList.clear();
         lcomp->GetPins( pinList, 0, 0 );
@@ -446,35 +653,36 @@ XNODE* NETLIST_EXPORTER_GENERIC::makeLibParts()
 
         if( pinList.size() )
         {
-            XNODE*     pins;
+            aSink->StartElement( "pins" );
 
-            xlibpart->AddChild( pins = node( "pins" ) );
             for( unsigned i=0; i<pinList.size();  ++i )
             {
-                XNODE*     pin;
-
-                pins->AddChild( pin = node( "pin" ) );
-                pin->AddAttribute( "num", pinList[i]->GetNumberString() );
-                pin->AddAttribute( "name", pinList[i]->GetName() );
-                pin->AddAttribute( "type", pinList[i]->GetCanonicalElectricalTypeName() );
+                aSink->StartElement( "pin" );
+                aSink->AddAttribute( "num", pinList[i]->GetNumberString() );
+                aSink->AddAttribute( "name", pinList[i]->GetName() );
+                aSink->AddAttribute( "type", pinList[i]->GetCanonicalElectricalTypeName() );
 
                 // caution: construction work site here, drive slowly
+                aSink->EndElement();
             }
+
+            aSink->EndElement();
         }
+
+        aSink->EndElement();    // libpart
     }
 
-    return xlibparts;
+    aSink->EndElement();
 }
 
 
-XNODE* NETLIST_EXPORTER_GENERIC::makeListOfNets()
+void NETLIST_EXPORTER_GENERIC::writeListOfNets( NETLIST_XML_SINK* aSink )
 {
-    XNODE*      xnets = node( "nets" );      // auto_ptr if exceptions ever get used.
     wxString    netCodeTxt;
     wxString    netName;
     wxString    ref;
 
-    XNODE*      xnet = 0;
+    bool        netOpen = false;
     int         netCode;
     int         lastNetCode = -1;
     int         sameNetcodeCount = 0;
@@ -489,6 +697,8 @@ XNODE* NETLIST_EXPORTER_GENERIC::makeListOfNets()
 
     m_LibParts.clear();     // must call this function before using m_LibParts.
 
+    aSink->StartElement( "nets" );
+
     for( unsigned ii = 0; ii < m_masterList->size(); ii++ )
     {
         NETLIST_OBJECT* nitem = m_masterList->GetItem( ii );
@@ -517,30 +727,26 @@ XNODE* NETLIST_EXPORTER_GENERIC::makeListOfNets()
 
         if( ++sameNetcodeCount == 1 )
         {
-            xnets->AddChild( xnet = node( "net" ) );
+            if( netOpen )
+                aSink->EndElement();
+
+            aSink->StartElement( "net" );
+            netOpen = true;
             netCodeTxt.Printf( "%d", netCode );
-            xnet->AddAttribute( "code", netCodeTxt );
-            xnet->AddAttribute( "name", netName );
+            aSink->AddAttribute( "code", netCodeTxt );
+            aSink->AddAttribute( "name", netName );
         }
 
-        XNODE*      xnode;
-        xnet->AddChild( xnode = node( "node" ) );
-        xnode->AddAttribute( "ref", ref );
-        xnode->AddAttribute( "pin",  nitem->GetPinNumText() );
+        aSink->StartElement( "node" );
+        aSink->AddAttribute( "ref", ref );
+        aSink->AddAttribute( "pin",  nitem->GetPinNumText() );
+        aSink->EndElement();
     }
 
-    return xnets;
-}
-
-
-XNODE* NETLIST_EXPORTER_GENERIC::node( const wxString& aName, const wxString& aTextualContent /* = wxEmptyString*/ )
-{
-    XNODE* n = new XNODE( wxXML_ELEMENT_NODE, aName );
-
-    if( aTextualContent.Len() > 0 )     // excludes wxEmptyString, the parameter's default value
-        n->AddChild( new XNODE( wxXML_TEXT_NODE, wxEmptyString, aTextualContent ) );
+    if( netOpen )
+        aSink->EndElement();
 
-    return n;
+    aSink->EndElement();
 }
 
 
@@ -30,6 +30,8 @@
 
 #include <xnode.h>      // also nests: <wx/xml/xml.h>
 
+class OUTPUTFORMATTER;
+
 #define GENERIC_INTERMEDIATE_NETLIST_EXT wxT( "xml" )
 
 /**
@@ -46,6 +48,137 @@ enum GNL_T
 };
 
 
+/**
+ * Class NETLIST_XML_SINK
+ * receives the generic netlist document one element at a time, so the same walk
+ * over the schematic can either build an XNODE tree or write the XML text directly.
+ * The attributes of an element must be given before its text and child elements.
+ */
+class NETLIST_XML_SINK
+{
+public:
+    virtual ~NETLIST_XML_SINK() {}
+
+    virtual void StartElement( const wxString& aName ) = 0;
+    virtual void AddAttribute( const wxString& aName, const wxString& aValue ) = 0;
+
+    /// Empty text is ignored, as node() does.
+    virtual void AddText( const wxString& aText ) = 0;
+    virtual void EndElement() = 0;
+
+    /**
+     * Function Element
+     * writes a whole element holding only the optional \a aText.
+     */
+    void Element( const wxString& aName, const wxString& aText = wxEmptyString )
+    {
+        StartElement( aName );
+        AddText( aText );
+        EndElement();
+    }
+};
+
+
+/**
+ * Class XNODE_TREE_SINK
+ * builds the XNODE tree of the generic netlist, for makeRoot().
+ */
+class XNODE_TREE_SINK : public NETLIST_XML_SINK
+{
+public:
+    XNODE_TREE_SINK() :
+        m_root( NULL )
+    {
+    }
+
+    ~XNODE_TREE_SINK()
+    {
+        delete m_root;
+    }
+
+    /// Returns the root of the tree, now owned by the caller.
+    XNODE* ReleaseRoot()
+    {
+        XNODE* root = m_root;
+        m_root = NULL;
+        return root;
+    }
+
+    void StartElement( const wxString& aName ) override;
+
+    void AddAttribute( const wxString& aName, const wxString& aValue ) override
+    {
+        m_stack.back()->AddAttribute( aName, aValue );
+    }
+
+    void AddText( const wxString& aText ) override;
+
+    void EndElement() override
+    {
+        m_stack.pop_back();
+    }
+
+private:
+    XNODE*              m_root;
+    std::vector<XNODE*> m_stack;    ///< the open elements, innermost last
+};
+
+
+/**
+ * Class XML_STREAM_SINK
+ * writes the generic netlist as XML text to an OUTPUTFORMATTER as the elements come.
+ * It reproduces what wxXmlDocument::Save() does with an indentation step of 2: the
+ * same declaration, indentation, escaping and "<foo/>" for the empty elements, so
+ * the file does not change when switching from the tree to the stream.
+ * Only the names of the open elements are kept.
+ */
+class XML_STREAM_SINK : public NETLIST_XML_SINK
+{
+public:
+    XML_STREAM_SINK( OUTPUTFORMATTER* aOut );
+
+    /**
+     * Function Flush
+     * writes the pending text to the formatter.  Must be called once the root
+     * element is ended.
+     * @throw IO_ERROR if any problems.
+     */
+    void Flush();
+
+    void StartElement( const wxString& aName ) override;
+    void AddAttribute( const wxString& aName, const wxString& aValue ) override;
+    void AddText( const wxString& aText ) override;
+    void EndElement() override;
+
+private:
+    /// Closes the start tag of the innermost element before its first text or child.
+    void openContent();
+
+    void indent( size_t aDepth );
+
+    /**
+     * Function escape
+     * appends \a aText with the escaping of wxXmlDocument: the markup characters
+     * everywhere, and also the quote and the white space other than a space in the
+     * attribute values.
+     */
+    void escape( const std::string& aText, bool aAttribute );
+
+    struct OPEN_ELEMENT
+    {
+        std::string m_name;
+        bool        m_hasContent;       ///< the start tag is closed by '>'
+        bool        m_lastIsText;       ///< no indentation before the end tag
+    };
+
+    static const size_t FLUSH_SIZE = 64 * 1024;
+
+    OUTPUTFORMATTER*            m_out;
+    std::string                 m_buf;      ///< text not yet given to m_out
+    std::vector<OPEN_ELEMENT>   m_stack;    ///< the open elements, innermost last
+};
+
+
 /**
  * Class NETLIST_EXPORTER_GENERIC
  * generates a generic XML based netlist file. This allows using XSLT or other methods to
@@ -67,18 +200,19 @@ public:
 
 #define GNL_ALL     ( GNL_LIBRARIES | GNL_COMPONENTS | GNL_PARTS | GNL_HEADER | GNL_NETS )
 
-protected:
-   /**
-     * Function node
-     * is a convenience function that creates a new XNODE with an optional textual child.
-     * It also provides some insulation from a possible change in XML library.
-     *
-     * @param aName is the name to associate with a new node of type wxXML_ELEMENT_NODE.
-     * @param aTextualContent is optional, and if given is the text to include in a child
-     *   of the returned node, and has type wxXML_TEXT_NODE.
+    /**
+     * Function FormatXml
+     * streams the XML netlist into \a aOut while walking the netlist, without
+     * building the document tree first.  The output is the same, byte for byte,
+     * as saving makeRoot() with wxXmlDocument::Save() and an indentation of 2.
+     * @param aOut is the destination of the serialization to text, and should be
+     *  opened in binary mode to keep the line endings of wxXmlDocument.
+     * @param aCtl is bit set composed by OR-ing together enum GNL bits.
+     * @throw IO_ERROR if any problems.
      */
-    XNODE* node( const wxString& aName, const wxString& aTextualContent = wxEmptyString );
+    void FormatXml( OUTPUTFORMATTER* aOut, int aCtl = GNL_ALL );
 
+protected:
     /**
      * Function makeGenericRoot
      * builds the entire document tree for the generic export.  This is factored
@@ -90,41 +224,47 @@ protected:
     XNODE* makeRoot( int aCtl = GNL_ALL );
 
     /**
-     * Function makeComponents
-     * @return XNODE* - returns a sub-tree holding all the schematic components.
+     * Function writeRoot
+     * walks the netlist and sends the whole generic document to \a aSink.
+     * makeRoot() and FormatXml() are both built on it, so the tree and the
+     * streamed XML can never disagree.
+     * @param aSink is the destination of the document elements.
+     * @param aCtl - a bitset or-ed together from GNL_ENUM values
+     */
+    void writeRoot( NETLIST_XML_SINK* aSink, int aCtl = GNL_ALL );
+
+    /**
+     * Function writeComponents
+     * writes the "components" element holding all the schematic components.
      */
-    XNODE* makeComponents();
+    void writeComponents( NETLIST_XML_SINK* aSink );
 
     /**
-     * Function makeDesignHeader
-     * fills out a project "design" header into an XML node.
-     * @return XNODE* - the design header
+     * Function writeDesignHeader
+     * writes the project "design" header element.
      */
-    XNODE* makeDesignHeader();
+    void writeDesignHeader( NETLIST_XML_SINK* aSink );
 
     /**
-     * Function makeLibParts
-     * fills out an XML node with the unique library parts and returns it.
-     * @return XNODE* - the library parts nodes
+     * Function writeLibParts
+     * writes the "libparts" element holding the unique library parts.
      */
-    XNODE* makeLibParts();
+    void writeLibParts( NETLIST_XML_SINK* aSink );
 
     /**
-     * Function makeListOfNets
-     * fills out an XML node with a list of nets and returns it.
-     * @return XNODE* - the list of nets nodes
+     * Function writeListOfNets
+     * writes the "nets" element holding the list of nets.
      */
-    XNODE* makeListOfNets();
+    void writeListOfNets( NETLIST_XML_SINK* aSink );
 
     /**
-     * Function makeLibraries
-     * fills out an XML node with a list of used libraries and returns it.
-     * Must have called makeGenericLibParts() before this function.
-     * @return XNODE* - the library nodes
+     * Function writeLibraries
+     * writes the "libraries" element holding the used libraries.
+     * Must have called writeLibParts() before this function.
      */
-    XNODE* makeLibraries();
+    void writeLibraries( NETLIST_XML_SINK* aSink );
 
-    void addComponentFields(  XNODE* xcomp, SCH_COMPONENT* comp, SCH_SHEET_PATH* aSheet );
+    void addComponentFields( NETLIST_XML_SINK* aSink, SCH_COMPONENT* comp, SCH_SHEET_PATH* aSheet );
 };
 
 #endif
@@ -246,51 +246,45 @@ void SCH_BUS_ENTRY_BASE::GetEndPoints( std::vector< DANGLING_END_ITEM >& aItemLi
 }
 
 
-bool SCH_BUS_ENTRY_BASE::IsDanglingStateChanged( std::vector<DANGLING_END_ITEM>& aItemList )
+bool SCH_BUS_ENTRY_BASE::IsDanglingStateChanged( const DANGLING_END_INDEX& aEndPoints )
 {
     bool previousStateStart = m_isDanglingStart;
     bool previousStateEnd = m_isDanglingEnd;
 
     m_isDanglingStart = m_isDanglingEnd = true;
 
-    // Wires and buses are stored in the list as a pair, start and end. This
-    // variable holds the start position from one iteration so it can be used
-    // when the end position is found.
-    wxPoint seg_start;
-
     // Special case: if both items are wires, show as dangling. This is because
     // a bus entry between two wires will look like a connection, but does NOT
     // actually represent one. We need to clarify this for the user.
     bool start_is_wire = false;
     bool end_is_wire = false;
 
-    for( DANGLING_END_ITEM& each_item : aItemList )
-    {
-        if( each_item.GetItem() == this )
-            continue;
+    std::vector<DANGLING_END_INDEX::SEGMENT> segments;
+
+    aEndPoints.GetSegmentsAt( m_pos, segments );
 
-        switch( each_item.GetType() )
+    for( const DANGLING_END_INDEX::SEGMENT& segment : segments )
+    {
+        if( IsPointOnSegment( segment.m_start->GetPosition(), segment.m_end->GetPosition(), m_pos ) )
         {
-        case WIRE_START_END:
-        case BUS_START_END:
-            seg_start = each_item.GetPosition();
-            break;
+            m_isDanglingStart = false;
 
-        case WIRE_END_END:
-            if( IsPointOnSegment( seg_start, each_item.GetPosition(), m_pos ) )
+            if( segment.m_end->GetType() == WIRE_END_END )
                 start_is_wire = true;
-            if( IsPointOnSegment( seg_start, each_item.GetPosition(), m_End() ) )
+        }
+    }
+
+    segments.clear();
+    aEndPoints.GetSegmentsAt( m_End(), segments );
+
+    for( const DANGLING_END_INDEX::SEGMENT& segment : segments )
+    {
+        if( IsPointOnSegment( segment.m_start->GetPosition(), segment.m_end->GetPosition(), m_End() ) )
+        {
+            m_isDanglingEnd = false;
+
+            if( segment.m_end->GetType() == WIRE_END_END )
                 end_is_wire = true;
-            // Fall through
-
-        case BUS_END_END:
-            if( IsPointOnSegment( seg_start, each_item.GetPosition(), m_pos ) )
-                m_isDanglingStart = false;
-            if( IsPointOnSegment( seg_start, each_item.GetPosition(), m_End() ) )
-                m_isDanglingEnd = false;
-            break;
-        default:
-            break;
         }
     }
 
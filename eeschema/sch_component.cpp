@@ -1851,7 +1851,7 @@ void SCH_COMPONENT::GetEndPoints( std::vector <DANGLING_END_ITEM>& aItemList )
 }
 
 
-bool SCH_COMPONENT::IsPinDanglingStateChanged( std::vector<DANGLING_END_ITEM> &aItemList,
+bool SCH_COMPONENT::IsPinDanglingStateChanged( const DANGLING_END_INDEX& aEndPoints,
         LIB_PINS& aLibPins, unsigned aPin )
 {
     bool previousState;
@@ -1868,9 +1868,12 @@ bool SCH_COMPONENT::IsPinDanglingStateChanged( std::vector<DANGLING_END_ITEM> &a
     }
 
     wxPoint pin_position = GetPinPhysicalPosition( aLibPins[aPin] );
+    DANGLING_END_INDEX::RANGE range = aEndPoints.GetItemsAt( pin_position );
 
-    for( DANGLING_END_ITEM& each_item : aItemList )
+    for( auto it = range.first; it != range.second; ++it )
     {
+        const DANGLING_END_ITEM& each_item = *it->second;
+
         // Some people like to stack pins on top of each other in a symbol to indicate
         // internal connection. While technically connected, it is not particularly useful
         // to display them that way, so skip any pins that are in the same symbol as this
@@ -1894,8 +1897,7 @@ bool SCH_COMPONENT::IsPinDanglingStateChanged( std::vector<DANGLING_END_ITEM> &a
         case WIRE_END_END:
         case NO_CONNECT_END:
         case JUNCTION_END:
-            if( pin_position == each_item.GetPosition() )
-                m_isDangling[aPin] = false;
+            m_isDangling[aPin] = false;
             break;
         default:
             break;
@@ -1908,7 +1910,7 @@ bool SCH_COMPONENT::IsPinDanglingStateChanged( std::vector<DANGLING_END_ITEM> &a
 }
 
 
-bool SCH_COMPONENT::IsDanglingStateChanged( std::vector<DANGLING_END_ITEM>& aItemList )
+bool SCH_COMPONENT::IsDanglingStateChanged( const DANGLING_END_INDEX& aEndPoints )
 {
     bool changed = false;
     LIB_PINS libPins;
@@ -1916,7 +1918,7 @@ bool SCH_COMPONENT::IsDanglingStateChanged( std::vector<DANGLING_END_ITEM>& aIte
         part->GetPins( libPins, m_unit, m_convert );
     for( size_t i = 0; i < libPins.size(); ++i )
     {
-        if( IsPinDanglingStateChanged( aItemList, libPins, i ) )
+        if( IsPinDanglingStateChanged( aEndPoints, libPins, i ) )
             changed = true;
     }
     return changed;
@@ -530,12 +530,12 @@ public:
      *
      * As a side effect, it actually updates the dangling status for that pin.
      *
-     * @param aItemList is list of all #DANGLING_END_ITEM items to be tested.
+     * @param aEndPoints is the index of all #DANGLING_END_ITEM items to be tested.
      * @param aLibPins is list of all the #LIB_PIN items in this symbol
      * @param aPin is the index into \a aLibPins that identifies the pin to test
      * @return true if the pin's state has changed.
      */
-    bool IsPinDanglingStateChanged( std::vector<DANGLING_END_ITEM>& aItemList,
+    bool IsPinDanglingStateChanged( const DANGLING_END_INDEX& aEndPoints,
             LIB_PINS& aLibPins, unsigned aPin );
 
     /**
@@ -545,11 +545,11 @@ public:
      *
      * @note This does not test for  short circuits.
      *
-     * @param aItemList is list of all #DANGLING_END_ITEM items to be tested.
+     * @param aEndPoints is the index of all #DANGLING_END_ITEM items to be tested.
      *
      * @return true if any pin's state has changed.
      */
-    bool IsDanglingStateChanged( std::vector<DANGLING_END_ITEM>& aItemList ) override;
+    bool IsDanglingStateChanged( const DANGLING_END_INDEX& aEndPoints ) override;
 
     /**
      * Return whether any pin in this symbol is dangling.
@@ -149,3 +149,49 @@ std::string SCH_ITEM::FormatInternalUnits( const wxSize& aSize )
 {
     return FormatInternalUnits( aSize.GetWidth() ) + " " + FormatInternalUnits( aSize.GetHeight() );
 }
+
+
+DANGLING_END_INDEX::DANGLING_END_INDEX( const std::vector<DANGLING_END_ITEM>& aItemList )
+{
+    m_positions.reserve( aItemList.size() );
+
+    for( unsigned ii = 0; ii < aItemList.size(); ii++ )
+    {
+        const DANGLING_END_ITEM& item = aItemList[ii];
+
+        m_positions.emplace( item.GetPosition(), &item );
+
+        // Wires and buses are stored in the list as a pair, start and end.
+        if( ( item.GetType() != WIRE_START_END && item.GetType() != BUS_START_END )
+          || ii + 1 >= aItemList.size() )
+            continue;
+
+        SEGMENT segment = { &item, &aItemList[ii + 1] };
+        wxPoint start = segment.m_start->GetPosition();
+        wxPoint end = segment.m_end->GetPosition();
+
+        if( start.y == end.y )
+            m_horizontalSegments[start.y].push_back( segment );
+        else if( start.x == end.x )
+            m_verticalSegments[start.x].push_back( segment );
+        else
+            m_otherSegments.push_back( segment );
+    }
+}
+
+
+void DANGLING_END_INDEX::GetSegmentsAt( const wxPoint& aPosition,
+                                        std::vector<SEGMENT>& aSegments ) const
+{
+    auto horizontal = m_horizontalSegments.find( aPosition.y );
+
+    if( horizontal != m_horizontalSegments.end() )
+        aSegments.insert( aSegments.end(), horizontal->second.begin(), horizontal->second.end() );
+
+    auto vertical = m_verticalSegments.find( aPosition.x );
+
+    if( vertical != m_verticalSegments.end() )
+        aSegments.insert( aSegments.end(), vertical->second.begin(), vertical->second.end() );
+
+    aSegments.insert( aSegments.end(), m_otherSegments.begin(), m_otherSegments.end() );
+}
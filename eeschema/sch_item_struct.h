@@ -33,6 +33,7 @@
 #include <vector>
 #include <class_base_screen.h>
 #include <general.h>
+#include <hashtables.h>
 
 #include <boost/ptr_container/ptr_vector.hpp>
 
@@ -106,6 +107,58 @@ public:
 };
 
 
+/**
+ * Class DANGLING_END_INDEX
+ * indexes the DANGLING_END_ITEMs of a screen by position, so an item can find what is
+ * connected to its end points without scanning all the end points of the screen.
+ * Wire and bus segments are also indexed by their Y coordinate when horizontal, and by
+ * their X coordinate when vertical, to find the segments a point can be on.
+ * The index refers to the items of the list it is built from, which must outlive it.
+ */
+class DANGLING_END_INDEX
+{
+public:
+    typedef std::unordered_multimap<wxPoint, const DANGLING_END_ITEM*, WXPOINT_HASH> POSITION_MAP;
+    typedef std::pair<POSITION_MAP::const_iterator, POSITION_MAP::const_iterator> RANGE;
+
+    /// A wire or bus segment, i.e. a pair of *_START_END and *_END_END items.
+    struct SEGMENT
+    {
+        const DANGLING_END_ITEM* m_start;
+        const DANGLING_END_ITEM* m_end;
+    };
+
+    DANGLING_END_INDEX( const std::vector<DANGLING_END_ITEM>& aItemList );
+
+    /**
+     * Function GetItemsAt
+     * @return the range of the items located at \a aPosition.
+     */
+    RANGE GetItemsAt( const wxPoint& aPosition ) const
+    {
+        return m_positions.equal_range( aPosition );
+    }
+
+    /**
+     * Function GetSegmentsAt
+     * collects the wire and bus segments which can contain \a aPosition, i.e.
+     * horizontal segments at the same Y, vertical segments at the same X, and
+     * the other segments.  The caller has still to test if the point is actually
+     * on the segment.
+     *
+     * @param aPosition - The position to test.
+     * @param aSegments - The list of segments to add to.
+     */
+    void GetSegmentsAt( const wxPoint& aPosition, std::vector<SEGMENT>& aSegments ) const;
+
+private:
+    POSITION_MAP                                    m_positions;
+    std::unordered_map<int, std::vector<SEGMENT>>   m_horizontalSegments;   ///< by Y coordinate
+    std::unordered_map<int, std::vector<SEGMENT>>   m_verticalSegments;     ///< by X coordinate
+    std::vector<SEGMENT>                            m_otherSegments;
+};
+
+
 /**
  * Class SCH_ITEM
  * is a base class for any item which can be embedded within the SCHEMATIC
@@ -252,7 +305,7 @@ public:
 
     /**
      * Function IsDanglingStateChanged
-     * tests the schematic item to \a aItemList to check if it's dangling state has changed.
+     * tests the schematic item to \a aEndPoints to check if it's dangling state has changed.
      *
      * Note that the return value only true when the state of the test has changed.  Use
      * the IsDangling() method to get the current dangling state of the item.  Some of
@@ -260,10 +313,10 @@ public:
      * always returns false.  Only override the method if the item can be tested for a
      * dangling state.
      *
-     * @param aItemList - List of items to test item against.
+     * @param aEndPoints - Index of the end points to test item against.
      * @return True if the dangling state has changed from it's current setting.
      */
-    virtual bool IsDanglingStateChanged( std::vector< DANGLING_END_ITEM >& aItemList ) { return false; }
+    virtual bool IsDanglingStateChanged( const DANGLING_END_INDEX& aEndPoints ) { return false; }
 
     virtual bool IsDangling() const { return false; }
 
@@ -22,6 +22,8 @@
 
 #include <ctype.h>
 #include <algorithm>
+#include <cstdint>
+#include <thread>
 
 #include <wx/mstream.h>
 #include <wx/filename.h>
@@ -34,6 +36,7 @@
 #include <core/typeinfo.h>
 #include <properties.h>
 #include <standalone_scanf.h>
+#include <sync_queue.h>
 
 #include <general.h>
 #include <lib_field.h>
@@ -80,6 +83,11 @@ static int strncasecmp_ascii(const char *_l, const char *_r, size_t n)
 // Must be the first line of part library document (.dcm) files.
 #define DOCFILE_IDENT     "EESchema-DOCLIB  Version 2.0"
 
+// Must be the first line of part library index (.idx) files.
+#define INDEXFILE_IDENT   "EESchema-LIBRARY-INDEX Version 1"
+
+#define INDEX_EXT         "idx"
+
 #define SCH_PARSE_ERROR( text, reader, pos )                         \
     THROW_PARSE_ERROR( text, reader.GetSource(), reader.Line(),      \
                        reader.LineNumber(), pos - reader.Line() )
@@ -500,6 +508,35 @@ class SCH_LEGACY_PLUGIN_CACHE
     int             m_versionMinor;
     int             m_libType;      // Is this cache a component or symbol library.
 
+    /// Location of a DEF/ENDDEF part entry in the library file.
+    struct PART_INDEX_ENTRY
+    {
+        long            m_offset;       // File offset of the DEF line.
+        int             m_lineNumber;   // Line number of the DEF line.
+        wxArrayString   m_aliasNames;   // The part name followed by its aliases.
+    };
+
+    /// Documentation of an alias read in the document file before the alias is loaded.
+    struct ALIAS_DOC
+    {
+        wxString        m_description;
+        wxString        m_keyWords;
+        wxString        m_docFileName;
+    };
+
+    // Parts are loaded on demand: m_aliases only holds the loaded ones.  The aliases of the
+    // parts not loaded yet are in m_unloadedAliases, mapped to the part m_partIndex entry.
+    std::vector< PART_INDEX_ENTRY >             m_partIndex;
+    std::map< wxString, size_t, AliasMapSort >  m_unloadedAliases;
+    std::map< wxString, ALIAS_DOC >             m_unloadedDocs;
+
+    bool            buildPartIndex();
+    bool            loadPartIndex();
+    void            savePartIndex();
+    wxFileName      getPartIndexFileName() const;
+    void            loadIndexedPart( size_t aIndex );
+    void            loadAllParts();
+
     LIB_PART*       loadPart( FILE_LINE_READER& aReader );
     void            loadHeader( FILE_LINE_READER& aReader );
     void            loadAliases( std::unique_ptr< LIB_PART >& aPart, FILE_LINE_READER& aReader );
@@ -541,6 +578,25 @@ public:
 
     void Load();
 
+    /**
+     * Function FindAlias
+     * @return the alias \a aName, loading its part if it is not loaded yet, or NULL if the
+     * alias is not found.
+     */
+    LIB_ALIAS* FindAlias( const wxString& aName );
+
+    /// Return all the aliases of the library, loading all the parts.
+    const LIB_ALIAS_MAP& GetAliases()
+    {
+        loadAllParts();
+        return m_aliases;
+    }
+
+    /// Append the names of all the aliases, in the alias map order, to \a aNames.
+    void GetAliasNames( wxArrayString& aNames ) const;
+
+    size_t GetAliasCount() const { return m_aliases.size() + m_unloadedAliases.size(); }
+
     void AddSymbol( const LIB_PART* aPart );
 
     void DeleteAlias( const wxString& aAliasName );
@@ -579,6 +635,7 @@ void SCH_LEGACY_PLUGIN::init( KIWAY* aKiway, const PROPERTIES* aProperties )
 {
     m_version = 0;
     m_rootSheet = NULL;
+    m_rootModified = false;
     m_props = aProperties;
     m_kiway = aKiway;
     m_cache = NULL;
@@ -626,9 +683,134 @@ SCH_SHEET* SCH_LEGACY_PLUGIN::Load( const wxString& aFileName, KIWAY* aKiway,
 }
 
 
+void SCH_LEGACY_PLUGIN::loadHierarchy( SCH_SHEET* aSheet )
+{
+    // The files are parsed first, then linked to their sheets in the order of a serial load,
+    // so the hierarchy and the reported error (if any) do not depend on the parsing order.
+    LOADED_SCREENS screens;
+
+    try
+    {
+        loadSheetFiles( aSheet, screens );
+        loadHierarchy( aSheet, screens );
+    }
+    catch( ... )
+    {
+        for( LOADED_SCREENS::value_type& loaded : screens )
+            delete loaded.second.m_screen;
+
+        throw;
+    }
+
+    // Files which were parsed but are not used, like sub-sheets of a broken file.
+    for( LOADED_SCREENS::value_type& loaded : screens )
+        delete loaded.second.m_screen;
+}
+
+
+void SCH_LEGACY_PLUGIN::loadSheetFiles( SCH_SHEET* aSheet, LOADED_SCREENS& aScreens )
+{
+    std::vector< wxString > files;      // The files of the next hierarchy level.
+
+    auto addSheetFile = [&]( SCH_SHEET* aSubSheet )
+    {
+        if( aSubSheet->GetScreen() )
+            return;
+
+        wxFileName  fileName = aSubSheet->GetFileName();
+        SCH_SCREEN* screen = NULL;
+
+        if( !fileName.IsAbsolute() )
+            fileName.MakeAbsolute( m_path );
+
+        if( aScreens.count( fileName.GetFullPath() )
+            || m_rootSheet->SearchHierarchy( fileName.GetFullPath(), &screen ) )
+            return;
+
+        aScreens[ fileName.GetFullPath() ] = LOADED_SCREEN();
+        files.push_back( fileName.GetFullPath() );
+    };
+
+    addSheetFile( aSheet );
+
+    while( !files.empty() )
+    {
+        std::vector< wxString >         level;
+        std::vector< LOADED_SCREEN* >   loaded;
+
+        level.swap( files );
+
+        for( const wxString& file : level )
+        {
+            LOADED_SCREEN* screen = &aScreens[ file ];
+
+            screen->m_screen = new SCH_SCREEN( m_kiway );
+            screen->m_screen->SetFileName( file );
+            loaded.push_back( screen );
+        }
+
+        SYNC_QUEUE< size_t >        queue;
+        std::vector< std::thread >  threads;
+
+        for( size_t i = 0; i < level.size(); ++i )
+            queue.push( i );
+
+        size_t thread_count = std::min<size_t>( level.size(),
+                                                std::max( 1u, std::thread::hardware_concurrency() ) );
+
+        if( m_props && m_props->Exists( SCH_LEGACY_PLUGIN::PropSerialLoad ) )
+            thread_count = 1;
+
+        for( size_t i = 0; i < thread_count; ++i )
+        {
+            threads.push_back( std::thread( [&]() {
+                size_t idx;
+
+                while( queue.pop( idx ) )
+                {
+                    // The parser keeps the state of the file being read: one parser per file.
+                    SCH_LEGACY_PLUGIN parser;
+
+                    parser.init( m_kiway, m_props );
+                    parser.m_path = m_path;
+
+                    try
+                    {
+                        parser.loadFile( level[idx], loaded[idx]->m_screen );
+                    }
+                    catch( ... )
+                    {
+                        // An exception cannot leave a thread: keep it for loadHierarchy().
+                        loaded[idx]->m_error = std::current_exception();
+                    }
+
+                    loaded[idx]->m_rootModified = parser.m_rootModified;
+                }
+            } ) );
+        }
+
+        for( std::thread& thread : threads )
+            thread.join();
+
+        for( LOADED_SCREEN* screen : loaded )
+        {
+            // The sub-sheets of a broken file are not loaded.
+            if( screen->m_error )
+                continue;
+
+            for( EDA_ITEM* item = screen->m_screen->GetDrawItems(); item; item = item->Next() )
+            {
+                if( item->Type() == SCH_SHEET_T )
+                    addSheetFile( (SCH_SHEET*) item );
+            }
+        }
+    }
+}
+
+
 // Everything below this comment is recursive.  Modify with care.
 
-void SCH_LEGACY_PLUGIN::loadHierarchy( SCH_SHEET* aSheet )
+void SCH_LEGACY_PLUGIN::loadHierarchy( SCH_SHEET* aSheet, LOADED_SCREENS& aScreens )
 {
     SCH_SCREEN* screen = NULL;
 
@@ -652,9 +834,29 @@ void SCH_LEGACY_PLUGIN::loadHierarchy( SCH_SHEET* aSheet )
         }
         else
         {
-            aSheet->SetScreen( new SCH_SCREEN( m_kiway ) );
-            aSheet->GetScreen()->SetFileName( fileName.GetFullPath() );
-            loadFile( fileName.GetFullPath(), aSheet->GetScreen() );
+            LOADED_SCREENS::iterator it = aScreens.find( fileName.GetFullPath() );
+
+            if( it != aScreens.end() )
+            {
+                LOADED_SCREEN loaded = it->second;
+
+                aScreens.erase( it );
+                aSheet->SetScreen( loaded.m_screen );
+
+                if( loaded.m_rootModified && m_rootSheet->GetScreen() )
+                    m_rootSheet->GetScreen()->SetModify();
+
+                if( loaded.m_error )
+                    std::rethrow_exception( loaded.m_error );
+            }
+            else
+            {
+                // The root file is not searched by SearchHierarchy(), so it can be loaded
+                // a second time as a sub-sheet: it was not parsed ahead for that.
+                aSheet->SetScreen( new SCH_SCREEN( m_kiway ) );
+                aSheet->GetScreen()->SetFileName( fileName.GetFullPath() );
+                loadFile( fileName.GetFullPath(), aSheet->GetScreen() );
+            }
 
             EDA_ITEM* item = aSheet->GetScreen()->GetDrawItems();
 
@@ -672,7 +874,7 @@ void SCH_LEGACY_PLUGIN::loadHierarchy( SCH_SHEET* aSheet )
                     sheet->SetParent( aSheet );
 
                     // Recursion starts here.
-                    loadHierarchy( sheet );
+                    loadHierarchy( sheet, aScreens );
                 }
 
                 item = item->Next();
@@ -1363,6 +1565,8 @@ SCH_COMPONENT* SCH_LEGACY_PLUGIN::loadComponent( FILE_LINE_READER& aReader )
                 // Set the file as modified so the user can be warned.
                 if( m_rootSheet && m_rootSheet->GetScreen() )
                     m_rootSheet->GetScreen()->SetModify();
+                else
+                    m_rootModified = true;
             }
 
             component->SetUnit( unit );
@@ -2141,6 +2345,9 @@ LIB_ALIAS* SCH_LEGACY_PLUGIN_CACHE::removeAlias( LIB_ALIAS* aAlias )
 
 void SCH_LEGACY_PLUGIN_CACHE::AddSymbol( const LIB_PART* aPart )
 {
+    // Edited libraries are fully loaded: they are saved from the alias map.
+    loadAllParts();
+
     // aPart is cloned in PART_LIB::AddPart().  The cache takes ownership of aPart.
     wxArrayString aliasNames = aPart->GetAliasNames();
 
@@ -2214,7 +2421,19 @@ void SCH_LEGACY_PLUGIN_CACHE::Load()
         m_libType = LIBRARY_TYPE_EESCHEMA;
     }
 
-    while( reader.ReadLine() )
+    // Parts are only indexed here, and loaded when they are first used.  The index is kept
+    // in a file next to the library, so it is not rebuilt until the library is changed.
+    bool indexed = loadPartIndex();
+
+    if( !indexed && buildPartIndex() )
+    {
+        indexed = true;
+        savePartIndex();
+    }
+
+    // Libraries which cannot be indexed (broken libraries with duplicate names) are fully
+    // loaded, to keep the renaming of duplicates done by loadAliases().
+    while( !indexed && reader.ReadLine() )
     {
         line = reader.Line();
 
@@ -2245,13 +2464,352 @@ void SCH_LEGACY_PLUGIN_CACHE::Load()
 }
 
 
+// A string identifying the content of a library file, stored in its part index file.
+// The modification time only has a one second resolution, so a hash of the file content
+// (64 bit FNV-1a) is added: a library saved twice in the same second is not mistaken.
+static wxString libraryFileStamp( const wxFileName& aFileName )
+{
+    uint64_t hash = 14695981039346656037ULL;
+    FILE*    fp = wxFopen( aFileName.GetFullPath(), wxT( "rb" ) );
+
+    if( fp )
+    {
+        std::vector< unsigned char > buffer( 65536 );
+        size_t count;
+
+        while( ( count = fread( buffer.data(), 1, buffer.size(), fp ) ) > 0 )
+        {
+            for( size_t i = 0; i < count; i++ )
+            {
+                hash ^= buffer[i];
+                hash *= 1099511628211ULL;
+            }
+        }
+
+        fclose( fp );
+    }
+
+    return aFileName.GetSize().ToString() + wxT( " " ) +
+           aFileName.GetModificationTime().GetValue().ToString() + wxT( " " ) +
+           wxString::Format( wxT( "%016llX" ), (unsigned long long) hash );
+}
+
+
+wxFileName SCH_LEGACY_PLUGIN_CACHE::getPartIndexFileName() const
+{
+    wxFileName fn = m_libFileName;
+
+    fn.SetExt( INDEX_EXT );
+
+    return fn;
+}
+
+
+bool SCH_LEGACY_PLUGIN_CACHE::buildPartIndex()
+{
+    // The file position of the lines is needed, so the file is opened here.  It is opened
+    // in binary mode: text mode offsets are not usable by fseek() on all platforms, and the
+    // line reader handles CR/LF line ends.
+    FILE* fp = wxFopen( m_libFileName.GetFullPath(), wxT( "rb" ) );
+
+    if( !fp )
+        return false;
+
+    FILE_LINE_READER    reader( fp, m_libFileName.GetFullPath() );
+    std::vector< PART_INDEX_ENTRY >             index;
+    std::map< wxString, size_t, AliasMapSort >  aliases;
+    PART_INDEX_ENTRY*   entry = NULL;
+    long                offset = ftell( fp );
+
+    try
+    {
+        while( reader.ReadLine() )
+        {
+            const char* line = reader.Line();
+
+            if( !entry )
+            {
+                if( strCompare( "DEF", line, &line ) )
+                {
+                    wxString name;
+
+                    parseUnquotedString( name, reader, line, &line );
+
+                    // Same part name as the one given by loadPart().
+                    if( name[0] == '~' )
+                        name = name.Right( name.Length() - 1 );
+
+                    index.push_back( PART_INDEX_ENTRY() );
+                    entry = &index.back();
+                    entry->m_offset = offset;
+                    entry->m_lineNumber = reader.LineNumber();
+                    entry->m_aliasNames.Add( name );
+                }
+            }
+            else if( strCompare( "ALIAS", line, &line ) )
+            {
+                wxString alias;
+
+                parseUnquotedString( alias, reader, line, &line, true );
+
+                while( !alias.IsEmpty() )
+                {
+                    entry->m_aliasNames.Add( alias );
+                    alias.clear();
+                    parseUnquotedString( alias, reader, line, &line, true );
+                }
+            }
+            else if( strCompare( "ENDDEF", line ) )
+            {
+                for( size_t i = 0; i < entry->m_aliasNames.GetCount(); i++ )
+                {
+                    const wxString& name = entry->m_aliasNames[i];
+
+                    if( name.IsEmpty() ||
+                        !aliases.insert( std::make_pair( name, index.size() - 1 ) ).second )
+                        return false;
+                }
+
+                entry = NULL;
+            }
+
+            offset = ftell( fp );
+        }
+    }
+    catch( const IO_ERROR& )
+    {
+        // Let the full load report the error.
+        return false;
+    }
+
+    // A missing ENDDEF is also reported by the full load.
+    if( entry )
+        return false;
+
+    m_partIndex.swap( index );
+    m_unloadedAliases.swap( aliases );
+
+    return true;
+}
+
+
+bool SCH_LEGACY_PLUGIN_CACHE::loadPartIndex()
+{
+    wxFileName fn = getPartIndexFileName();
+
+    if( !fn.FileExists() )
+        return false;
+
+    std::vector< PART_INDEX_ENTRY >             index;
+    std::map< wxString, size_t, AliasMapSort >  aliases;
+
+    try
+    {
+        FILE_LINE_READER reader( fn.GetFullPath() );
+        const char* line = reader.ReadLine();
+
+        if( !line || !strCompare( INDEXFILE_IDENT, line ) )
+            return false;
+
+        // The index is only valid for the library file content it was built from.
+        line = reader.ReadLine();
+
+        if( !line || !strCompare( "Source", line, &line )
+            || FROM_UTF8( line ).Trim() != libraryFileStamp( m_libFileName ) )
+            return false;
+
+        while( reader.ReadLine() )
+        {
+            line = reader.Line();
+
+            if( strCompare( "#End", line ) )
+            {
+                m_partIndex.swap( index );
+                m_unloadedAliases.swap( aliases );
+                return true;
+            }
+
+            if( !strCompare( "DEF", line, &line ) )
+                return false;
+
+            PART_INDEX_ENTRY entry;
+            wxString         name;
+
+            entry.m_offset = parseInt( reader, line, &line );
+            entry.m_lineNumber = parseInt( reader, line, &line );
+            parseUnquotedString( name, reader, line, &line );
+
+            while( !name.IsEmpty() )
+            {
+                if( !aliases.insert( std::make_pair( name, index.size() ) ).second )
+                    return false;
+
+                entry.m_aliasNames.Add( name );
+                name.clear();
+                parseUnquotedString( name, reader, line, &line, true );
+            }
+
+            index.push_back( entry );
+        }
+    }
+    catch( const IO_ERROR& )
+    {
+    }
+
+    // A truncated or broken index is rebuilt.
+    return false;
+}
+
+
+void SCH_LEGACY_PLUGIN_CACHE::savePartIndex()
+{
+    wxFileName fn = getPartIndexFileName();
+
+    // The index is only an optimization: libraries in read only folders are not indexed.
+    if( !fn.IsDirWritable() || ( fn.FileExists() && !fn.IsFileWritable() ) )
+        return;
+
+    try
+    {
+        FILE_OUTPUTFORMATTER formatter( fn.GetFullPath() );
+
+        formatter.Print( 0, "%s\n", INDEXFILE_IDENT );
+        formatter.Print( 0, "Source %s\n", TO_UTF8( libraryFileStamp( m_libFileName ) ) );
+
+        for( const PART_INDEX_ENTRY& entry : m_partIndex )
+        {
+            formatter.Print( 0, "DEF %ld %d", entry.m_offset, entry.m_lineNumber );
+
+            for( size_t i = 0; i < entry.m_aliasNames.GetCount(); i++ )
+                formatter.Print( 0, " %s", TO_UTF8( entry.m_aliasNames[i] ) );
+
+            formatter.Print( 0, "\n" );
+        }
+
+        formatter.Print( 0, "#End Index\n" );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        wxLogTrace( traceSchLegacyPlugin, "Cannot save part index of library '%s': %s",
+                    m_libFileName.GetFullPath(), ioe.What() );
+    }
+}
+
+
+void SCH_LEGACY_PLUGIN_CACHE::loadIndexedPart( size_t aIndex )
+{
+    wxCHECK_RET( aIndex < m_partIndex.size(), "Invalid part index." );
+
+    const PART_INDEX_ENTRY& entry = m_partIndex[ aIndex ];
+
+    // The part is not pending anymore, even if it cannot be loaded: it is tried only once.
+    for( size_t i = 0; i < entry.m_aliasNames.GetCount(); i++ )
+        m_unloadedAliases.erase( entry.m_aliasNames[i] );
+
+    wxString fileName = m_libFileName.GetFullPath();
+
+    try
+    {
+        // Binary mode, as in buildPartIndex(), so the indexed offsets are valid.
+        FILE* fp = wxFopen( fileName, wxT( "rb" ) );
+
+        if( !fp )
+            THROW_IO_ERROR( wxString::Format( _( "cannot open library file '%s'" ), fileName ) );
+
+        FILE_LINE_READER reader( fp, fileName, true, entry.m_lineNumber - 1 );
+
+        if( fseek( fp, entry.m_offset, SEEK_SET ) != 0 || !reader.ReadLine()
+            || !strCompare( "DEF", reader.Line() ) )
+            THROW_IO_ERROR( wxString::Format( _( "symbol '%s' not found at its indexed position "
+                                                 "in library file '%s'" ),
+                                              entry.m_aliasNames[0], fileName ) );
+
+        loadPart( reader );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        // The library was indexed without error, so only this part is broken (or the file
+        // was modified behind our back).  Skip it, as the document file errors are skipped.
+        wxLogWarning( "Symbol '%s' cannot be loaded from library:\n\n'%s'\n\n%s",
+                      entry.m_aliasNames[0], fileName, ioe.What() );
+        return;
+    }
+
+    // Set the documentation read before the part was loaded.
+    for( size_t i = 0; i < entry.m_aliasNames.GetCount(); i++ )
+    {
+        auto doc = m_unloadedDocs.find( entry.m_aliasNames[i] );
+
+        if( doc == m_unloadedDocs.end() )
+            continue;
+
+        LIB_ALIAS_MAP::iterator it = m_aliases.find( entry.m_aliasNames[i] );
+
+        if( it != m_aliases.end() )
+        {
+            it->second->SetDescription( doc->second.m_description );
+            it->second->SetKeyWords( doc->second.m_keyWords );
+            it->second->SetDocFileName( doc->second.m_docFileName );
+        }
+
+        m_unloadedDocs.erase( doc );
+    }
+}
+
+
+void SCH_LEGACY_PLUGIN_CACHE::loadAllParts()
+{
+    while( !m_unloadedAliases.empty() )
+        loadIndexedPart( m_unloadedAliases.begin()->second );
+}
+
+
+LIB_ALIAS* SCH_LEGACY_PLUGIN_CACHE::FindAlias( const wxString& aName )
+{
+    LIB_ALIAS_MAP::const_iterator it = m_aliases.find( aName );
+
+    if( it != m_aliases.end() )
+        return it->second;
+
+    auto unloaded = m_unloadedAliases.find( aName );
+
+    if( unloaded == m_unloadedAliases.end() )
+        return NULL;
+
+    loadIndexedPart( unloaded->second );
+
+    it = m_aliases.find( aName );
+
+    return ( it != m_aliases.end() ) ? it->second : NULL;
+}
+
+
+void SCH_LEGACY_PLUGIN_CACHE::GetAliasNames( wxArrayString& aNames ) const
+{
+    // Both maps use the same sort order: merge them.
+    AliasMapSort less;
+    LIB_ALIAS_MAP::const_iterator loaded = m_aliases.begin();
+    auto unloaded = m_unloadedAliases.begin();
+
+    while( loaded != m_aliases.end() || unloaded != m_unloadedAliases.end() )
+    {
+        if( unloaded == m_unloadedAliases.end()
+            || ( loaded != m_aliases.end() && less( loaded->first, unloaded->first ) ) )
+            aNames.Add( ( loaded++ )->first );
+        else
+            aNames.Add( ( unloaded++ )->first );
+    }
+}
+
+
 void SCH_LEGACY_PLUGIN_CACHE::loadDocs()
 {
     const char* line;
     wxString    text;
     wxString    aliasName;
     wxFileName  fn = m_libFileName;
-    LIB_ALIAS*  alias = NULL;;
+    LIB_ALIAS*  alias;
+    ALIAS_DOC*  doc;
 
     fn.SetExt( DOC_EXT );
 
@@ -2288,12 +2846,17 @@ void SCH_LEGACY_PLUGIN_CACHE::loadDocs()
 
         LIB_ALIAS_MAP::iterator it = m_aliases.find( aliasName );
 
-        if( it == m_aliases.end() )
+        alias = NULL;
+        doc = NULL;
+
+        if( it != m_aliases.end() )
+            alias = it->second;
+        else if( m_unloadedAliases.count( aliasName ) )
+            doc = &m_unloadedDocs[ aliasName ];     // Set when the alias is loaded.
+        else
             wxLogWarning( "Alias '%s' not found in library:\n\n"
                           "'%s'\n\nat line %d offset %d", aliasName, fn.GetFullPath(),
                           reader.LineNumber(), (int) (line - reader.Line() ) );
-        else
-            alias = it->second;
 
         // Read the curent alias associated doc.
         // if the alias does not exist, just skip the description
@@ -2316,16 +2879,22 @@ void SCH_LEGACY_PLUGIN_CACHE::loadDocs()
             case 'D':
                 if( alias )
                     alias->SetDescription( text );
+                else if( doc )
+                    doc->m_description = text;
                 break;
 
             case 'K':
                 if( alias )
                     alias->SetKeyWords( text );
+                else if( doc )
+                    doc->m_keyWords = text;
                 break;
 
             case 'F':
                 if( alias )
                     alias->SetDocFileName( text );
+                else if( doc )
+                    doc->m_docFileName = text;
                 break;
 
             case '#':
@@ -3299,6 +3868,8 @@ void SCH_LEGACY_PLUGIN_CACHE::Save( bool aSaveDocFile )
     if( !m_isModified )
         return;
 
+    loadAllParts();
+
     std::unique_ptr< FILE_OUTPUTFORMATTER > formatter( new FILE_OUTPUTFORMATTER( m_libFileName.GetFullPath() ) );
     formatter->Print( 0, "%s %d.%d\n", LIBFILE_IDENT, LIB_VERSION_MAJOR, LIB_VERSION_MINOR );
     formatter->Print( 0, "#encoding utf-8\n");
@@ -3317,6 +3888,12 @@ void SCH_LEGACY_PLUGIN_CACHE::Save( bool aSaveDocFile )
     m_fileModTime = m_libFileName.GetModificationTime();
     m_isModified = false;
 
+    // The part index of the previous file content is no longer valid.
+    wxFileName indexFileName = getPartIndexFileName();
+
+    if( indexFileName.FileExists() )
+        wxRemoveFile( indexFileName.GetFullPath() );
+
     if( aSaveDocFile )
         saveDocFile();
 }
@@ -3342,6 +3919,8 @@ void SCH_LEGACY_PLUGIN_CACHE::saveDocFile()
 
 void SCH_LEGACY_PLUGIN_CACHE::DeleteAlias( const wxString& aAliasName )
 {
+    loadAllParts();
+
     LIB_ALIAS_MAP::iterator it = m_aliases.find( aAliasName );
 
     if( it == m_aliases.end() )
@@ -3377,6 +3956,8 @@ void SCH_LEGACY_PLUGIN_CACHE::DeleteAlias( const wxString& aAliasName )
 
 void SCH_LEGACY_PLUGIN_CACHE::DeleteSymbol( const wxString& aAliasName )
 {
+    loadAllParts();
+
     LIB_ALIAS_MAP::iterator it = m_aliases.find( aAliasName );
 
     if( it == m_aliases.end() )
@@ -3447,7 +4028,7 @@ size_t SCH_LEGACY_PLUGIN::GetSymbolLibCount( const wxString&   aLibraryPath,
 
     cacheLib( aLibraryPath );
 
-    return m_cache->m_aliases.size();
+    return m_cache->GetAliasCount();
 }
 
 
@@ -3459,10 +4040,7 @@ void SCH_LEGACY_PLUGIN::EnumerateSymbolLib( wxArrayString&    aAliasNameList,
 
     cacheLib( aLibraryPath );
 
-    const LIB_ALIAS_MAP& aliases = m_cache->m_aliases;
-
-    for( LIB_ALIAS_MAP::const_iterator it = aliases.begin();  it != aliases.end();  ++it )
-        aAliasNameList.Add( it->first );
+    m_cache->GetAliasNames( aAliasNameList );
 }
 
 
@@ -3474,7 +4052,7 @@ void SCH_LEGACY_PLUGIN::EnumerateSymbolLib( std::vector<LIB_ALIAS*>& aAliasList,
 
     cacheLib( aLibraryPath );
 
-    const LIB_ALIAS_MAP& aliases = m_cache->m_aliases;
+    const LIB_ALIAS_MAP& aliases = m_cache->GetAliases();
 
     for( LIB_ALIAS_MAP::const_iterator it = aliases.begin();  it != aliases.end();  ++it )
         aAliasList.push_back( it->second );
@@ -3488,12 +4066,7 @@ LIB_ALIAS* SCH_LEGACY_PLUGIN::LoadSymbol( const wxString& aLibraryPath, const wx
 
     cacheLib( aLibraryPath );
 
-    LIB_ALIAS_MAP::const_iterator it = m_cache->m_aliases.find( aAliasName );
-
-    if( it == m_cache->m_aliases.end() )
-        return NULL;
-
-    return it->second;
+    return m_cache->FindAlias( aAliasName );
 }
 
 
@@ -3606,3 +4179,4 @@ void SCH_LEGACY_PLUGIN::SaveLibrary( const wxString& aLibraryPath, const PROPERT
 
 const char* SCH_LEGACY_PLUGIN::PropBuffering = "buffering";
 const char* SCH_LEGACY_PLUGIN::PropNoDocFile = "no_doc_file";
+const char* SCH_LEGACY_PLUGIN::PropSerialLoad = "serial_load";
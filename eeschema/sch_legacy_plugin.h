@@ -23,6 +23,9 @@
  * with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <exception>
+#include <map>
+
 #include <sch_io_mgr.h>
 
 
@@ -92,6 +95,14 @@ public:
      */
     static const char* PropNoDocFile;
 
+    /**
+     * const char* PropSerialLoad
+     *
+     * is a property used to parse the sheet files of a hierarchy one at a time, instead
+     * of in parallel.  The result is the same, it is used to measure the parallel load.
+     */
+    static const char* PropSerialLoad;
+
     int GetModifyHash() const override;
 
     SCH_SHEET* Load( const wxString& aFileName, KIWAY* aKiway,
@@ -125,7 +136,28 @@ public:
     void SaveLibrary( const wxString& aLibraryPath, const PROPERTIES* aProperties = NULL ) override;
 
 private:
+    /// A schematic file parsed by loadSheetFiles(), before being linked to its sheet.
+    struct LOADED_SCREEN
+    {
+        SCH_SCREEN*         m_screen;
+        std::exception_ptr  m_error;        ///< The parse error, rethrown when it is linked.
+        bool                m_rootModified; ///< Broken data was fixed while parsing the file.
+
+        LOADED_SCREEN() : m_screen( NULL ), m_rootModified( false ) {}
+    };
+
+    /// Parsed files, by full path name.
+    typedef std::map< wxString, LOADED_SCREEN > LOADED_SCREENS;
+
     void loadHierarchy( SCH_SHEET* aSheet );
+    void loadHierarchy( SCH_SHEET* aSheet, LOADED_SCREENS& aScreens );
+
+    /**
+     * Function loadSheetFiles
+     * parses the files of the hierarchy of \a aSheet not loaded yet, one hierarchy level
+     * at a time.  The files of a level are parsed in parallel, each of them only once.
+     */
+    void loadSheetFiles( SCH_SHEET* aSheet, LOADED_SCREENS& aScreens );
     void loadHeader( FILE_LINE_READER& aReader, SCH_SCREEN* aScreen );
     void loadPageSettings( FILE_LINE_READER& aReader, SCH_SCREEN* aScreen );
     void loadFile( const wxString& aFileName, SCH_SCREEN* aScreen );
@@ -159,6 +191,7 @@ protected:
     const PROPERTIES* m_props;      ///< Passed via Save() or Load(), no ownership, may be NULL.
     KIWAY*            m_kiway;      ///< Required for path to legacy component libraries.
     SCH_SHEET*        m_rootSheet;  ///< The root sheet of the schematic being loaded..
+    bool              m_rootModified; ///< The root screen must be set modified after loading.
     FILE_OUTPUTFORMATTER* m_out;    ///< The output formatter for saving SCH_SCREEN objects.
     SCH_LEGACY_PLUGIN_CACHE* m_cache;
 
@@ -369,7 +369,7 @@ void SCH_LINE::GetEndPoints( std::vector <DANGLING_END_ITEM>& aItemList )
 }
 
 
-bool SCH_LINE::IsDanglingStateChanged( std::vector< DANGLING_END_ITEM >& aItemList )
+bool SCH_LINE::IsDanglingStateChanged( const DANGLING_END_INDEX& aEndPoints )
 {
     bool previousStartState = m_startIsDangling;
     bool previousEndState = m_endIsDangling;
@@ -378,23 +378,24 @@ bool SCH_LINE::IsDanglingStateChanged( std::vector< DANGLING_END_ITEM >& aItemLi
 
     if( GetLayer() == LAYER_WIRE )
     {
-        for( DANGLING_END_ITEM item : aItemList )
+        // An end is connected if any other item, except a no connect, is at the same position
+        auto isConnected = [&]( const wxPoint& aPosition ) -> bool
         {
-            if( item.GetItem() == this )
-                continue;
+            DANGLING_END_INDEX::RANGE range = aEndPoints.GetItemsAt( aPosition );
 
-            if( item.GetType() == NO_CONNECT_END )
-                continue;
+            for( auto it = range.first; it != range.second; ++it )
+            {
+                const DANGLING_END_ITEM* item = it->second;
 
-            if( m_start == item.GetPosition() )
-                m_startIsDangling = false;
+                if( item->GetItem() != this && item->GetType() != NO_CONNECT_END )
+                    return true;
+            }
 
-            if( m_end == item.GetPosition() )
-                m_endIsDangling = false;
+            return false;
+        };
 
-            if( (m_startIsDangling == false) && (m_endIsDangling == false) )
-                break;
-        }
+        m_startIsDangling = !isConnected( m_start );
+        m_endIsDangling = !isConnected( m_end );
     }
     else if( GetLayer() == LAYER_BUS || GetLayer() == LAYER_NOTES )
     {
@@ -459,6 +459,9 @@ public:
 #endif
 
 private:
+    /// The indexes used by Annotate() to replace the searches in the whole list.
+    class ANNOTATION_STATE;
+
     /* sort functions used to sort componentFlatList
     */
 
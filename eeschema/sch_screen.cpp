@@ -53,6 +53,10 @@
 #include <sch_component.h>
 #include <sch_text.h>
 #include <lib_pin.h>
+#include <hashtables.h>
+
+#include <algorithm>
+#include <unordered_set>
 
 
 #define EESCHEMA_FILE_STAMP   "EESchema"
@@ -98,6 +102,9 @@ SCH_SCREEN::SCH_SCREEN( KIWAY* aKiway ) :
     m_paper( wxT( "A4" ) )
 {
     m_modification_sync = 0;
+    m_itemsIndexValid = false;
+    m_itemsIndexNextRank = 0;
+    m_itemsIndexModifyCount = 0;
 
     SetZoom( 32 );
 
@@ -151,12 +158,14 @@ void SCH_SCREEN::Clear()
 
 void SCH_SCREEN::FreeDrawList()
 {
+    InvalidateItemsIndex();
     m_drawList.DeleteAll();
 }
 
 
 void SCH_SCREEN::Remove( SCH_ITEM* aItem )
 {
+    removeFromItemsIndex( aItem );
     m_drawList.Remove( aItem );
 }
 
@@ -165,8 +174,14 @@ void SCH_SCREEN::DeleteItem( SCH_ITEM* aItem )
 {
     wxCHECK_RET( aItem, wxT( "Cannot delete invalid item from screen." ) );
 
+    // The index is updated below, this change must not make an up to date index stale.
+    bool indexUpToDate = m_itemsIndexModifyCount == GetModifyCount();
+
     SetModify();
 
+    if( indexUpToDate )
+        m_itemsIndexModifyCount = GetModifyCount();
+
     if( aItem->Type() == SCH_SHEET_PIN_T )
     {
         // This structure is attached to a sheet, get the parent sheet object.
@@ -175,15 +190,131 @@ void SCH_SCREEN::DeleteItem( SCH_ITEM* aItem )
         wxCHECK_RET( sheet,
                      wxT( "Sheet label parent not properly set, bad programmer!" ) );
         sheet->RemovePin( sheetPin );
+        InvalidateItemsIndex();
         return;
     }
     else
     {
+        removeFromItemsIndex( aItem );
         delete m_drawList.Remove( aItem );
     }
 }
 
 
+// The area of an item in the spatial index: it must contain every point where the item
+// can be found by the SCH_SCREEN search functions.
+static EDA_RECT itemsIndexArea( const SCH_ITEM* aItem )
+{
+    EDA_RECT area = aItem->GetBoundingBox();
+    std::vector< wxPoint > connections;
+
+    area.Normalize();
+    aItem->GetConnectionPoints( connections );
+
+    for( const wxPoint& pt : connections )
+        area.Merge( pt );
+
+    if( aItem->Type() == SCH_SHEET_T )
+    {
+        for( const SCH_SHEET_PIN& pin : ( (const SCH_SHEET*) aItem )->GetPins() )
+            area.Merge( pin.GetBoundingBox() );
+    }
+
+    // Bounding boxes are [pos,dim) in nature, but the hit tests include their end.
+    area.Inflate( 1 );
+
+    return area;
+}
+
+
+void SCH_SCREEN::clearItemsIndex() const
+{
+    m_itemsIndex.RemoveAll();
+    m_indexedItems.clear();
+    m_itemsIndexValid = false;
+}
+
+
+void SCH_SCREEN::addToItemsIndex( SCH_ITEM* aItem ) const
+{
+    if( !m_itemsIndexValid )
+        return;
+
+    INDEXED_ITEM& indexed = m_indexedItems[ aItem ];
+    indexed.m_area = itemsIndexArea( aItem );
+    indexed.m_rank = m_itemsIndexNextRank++;
+
+    int mmin[2] = { indexed.m_area.GetX(), indexed.m_area.GetY() };
+    int mmax[2] = { indexed.m_area.GetRight(), indexed.m_area.GetBottom() };
+    m_itemsIndex.Insert( mmin, mmax, aItem );
+}
+
+
+void SCH_SCREEN::removeFromItemsIndex( SCH_ITEM* aItem ) const
+{
+    if( !m_itemsIndexValid )
+        return;
+
+    auto it = m_indexedItems.find( aItem );
+
+    if( it == m_indexedItems.end() )
+        return;
+
+    const EDA_RECT& area = it->second.m_area;
+    int mmin[2] = { area.GetX(), area.GetY() };
+    int mmax[2] = { area.GetRight(), area.GetBottom() };
+    m_itemsIndex.Remove( mmin, mmax, aItem );
+    m_indexedItems.erase( it );
+}
+
+
+void SCH_SCREEN::queryItems( const wxPoint& aPosition, int aAccuracy,
+                             std::vector< SCH_ITEM* >& aItems ) const
+{
+    // Items can be moved or edited with only a SetModify() call, so a change of the
+    // modification count makes the index stale.
+    if( m_itemsIndexValid && m_itemsIndexModifyCount != GetModifyCount() )
+        clearItemsIndex();
+
+    if( !m_itemsIndexValid )
+    {
+        m_itemsIndexValid = true;
+        m_itemsIndexNextRank = 0;
+        m_itemsIndexModifyCount = GetModifyCount();
+
+        for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+            addToItemsIndex( item );
+    }
+
+    aAccuracy = std::abs( aAccuracy );
+
+    int mmin[2] = { aPosition.x - aAccuracy, aPosition.y - aAccuracy };
+    int mmax[2] = { aPosition.x + aAccuracy, aPosition.y + aAccuracy };
+
+    auto collector = [&aItems]( SCH_ITEM* aItem ) -> bool
+    {
+        aItems.push_back( aItem );
+        return true;
+    };
+
+    m_itemsIndex.Search( mmin, mmax, collector );
+
+    // The current item may be moving: it is not where it was indexed until SetModify().
+    SCH_ITEM* curItem = GetCurItem();
+
+    if( curItem && m_indexedItems.count( curItem )
+        && std::find( aItems.begin(), aItems.end(), curItem ) == aItems.end() )
+        aItems.push_back( curItem );
+
+    // When several items are found, the first one in the draw list wins, as in a list walk.
+    std::sort( aItems.begin(), aItems.end(),
+               [this]( const SCH_ITEM* a, const SCH_ITEM* b )
+               {
+                   return m_indexedItems.at( a ).m_rank < m_indexedItems.at( b ).m_rank;
+               } );
+}
+
+
 bool SCH_SCREEN::CheckIfOnDrawList( SCH_ITEM* aItem )
 {
     SCH_ITEM* itemList = m_drawList.begin();
@@ -202,7 +333,10 @@ bool SCH_SCREEN::CheckIfOnDrawList( SCH_ITEM* aItem )
 
 SCH_ITEM* SCH_SCREEN::GetItem( const wxPoint& aPosition, int aAccuracy, KICAD_T aType ) const
 {
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    std::vector< SCH_ITEM* > candidates;
+    queryItems( aPosition, aAccuracy, candidates );
+
+    for( SCH_ITEM* item : candidates )
     {
         if( item->HitTest( aPosition, aAccuracy ) && (aType == NOT_USED) )
             return item;
@@ -243,6 +377,8 @@ void SCH_SCREEN::ExtractWires( DLIST< SCH_ITEM >& aList, bool aCreateCopy )
     SCH_ITEM* item;
     SCH_ITEM* next_item;
 
+    InvalidateItemsIndex();
+
     for( item = m_drawList.begin(); item; item = next_item )
     {
         next_item = item->Next();
@@ -289,6 +425,7 @@ void SCH_SCREEN::ReplaceWires( DLIST< SCH_ITEM >& aWireList )
     }
 
     m_drawList.Append( aWireList );
+    InvalidateItemsIndex();
 }
 
 
@@ -297,7 +434,18 @@ void SCH_SCREEN::MarkConnections( SCH_LINE* aSegment )
     wxCHECK_RET( (aSegment) && (aSegment->Type() == SCH_LINE_T),
                  wxT( "Invalid object pointer." ) );
 
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    // Only the items found at an end point of aSegment can be connected to it.
+    std::vector< SCH_ITEM* > candidates;
+    queryItems( aSegment->GetStartPoint(), 0, candidates );
+
+    if( aSegment->GetEndPoint() != aSegment->GetStartPoint() )
+    {
+        queryItems( aSegment->GetEndPoint(), 0, candidates );
+        candidates.erase( std::unique( candidates.begin(), candidates.end() ),
+                          candidates.end() );
+    }
+
+    for( SCH_ITEM* item : candidates )
     {
         if( item->GetFlags() & CANDIDATE )
             continue;
@@ -425,50 +573,172 @@ bool SCH_SCREEN::IsTerminalPoint( const wxPoint& aPosition, int aLayer )
 
 bool SCH_SCREEN::SchematicCleanUp()
 {
-    bool      modified = false;
+    // Two lines can be merged only if they have a common end point, and a junction
+    // is a duplicate only if it covers the position of another junction.
+    // So instead of comparing each item to all the others, candidates are found
+    // from hash tables of the line end points and of the junction positions.
+    // The result is the same as comparing the items in the draw list order.
+    typedef std::unordered_multimap<wxPoint, size_t, WXPOINT_HASH> LINE_ENDS_MAP;
+
+    std::vector<SCH_LINE*>          lines;
+    std::vector<SCH_JUNCTION*>      junctions;
+    LINE_ENDS_MAP                   lineEnds;     // index in lines of the lines ending at a point
+    std::unordered_set<SCH_ITEM*>   removed;      // items merged into another one
 
-    for( SCH_ITEM* item = m_drawList.begin() ; item; item = item->Next() )
+    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
     {
-        if( ( item->Type() != SCH_LINE_T ) && ( item->Type() != SCH_JUNCTION_T ) )
+        if( item->Type() == SCH_LINE_T )
+            lines.push_back( (SCH_LINE*) item );
+        else if( item->Type() == SCH_JUNCTION_T )
+            junctions.push_back( (SCH_JUNCTION*) item );
+    }
+
+    auto removeLineEnd = [&]( const wxPoint& aPoint, size_t aLineIdx )
+    {
+        auto range = lineEnds.equal_range( aPoint );
+
+        for( auto it = range.first; it != range.second; ++it )
+        {
+            if( it->second == aLineIdx )
+            {
+                lineEnds.erase( it );
+                return;
+            }
+        }
+    };
+
+    for( size_t ii = 0; ii < lines.size(); ii++ )
+    {
+        lineEnds.emplace( lines[ii]->GetStartPoint(), ii );
+        lineEnds.emplace( lines[ii]->GetEndPoint(), ii );
+    }
+
+    // Each line absorbs the lines it can be merged with. SCH_LINE::MergeOverlap() is not
+    // symmetric, so as long as a line is not modified, it is only tested against the next
+    // lines in list, and candidates are always tested in the list order.
+    std::vector<size_t> candidates;
+
+    for( size_t ii = 0; ii < lines.size(); ii++ )
+    {
+        SCH_LINE* line = lines[ii];
+
+        if( removed.count( line ) )
             continue;
 
-        bool restart;
+        bool modified = false;
+        bool merged;
 
-        for( SCH_ITEM* testItem = item->Next(); testItem; testItem = restart ? m_drawList.begin() : testItem->Next() )
+        do
         {
-            restart = false;
+            merged = false;
+            const wxPoint ends[2] = { line->GetStartPoint(), line->GetEndPoint() };
 
-            if( ( item->Type() == SCH_LINE_T ) && ( testItem->Type() == SCH_LINE_T ) )
+            candidates.clear();
+
+            for( const wxPoint& end : ends )
             {
-                SCH_LINE* line = (SCH_LINE*) item;
+                auto range = lineEnds.equal_range( end );
 
-                if( line->MergeOverlap( (SCH_LINE*) testItem ) )
+                for( auto it = range.first; it != range.second; ++it )
                 {
-                    // Keep the current flags, because the deleted segment can be flagged.
-                    item->SetFlags( testItem->GetFlags() );
-                    DeleteItem( testItem );
-                    restart = true;
-                    modified = true;
+                    if( it->second > ii || ( modified && it->second != ii ) )
+                        candidates.push_back( it->second );
                 }
             }
-            else if ( ( ( item->Type() == SCH_JUNCTION_T )
-                      && ( testItem->Type() == SCH_JUNCTION_T ) ) && ( testItem != item ) )
+
+            std::sort( candidates.begin(), candidates.end() );
+            candidates.erase( std::unique( candidates.begin(), candidates.end() ),
+                              candidates.end() );
+
+            for( size_t candidate : candidates )
             {
-                if ( testItem->HitTest( item->GetPosition() ) )
+                SCH_LINE* testLine = lines[candidate];
+
+                if( !line->MergeOverlap( testLine ) )
+                    continue;
+
+                // Keep the current flags, because the deleted segment can be flagged.
+                line->SetFlags( testLine->GetFlags() );
+
+                removeLineEnd( testLine->GetStartPoint(), candidate );
+                removeLineEnd( testLine->GetEndPoint(), candidate );
+                removeLineEnd( ends[0], ii );
+                removeLineEnd( ends[1], ii );
+                lineEnds.emplace( line->GetStartPoint(), ii );
+                lineEnds.emplace( line->GetEndPoint(), ii );
+
+                removed.insert( testLine );
+                modified = merged = true;
+                break;
+            }
+        } while( merged );
+    }
+
+    // Junctions are stored by cells larger than a junction, so a junction covering
+    // the position of another one is in the same cell or in a neighbor cell.
+    int cellSize = 1;
+
+    for( SCH_JUNCTION* junction : junctions )
+    {
+        EDA_RECT box = junction->GetBoundingBox();
+        cellSize = std::max( cellSize, std::max( box.GetWidth(), box.GetHeight() ) );
+    }
+
+    std::unordered_map<wxPoint, std::vector<SCH_JUNCTION*>, WXPOINT_HASH> junctionCells;
+
+    for( SCH_JUNCTION* junction : junctions )
+    {
+        EDA_RECT box = junction->GetBoundingBox();
+        box.Normalize();
+
+        SCH_JUNCTION* duplicate = NULL;
+
+        for( int x = box.GetX() / cellSize; x <= box.GetRight() / cellSize && !duplicate; x++ )
+        {
+            for( int y = box.GetY() / cellSize; y <= box.GetBottom() / cellSize; y++ )
+            {
+                auto cell = junctionCells.find( wxPoint( x, y ) );
+
+                if( cell == junctionCells.end() )
+                    continue;
+
+                for( SCH_JUNCTION* kept : cell->second )
                 {
-                    // Keep the current flags, because the deleted segment can be flagged.
-                    item->SetFlags( testItem->GetFlags() );
-                    DeleteItem( testItem );
-                    restart = true;
-                    modified = true;
+                    if( junction->HitTest( kept->GetPosition(), 0 ) )
+                    {
+                        duplicate = kept;
+                        break;
+                    }
                 }
+
+                if( duplicate )
+                    break;
             }
         }
+
+        if( duplicate )
+        {
+            // Keep the current flags, because the deleted junction can be flagged.
+            duplicate->SetFlags( junction->GetFlags() );
+            removed.insert( junction );
+        }
+        else
+        {
+            wxPoint pos = junction->GetPosition();
+            junctionCells[ wxPoint( pos.x / cellSize, pos.y / cellSize ) ].push_back( junction );
+        }
     }
 
+    for( SCH_ITEM* item : removed )
+        DeleteItem( item );
+
+    // Merged lines have a new length.
+    if( !removed.empty() )
+        InvalidateItemsIndex();
+
     TestDanglingEnds();
 
-    return modified;
+    return !removed.empty();
 }
 
 
@@ -549,6 +819,9 @@ void SCH_SCREEN::CheckComponentsToPartsLinks()
 
             SCH_COMPONENT::ResolveAll( c, libs );
 
+            // The component shapes come from the libraries.
+            InvalidateItemsIndex();
+
             m_modification_sync = mod_hash;     // note the last mod_hash
         }
     }
@@ -628,11 +901,13 @@ void SCH_SCREEN::ClearDrawingState()
 LIB_PIN* SCH_SCREEN::GetPin( const wxPoint& aPosition, SCH_COMPONENT** aComponent,
                              bool aEndPointOnly ) const
 {
-    SCH_ITEM*       item;
     SCH_COMPONENT*  component = NULL;
     LIB_PIN*        pin = NULL;
 
-    for( item = m_drawList.begin(); item; item = item->Next() )
+    std::vector< SCH_ITEM* > candidates;
+    queryItems( aPosition, 0, candidates );
+
+    for( SCH_ITEM* item : candidates )
     {
         if( item->Type() != SCH_COMPONENT_T )
             continue;
@@ -702,7 +977,10 @@ SCH_SHEET_PIN* SCH_SCREEN::GetSheetLabel( const wxPoint& aPosition )
 {
     SCH_SHEET_PIN* sheetPin = NULL;
 
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    std::vector< SCH_ITEM* > candidates;
+    queryItems( aPosition, 0, candidates );
+
+    for( SCH_ITEM* item : candidates )
     {
         if( item->Type() != SCH_SHEET_T )
             continue;
@@ -720,10 +998,12 @@ SCH_SHEET_PIN* SCH_SCREEN::GetSheetLabel( const wxPoint& aPosition )
 
 int SCH_SCREEN::CountConnectedItems( const wxPoint& aPos, bool aTestJunctions ) const
 {
-    SCH_ITEM* item;
     int       count = 0;
 
-    for( item = m_drawList.begin(); item; item = item->Next() )
+    std::vector< SCH_ITEM* > candidates;
+    queryItems( aPos, 0, candidates );
+
+    for( SCH_ITEM* item : candidates )
     {
         if( item->Type() == SCH_JUNCTION_T  && !aTestJunctions )
             continue;
@@ -788,6 +1068,9 @@ void SCH_SCREEN::SelectBlockItems()
         return;
 
     // Select all the items in the screen connected to the items in the block.
+    // Items can have been moved since the last search: rebuild the items index.
+    InvalidateItemsIndex();
+
     // be sure end lines that are on the block limits are seen inside this block
     m_BlockLocate.Inflate( 1 );
     unsigned last_select_id = pickedlist->GetCount();
@@ -834,11 +1117,13 @@ void SCH_SCREEN::SelectBlockItems()
 
 void SCH_SCREEN::addConnectedItemsToBlock( const wxPoint& position )
 {
-    SCH_ITEM* item;
     ITEM_PICKER picker;
     bool addinlist = true;
 
-    for( item = m_drawList.begin(); item; item = item->Next() )
+    std::vector< SCH_ITEM* > candidates;
+    queryItems( position, 0, candidates );
+
+    for( SCH_ITEM* item : candidates )
     {
         picker.SetItem( item );
 
@@ -921,9 +1206,39 @@ bool SCH_SCREEN::TestDanglingEnds()
     for( item = m_drawList.begin(); item; item = item->Next() )
         item->GetEndPoints( endPoints );
 
+    DANGLING_END_INDEX index( endPoints );
+
+    for( item = m_drawList.begin(); item; item = item->Next() )
+    {
+        if( item->IsDanglingStateChanged( index ) )
+        {
+            hasStateChanged = true;
+        }
+    }
+
+    return hasStateChanged;
+}
+
+
+bool SCH_SCREEN::TestDanglingEnds( const EDA_RECT& aArea )
+{
+    SCH_ITEM* item;
+    std::vector< DANGLING_END_ITEM > endPoints;
+    bool hasStateChanged = false;
+
+    // All the end points are needed: an item inside the area can be connected
+    // to an item outside it.
+    for( item = m_drawList.begin(); item; item = item->Next() )
+        item->GetEndPoints( endPoints );
+
+    DANGLING_END_INDEX index( endPoints );
+
     for( item = m_drawList.begin(); item; item = item->Next() )
     {
-        if( item->IsDanglingStateChanged( endPoints ) )
+        if( !aArea.Intersects( item->GetBoundingBox() ) )
+            continue;
+
+        if( item->IsDanglingStateChanged( index ) )
         {
             hasStateChanged = true;
         }
@@ -958,6 +1273,9 @@ bool SCH_SCREEN::BreakSegment( const wxPoint& aPoint )
         brokenSegments = true;
     }
 
+    if( brokenSegments )
+        InvalidateItemsIndex();
+
     return brokenSegments;
 }
 
@@ -993,7 +1311,10 @@ bool SCH_SCREEN::BreakSegmentsOnJunctions()
 
 int SCH_SCREEN::GetNode( const wxPoint& aPosition, EDA_ITEMS& aList )
 {
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    std::vector< SCH_ITEM* > candidates;
+    queryItems( aPosition, 0, candidates );
+
+    for( SCH_ITEM* item : candidates )
     {
         if( item->Type() == SCH_LINE_T && item->HitTest( aPosition )
             && (item->GetLayer() == LAYER_BUS || item->GetLayer() == LAYER_WIRE) )
@@ -1012,7 +1333,10 @@ int SCH_SCREEN::GetNode( const wxPoint& aPosition, EDA_ITEMS& aList )
 
 SCH_LINE* SCH_SCREEN::GetWireOrBus( const wxPoint& aPosition )
 {
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    std::vector< SCH_ITEM* > candidates;
+    queryItems( aPosition, 0, candidates );
+
+    for( SCH_ITEM* item : candidates )
     {
         if( (item->Type() == SCH_LINE_T) && item->HitTest( aPosition )
             && (item->GetLayer() == LAYER_BUS || item->GetLayer() == LAYER_WIRE) )
@@ -1028,7 +1352,10 @@ SCH_LINE* SCH_SCREEN::GetWireOrBus( const wxPoint& aPosition )
 SCH_LINE* SCH_SCREEN::GetLine( const wxPoint& aPosition, int aAccuracy, int aLayer,
                                SCH_LINE_TEST_T aSearchType )
 {
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    std::vector< SCH_ITEM* > candidates;
+    queryItems( aPosition, aAccuracy, candidates );
+
+    for( SCH_ITEM* item : candidates )
     {
         if( item->Type() != SCH_LINE_T )
             continue;
@@ -1061,7 +1388,10 @@ SCH_LINE* SCH_SCREEN::GetLine( const wxPoint& aPosition, int aAccuracy, int aLay
 
 SCH_TEXT* SCH_SCREEN::GetLabel( const wxPoint& aPosition, int aAccuracy )
 {
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    std::vector< SCH_ITEM* > candidates;
+    queryItems( aPosition, aAccuracy, candidates );
+
+    for( SCH_ITEM* item : candidates )
     {
         switch( item->Type() )
         {
@@ -1137,6 +1467,9 @@ int SCH_SCREEN::GetConnection( const wxPoint& aPosition, PICKED_ITEMS_LIST& aLis
     ClearDrawingState();
     BreakSegmentsOnJunctions();
 
+    // Items can have been moved since the last search: rebuild the items index.
+    InvalidateItemsIndex();
+
     if( GetNode( aPosition, list ) == 0 )
         return 0;
 
@@ -1184,22 +1517,30 @@ int SCH_SCREEN::GetConnection( const wxPoint& aPosition, PICKED_ITEMS_LIST& aLis
 
             segment = (SCH_LINE*) item;
 
+            std::vector< SCH_ITEM* > candidates;
+
             /* If the wire start point is connected to a wire that was already found
              * and now is not connected, add the wire to the list. */
-            for( tmp = m_drawList.begin(); tmp; tmp = tmp->Next() )
+            queryItems( segment->GetStartPoint(), 0, candidates );
+            tmp = NULL;
+
+            for( SCH_ITEM* candidate : candidates )
             {
-                // Ensure tmp is a previously deleted segment:
-                if( ( tmp->GetFlags() & STRUCT_DELETED ) == 0 )
+                // Ensure candidate is a previously deleted segment:
+                if( ( candidate->GetFlags() & STRUCT_DELETED ) == 0 )
                     continue;
 
-                if( tmp->Type() != SCH_LINE_T )
+                if( candidate->Type() != SCH_LINE_T )
                     continue;
 
-                SCH_LINE* testSegment = (SCH_LINE*) tmp;
+                SCH_LINE* testSegment = (SCH_LINE*) candidate;
 
-               // Test for segment connected to the previously deleted segment:
+                // Test for segment connected to the previously deleted segment:
                 if( testSegment->IsEndPoint( segment->GetStartPoint() ) )
+                {
+                    tmp = candidate;
                     break;
+                }
             }
 
             // when tmp != NULL, segment is a new candidate:
@@ -1208,22 +1549,30 @@ int SCH_SCREEN::GetConnection( const wxPoint& aPosition, PICKED_ITEMS_LIST& aLis
             if( tmp && !CountConnectedItems( segment->GetStartPoint(), true ) )
                 noconnect = true;
 
+            candidates.clear();
+
             /* If the wire end point is connected to a wire that has already been found
              * and now is not connected, add the wire to the list. */
-            for( tmp = m_drawList.begin(); tmp; tmp = tmp->Next() )
+            queryItems( segment->GetEndPoint(), 0, candidates );
+            tmp = NULL;
+
+            for( SCH_ITEM* candidate : candidates )
             {
-                // Ensure tmp is a previously deleted segment:
-                if( ( tmp->GetFlags() & STRUCT_DELETED ) == 0 )
+                // Ensure candidate is a previously deleted segment:
+                if( ( candidate->GetFlags() & STRUCT_DELETED ) == 0 )
                     continue;
 
-                if( tmp->Type() != SCH_LINE_T )
+                if( candidate->Type() != SCH_LINE_T )
                     continue;
 
-                SCH_LINE* testSegment = (SCH_LINE*) tmp;
+                SCH_LINE* testSegment = (SCH_LINE*) candidate;
 
                 // Test for segment connected to the previously deleted segment:
                 if( testSegment->IsEndPoint( segment->GetEndPoint() ) )
+                {
+                    tmp = candidate;
                     break;
+                }
             }
 
             // when tmp != NULL, segment is a new candidate:
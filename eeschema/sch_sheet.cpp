@@ -994,13 +994,13 @@ void SCH_SHEET::GetEndPoints( std::vector <DANGLING_END_ITEM>& aItemList )
 }
 
 
-bool SCH_SHEET::IsDanglingStateChanged( std::vector< DANGLING_END_ITEM >& aItemList )
+bool SCH_SHEET::IsDanglingStateChanged( const DANGLING_END_INDEX& aEndPoints )
 {
     bool currentState = IsDangling();
 
     for( SCH_SHEET_PIN& pinsheet : GetPins() )
     {
-        pinsheet.IsDanglingStateChanged( aItemList );
+        pinsheet.IsDanglingStateChanged( aEndPoints );
     }
 
     return currentState != IsDangling();
@@ -558,7 +558,7 @@ public:
 
     void GetEndPoints( std::vector <DANGLING_END_ITEM>& aItemList ) override;
 
-    bool IsDanglingStateChanged( std::vector< DANGLING_END_ITEM >& aItemList ) override;
+    bool IsDanglingStateChanged( const DANGLING_END_INDEX& aEndPoints ) override;
 
     bool IsDangling() const override;
 
@@ -508,7 +508,7 @@ void SCH_TEXT::GetEndPoints( std::vector <DANGLING_END_ITEM>& aItemList )
 }
 
 
-bool SCH_TEXT::IsDanglingStateChanged( std::vector< DANGLING_END_ITEM >& aItemList )
+bool SCH_TEXT::IsDanglingStateChanged( const DANGLING_END_INDEX& aEndPoints )
 {
     // Normal text labels cannot be tested for dangling ends.
     if( Type() == SCH_TEXT_T )
@@ -517,9 +517,11 @@ bool SCH_TEXT::IsDanglingStateChanged( std::vector< DANGLING_END_ITEM >& aItemLi
     bool previousState = m_isDangling;
     m_isDangling = true;
 
-    for( unsigned ii = 0; ii < aItemList.size(); ii++ )
+    DANGLING_END_INDEX::RANGE range = aEndPoints.GetItemsAt( GetTextPos() );
+
+    for( auto it = range.first; it != range.second && m_isDangling; ++it )
     {
-        DANGLING_END_ITEM& item = aItemList[ii];
+        const DANGLING_END_ITEM& item = *it->second;
 
         if( item.GetItem() == this )
             continue;
@@ -529,32 +531,29 @@ bool SCH_TEXT::IsDanglingStateChanged( std::vector< DANGLING_END_ITEM >& aItemLi
         case PIN_END:
         case LABEL_END:
         case SHEET_LABEL_END:
-            if( GetTextPos() == item.GetPosition() )
-                m_isDangling = false;
-
-            break;
-
-        case WIRE_START_END:
-        case BUS_START_END:
-        {
-            // These schematic items have created 2 DANGLING_END_ITEM one per end.  But being
-            // a paranoid programmer, I'll check just in case.
-            ii++;
-
-            wxCHECK_MSG( ii < aItemList.size(), previousState != m_isDangling,
-                         wxT( "Dangling end type list overflow.  Bad programmer!" ) );
-
-            DANGLING_END_ITEM & nextItem = aItemList[ii];
-            m_isDangling = !IsPointOnSegment( item.GetPosition(), nextItem.GetPosition(), GetTextPos() );
-        }
+            m_isDangling = false;
             break;
 
         default:
             break;
         }
+    }
 
-        if( !m_isDangling )
-            break;
+    if( m_isDangling )
+    {
+        // The label can also be anywhere on a wire or a bus segment.
+        std::vector<DANGLING_END_INDEX::SEGMENT> segments;
+        aEndPoints.GetSegmentsAt( GetTextPos(), segments );
+
+        for( const DANGLING_END_INDEX::SEGMENT& segment : segments )
+        {
+            if( IsPointOnSegment( segment.m_start->GetPosition(), segment.m_end->GetPosition(),
+                                  GetTextPos() ) )
+            {
+                m_isDangling = false;
+                break;
+            }
+        }
     }
 
     return previousState != m_isDangling;
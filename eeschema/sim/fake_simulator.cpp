@@ -0,0 +1,228 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * https://www.gnu.org/licenses/gpl-3.0.html
+ * or you may search the http://www.gnu.org website for the version 3 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "fake_simulator.h"
+#include "spice_reporter.h"
+
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <thread>
+
+using namespace std;
+
+
+FAKE_SIMULATOR::FAKE_SIMULATOR( int aPoints, int aRunTime ) :
+    m_points( aPoints ), m_runTime( aRunTime ), m_seed( 0 ), m_runCount( 0 )
+{
+}
+
+
+void FAKE_SIMULATOR::Init()
+{
+    m_params.clear();
+    m_seed = 0;
+}
+
+
+bool FAKE_SIMULATOR::LoadNetlist( const string& aNetlist )
+{
+    m_netlist = aNetlist;
+    m_params.clear();
+
+    return true;
+}
+
+
+bool FAKE_SIMULATOR::Run()
+{
+    if( m_reporter )
+        m_reporter->OnSimStateChange( this, SIM_RUNNING );
+
+    bool res = RunBlocking();
+
+    if( m_reporter )
+        m_reporter->OnSimStateChange( this, SIM_IDLE );
+
+    return res;
+}
+
+
+bool FAKE_SIMULATOR::RunBlocking()
+{
+    if( m_netlist.empty() )
+        return false;
+
+    if( m_runTime > 0 )
+        this_thread::sleep_for( chrono::milliseconds( m_runTime ) );
+
+    hash<string> hasher;
+    m_seed = hasher( m_netlist );
+
+    for( const auto& param : m_params )
+        m_seed = m_seed * 31 + hasher( param.first + "=" + param.second );
+
+    if( m_seed == 0 )
+        m_seed = 1;
+
+    ++m_runCount;
+
+    return true;
+}
+
+
+void FAKE_SIMULATOR::ClearResults()
+{
+    m_netlist.clear();
+    m_params.clear();
+    m_seed = 0;
+}
+
+
+bool FAKE_SIMULATOR::Command( const string& aCmd )
+{
+    const string alter( "alter " );
+
+    if( aCmd.compare( 0, alter.size(), alter ) != 0 )
+        return true;
+
+    size_t eq = aCmd.find( '=', alter.size() );
+
+    if( eq == string::npos )
+        return false;
+
+    size_t start = aCmd.find_first_not_of( " @", alter.size() );
+
+    if( start >= eq )
+        return false;
+
+    m_params[ aCmd.substr( start, eq - start ) ] = aCmd.substr( eq + 1 );
+
+    return true;
+}
+
+
+string FAKE_SIMULATOR::GetXAxis( SIM_TYPE aType ) const
+{
+    switch( aType )
+    {
+        case ST_AC:
+        case ST_NOISE:
+            return string( "frequency" );
+
+        case ST_DC:
+            return string( "v-sweep" );
+
+        case ST_TRANSIENT:
+            return string( "time" );
+
+        default:
+            break;
+    }
+
+    return string( "" );
+}
+
+
+bool FAKE_SIMULATOR::isXAxis( const string& aName ) const
+{
+    return aName == "frequency" || aName == "v-sweep" || aName == "time";
+}
+
+
+vector<COMPLEX> FAKE_SIMULATOR::GetPlot( const string& aName, int aMaxLen )
+{
+    vector<COMPLEX> data;
+
+    if( !m_seed )
+        return data;
+
+    int length = aMaxLen < 0 ? m_points : std::min( aMaxLen, m_points );
+    data.reserve( length );
+
+    if( isXAxis( aName ) )
+    {
+        for( int i = 0; i < length; i++ )
+            data.push_back( COMPLEX( ( i + 1 ) * 1e-3, 0.0 ) );
+
+        return data;
+    }
+
+    // Derive a sine wave from the run and the vector name
+    size_t h = m_seed ^ hash<string>()( aName );
+    double amplitude = 1.0 + ( h % 1000 ) / 100.0;
+    double frequency = 1.0 + ( ( h >> 10 ) % 10 );
+    double phase = ( ( h >> 20 ) % 628 ) / 100.0;
+
+    for( int i = 0; i < length; i++ )
+    {
+        double angle = 2 * M_PI * frequency * ( i + 1 ) * 1e-3 + phase;
+        data.push_back( COMPLEX( amplitude * sin( angle ), 0.5 * amplitude * cos( angle ) ) );
+    }
+
+    return data;
+}
+
+
+vector<double> FAKE_SIMULATOR::GetRealPlot( const string& aName, int aMaxLen )
+{
+    vector<double> data;
+
+    for( const COMPLEX& c : GetPlot( aName, aMaxLen ) )
+        data.push_back( c.real() );
+
+    return data;
+}
+
+
+vector<double> FAKE_SIMULATOR::GetImagPlot( const string& aName, int aMaxLen )
+{
+    vector<double> data;
+
+    for( const COMPLEX& c : GetPlot( aName, aMaxLen ) )
+        data.push_back( c.imag() );
+
+    return data;
+}
+
+
+vector<double> FAKE_SIMULATOR::GetMagPlot( const string& aName, int aMaxLen )
+{
+    vector<double> data;
+
+    for( const COMPLEX& c : GetPlot( aName, aMaxLen ) )
+        data.push_back( abs( c ) );
+
+    return data;
+}
+
+
+vector<double> FAKE_SIMULATOR::GetPhasePlot( const string& aName, int aMaxLen )
+{
+    vector<double> data;
+
+    for( const COMPLEX& c : GetPlot( aName, aMaxLen ) )
+        data.push_back( arg( c ) );
+
+    return data;
+}
@@ -0,0 +1,123 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * https://www.gnu.org/licenses/gpl-3.0.html
+ * or you may search the http://www.gnu.org website for the version 3 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef FAKE_SIMULATOR_H
+#define FAKE_SIMULATOR_H
+
+#include "spice_simulator.h"
+
+#include <map>
+
+/**
+ * @brief Simulator backend that does not simulate anything.
+ *
+ * It returns waveforms computed from the hash of the netlist, of the values set with
+ * "alter" commands and of the vector name, so the same run always gives the same
+ * vectors and different runs give different ones. It has no global state, so any number
+ * of instances may run in parallel, which makes it suitable to exercise SIM_BATCH
+ * without ngspice.
+ */
+class FAKE_SIMULATOR : public SPICE_SIMULATOR
+{
+public:
+    /**
+     * @param aPoints is the number of points of each vector.
+     * @param aRunTime is the time taken by a run in milliseconds, to emulate a real simulator.
+     */
+    FAKE_SIMULATOR( int aPoints = 1000, int aRunTime = 0 );
+
+    ///> @copydoc SPICE_SIMULATOR::Init()
+    void Init() override;
+
+    ///> @copydoc SPICE_SIMULATOR::LoadNetlist()
+    bool LoadNetlist( const std::string& aNetlist ) override;
+
+    ///> @copydoc SPICE_SIMULATOR::Run()
+    bool Run() override;
+
+    ///> @copydoc SPICE_SIMULATOR::RunBlocking()
+    bool RunBlocking() override;
+
+    ///> @copydoc SPICE_SIMULATOR::ClearResults()
+    void ClearResults() override;
+
+    ///> @copydoc SPICE_SIMULATOR::Stop()
+    bool Stop() override
+    {
+        return true;
+    }
+
+    ///> @copydoc SPICE_SIMULATOR::IsRunning()
+    bool IsRunning() override
+    {
+        return false;
+    }
+
+    /**
+     * @brief Handles "alter @device=value" commands, the other ones are ignored.
+     */
+    bool Command( const std::string& aCmd ) override;
+
+    ///> @copydoc SPICE_SIMULATOR::GetXAxis()
+    std::string GetXAxis( SIM_TYPE aType ) const override;
+
+    ///> @copydoc SPICE_SIMULATOR::GetPlot()
+    std::vector<COMPLEX> GetPlot( const std::string& aName, int aMaxLen = -1 ) override;
+
+    ///> @copydoc SPICE_SIMULATOR::GetRealPlot()
+    std::vector<double> GetRealPlot( const std::string& aName, int aMaxLen = -1 ) override;
+
+    ///> @copydoc SPICE_SIMULATOR::GetImagPlot()
+    std::vector<double> GetImagPlot( const std::string& aName, int aMaxLen = -1 ) override;
+
+    ///> @copydoc SPICE_SIMULATOR::GetMagPlot()
+    std::vector<double> GetMagPlot( const std::string& aName, int aMaxLen = -1 ) override;
+
+    ///> @copydoc SPICE_SIMULATOR::GetPhasePlot()
+    std::vector<double> GetPhasePlot( const std::string& aName, int aMaxLen = -1 ) override;
+
+    ///> Returns the number of completed runs
+    int GetRunCount() const
+    {
+        return m_runCount;
+    }
+
+private:
+    ///> Returns true if aName is the X axis vector of one of the simulation types
+    bool isXAxis( const std::string& aName ) const;
+
+    const int m_points;
+    const int m_runTime;
+
+    std::string m_netlist;
+
+    ///> Device parameters set with "alter" commands
+    std::map<std::string, std::string> m_params;
+
+    ///> Hash of the netlist and the parameters of the last run, 0 if there are no results
+    size_t m_seed;
+
+    int m_runCount;
+};
+
+#endif /* FAKE_SIMULATOR_H */
@@ -30,11 +30,14 @@
 #include <wx/stdpaths.h>
 #include <wx/dir.h>
 
+#include <chrono>
 #include <sstream>
+#include <thread>
 
 using namespace std;
 
-NGSPICE::NGSPICE()
+NGSPICE::NGSPICE() :
+    m_blockingRun( false )
 {
     init();
 }
@@ -219,6 +222,32 @@ bool NGSPICE::Run()
 }
 
 
+bool NGSPICE::RunBlocking()
+{
+    // The C locale is global, so it is not kept for the whole simulation: the run is done by
+    // the ngspice background thread, and the locale is only set while the command is issued
+    // (see Command()), as in Run()
+    if( IsRunning() )
+        return false;
+
+    m_blockingRun = true;
+    Command( "bg_run" );
+
+    while( m_blockingRun )
+        std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+
+    return true;
+}
+
+
+void NGSPICE::ClearResults()
+{
+    LOCALE_IO c_locale;               // ngspice works correctly only with C locale
+    Command( "destroy all" );
+    Command( "remcirc" );
+}
+
+
 bool NGSPICE::Stop()
 {
     LOCALE_IO c_locale;               // ngspice works correctly only with C locale
@@ -412,6 +441,15 @@ int NGSPICE::cbBGThreadRunning( bool is_running, int id, void* user )
 {
     NGSPICE* sim = reinterpret_cast<NGSPICE*>( user );
 
+    // A blocking run is not reported, RunBlocking() only waits for its end
+    if( sim->m_blockingRun )
+    {
+        if( is_running )
+            sim->m_blockingRun = false;
+
+        return 0;
+    }
+
     if( sim->m_reporter )
         // I know the test below seems like an error, but well, it works somehow..
         sim->m_reporter->OnSimStateChange( sim, is_running ? SIM_IDLE : SIM_RUNNING );
@@ -29,6 +29,8 @@
 
 #include <ngspice/sharedspice.h>
 
+#include <atomic>
+
 class wxDynamicLibrary;
 
 class NGSPICE : public SPICE_SIMULATOR {
@@ -46,6 +48,12 @@ public:
     ///> @copydoc SPICE_SIMULATOR::Run()
     bool Run() override;
 
+    ///> @copydoc SPICE_SIMULATOR::RunBlocking()
+    bool RunBlocking() override;
+
+    ///> @copydoc SPICE_SIMULATOR::ClearResults()
+    void ClearResults() override;
+
     ///> @copydoc SPICE_SIMULATOR::Stop()
     bool Stop() override;
 
@@ -96,6 +104,9 @@ private:
 
     ///> NGspice should be initialized only once
     static bool m_initialized;
+
+    ///> True while RunBlocking() waits for the background thread
+    std::atomic<bool> m_blockingRun;
 };
 
 #endif /* NGSPICE_H */
@@ -0,0 +1,197 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * https://www.gnu.org/licenses/gpl-3.0.html
+ * or you may search the http://www.gnu.org website for the version 3 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "sim_batch.h"
+#include "spice_simulator.h"
+
+#include <locale>
+#include <random>
+#include <sstream>
+
+using namespace std;
+
+
+SIM_BATCH::SIM_BATCH( const vector<SPICE_SIMULATOR*>& aSimulators ) :
+    m_simulators( aSimulators ), m_simType( ST_UNKNOWN ), m_nextRun( 0 ),
+    m_activeWorkers( 0 ), m_finished( 0 ), m_cancelled( false )
+{
+}
+
+
+SIM_BATCH::~SIM_BATCH()
+{
+    Stop();
+}
+
+
+bool SIM_BATCH::Start( const string& aNetlist, SIM_TYPE aSimType,
+        const vector<SIM_BATCH_VARIANT>& aVariants, const vector<SIM_BATCH_PROBE>& aProbes,
+        NOTIFIER aNotifier )
+{
+    if( IsRunning() || m_simulators.empty() )
+        return false;
+
+    // Join the workers of a previous batch
+    Wait();
+
+    m_netlist = aNetlist;
+    m_simType = aSimType;
+    m_variants = aVariants;
+    m_probes = aProbes;
+    m_notifier = aNotifier;
+
+    m_nextRun = 0;
+    m_finished = 0;
+    m_cancelled = false;
+    m_results.clear();
+
+    if( m_variants.empty() )
+        return true;
+
+    size_t count = std::min( m_simulators.size(), m_variants.size() );
+    m_activeWorkers = (int) count;
+
+    for( size_t i = 0; i < count; ++i )
+        m_threads.push_back( thread( &SIM_BATCH::worker, this, m_simulators[i] ) );
+
+    return true;
+}
+
+
+void SIM_BATCH::Stop()
+{
+    m_cancelled = true;
+    Wait();
+}
+
+
+void SIM_BATCH::Wait()
+{
+    for( thread& t : m_threads )
+        t.join();
+
+    m_threads.clear();
+}
+
+
+void SIM_BATCH::worker( SPICE_SIMULATOR* aSimulator )
+{
+    for( size_t run = m_nextRun++; run < m_variants.size() && !m_cancelled; run = m_nextRun++ )
+    {
+        SIM_BATCH_RESULT result;
+        result.m_run = (int) run;
+
+        aSimulator->Init();
+        result.m_success = aSimulator->LoadNetlist( m_netlist );
+
+        for( const string& cmd : m_variants[run].m_commands )
+            aSimulator->Command( cmd );
+
+        result.m_success = result.m_success && aSimulator->RunBlocking();
+
+        if( result.m_success )
+        {
+            result.m_x = aSimulator->GetMagPlot( aSimulator->GetXAxis( m_simType ) );
+
+            for( const SIM_BATCH_PROBE& probe : m_probes )
+                result.m_y.push_back( getProbeData( aSimulator, probe ) );
+        }
+
+        // Do not let the results of hundreds of runs pile up in the simulator
+        aSimulator->ClearResults();
+
+        m_results.move_push( std::move( result ) );
+        ++m_finished;
+
+        if( m_notifier )
+            m_notifier();
+    }
+
+    // The last worker tells the batch is over
+    if( --m_activeWorkers == 0 && m_notifier )
+        m_notifier();
+}
+
+
+vector<double> SIM_BATCH::getProbeData( SPICE_SIMULATOR* aSimulator,
+        const SIM_BATCH_PROBE& aProbe ) const
+{
+    if( m_simType == ST_AC && ( aProbe.m_type & SPT_AC_PHASE ) )
+        return aSimulator->GetPhasePlot( aProbe.m_vector );
+
+    return aSimulator->GetMagPlot( aProbe.m_vector );
+}
+
+
+string SIM_BATCH::alterCommand( const string& aDevice, double aValue )
+{
+    // Spice expects '.' as the decimal separator, whatever the user locale is
+    ostringstream cmd;
+    cmd.imbue( locale::classic() );
+    cmd.precision( 12 );
+    cmd << "alter @" << aDevice << "=" << aValue;
+
+    return cmd.str();
+}
+
+
+vector<SIM_BATCH_VARIANT> SIM_BATCH::MakeSweep( const string& aDevice,
+        const vector<double>& aValues )
+{
+    vector<SIM_BATCH_VARIANT> variants;
+
+    for( double value : aValues )
+    {
+        SIM_BATCH_VARIANT variant;
+        variant.m_commands.push_back( alterCommand( aDevice, value ) );
+        variant.m_title = variant.m_commands.back().substr( 7 );     // strip "alter @"
+        variants.push_back( variant );
+    }
+
+    return variants;
+}
+
+
+vector<SIM_BATCH_VARIANT> SIM_BATCH::MakeMonteCarlo( const vector< pair<string, double> >& aDevices,
+        double aTolerance, int aRuns, unsigned aSeed )
+{
+    vector<SIM_BATCH_VARIANT> variants;
+    mt19937 generator( aSeed );
+    uniform_real_distribution<double> deviation( -aTolerance, aTolerance );
+
+    for( int run = 0; run < aRuns; ++run )
+    {
+        SIM_BATCH_VARIANT variant;
+        variant.m_title = "#" + to_string( run + 1 );
+
+        for( const auto& device : aDevices )
+        {
+            double value = device.second * ( 1.0 + deviation( generator ) );
+            variant.m_commands.push_back( alterCommand( device.first, value ) );
+        }
+
+        variants.push_back( variant );
+    }
+
+    return variants;
+}
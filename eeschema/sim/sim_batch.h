@@ -0,0 +1,197 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * https://www.gnu.org/licenses/gpl-3.0.html
+ * or you may search the http://www.gnu.org website for the version 3 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef SIM_BATCH_H
+#define SIM_BATCH_H
+
+#include "sim_types.h"
+
+#include <sync_queue.h>
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class SPICE_SIMULATOR;
+
+///> A single run of a batch: the netlist is modified with Spice commands before the run
+struct SIM_BATCH_VARIANT
+{
+    ///> Name of the run, displayed in the trace titles
+    std::string m_title;
+
+    ///> Commands issued after loading the netlist (e.g. "alter @r1=1k")
+    std::vector<std::string> m_commands;
+};
+
+///> A vector to be read after each run
+struct SIM_BATCH_PROBE
+{
+    ///> Name of the vector in Spice convention (e.g. V(3), @r1[i])
+    std::string m_vector;
+
+    ///> Type of the plot, selects the magnitude or the phase for AC simulations
+    SIM_PLOT_TYPE m_type;
+};
+
+///> Vectors of a finished run
+struct SIM_BATCH_RESULT
+{
+    ///> Index of the run in the variant list
+    int m_run;
+
+    ///> False if the simulator failed, then there are no vectors
+    bool m_success;
+
+    ///> X axis values
+    std::vector<double> m_x;
+
+    ///> Y axis values, one vector for each probe in the probe list order
+    std::vector< std::vector<double> > m_y;
+};
+
+
+/**
+ * @brief Runs a list of variants of a netlist in the background, distributing them over a
+ * set of simulators.
+ *
+ * Each simulator is driven by its own worker thread, and the results are queued as soon
+ * as a run is finished, so they can be displayed while the batch goes on.
+ * The simulators must be independent instances. libngspice keeps its state in global
+ * variables and is linked once, so there is a single NGSPICE instance: a batch using it
+ * has one worker and runs the variants one after the other, and the simulator is not
+ * available to the caller until the batch is finished. Several workers run at once only
+ * with backends that have no global state, such as FAKE_SIMULATOR.
+ */
+class SIM_BATCH
+{
+public:
+    ///> Called from the worker threads each time a result is queued, and when the batch ends
+    typedef std::function<void()> NOTIFIER;
+
+    /**
+     * @param aSimulators are the simulators used by the workers, one worker per simulator.
+     * They are not owned by the batch and must exist until the batch is finished.
+     */
+    SIM_BATCH( const std::vector<SPICE_SIMULATOR*>& aSimulators );
+    ~SIM_BATCH();
+
+    /**
+     * @brief Starts the batch in the background.
+     * @param aNetlist is the netlist, as generated by NETLIST_EXPORTER_PSPICE_SIM.
+     * @param aSimType is the simulation type of the netlist.
+     * @param aVariants are the runs.
+     * @param aProbes are the vectors to read after each run.
+     * @param aNotifier is an optional function called by the workers for each result.
+     * @return False if the batch is already running or there is no simulator.
+     */
+    bool Start( const std::string& aNetlist, SIM_TYPE aSimType,
+            const std::vector<SIM_BATCH_VARIANT>& aVariants,
+            const std::vector<SIM_BATCH_PROBE>& aProbes, NOTIFIER aNotifier = NOTIFIER() );
+
+    /**
+     * @brief Cancels the runs that have not started yet and waits for the running ones.
+     */
+    void Stop();
+
+    /**
+     * @brief Waits until all the runs are finished.
+     */
+    void Wait();
+
+    ///> Returns true until the last run is finished (or cancelled)
+    bool IsRunning() const
+    {
+        return m_activeWorkers > 0;
+    }
+
+    ///> Returns the number of finished runs
+    int GetFinishedCount() const
+    {
+        return m_finished;
+    }
+
+    /**
+     * @brief Takes the next available result.
+     * @return False if there is no result queued at the moment.
+     */
+    bool GetResult( SIM_BATCH_RESULT& aResult )
+    {
+        return m_results.pop( aResult );
+    }
+
+    /**
+     * @brief Creates a parameter sweep.
+     * @param aDevice is the Spice name of the device (e.g. r1, see TUNER_SLIDER).
+     * @param aValues are the values of the device, one run for each.
+     */
+    static std::vector<SIM_BATCH_VARIANT> MakeSweep( const std::string& aDevice,
+            const std::vector<double>& aValues );
+
+    /**
+     * @brief Creates a Monte Carlo analysis: the device values are picked uniformly within
+     * their tolerance in each run.
+     * @param aDevices are the Spice names and nominal values of the devices.
+     * @param aTolerance is the relative tolerance (e.g. 0.05 for 5%).
+     * @param aRuns is the number of runs.
+     * @param aSeed initializes the random generator, so an analysis can be repeated.
+     */
+    static std::vector<SIM_BATCH_VARIANT> MakeMonteCarlo(
+            const std::vector< std::pair<std::string, double> >& aDevices,
+            double aTolerance, int aRuns, unsigned aSeed );
+
+private:
+    ///> Runs the variants with a simulator until there is nothing left to do
+    void worker( SPICE_SIMULATOR* aSimulator );
+
+    ///> Reads the vector of a probe, as SIM_PLOT_FRAME::updatePlot() does
+    std::vector<double> getProbeData( SPICE_SIMULATOR* aSimulator,
+            const SIM_BATCH_PROBE& aProbe ) const;
+
+    ///> Returns the alter command setting a device value
+    static std::string alterCommand( const std::string& aDevice, double aValue );
+
+    std::vector<SPICE_SIMULATOR*> m_simulators;
+    std::vector<std::thread> m_threads;
+
+    // Batch description, constant while the workers run
+    std::string m_netlist;
+    SIM_TYPE m_simType;
+    std::vector<SIM_BATCH_VARIANT> m_variants;
+    std::vector<SIM_BATCH_PROBE> m_probes;
+    NOTIFIER m_notifier;
+
+    ///> Index of the next variant to run
+    std::atomic<size_t> m_nextRun;
+
+    std::atomic<int> m_activeWorkers;
+    std::atomic<int> m_finished;
+    std::atomic<bool> m_cancelled;
+
+    SYNC_QUEUE<SIM_BATCH_RESULT> m_results;
+};
+
+#endif /* SIM_BATCH_H */
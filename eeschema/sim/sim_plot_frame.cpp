@@ -39,9 +39,13 @@
 #include "sim_plot_panel.h"
 #include "spice_simulator.h"
 #include "spice_reporter.h"
+#include "sim_batch.h"
 
 #include <menus_helpers.h>
 
+#include <wx/choicdlg.h>
+#include <wx/numdlg.h>
+
 SIM_PLOT_TYPE operator|( SIM_PLOT_TYPE aFirst, SIM_PLOT_TYPE aSecond )
 {
     int res = (int) aFirst | (int) aSecond;
@@ -106,7 +110,7 @@ TRACE_DESC::TRACE_DESC( const NETLIST_EXPORTER_PSPICE_SIM& aExporter, const wxSt
 wxString SIM_PLOT_FRAME::m_savedWorkbooksPath;
 
 SIM_PLOT_FRAME::SIM_PLOT_FRAME( KIWAY* aKiway, wxWindow* aParent )
-    : SIM_PLOT_FRAME_BASE( aParent ), m_lastSimPlot( nullptr )
+    : SIM_PLOT_FRAME_BASE( aParent ), m_batchPlot( nullptr ), m_lastSimPlot( nullptr )
 {
     SetKiway( this, aKiway );
     m_signalsIconColorList = NULL;
@@ -149,6 +153,7 @@ SIM_PLOT_FRAME::SIM_PLOT_FRAME( KIWAY* aKiway, wxWindow* aParent )
     Connect( EVT_SIM_REPORT, wxCommandEventHandler( SIM_PLOT_FRAME::onSimReport ), NULL, this );
     Connect( EVT_SIM_STARTED, wxCommandEventHandler( SIM_PLOT_FRAME::onSimStarted ), NULL, this );
     Connect( EVT_SIM_FINISHED, wxCommandEventHandler( SIM_PLOT_FRAME::onSimFinished ), NULL, this );
+    Connect( EVT_SIM_BATCH_RESULT, wxCommandEventHandler( SIM_PLOT_FRAME::onSimBatchResult ), NULL, this );
     Connect( EVT_SIM_CURSOR_UPDATE, wxCommandEventHandler( SIM_PLOT_FRAME::onCursorUpdate ), NULL, this );
 
     // Toolbar buttons
@@ -181,6 +186,13 @@ SIM_PLOT_FRAME::SIM_PLOT_FRAME( KIWAY* aKiway, wxWindow* aParent )
     Bind( wxEVT_COMMAND_MENU_SELECTED, &SIM_PLOT_FRAME::onTune,      this, m_tuneValue->GetId() );
     Bind( wxEVT_COMMAND_MENU_SELECTED, &SIM_PLOT_FRAME::onSettings,  this, m_settings->GetId() );
 
+    // Batch simulation entry, placed after the tuning one
+    size_t tuneValuePos = 0;
+    m_simulationMenu->FindChildItem( m_tuneValue->GetId(), &tuneValuePos );
+    m_sweepTuned = m_simulationMenu->Insert( tuneValuePos + 1, wxID_ANY,
+            _( "Sweep tuned value..." ), _( "Simulate a tuned component over its tuning range" ) );
+    Bind( wxEVT_COMMAND_MENU_SELECTED, &SIM_PLOT_FRAME::onSweepTuned, this, m_sweepTuned->GetId() );
+
     m_toolBar->Realize();
     m_plotNotebook->SetPageText( 0, _( "Welcome!" ) );
 
@@ -202,6 +214,9 @@ SIM_PLOT_FRAME::SIM_PLOT_FRAME( KIWAY* aKiway, wxWindow* aParent )
 
 SIM_PLOT_FRAME::~SIM_PLOT_FRAME()
 {
+    // The batch workers must not notify a deleted frame
+    m_batch.reset();
+
     m_simulator->SetReporter( nullptr );
     delete m_reporter;
     delete m_signalsIconColorList;
@@ -263,6 +278,10 @@ void SIM_PLOT_FRAME::StartSimulation()
     STRING_FORMATTER formatter;
     SIM_PLOT_PANEL* plotPanel = CurrentPlot();
 
+    // The simulator belongs to the batch worker until the batch is finished
+    if( isBatchRunning() )
+        return;
+
     if( !m_settingsDlg )
         m_settingsDlg = new DIALOG_SIM_SETTINGS( this );
 
@@ -288,21 +307,123 @@ void SIM_PLOT_FRAME::StartSimulation()
     updateTuners();
     applyTuners();
     m_simulator->Run();
+
+    m_lastSimPlot = plotPanel;
 }
 
 
 void SIM_PLOT_FRAME::StopSimulation()
 {
-    m_simulator->Stop();
+    if( isBatchRunning() )
+        m_batch->Stop();
+    else
+        m_simulator->Stop();
 }
 
 
 bool SIM_PLOT_FRAME::IsSimulationRunning()
 {
+    // Do not query the simulator while a batch worker uses it
+    if( isBatchRunning() )
+        return true;
+
     return m_simulator ? m_simulator->IsRunning() : false;
 }
 
 
+bool SIM_PLOT_FRAME::isBatchRunning() const
+{
+    return m_batch && m_batch->IsRunning();
+}
+
+
+bool SIM_PLOT_FRAME::StartBatchSimulation( const std::vector<SIM_BATCH_VARIANT>& aVariants )
+{
+    STRING_FORMATTER formatter;
+    SIM_PLOT_PANEL* plotPanel = CurrentPlot();
+
+    if( IsSimulationRunning() || aVariants.empty() )
+        return false;
+
+    if( !plotPanel || m_plots[plotPanel].m_traces.empty() )
+    {
+        DisplayInfoMessage( this, _( "You need to add signals to the plot first." ) );
+        return false;
+    }
+
+    if( !m_settingsDlg )
+        m_settingsDlg = new DIALOG_SIM_SETTINGS( this );
+
+    m_simConsole->Clear();
+    updateNetlistExporter();
+    m_exporter->SetSimCommand( m_plots[plotPanel].m_simCommand );
+
+    if( !m_exporter->Format( &formatter, m_settingsDlg->GetNetlistOptions() ) )
+    {
+        DisplayError( this, _( "There were errors during netlist export, aborted." ) );
+        return false;
+    }
+
+    SIM_TYPE simType = m_exporter->GetSimType();
+
+    if( !SIM_PLOT_PANEL::IsPlottable( simType ) || plotPanel->GetType() != simType )
+    {
+        DisplayInfoMessage( this, _( "Batch simulations need a plot of the simulation type." ) );
+        return false;
+    }
+
+    std::vector<SIM_BATCH_PROBE> probes;
+    m_batchTraces.clear();
+
+    for( const auto& trace : m_plots[plotPanel].m_traces )
+    {
+        const TRACE_DESC& desc = trace.second;
+        wxString spiceVector = m_exporter->GetSpiceVector( desc.GetName(), desc.GetType(),
+                desc.GetParam() );
+
+        probes.push_back( { (const char*) spiceVector.c_str(), desc.GetType() } );
+        m_batchTraces.push_back( desc );
+    }
+
+    // The tuned values apply to all the runs, unless a run changes them
+    std::vector<SIM_BATCH_VARIANT> variants( aVariants );
+    updateTuners();
+
+    const std::vector<std::string> tunerCommands = getTunerCommands();
+
+    for( auto& variant : variants )
+    {
+        variant.m_commands.insert( variant.m_commands.begin(),
+                                   tunerCommands.begin(), tunerCommands.end() );
+    }
+
+    m_batchTitles.clear();
+
+    for( const auto& variant : variants )
+        m_batchTitles.push_back( wxString::FromUTF8( variant.m_title.c_str() ) );
+
+    m_batchPlot = plotPanel;
+
+    // The batch clears the circuit from the simulator after each run, so the next tuner
+    // update has to load the netlist again
+    m_lastSimPlot = nullptr;
+
+    // libngspice keeps its state in global variables, so there can be only one ngspice
+    // instance, and the batch runs in a single background worker using the frame simulator.
+    m_batch.reset( new SIM_BATCH( { m_simulator } ) );
+
+    m_batch->Start( formatter.GetString(), simType, variants, probes, [this]() {
+        wxQueueEvent( this, new wxCommandEvent( EVT_SIM_BATCH_RESULT ) );
+    } );
+
+    m_toolBar->SetToolNormalBitmap( ID_SIM_RUN, KiBitmap( sim_stop_xpm ) );
+    SetCursor( wxCURSOR_ARROWWAIT );
+    enableSimulatorTools( false );
+
+    return true;
+}
+
+
 SIM_PLOT_PANEL* SIM_PLOT_FRAME::NewPlotPanel( SIM_TYPE aSimType )
 {
     SIM_PLOT_PANEL* plotPanel = new SIM_PLOT_PANEL( aSimType, m_plotNotebook, wxID_ANY );
@@ -393,6 +514,10 @@ SIM_PLOT_PANEL* SIM_PLOT_FRAME::CurrentPlot() const
 
 void SIM_PLOT_FRAME::addPlot( const wxString& aName, SIM_PLOT_TYPE aType, const wxString& aParam )
 {
+    // The simulator vectors cannot be read while a batch worker uses the simulator
+    if( isBatchRunning() )
+        return;
+
     SIM_TYPE simType = m_exporter->GetSimType();
 
     if( !SIM_PLOT_PANEL::IsPlottable( simType ) )
@@ -607,6 +732,22 @@ void SIM_PLOT_FRAME::updateCursors()
 }
 
 
+void SIM_PLOT_FRAME::enableSimulatorTools( bool aEnable )
+{
+    m_toolBar->EnableTool( m_toolAddSignals->GetId(), aEnable );
+    m_toolBar->EnableTool( m_toolProbe->GetId(), aEnable );
+    m_toolBar->EnableTool( m_toolTune->GetId(), aEnable );
+
+    m_addSignals->Enable( aEnable );
+    m_probeSignals->Enable( aEnable );
+    m_tuneValue->Enable( aEnable );
+    m_sweepTuned->Enable( aEnable );
+
+    // The tuner sliders restart the simulation
+    m_tunePanel->Enable( aEnable );
+}
+
+
 void SIM_PLOT_FRAME::updateTuners()
 {
     const auto& spiceItems = m_exporter->GetSpiceItems();
@@ -635,14 +776,28 @@ void SIM_PLOT_FRAME::updateTuners()
 
 void SIM_PLOT_FRAME::applyTuners()
 {
-    for( auto& tuner : m_tuners )
+    if( isBatchRunning() )
+        return;
+
+    for( const auto& command : getTunerCommands() )
+        m_simulator->Command( command );
+}
+
+
+std::vector<std::string> SIM_PLOT_FRAME::getTunerCommands() const
+{
+    std::vector<std::string> commands;
+
+    for( const auto& tuner : m_tuners )
     {
         /// @todo no ngspice hardcoding
         std::string command( "alter @" + tuner->GetSpiceName()
                 + "=" + tuner->GetValue().ToSpiceString() );
 
-        m_simulator->Command( command );
+        commands.push_back( command );
     }
+
+    return commands;
 }
 
 
@@ -1029,6 +1184,9 @@ void SIM_PLOT_FRAME::onAddSignal( wxCommandEvent& event )
 {
     SIM_PLOT_PANEL* plotPanel = CurrentPlot();
 
+    if( isBatchRunning() )
+        return;
+
     if( !plotPanel || !m_exporter || plotPanel->GetType() != m_exporter->GetSimType() )
     {
         DisplayInfoMessage( this, _( "You need to run simulation first." ) );
@@ -1042,7 +1200,7 @@ void SIM_PLOT_FRAME::onAddSignal( wxCommandEvent& event )
 
 void SIM_PLOT_FRAME::onProbe( wxCommandEvent& event )
 {
-    if( m_schematicFrame == NULL )
+    if( m_schematicFrame == NULL || isBatchRunning() )
         return;
 
     wxQueueEvent( m_schematicFrame, new wxCommandEvent( wxEVT_TOOL, ID_SIM_PROBE ) );
@@ -1052,7 +1210,7 @@ void SIM_PLOT_FRAME::onProbe( wxCommandEvent& event )
 
 void SIM_PLOT_FRAME::onTune( wxCommandEvent& event )
 {
-    if( m_schematicFrame == NULL )
+    if( m_schematicFrame == NULL || isBatchRunning() )
         return;
 
     wxQueueEvent( m_schematicFrame, new wxCommandEvent( wxEVT_TOOL, ID_SIM_TUNE ) );
@@ -1060,12 +1218,59 @@ void SIM_PLOT_FRAME::onTune( wxCommandEvent& event )
 }
 
 
+void SIM_PLOT_FRAME::onSweepTuned( wxCommandEvent& event )
+{
+    if( IsSimulationRunning() )
+        return;
+
+    if( m_tuners.empty() )
+    {
+        DisplayInfoMessage( this, _( "You need to tune a component value first." ) );
+        return;
+    }
+
+    TUNER_SLIDER* tuner = m_tuners.front();
+
+    if( m_tuners.size() > 1 )
+    {
+        wxArrayString names;
+
+        for( const auto& t : m_tuners )
+            names.Add( t->GetComponentName() );
+
+        int idx = wxGetSingleChoiceIndex( _( "Component to sweep:" ), _( "Sweep Tuned Value" ),
+                                          names, this );
+
+        if( idx < 0 )
+            return;
+
+        tuner = *std::next( m_tuners.begin(), idx );
+    }
+
+    long runs = wxGetNumberFromUser(
+            _( "The value is swept from the tuner minimum to its maximum." ),
+            _( "Runs:" ), _( "Sweep Tuned Value" ), 5, 2, 100, this );
+
+    if( runs < 2 )
+        return;     // cancelled
+
+    const double minValue = tuner->GetMin().ToDouble();
+    const double maxValue = tuner->GetMax().ToDouble();
+    std::vector<double> values;
+
+    for( long i = 0; i < runs; ++i )
+        values.push_back( minValue + ( maxValue - minValue ) * i / ( runs - 1 ) );
+
+    StartBatchSimulation( SIM_BATCH::MakeSweep( tuner->GetSpiceName().ToStdString(), values ) );
+}
+
+
 void SIM_PLOT_FRAME::onClose( wxCloseEvent& aEvent )
 {
     SaveSettings( config() );
 
     if( IsSimulationRunning() )
-        m_simulator->Stop();
+        StopSimulation();
 
     Destroy();
 }
@@ -1178,12 +1383,67 @@ void SIM_PLOT_FRAME::onSimFinished( wxCommandEvent& aEvent )
 }
 
 
+void SIM_PLOT_FRAME::onSimBatchResult( wxCommandEvent& aEvent )
+{
+    if( !m_batch )
+        return;     // a notification sent before the batch was stopped
+
+    // Read before taking the results, as the workers queue them before they exit
+    bool running = m_batch->IsRunning();
+
+    // The panel might have been closed during the batch
+    bool plotExists = m_plots.count( m_batchPlot ) > 0;
+    SIM_BATCH_RESULT result;
+
+    while( m_batch->GetResult( result ) )
+    {
+        const wxString& runTitle = m_batchTitles[result.m_run];
+
+        if( !result.m_success )
+        {
+            m_simConsole->AppendText( wxString::Format( _( "Run %s failed\n" ), runTitle ) );
+            continue;
+        }
+
+        if( !plotExists )
+            continue;
+
+        for( unsigned i = 0; i < m_batchTraces.size(); ++i )
+        {
+            const std::vector<double>& data_y = result.m_y[i];
+
+            if( data_y.empty() || data_y.size() != result.m_x.size() )
+                continue;
+
+            m_batchPlot->AddTrace( m_batchTraces[i].GetTitle() + " " + runTitle, data_y.size(),
+                    result.m_x.data(), data_y.data(), m_batchTraces[i].GetType() );
+        }
+    }
+
+    if( running )
+        return;
+
+    m_batch.reset();
+
+    m_toolBar->SetToolNormalBitmap( ID_SIM_RUN, KiBitmap( sim_run_xpm ) );
+    SetCursor( wxCURSOR_ARROW );
+    enableSimulatorTools( true );
+
+    if( plotExists )
+        m_batchPlot->ResetScales();
+}
+
+
 void SIM_PLOT_FRAME::onSimUpdate( wxCommandEvent& aEvent )
 {
+    // Tuner changes do not apply to a running batch
+    if( isBatchRunning() )
+        return;
+
     if( IsSimulationRunning() )
         StopSimulation();
 
-    if( CurrentPlot() != m_lastSimPlot )
+    if( !m_lastSimPlot || CurrentPlot() != m_lastSimPlot )
     {
         // We need to rerun simulation, as the simulator currently stores
         // results for another plot
@@ -1255,3 +1515,4 @@ wxDEFINE_EVENT( EVT_SIM_REPORT, wxCommandEvent );
 
 wxDEFINE_EVENT( EVT_SIM_STARTED, wxCommandEvent );
 wxDEFINE_EVENT( EVT_SIM_FINISHED, wxCommandEvent );
+wxDEFINE_EVENT( EVT_SIM_BATCH_RESULT, wxCommandEvent );
@@ -45,11 +45,15 @@
 #include <list>
 #include <memory>
 #include <map>
+#include <string>
+#include <vector>
 
 class SCH_EDIT_FRAME;
 class SCH_COMPONENT;
 
 class SPICE_SIMULATOR;
+class SIM_BATCH;
+struct SIM_BATCH_VARIANT;
 class NETLIST_EXPORTER_PSPICE_SIM;
 class SIM_PLOT_PANEL;
 class SIM_THREAD_REPORTER;
@@ -117,6 +121,15 @@ public:
     void StopSimulation();
     bool IsSimulationRunning();
 
+    /**
+     * @brief Runs a batch of simulations of the current schematic in the background, e.g.
+     * a parameter sweep or a Monte Carlo analysis (see SIM_BATCH). The signals of the
+     * current plot are read after each run, and added to the plot as soon as they are ready.
+     * @param aVariants are the runs of the batch.
+     * @return True if the batch was started.
+     */
+    bool StartBatchSimulation( const std::vector<SIM_BATCH_VARIANT>& aVariants );
+
     /**
      * @brief Creates a new plot panel for a given simulation type and adds it to the main
      * notebook.
@@ -199,6 +212,15 @@ private:
      */
     void updateCursors();
 
+    /**
+     * @brief Enables or disables the tools that read or restart the simulator (signals,
+     * probe, tuners). They are disabled while a batch uses the simulator.
+     */
+    void enableSimulatorTools( bool aEnable );
+
+    ///> Returns true while a batch runs, the simulator must not be used meanwhile
+    bool isBatchRunning() const;
+
     /**
      * @brief Filters out tuners for components that do not exist anymore.
      * Decisions are based on the current NETLIST_EXPORTER data.
@@ -210,6 +232,11 @@ private:
      */
     void applyTuners();
 
+    /**
+     * @brief Returns the commands setting the component values specified using tuner sliders.
+     */
+    std::vector<std::string> getTunerCommands() const;
+
     /**
      * @brief Loads plot settings from a file.
      * @param aPath is the file name.
@@ -261,6 +288,7 @@ private:
     void onAddSignal( wxCommandEvent& event );
     void onProbe( wxCommandEvent& event );
     void onTune( wxCommandEvent& event );
+    void onSweepTuned( wxCommandEvent& event );
 
     void onClose( wxCloseEvent& aEvent );
 
@@ -269,6 +297,7 @@ private:
     void onSimReport( wxCommandEvent& aEvent );
     void onSimStarted( wxCommandEvent& aEvent );
     void onSimFinished( wxCommandEvent& aEvent );
+    void onSimBatchResult( wxCommandEvent& aEvent );
 
     // adjust the sash dimension of splitter windows after reading
     // the config settings
@@ -305,6 +334,21 @@ private:
     ///> List of currently displayed tuners
     std::list<TUNER_SLIDER*> m_tuners;
 
+    ///> Simulation menu entry starting a sweep of a tuned component
+    wxMenuItem* m_sweepTuned;
+
+    ///> Batch simulation in progress (if any)
+    std::unique_ptr<SIM_BATCH> m_batch;
+
+    ///> Panel receiving the batch traces
+    SIM_PLOT_PANEL* m_batchPlot;
+
+    ///> Signals read after each batch run, in the SIM_BATCH probe order
+    std::vector<TRACE_DESC> m_batchTraces;
+
+    ///> Titles of the batch runs, appended to the trace titles
+    std::vector<wxString> m_batchTitles;
+
     // Trick to preserve settings between runs:
     // the DIALOG_SIM_SETTINGS is not destroyed after closing the dialog.
     // Once created it will be not shown (shown only on request) during a session
@@ -355,5 +399,6 @@ wxDECLARE_EVENT( EVT_SIM_REPORT, wxCommandEvent );
 // Notifications
 wxDECLARE_EVENT( EVT_SIM_STARTED, wxCommandEvent );
 wxDECLARE_EVENT( EVT_SIM_FINISHED, wxCommandEvent );
+wxDECLARE_EVENT( EVT_SIM_BATCH_RESULT, wxCommandEvent );
 
 #endif // __sim_plot_frame__
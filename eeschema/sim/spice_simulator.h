@@ -59,6 +59,19 @@ public:
      */
     virtual bool Run() = 0;
 
+    /**
+     * @brief Executes the simulation with currently loaded netlist and returns once it is
+     * finished. Unlike Run(), it does not report the simulation state changes, so it may
+     * be called from a worker thread.
+     * @return True in case of success, false otherwise.
+     */
+    virtual bool RunBlocking() = 0;
+
+    /**
+     * @brief Frees the netlists and the result vectors of the previous runs.
+     */
+    virtual void ClearResults() = 0;
+
     /**
      * @brief Halts the simulation.
      * @return True in case of success, false otherwise.
@@ -208,15 +208,19 @@ void GERBVIEW_FRAME::Block_Move()
         if( gerber == NULL )    // Graphic layer not yet used
             continue;
 
-        /* Move items in block */
-        for( GERBER_DRAW_ITEM* item = gerber->GetItemsList(); item; item = item->Next() )
-        {
-            GERBER_DRAW_ITEM* gerb_item = item;
+        /* Move items in block: only items with a bounding box intersecting
+         * the block can have their start or end point inside it */
+        std::vector<GERBER_DRAW_ITEM*> candidates;
+        gerber->QueryItems( GetScreen()->m_BlockLocate, candidates );
 
+        for( GERBER_DRAW_ITEM* gerb_item : candidates )
+        {
             if( gerb_item->HitTest( GetScreen()->m_BlockLocate ) )
                 gerb_item->MoveAB( delta );
         }
     }
 
-    m_canvas->Refresh( true );
+    // Moved items have a new bounding box: rebuild the GAL view
+    loadGalCanvasItems();
+    RefreshCanvas( true );
 }
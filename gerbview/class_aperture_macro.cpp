@@ -95,18 +95,17 @@ bool AM_PRIMITIVE::IsAMPrimitiveExposureOn(GERBER_DRAW_ITEM* aParent) const
 const int seg_per_circle = 64;   // Number of segments to approximate a circle
 
 void AM_PRIMITIVE::DrawBasicShape( GERBER_DRAW_ITEM* aParent,
-                                   SHAPE_POLY_SET& aShapeBuffer,
-                                   wxPoint aShapePos )
+                                   SHAPE_POLY_SET& aShapeBuffer )
 {
     #define TO_POLY_SHAPE { aShapeBuffer.NewOutline(); \
                             for( unsigned jj = 0; jj < polybuffer.size(); jj++ )\
                                 aShapeBuffer.Append( polybuffer[jj].x, polybuffer[jj].y );}
 
-    // Draw the primitive shape for flashed items.
-    static std::vector<wxPoint> polybuffer;     // create a static buffer to avoid a lot of memory reallocation
-    polybuffer.clear();
+    // Draw the primitive shape for flashed items, relative to the shape position.
+    // This is made only once by D_CODE, so the buffer does not need to be static
+    std::vector<wxPoint> polybuffer;
 
-    wxPoint curPos = aShapePos;
+    wxPoint curPos( 0, 0 );
     D_CODE* tool   = aParent->GetDcodeDescr();
     double rotation;
 
@@ -134,14 +133,6 @@ void AM_PRIMITIVE::DrawBasicShape( GERBER_DRAW_ITEM* aParent,
             }
         }
 
-
-        // Move to current position:
-        for( unsigned ii = 0; ii < polybuffer.size(); ii++ )
-        {
-            polybuffer[ii] += curPos;
-            polybuffer[ii] = aParent->GetABPosition( polybuffer[ii] );
-        }
-
         TO_POLY_SHAPE;
     }
     break;
@@ -169,13 +160,6 @@ void AM_PRIMITIVE::DrawBasicShape( GERBER_DRAW_ITEM* aParent,
                 RotatePoint( &polybuffer[ii], -rotation );
         }
 
-        // Move to current position:
-        for( unsigned ii = 0; ii < polybuffer.size(); ii++ )
-        {
-            polybuffer[ii] += curPos;
-            polybuffer[ii] = aParent->GetABPosition( polybuffer[ii] );
-        }
-
         TO_POLY_SHAPE;
     }
     break;
@@ -201,13 +185,6 @@ void AM_PRIMITIVE::DrawBasicShape( GERBER_DRAW_ITEM* aParent,
                 RotatePoint( &polybuffer[ii], -rotation );
         }
 
-        // Move to current position:
-        for( unsigned ii = 0; ii < polybuffer.size(); ii++ )
-        {
-            polybuffer[ii] += curPos;
-            polybuffer[ii] = aParent->GetABPosition( polybuffer[ii] );
-        }
-
         TO_POLY_SHAPE;
     }
     break;
@@ -229,13 +206,6 @@ void AM_PRIMITIVE::DrawBasicShape( GERBER_DRAW_ITEM* aParent,
                 RotatePoint( &polybuffer[ii], -rotation );
         }
 
-        // Move to current position:
-        for( unsigned ii = 0; ii < polybuffer.size(); ii++ )
-        {
-            polybuffer[ii] += curPos;
-            polybuffer[ii] = aParent->GetABPosition( polybuffer[ii] );
-        }
-
         TO_POLY_SHAPE;
     }
     break;
@@ -268,10 +238,7 @@ void AM_PRIMITIVE::DrawBasicShape( GERBER_DRAW_ITEM* aParent,
 
             // Move to current position:
             for( unsigned jj = 0; jj < polybuffer.size(); jj++ )
-            {
                 polybuffer[jj] += curPos;
-                polybuffer[jj] = aParent->GetABPosition( polybuffer[jj] );
-            }
 
             TO_POLY_SHAPE;
         }
@@ -298,7 +265,7 @@ void AM_PRIMITIVE::DrawBasicShape( GERBER_DRAW_ITEM* aParent,
         int numCircles = KiROUND( params[5].GetValue( tool ) );
 
         // Draw circles:
-        wxPoint center = aParent->GetABPosition( curPos );
+        wxPoint center = curPos;
         // adjust outerDiam by this on each nested circle
         int diamAdjust = (gap + penThickness) * 2;
 
@@ -331,7 +298,6 @@ void AM_PRIMITIVE::DrawBasicShape( GERBER_DRAW_ITEM* aParent,
             RotatePoint( &polybuffer[ii], -rotation );
             // Move to current position:
             polybuffer[ii] += curPos;
-            polybuffer[ii] = aParent->GetABPosition( polybuffer[ii] );
         }
 
         TO_POLY_SHAPE;
@@ -372,13 +338,6 @@ void AM_PRIMITIVE::DrawBasicShape( GERBER_DRAW_ITEM* aParent,
             RotatePoint( &polybuffer[ii], -rotation );
        }
 
-        // Move to current position:
-        for( unsigned ii = 0; ii < polybuffer.size(); ii++ )
-        {
-            polybuffer[ii] += curPos;
-            polybuffer[ii] = aParent->GetABPosition( polybuffer[ii] );
-        }
-
         TO_POLY_SHAPE;
     }
         break;
@@ -403,7 +362,6 @@ void AM_PRIMITIVE::DrawBasicShape( GERBER_DRAW_ITEM* aParent,
         {
             RotatePoint( &polybuffer[ii], -rotation );
             polybuffer[ii] += curPos;
-            polybuffer[ii] = aParent->GetABPosition( polybuffer[ii] );
         }
 
         TO_POLY_SHAPE;
@@ -747,44 +705,79 @@ int AM_PRIMITIVE::GetShapeDim( GERBER_DRAW_ITEM* aParent )
 
 
 /*
- * Function DrawApertureMacroShape
- * Draw the primitive shape for flashed items.
- * When an item is flashed, this is the shape of the item
+ * Function ConvertToPolygon
+ * Calculate the shape of the macro, relative to the shape position, in X,Y gerber axis.
  */
-void APERTURE_MACRO::DrawApertureMacroShape( GERBER_DRAW_ITEM* aParent,
-                                             EDA_RECT* aClipBox, wxDC* aDC,
-                                             COLOR4D aColor,
-                                             wxPoint aShapePos, bool aFilledShape )
+void APERTURE_MACRO::ConvertToPolygon( GERBER_DRAW_ITEM* aParent, SHAPE_POLY_SET& aShapeBuffer )
 {
-    SHAPE_POLY_SET shapeBuffer;
     SHAPE_POLY_SET holeBuffer;
     bool hasHole = false;
 
+    aShapeBuffer.RemoveAllContours();
+
     for( AM_PRIMITIVES::iterator prim_macro = primitives.begin();
          prim_macro != primitives.end(); ++prim_macro )
     {
         if( prim_macro->IsAMPrimitiveExposureOn( aParent ) )
-            prim_macro->DrawBasicShape( aParent, shapeBuffer, aShapePos );
+            prim_macro->DrawBasicShape( aParent, aShapeBuffer );
         else
         {
-            prim_macro->DrawBasicShape( aParent, holeBuffer, aShapePos );
+            prim_macro->DrawBasicShape( aParent, holeBuffer );
 
             if( holeBuffer.OutlineCount() )     // we have a new hole in shape: remove the hole
             {
-                shapeBuffer.BooleanSubtract( holeBuffer, SHAPE_POLY_SET::PM_FAST );
+                aShapeBuffer.BooleanSubtract( holeBuffer, SHAPE_POLY_SET::PM_FAST );
                 holeBuffer.RemoveAllContours();
                 hasHole = true;
             }
         }
     }
 
-    if( shapeBuffer.OutlineCount() == 0 )
-        return;
-
     // If a hole is defined inside a polygon, we must fracture the polygon
     // to be able to drawn it (i.e link holes by overlapping edges)
-    if( hasHole )
-        shapeBuffer.Fracture( SHAPE_POLY_SET::PM_FAST );
+    if( hasHole && aShapeBuffer.OutlineCount() )
+        aShapeBuffer.Fracture( SHAPE_POLY_SET::PM_FAST );
+}
+
+
+/*
+ * Function GetApertureMacroShape
+ * Calculate the primitive shape for flashed items.
+ * When an item is flashed, this is the shape of the item
+ */
+void APERTURE_MACRO::GetApertureMacroShape( GERBER_DRAW_ITEM* aParent, wxPoint aShapePos,
+                                            SHAPE_POLY_SET& aShapeBuffer )
+{
+    D_CODE* tool = aParent->GetDcodeDescr();
+
+    wxASSERT( tool && tool->GetMacro() == this );
+
+    // The shape itself is calculated once by D_CODE: only move it
+    // to the actual position, and convert it to A,B plotter axis
+    aShapeBuffer = tool->GetMacroShape( aParent );
+
+    for( SHAPE_POLY_SET::ITERATOR iter = aShapeBuffer.IterateWithHoles(); iter; iter++ )
+    {
+        wxPoint corner( iter->x + aShapePos.x, iter->y + aShapePos.y );
+        corner = aParent->GetABPosition( corner );
+        *iter = VECTOR2I( corner.x, corner.y );
+    }
+}
+
+
+/*
+ * Function DrawApertureMacroShape
+ * Draw the primitive shape for flashed items.
+ * When an item is flashed, this is the shape of the item
+ */
+void APERTURE_MACRO::DrawApertureMacroShape( GERBER_DRAW_ITEM* aParent,
+                                             EDA_RECT* aClipBox, wxDC* aDC,
+                                             COLOR4D aColor,
+                                             wxPoint aShapePos, bool aFilledShape )
+{
+    SHAPE_POLY_SET shapeBuffer;
+
+    GetApertureMacroShape( aParent, aShapePos, shapeBuffer );
 
     for( int ii = 0; ii < shapeBuffer.OutlineCount(); ii++ )
     {
@@ -133,11 +133,10 @@ public: AM_PRIMITIVE( bool aGerbMetric, AM_PRIMITIVE_ID aId = AMP_UNKNOWN )
      * Function drawBasicShape
      * Draw (in fact generate the actual polygonal shape of) the primitive shape of an aperture macro instance.
      * @param aParent = the parent GERBER_DRAW_ITEM which is actually drawn
-     * @param aShapeBuffer = a SHAPE_POLY_SET to put the shape converted to a polygon
-     * @param aShapePos = the actual shape position
+     * @param aShapeBuffer = a SHAPE_POLY_SET to put the shape converted to a polygon,
+     * relative to the shape position, in X,Y gerber axis
      */
-    void DrawBasicShape( GERBER_DRAW_ITEM* aParent, SHAPE_POLY_SET& aShapeBuffer,
-                         wxPoint aShapePos );
+    void DrawBasicShape( GERBER_DRAW_ITEM* aParent, SHAPE_POLY_SET& aShapeBuffer );
 private:
 
     /**
@@ -197,6 +196,32 @@ struct APERTURE_MACRO
     void DrawApertureMacroShape( GERBER_DRAW_ITEM* aParent, EDA_RECT* aClipBox, wxDC* aDC,
                                  COLOR4D aColor, wxPoint aShapePos, bool aFilledShape );
 
+    /**
+     * Function ConvertToPolygon
+     * Calculate the shape of the macro for the parameters of a given D_CODE,
+     * relative to the shape position, in X,Y gerber axis.
+     * This is the expensive part of GetApertureMacroShape(), and its result is cached
+     * by D_CODE::GetMacroShape().
+     * @param aParent = a GERBER_DRAW_ITEM flashed with the D_CODE using this macro
+     * @param aShapeBuffer = a SHAPE_POLY_SET to put the shape.
+     * Polygons with holes are fractured.
+     */
+    void ConvertToPolygon( GERBER_DRAW_ITEM* aParent, SHAPE_POLY_SET& aShapeBuffer );
+
+    /**
+     * Function GetApertureMacroShape
+     * Calculate the primitive shape for flashed items, i.e. the polygons drawn
+     * by DrawApertureMacroShape().
+     * The shape is calculated once by D_CODE, and only moved to the actual
+     * position here.
+     * @param aParent = the parent GERBER_DRAW_ITEM which is actually drawn
+     * @param aShapePos = the actual shape position
+     * @param aShapeBuffer = a SHAPE_POLY_SET to put the shape, in A,B plotter axis.
+     * Polygons with holes are fractured.
+     */
+    void GetApertureMacroShape( GERBER_DRAW_ITEM* aParent, wxPoint aShapePos,
+                                SHAPE_POLY_SET& aShapeBuffer );
+
     /**
      * Function GetShapeDim
      * Calculate a value that can be used to evaluate the size of text
@@ -121,7 +121,7 @@ public: EXCELLON_IMAGE( int layer ) :
      * Warning and info messages are stored in m_Messages
      * @return bool if OK, false if the gerber file was not loaded
      */
-    bool LoadFile( const wxString& aFullFileName );
+    bool LoadFile( const wxString& aFullFileName ) override;
 
 private:
     bool Execute_HEADER_Command( char*& text );
@@ -33,6 +33,7 @@
 #include <class_drawpanel.h>
 #include <msgpanel.h>
 #include <gerbview_frame.h>
+#include <geometry/shape_poly_set.h>
 
 #include <class_gerber_draw_item.h>
 #include <class_gerber_file_image.h>
@@ -220,18 +221,82 @@ const EDA_RECT GERBER_DRAW_ITEM::GetBoundingBox() const
     // return a rectangle which is (pos,dim) in nature.  therefore the +1
     EDA_RECT bbox( m_Start, wxSize( 1, 1 ) );
 
-    bbox.Inflate( m_Size.x / 2, m_Size.y / 2 );
+    switch( m_Shape )
+    {
+    case GBR_POLYGON:
+        if( m_PolyCorners.size() )
+            bbox = EDA_RECT( m_PolyCorners[0], wxSize( 1, 1 ) );
+
+        for( unsigned ii = 1; ii < m_PolyCorners.size(); ii++ )
+            bbox.Merge( m_PolyCorners[ii] );
+
+        break;
+
+    case GBR_CIRCLE:
+        bbox.Inflate( KiROUND( GetLineLength( m_Start, m_End ) ) + m_Size.x / 2 );
+        break;
 
-    // calculate the corners coordinates in current gerber axis orientations
-    wxPoint org = GetABPosition( bbox.GetOrigin() );
-    wxPoint end = GetABPosition( bbox.GetEnd() );
+    case GBR_ARC:
+        // Use the full circle: the arc is inside it
+        bbox = EDA_RECT( m_ArcCentre, wxSize( 1, 1 ) );
+        bbox.Inflate( KiROUND( GetLineLength( m_ArcCentre, m_Start ) ) + m_Size.x / 2 );
+        break;
 
-    // Set the corners position:
-    bbox.SetOrigin( org );
-    bbox.SetEnd( end );
-    bbox.Normalize();
+    case GBR_SEGMENT:
+        bbox.Merge( m_End );
+        bbox.Inflate( m_Size.x / 2, m_Size.y / 2 );
+        break;
 
-    return bbox;
+    case GBR_SPOT_MACRO:
+    {
+        // The size of a macro shape is known only from its polygons,
+        // which are cached by the D_CODE relative to the shape position
+        GERBER_DRAW_ITEM* item = const_cast<GERBER_DRAW_ITEM*>( this );
+        D_CODE* d_codeDescr = item->GetDcodeDescr();
+
+        if( d_codeDescr && d_codeDescr->GetMacro() )
+        {
+            const SHAPE_POLY_SET& shape = d_codeDescr->GetMacroShape( item );
+
+            if( shape.OutlineCount() )
+            {
+                BOX2I box = shape.BBox();
+                bbox = EDA_RECT( m_Start + wxPoint( box.GetX(), box.GetY() ),
+                                 wxSize( box.GetWidth() + 1, box.GetHeight() + 1 ) );
+                break;
+            }
+        }
+
+        bbox.Inflate( m_Size.x / 2, m_Size.y / 2 );
+        break;
+    }
+
+    default:    // other flashed shapes
+        bbox.Inflate( m_Size.x / 2, m_Size.y / 2 );
+        break;
+    }
+
+    // calculate the corners coordinates in current gerber axis orientations.
+    // All the corners are used, because the layer can be rotated
+    wxPoint corners[4] =
+    {
+        bbox.GetOrigin(), bbox.GetEnd(),
+        wxPoint( bbox.GetX(), bbox.GetBottom() ), wxPoint( bbox.GetRight(), bbox.GetY() )
+    };
+
+    EDA_RECT abBox( GetABPosition( corners[0] ), wxSize( 1, 1 ) );
+
+    for( int ii = 1; ii < 4; ii++ )
+        abBox.Merge( GetABPosition( corners[ii] ) );
+
+    return abBox;
+}
+
+
+void GERBER_DRAW_ITEM::ViewGetLayers( int aLayers[], int& aCount ) const
+{
+    aCount = 1;
+    aLayers[0] = GERBER_DRAW_LAYER( GetLayer() );
 }
 
 
@@ -239,23 +304,35 @@ void GERBER_DRAW_ITEM::MoveAB( const wxPoint& aMoveVector )
 {
     wxPoint xymove = GetXYPosition( aMoveVector );
 
+    if( m_GerberImageFile )
+        m_GerberImageFile->RemoveFromItemsIndex( this );
+
     m_Start     += xymove;
     m_End       += xymove;
     m_ArcCentre += xymove;
 
     for( unsigned ii = 0; ii < m_PolyCorners.size(); ii++ )
         m_PolyCorners[ii] += xymove;
+
+    if( m_GerberImageFile )
+        m_GerberImageFile->AddToItemsIndex( this );
 }
 
 
 void GERBER_DRAW_ITEM::MoveXY( const wxPoint& aMoveVector )
 {
+    if( m_GerberImageFile )
+        m_GerberImageFile->RemoveFromItemsIndex( this );
+
     m_Start     += aMoveVector;
     m_End       += aMoveVector;
     m_ArcCentre += aMoveVector;
 
     for( unsigned ii = 0; ii < m_PolyCorners.size(); ii++ )
         m_PolyCorners[ii] += aMoveVector;
+
+    if( m_GerberImageFile )
+        m_GerberImageFile->AddToItemsIndex( this );
 }
 
 
@@ -579,6 +656,24 @@ bool GERBER_DRAW_ITEM::HitTest( const wxPoint& aRefPos ) const
     // calculate aRefPos in XY gerber axis:
     wxPoint ref_pos = GetXYPosition( aRefPos );
 
+    if( m_Shape == GBR_SPOT_MACRO )
+    {
+        // The macro shape is cached by the D_CODE, relative to the shape position
+        D_CODE* d_codeDescr = const_cast<GERBER_DRAW_ITEM*>( this )->GetDcodeDescr();
+
+        if( d_codeDescr && d_codeDescr->GetMacro() )
+        {
+            const SHAPE_POLY_SET& shape =
+                d_codeDescr->GetMacroShape( const_cast<GERBER_DRAW_ITEM*>( this ) );
+
+            if( shape.OutlineCount() )
+            {
+                wxPoint rel_pos = ref_pos - m_Start;
+                return shape.Contains( VECTOR2I( rel_pos.x, rel_pos.y ) );
+            }
+        }
+    }
+
     // TODO: a better analyze of the shape (perhaps create a D_CODE::HitTest for flashed items)
     int     radius = std::min( m_Size.x, m_Size.y ) >> 1;
 
@@ -126,6 +126,106 @@ GERBER_DRAW_ITEM * GERBER_FILE_IMAGE::GetItemsList()
     return m_Drawings;
 }
 
+
+// Spatial index helpers: the index is searched with the A,B axis bounding box of items
+static void itemBoxToRTreeBox( const EDA_RECT& aBox, int aMin[2], int aMax[2] )
+{
+    EDA_RECT box = aBox;
+    box.Normalize();
+
+    aMin[0] = box.GetX();
+    aMin[1] = box.GetY();
+    aMax[0] = box.GetRight();
+    aMax[1] = box.GetBottom();
+}
+
+
+void GERBER_FILE_IMAGE::AddToItemsIndex( GERBER_DRAW_ITEM* aItem )
+{
+    if( !m_itemsIndexValid )
+        return;
+
+    int mmin[2], mmax[2];
+    itemBoxToRTreeBox( aItem->GetBoundingBox(), mmin, mmax );
+    m_itemsIndex.Insert( mmin, mmax, aItem );
+}
+
+
+void GERBER_FILE_IMAGE::RemoveFromItemsIndex( GERBER_DRAW_ITEM* aItem )
+{
+    if( !m_itemsIndexValid )
+        return;
+
+    int mmin[2], mmax[2];
+    itemBoxToRTreeBox( aItem->GetBoundingBox(), mmin, mmax );
+    m_itemsIndex.Remove( mmin, mmax, aItem );
+}
+
+
+void GERBER_FILE_IMAGE::QueryItems( const EDA_RECT& aArea, std::vector<GERBER_DRAW_ITEM*>& aItems )
+{
+    if( !m_itemsIndexValid )
+    {
+        m_itemsIndexValid = true;
+
+        for( GERBER_DRAW_ITEM* item = GetItemsList(); item; item = item->Next() )
+            AddToItemsIndex( item );
+    }
+
+    int mmin[2], mmax[2];
+    itemBoxToRTreeBox( aArea, mmin, mmax );
+
+    auto collector = [&aItems]( GERBER_DRAW_ITEM* aItem ) -> bool
+    {
+        aItems.push_back( aItem );
+        return true;
+    };
+
+    m_itemsIndex.Search( mmin, mmax, collector );
+}
+
+
+GERBER_DRAW_ITEM* GERBER_FILE_IMAGE::LocateItem( const wxPoint& aPosition )
+{
+    std::vector<GERBER_DRAW_ITEM*> candidates;
+    QueryItems( EDA_RECT( aPosition, wxSize( 1, 1 ) ), candidates );
+
+    GERBER_DRAW_ITEM* found = NULL;
+    double foundArea = 0.0;
+
+    for( GERBER_DRAW_ITEM* item : candidates )
+    {
+        if( !item->HitTest( aPosition ) )
+            continue;
+
+        EDA_RECT bbox = item->GetBoundingBox();
+        double area = (double) bbox.GetWidth() * bbox.GetHeight();
+
+        if( found == NULL || area < foundArea )
+        {
+            found = item;
+            foundArea = area;
+        }
+    }
+
+    return found;
+}
+
+
+FILE* GERBER_FILE_IMAGE::openFile( const wxString& aFullFileName, std::vector<char>& aBuffer )
+{
+    FILE* file = wxFopen( aFullFileName, wxT( "rt" ) );
+
+    if( file == NULL )
+        return NULL;
+
+    aBuffer.resize( GERBER_FILE_BUFSIZE );
+    setvbuf( file, aBuffer.data(), _IOFBF, aBuffer.size() );
+
+    return file;
+}
+
+
 D_CODE* GERBER_FILE_IMAGE::GetDCODE( int aDCODE, bool aCreateIfNoExist )
 {
     unsigned ndx = aDCODE - FIRST_DCODE;
@@ -206,6 +306,8 @@ void GERBER_FILE_IMAGE::ResetDefaultValues()
     m_IJPos.x = m_IJPos.y = 0;                      // current centre coord for
                                                     // plot arcs & circles
     m_Current_File    = NULL;                       // Gerber file to read
+    m_itemsIndex.RemoveAll();                       // Items index is built after loading
+    m_itemsIndexValid = false;
     m_FilesPtr        = 0;
     m_PolygonFillMode = false;
     m_PolygonFillModeState = 0;
@@ -32,6 +32,7 @@
 #include <class_gerber_draw_item.h>
 #include <class_aperture_macro.h>
 #include <gbr_netlist_metadata.h>
+#include <geometry/rtree.h>
 
 // An useful macro used when reading gerber files;
 #define IsNumber( x ) ( ( ( (x) >= '0' ) && ( (x) <='9' ) )   \
@@ -104,6 +105,11 @@ class GERBER_FILE_IMAGE
 
     GERBER_LAYER       m_GBRLayerParams; // hold params for the current gerber layer
 
+    typedef RTree<GERBER_DRAW_ITEM*, int, 2, float> ITEMS_RTREE;
+
+    ITEMS_RTREE        m_itemsIndex;        ///< spatial index of m_Drawings, by bounding box
+    bool               m_itemsIndexValid;   ///< false until m_itemsIndex is built
+
 public:
     DLIST<GERBER_DRAW_ITEM> m_Drawings;                         // linked list of Gerber Items to draw
 
@@ -196,6 +202,18 @@ public:
      */
     bool LoadGerberFile( const wxString& aFullFileName );
 
+    /**
+     * Function LoadFile
+     * reads and loads the file of this image, using the reader of the image type.
+     * Files of different images can be loaded at the same time by different threads.
+     * @param aFullFileName = the full filename of the file
+     * @return bool if OK, false if the file was not loaded
+     */
+    virtual bool LoadFile( const wxString& aFullFileName )
+    {
+        return LoadGerberFile( aFullFileName );
+    }
+
     const wxArrayString& GetMessages() const { return m_messagesList; }
 
     /**
@@ -213,6 +231,33 @@ public:
      */
     GERBER_DRAW_ITEM * GetItemsList();
 
+    /**
+     * Function QueryItems
+     * finds the items which have a bounding box intersecting a given area.
+     * Uses a spatial index of the items, built on the first call after a file is loaded.
+     * @param aArea is the area to search, in A,B plotter axis.
+     * @param aItems receives the items found.
+     */
+    void QueryItems( const EDA_RECT& aArea, std::vector<GERBER_DRAW_ITEM*>& aItems );
+
+    /**
+     * Function LocateItem
+     * finds the item at a given position. When items overlap, the smallest one is returned,
+     * i.e. the most specific one (a flash rather than the region around it).
+     * @param aPosition is the position to test, in A,B plotter axis.
+     * @return the item found, or NULL.
+     */
+    GERBER_DRAW_ITEM* LocateItem( const wxPoint& aPosition );
+
+    /**
+     * Functions RemoveFromItemsIndex and AddToItemsIndex
+     * keep the spatial index up to date when the geometry of an item is modified:
+     * RemoveFromItemsIndex must be called before the change, AddToItemsIndex after it.
+     * Nothing is done if the index is not yet built.
+     */
+    void RemoveFromItemsIndex( GERBER_DRAW_ITEM* aItem );
+    void AddToItemsIndex( GERBER_DRAW_ITEM* aItem );
+
     /**
      * Function GetLayerParams
      * @return the current layers params
@@ -282,6 +327,17 @@ public:
      */
     bool ReadRS274XCommand( char *aBuff, char* & text );
 
+    /**
+     * Function openFile
+     * opens a Gerber or drill file for reading.
+     * The file is read by blocks of GERBER_FILE_BUFSIZE bytes, much larger than
+     * the default stdio buffer, which is a small part of a large photoplot file.
+     * @param aFullFileName is the file to open.
+     * @param aBuffer is the read buffer. It must not be freed before the file is closed.
+     * @return the opened file, or NULL if the file cannot be opened.
+     */
+    static FILE* openFile( const wxString& aFullFileName, std::vector<char>& aBuffer );
+
     /**
      * Function ExecuteRS274XCommand
      * executes 1 command
@@ -35,7 +35,12 @@
 #include <class_gerber_file_image_list.h>
 #include <class_X2_gerber_attributes.h>
 
+#include <algorithm>
+#include <atomic>
 #include <map>
+#include <thread>
+
+#include <sync_queue.h>
 
 
 // The global image list:
@@ -119,6 +124,72 @@ void GERBER_FILE_IMAGE_LIST::DeleteImage( int aIdx )
     m_GERBER_List[ aIdx ] = NULL;
 }
 
+
+bool GERBER_FILE_IMAGE_LIST::MoveImage( int aFrom, int aTo )
+{
+    int count = m_GERBER_List.size();
+
+    if( aFrom < 0 || aFrom >= count || aTo < 0 || aTo >= count
+        || m_GERBER_List[ aFrom ] == NULL || m_GERBER_List[ aTo ] != NULL )
+        return false;
+
+    // The items use the graphic layer of their image
+    m_GERBER_List[ aTo ] = m_GERBER_List[ aFrom ];
+    m_GERBER_List[ aTo ]->m_GraphicLayer = aTo;
+    m_GERBER_List[ aFrom ] = NULL;
+
+    return true;
+}
+
+int GERBER_FILE_IMAGE_LIST::LoadFiles( const std::vector<int>& aLayers,
+                                       const std::vector<wxString>& aFileNames )
+{
+    wxASSERT( aLayers.size() == aFileNames.size() );
+
+    SYNC_QUEUE<size_t> queue;
+
+    for( size_t ii = 0; ii < aLayers.size(); ++ii )
+    {
+        wxASSERT( GetGbrImage( aLayers[ii] ) );
+        queue.push( ii );
+    }
+
+    std::atomic<int> loadedCount( 0 );
+
+    auto loadJob = [&]()
+    {
+        size_t ii;
+
+        while( queue.pop( ii ) )
+        {
+            GERBER_FILE_IMAGE* image = GetGbrImage( aLayers[ii] );
+
+            if( image && image->LoadFile( aFileNames[ii] ) )
+                loadedCount++;
+        }
+    };
+
+    size_t nthreads = std::min<size_t>( aLayers.size(), std::thread::hardware_concurrency() );
+
+    if( nthreads <= 1 )
+    {
+        loadJob();
+    }
+    else
+    {
+        std::vector<std::thread> threads;
+
+        for( size_t ii = 0; ii < nthreads; ++ii )
+            threads.push_back( std::thread( loadJob ) );
+
+        for( auto& thread : threads )
+            thread.join();
+    }
+
+    return loadedCount;
+}
+
+
 // Build a name for image aIdx which can be used in layers manager
 const wxString GERBER_FILE_IMAGE_LIST::GetDisplayName( int aIdx, bool aNameOnly )
 {
@@ -95,6 +95,26 @@ public:
      */
     void DeleteImage( int aIdx );
 
+    /**
+     * moves the image aFrom to the free location aTo, and updates its graphic layer
+     * @param aFrom = the index of the image to move ( 0 ... GERBER_DRAWLAYERS_COUNT-1 )
+     * @param aTo = the index of a free location ( 0 ... GERBER_DRAWLAYERS_COUNT-1 )
+     * @return true if the image was moved
+     */
+    bool MoveImage( int aFrom, int aTo );
+
+    /**
+     * Function LoadFiles
+     * reads a list of files in images already added to the list.
+     * Each image reads its own file (Gerber or drill, according to its type), and the
+     * files are read at the same time by a pool of threads.
+     * Errors found in a file are stored in the messages of its image.
+     * @param aLayers = the index of the image of each file ( 0 ... GERBER_DRAWLAYERS_COUNT-1 )
+     * @param aFileNames = the full filename of each file
+     * @return the count of files successfully loaded
+     */
+    int LoadFiles( const std::vector<int>& aLayers, const std::vector<wxString>& aFileNames );
+
     /**
      * @return a name for image aIdx which can be used in layers manager
      * and layer selector or in the status bar
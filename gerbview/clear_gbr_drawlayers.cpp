@@ -47,6 +47,8 @@ bool GERBVIEW_FRAME::Clear_DrawLayers( bool query )
             return false;
     }
 
+    // Detach items from the GAL canvas before deleting them
+    clearGalCanvasItems();
     GetImagesList()->DeleteAllImages();
 
     GetGerberLayout()->SetBoundingBox( EDA_RECT() );
@@ -70,9 +72,11 @@ void GERBVIEW_FRAME::Erase_Current_DrawLayer( bool query )
 
     SetCurItem( NULL );
 
+    clearGalCanvasItems();
     GetImagesList()->DeleteImage( layer );
+    loadGalCanvasItems();
 
     ReFillLayerWidget();
     syncLayerBox();
-    m_canvas->Refresh();
+    RefreshCanvas();
 }
@@ -88,6 +88,8 @@ void D_CODE::Clear_D_CODE_Data()
     m_Rotation   = 0.0;
     m_EdgesCount = 0;
     m_PolyCorners.clear();
+    m_am_params.clear();
+    m_MacroShape.RemoveAllContours();
 }
 
 
@@ -150,6 +152,17 @@ int D_CODE::GetShapeDim( GERBER_DRAW_ITEM* aParent )
 }
 
 
+const SHAPE_POLY_SET& D_CODE::GetMacroShape( GERBER_DRAW_ITEM* aParent )
+{
+    wxASSERT( m_Macro );
+
+    if( m_MacroShape.OutlineCount() == 0 && m_Macro )
+        m_Macro->ConvertToPolygon( aParent, m_MacroShape );
+
+    return m_MacroShape;
+}
+
+
 void D_CODE::DrawFlashedShape(  GERBER_DRAW_ITEM* aParent,
                                 EDA_RECT* aClipBox, wxDC* aDC, COLOR4D aColor,
                                 wxPoint aShapePos, bool aFilledShape )
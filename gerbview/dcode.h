@@ -34,6 +34,7 @@
 
 #include <base_struct.h>
 #include <gal/color4d.h>
+#include <geometry/shape_poly_set.h>
 
 using KIGFX::COLOR4D;
 
@@ -94,6 +95,12 @@ private:
                                              * (shapes with hole )
                                              */
 
+    SHAPE_POLY_SET        m_MacroShape;     /* Shape of an aperture macro, relative to the
+                                             * shape position, in X,Y gerber axis.
+                                             * It depends only on the macro and m_am_params,
+                                             * so it is shared by all the flashes of this D_CODE
+                                             */
+
 public:
     wxSize                m_Size;           ///< Horizontal and vertical dimensions.
     APERTURE_T            m_Shape;          ///< shape ( Line, rectangle, circle , oval .. )
@@ -123,6 +130,7 @@ public:
     void AppendParam( double aValue )
     {
         m_am_params.push_back( aValue );
+        m_MacroShape.RemoveAllContours();
     }
 
     /**
@@ -152,6 +160,7 @@ public:
     void SetMacro( APERTURE_MACRO* aMacro )
     {
         m_Macro = aMacro;
+        m_MacroShape.RemoveAllContours();
     }
 
 
@@ -205,6 +214,28 @@ public:
      */
     void ConvertShapeToPolygon();
 
+    /**
+     * Function GetShapePolygon
+     * @return the polygon used to draw the APT_POLYGON shape and the shapes with a hole,
+     * relative to the shape position, in X,Y gerber axis. It is built on the first call.
+     */
+    const std::vector<wxPoint>& GetShapePolygon()
+    {
+        if( m_PolyCorners.size() == 0 )
+            ConvertShapeToPolygon();
+
+        return m_PolyCorners;
+    }
+
+    /**
+     * Function GetMacroShape
+     * @return the shape of the aperture macro used by this D_CODE, relative to the shape
+     * position, in X,Y gerber axis. It is built on the first call, and must be moved
+     * to the flash position and converted to A,B plotter axis by the caller.
+     * @param aParent = a GERBER_DRAW_ITEM flashed with this D_CODE
+     */
+    const SHAPE_POLY_SET& GetMacroShape( GERBER_DRAW_ITEM* aParent );
+
     /**
      * Function GetShapeDim
      * calculates a value that can be used to evaluate the size of text
@@ -72,6 +72,11 @@ BEGIN_EVENT_TABLE( GERBVIEW_FRAME, EDA_DRAW_FRAME )
 
     EVT_MENU( wxID_EXIT, GERBVIEW_FRAME::OnQuit )
 
+    // Menu View:
+    EVT_MENU( ID_MENU_CANVAS_LEGACY, GERBVIEW_FRAME::SwitchCanvas )
+    EVT_MENU( ID_MENU_CANVAS_CAIRO, GERBVIEW_FRAME::SwitchCanvas )
+    EVT_MENU( ID_MENU_CANVAS_OPENGL, GERBVIEW_FRAME::SwitchCanvas )
+
     // menu Preferences
     EVT_MENU_RANGE( ID_PREFERENCES_HOTKEY_START, ID_PREFERENCES_HOTKEY_END,
                     GERBVIEW_FRAME::Process_Config )
@@ -151,6 +156,10 @@ BEGIN_EVENT_TABLE( GERBVIEW_FRAME, EDA_DRAW_FRAME )
     EVT_UPDATE_UI_RANGE( ID_TB_OPTIONS_SHOW_GBR_MODE_0, ID_TB_OPTIONS_SHOW_GBR_MODE_2,
                          GERBVIEW_FRAME::OnUpdateDrawMode )
 
+    EVT_UPDATE_UI( ID_MENU_CANVAS_LEGACY, GERBVIEW_FRAME::OnUpdateSwitchCanvas )
+    EVT_UPDATE_UI( ID_MENU_CANVAS_CAIRO, GERBVIEW_FRAME::OnUpdateSwitchCanvas )
+    EVT_UPDATE_UI( ID_MENU_CANVAS_OPENGL, GERBVIEW_FRAME::OnUpdateSwitchCanvas )
+
 END_EVENT_TABLE()
 
 
@@ -310,7 +319,7 @@ void GERBVIEW_FRAME::OnSelectActiveLayer( wxCommandEvent& event )
     if( layer != getActiveLayer() )
     {
         if( m_LayersManager->OnLayerSelected() )
-            m_canvas->Refresh();
+            RefreshCanvas();
     }
 }
 
@@ -373,7 +382,7 @@ void GERBVIEW_FRAME::OnSelectDisplayMode( wxCommandEvent& event )
     }
 
     if( GetDisplayMode() != oldMode )
-        m_canvas->Refresh();
+        RefreshCanvas();
 }
 
 
@@ -423,27 +432,27 @@ void GERBVIEW_FRAME::OnSelectOptionToolbar( wxCommandEvent& event )
 
     case ID_TB_OPTIONS_SHOW_FLASHED_ITEMS_SKETCH:
         m_DisplayOptions.m_DisplayFlashedItemsFill = not state;
-        m_canvas->Refresh( true );
+        RefreshCanvas( true );
         break;
 
     case ID_TB_OPTIONS_SHOW_LINES_SKETCH:
         m_DisplayOptions.m_DisplayLinesFill = not state;
-        m_canvas->Refresh( true );
+        RefreshCanvas( true );
         break;
 
     case ID_TB_OPTIONS_SHOW_POLYGONS_SKETCH:
         m_DisplayOptions.m_DisplayPolygonsFill = not state;
-        m_canvas->Refresh( true );
+        RefreshCanvas( true );
         break;
 
     case ID_TB_OPTIONS_SHOW_DCODES:
         SetElementVisibility( LAYER_DCODES, state );
-        m_canvas->Refresh( true );
+        RefreshCanvas();
         break;
 
     case ID_TB_OPTIONS_SHOW_NEGATIVE_ITEMS:
         SetElementVisibility( LAYER_NEGATIVE_OBJECTS, state );
-        m_canvas->Refresh( true );
+        RefreshCanvas();
         break;
 
     case ID_TB_OPTIONS_SHOW_LAYERS_MANAGER_VERTICAL_TOOLBAR:
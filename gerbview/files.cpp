@@ -32,6 +32,7 @@
 #include <wx/zipstrm.h>
 
 #include <common.h>
+#include <confirm.h>
 #include <class_drawpanel.h>
 #include <reporter.h>
 #include <html_messagebox.h>
@@ -39,9 +40,13 @@
 #include <gerbview_frame.h>
 #include <gerbview_id.h>
 #include <class_gerber_file_image.h>
+#include <class_gerber_file_image_list.h>
+#include <class_excellon.h>
 #include <class_gerbview_layer_widget.h>
 #include <wildcards_and_files_ext.h>
 
+#include <deque>
+
 // HTML Messages used more than one time:
 #define MSG_NO_MORE_LAYER\
     _( "<b>No more available free graphic layer</b> in Gerbview to load files" )
@@ -87,6 +92,142 @@ void GERBVIEW_FRAME::OnZipFileHistory( wxCommandEvent& event )
 }
 
 
+bool GERBVIEW_FRAME::loadFiles( const std::vector<wxString>& aFileNames, bool aDrillFiles,
+                                REPORTER& aReporter )
+{
+    GERBER_FILE_IMAGE_LIST* images = GetImagesList();
+    bool success = true;
+    int layer = getActiveLayer();
+    unsigned next = 0;      // the first file not read yet
+
+    while( next < aFileNames.size() && layer != NO_AVAILABLE_LAYERS )
+    {
+        std::vector<int> layers;
+        std::vector<wxString> fileNames;
+
+        // Give a graphic layer and an image to each file, while layers are available
+        for( ; next < aFileNames.size() && layer != NO_AVAILABLE_LAYERS; next++ )
+        {
+            GERBER_FILE_IMAGE* image = GetGbrImage( layer );
+
+            // The image is reused only if it can read this type of file
+            if( image && ( dynamic_cast<EXCELLON_IMAGE*>( image ) != NULL ) != aDrillFiles )
+            {
+                images->DeleteImage( layer );
+                image = NULL;
+            }
+
+            if( image == NULL )
+            {
+                if( aDrillFiles )
+                    image = new EXCELLON_IMAGE( layer );
+                else
+                    image = new GERBER_FILE_IMAGE( layer );
+
+                images->AddGbrImage( image, layer );
+            }
+
+            layers.push_back( layer );
+            fileNames.push_back( aFileNames[next] );
+
+            layer = getNextAvailableLayer( layer );
+        }
+
+        // Read all files at once: each file has its own image
+        images->LoadFiles( layers, fileNames );
+
+        // The layer of a file which cannot be read is released, and the next loaded images
+        // are moved down, so loaded files use the same layers as when read one by one.
+        std::deque<int> freeLayers;
+
+        for( unsigned ii = 0; ii < fileNames.size(); ii++ )
+        {
+            m_lastFileName = fileNames[ii];
+
+            if( !showLoadResult( GetGbrImage( layers[ii] ), fileNames[ii], aDrillFiles ) )
+            {
+                success = false;
+                images->DeleteImage( layers[ii] );
+                freeLayers.push_back( layers[ii] );
+                continue;
+            }
+
+            if( !freeLayers.empty() && images->MoveImage( layers[ii], freeLayers.front() ) )
+            {
+                freeLayers.pop_front();
+                freeLayers.push_back( layers[ii] );
+            }
+
+            if( aDrillFiles )
+                UpdateFileHistory( m_lastFileName, &m_drillFileHistory );
+            else
+                UpdateFileHistory( m_lastFileName );
+        }
+
+        // Files left for lack of layers are read in the released layers
+        if( !freeLayers.empty() )
+            layer = freeLayers.front();
+    }
+
+    if( next < aFileNames.size() )
+    {
+        success = false;
+        aReporter.Report( MSG_NO_MORE_LAYER, REPORTER::RPT_ERROR );
+
+        // Report the name of not loaded files:
+        for( ; next < aFileNames.size(); next++ )
+        {
+            wxString txt;
+            txt.Printf( MSG_NOT_LOADED,
+                        GetChars( wxFileName( aFileNames[next] ).GetFullName() ) );
+            aReporter.Report( txt, REPORTER::RPT_ERROR );
+        }
+    }
+
+    // The next file will be loaded on the first free layer
+    if( layer != NO_AVAILABLE_LAYERS )
+        setActiveLayer( layer, false );
+
+    return success;
+}
+
+
+bool GERBVIEW_FRAME::showLoadResult( GERBER_FILE_IMAGE* aImage, const wxString& aFullFileName,
+                                     bool aDrillFile )
+{
+    wxString msg;
+
+    if( aImage == NULL || !aImage->m_InUse )
+    {
+        msg.Printf( _( "File <%s> not found" ), GetChars( aFullFileName ) );
+        DisplayError( this, msg, 10 );
+        return false;
+    }
+
+    // Display errors list
+    if( aImage->GetMessages().size() > 0 )
+    {
+        HTML_MESSAGE_BOX dlg( this, aDrillFile ? _( "Error reading EXCELLON drill file" )
+                                               : _( "Errors" ) );
+        dlg.ListSet( aImage->GetMessages() );
+        dlg.ShowModal();
+    }
+
+    /* if the gerber file is only a RS274D file
+     * (i.e. without any aperture information), warn the user:
+     */
+    if( !aDrillFile && !aImage->m_Has_DCode )
+    {
+        msg = _("Warning: this file has no D-Code definition\n"
+                "It is perhaps an old RS274D file\n"
+                "Therefore the size of items is undefined");
+        wxMessageBox( msg );
+    }
+
+    return true;
+}
+
+
 /* File commands. */
 void GERBVIEW_FRAME::Files_io( wxCommandEvent& event )
 {
@@ -102,18 +243,18 @@ void GERBVIEW_FRAME::Files_io( wxCommandEvent& event )
     case ID_GERBVIEW_ERASE_ALL:
         Clear_DrawLayers( false );
         Zoom_Automatique( false );
-        m_canvas->Refresh();
+        RefreshCanvas();
         ClearMsgPanel();
         break;
 
     case ID_GERBVIEW_LOAD_DRILL_FILE:
         LoadExcellonFiles( wxEmptyString );
-        m_canvas->Refresh();
+        RefreshCanvas();
         break;
 
     case ID_GERBVIEW_LOAD_ZIP_ARCHIVE_FILE:
         LoadZipArchiveFile( wxEmptyString );
-        m_canvas->Refresh();
+        RefreshCanvas();
         break;
 
     default:
@@ -202,13 +343,11 @@ bool GERBVIEW_FRAME::LoadGerberFiles( const wxString& aFullFileName )
         m_mruPath = currentPath;
     }
 
-    // Read gerber files: each file is loaded on a new GerbView layer
-    bool success = true;
-    int layer = getActiveLayer();
+    // Detach the displayed items from the GAL canvas: a file can replace a loaded image
+    clearGalCanvasItems();
 
-    // Manage errors when loading files
-    wxString msg;
-    WX_STRING_REPORTER reporter( &msg );
+    // Read gerber files: each file is loaded on a new GerbView layer
+    std::vector<wxString> fileNames;
 
     for( unsigned ii = 0; ii < filenamesList.GetCount(); ii++ )
     {
@@ -217,45 +356,23 @@ bool GERBVIEW_FRAME::LoadGerberFiles( const wxString& aFullFileName )
         if( !filename.IsAbsolute() )
             filename.SetPath( currentPath );
 
-        m_lastFileName = filename.GetFullPath();
-
-        setActiveLayer( layer, false );
-
-        if( Read_GERBER_File( filename.GetFullPath() ) )
-        {
-            UpdateFileHistory( m_lastFileName );
-
-            layer = getNextAvailableLayer( layer );
-
-            if( layer == NO_AVAILABLE_LAYERS && ii < filenamesList.GetCount()-1 )
-            {
-                success = false;
-                reporter.Report( MSG_NO_MORE_LAYER, REPORTER::RPT_ERROR );
+        fileNames.push_back( filename.GetFullPath() );
+    }
 
-                // Report the name of not loaded files:
-                ii += 1;
-                while( ii < filenamesList.GetCount() )
-                {
-                    filename = filenamesList[ii++];
-                    wxString txt;
-                    txt.Printf( MSG_NOT_LOADED,
-                                GetChars( filename.GetFullName() ) );
-                    reporter.Report( txt, REPORTER::RPT_ERROR );
-                }
-                break;
-            }
+    // Manage errors when loading files
+    wxString msg;
+    WX_STRING_REPORTER reporter( &msg );
 
-            setActiveLayer( layer, false );
-        }
-    }
+    bool success = loadFiles( fileNames, false, reporter );
 
-    if( !success )
+    if( !msg.IsEmpty() )
     {
         HTML_MESSAGE_BOX mbox( this, _( "Errors" ) );
         mbox.ListSet( msg );
         mbox.ShowModal();
     }
 
+    loadGalCanvasItems();
     Zoom_Automatique( false );
 
     // Synchronize layers tools with actual active layer:
@@ -305,13 +422,11 @@ bool GERBVIEW_FRAME::LoadExcellonFiles( const wxString& aFullFileName )
         m_mruPath = currentPath;
     }
 
-    // Read Excellon drill files: each file is loaded on a new GerbView layer
-    bool success = true;
-    int layer = getActiveLayer();
+    // Detach the displayed items from the GAL canvas: a file can replace a loaded image
+    clearGalCanvasItems();
 
-    // Manage errors when loading files
-    wxString msg;
-    WX_STRING_REPORTER reporter( &msg );
+    // Read Excellon drill files: each file is loaded on a new GerbView layer
+    std::vector<wxString> fileNames;
 
     for( unsigned ii = 0; ii < filenamesList.GetCount(); ii++ )
     {
@@ -320,46 +435,23 @@ bool GERBVIEW_FRAME::LoadExcellonFiles( const wxString& aFullFileName )
         if( !filename.IsAbsolute() )
             filename.SetPath( currentPath );
 
-        m_lastFileName = filename.GetFullPath();
-
-        setActiveLayer( layer, false );
-
-        if( Read_EXCELLON_File( filename.GetFullPath() ) )
-        {
-            // Update the list of recent drill files.
-            UpdateFileHistory( filename.GetFullPath(),  &m_drillFileHistory );
-
-            layer = getNextAvailableLayer( layer );
-
-            if( layer == NO_AVAILABLE_LAYERS && ii < filenamesList.GetCount()-1 )
-            {
-                success = false;
-                reporter.Report( MSG_NO_MORE_LAYER, REPORTER::RPT_ERROR );
+        fileNames.push_back( filename.GetFullPath() );
+    }
 
-                // Report the name of not loaded files:
-                ii += 1;
-                while( ii < filenamesList.GetCount() )
-                {
-                    filename = filenamesList[ii++];
-                    wxString txt;
-                    txt.Printf( MSG_NOT_LOADED,
-                                GetChars( filename.GetFullName() ) );
-                    reporter.Report( txt, REPORTER::RPT_ERROR );
-                }
-                break;
-            }
+    // Manage errors when loading files
+    wxString msg;
+    WX_STRING_REPORTER reporter( &msg );
 
-            setActiveLayer( layer, false );
-        }
-    }
+    bool success = loadFiles( fileNames, true, reporter );
 
-    if( !success )
+    if( !msg.IsEmpty() )
     {
         HTML_MESSAGE_BOX mbox( this, _( "Errors" ) );
         mbox.ListSet( msg );
         mbox.ShowModal();
     }
 
+    loadGalCanvasItems();
     Zoom_Automatique( false );
 
     // Synchronize layers tools with actual active layer:
@@ -559,9 +651,13 @@ bool GERBVIEW_FRAME::LoadZipArchiveFile( const wxString& aFullFileName )
     wxString msg;
     WX_STRING_REPORTER reporter( &msg );
 
+    clearGalCanvasItems();
+
     if( filename.IsOk() )
         unarchiveFiles( filename.GetFullPath(), &reporter );
 
+    loadGalCanvasItems();
+
     Zoom_Automatique( false );
 
     // Synchronize layers tools with actual active layer:
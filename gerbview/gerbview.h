@@ -38,6 +38,9 @@
 */
 #define GERBER_BUFZ     4000
 
+// Size of the read buffer of Gerber and drill files
+#define GERBER_FILE_BUFSIZE ( 1024 * 1024 )
+
 /// List of page sizes
 extern const wxChar* g_GerberPageSizeList[8];
 
@@ -0,0 +1,217 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "gerbview_draw_panel_gal.h"
+#include <view/view.h>
+#include <view/wx_view_controls.h>
+#include <gal/graphics_abstraction_layer.h>
+#include <gerbview_painter.h>
+#include <convert_to_biu.h>
+#include <macros.h>
+
+#include <class_colors_design_settings.h>
+#include <gerbview_frame.h>
+#include <class_gbr_layout.h>
+#include <class_gerber_file_image.h>
+#include <class_gerber_file_image_list.h>
+#include <class_gerber_draw_item.h>
+
+
+// Draw layers are stacked in the layer number order: the layer 0 is on the top,
+// as in the legacy canvas when no layer is active.
+const LAYER_NUM GERBVIEW_GAL_LAYER_ORDER[] =
+{
+    LAYER_DCODES,
+    GERBER_DRAW_LAYER( 0 ),  GERBER_DRAW_LAYER( 1 ),  GERBER_DRAW_LAYER( 2 ),
+    GERBER_DRAW_LAYER( 3 ),  GERBER_DRAW_LAYER( 4 ),  GERBER_DRAW_LAYER( 5 ),
+    GERBER_DRAW_LAYER( 6 ),  GERBER_DRAW_LAYER( 7 ),  GERBER_DRAW_LAYER( 8 ),
+    GERBER_DRAW_LAYER( 9 ),  GERBER_DRAW_LAYER( 10 ), GERBER_DRAW_LAYER( 11 ),
+    GERBER_DRAW_LAYER( 12 ), GERBER_DRAW_LAYER( 13 ), GERBER_DRAW_LAYER( 14 ),
+    GERBER_DRAW_LAYER( 15 ), GERBER_DRAW_LAYER( 16 ), GERBER_DRAW_LAYER( 17 ),
+    GERBER_DRAW_LAYER( 18 ), GERBER_DRAW_LAYER( 19 ), GERBER_DRAW_LAYER( 20 ),
+    GERBER_DRAW_LAYER( 21 ), GERBER_DRAW_LAYER( 22 ), GERBER_DRAW_LAYER( 23 ),
+    GERBER_DRAW_LAYER( 24 ), GERBER_DRAW_LAYER( 25 ), GERBER_DRAW_LAYER( 26 ),
+    GERBER_DRAW_LAYER( 27 ), GERBER_DRAW_LAYER( 28 ), GERBER_DRAW_LAYER( 29 ),
+    GERBER_DRAW_LAYER( 30 ), GERBER_DRAW_LAYER( 31 )
+};
+
+
+GERBVIEW_DRAW_PANEL_GAL::GERBVIEW_DRAW_PANEL_GAL( wxWindow* aParentWindow, wxWindowID aWindowId,
+                                                  const wxPoint& aPosition, const wxSize& aSize,
+                                                  KIGFX::GAL_DISPLAY_OPTIONS& aOptions,
+                                                  GAL_TYPE aGalType ) :
+EDA_DRAW_PANEL_GAL( aParentWindow, aWindowId, aPosition, aSize, aOptions, aGalType )
+{
+    setDefaultLayerOrder();
+    setDefaultLayerDeps();
+    setWorldUnitLength();
+
+    // Inside a layer, items are drawn in the order they were added, i.e. the file order
+    m_view->UseDrawPriority( true );
+
+    m_painter = new KIGFX::GERBVIEW_PAINTER( m_gal );
+    m_view->SetPainter( m_painter );
+
+    GERBVIEW_FRAME* frame = dynamic_cast<GERBVIEW_FRAME*>( GetParentEDAFrame() );
+
+    if( frame )
+    {
+        static_cast<KIGFX::GERBVIEW_RENDER_SETTINGS*>(
+            m_view->GetPainter()->GetSettings() )->LoadDisplayOptions( &frame->m_DisplayOptions );
+    }
+}
+
+
+GERBVIEW_DRAW_PANEL_GAL::~GERBVIEW_DRAW_PANEL_GAL()
+{
+    delete m_painter;
+}
+
+
+void GERBVIEW_DRAW_PANEL_GAL::DisplayLayout( GBR_LAYOUT* aLayout )
+{
+    m_view->Clear();
+
+    GERBER_FILE_IMAGE_LIST* images = aLayout->GetImagesList();
+
+    for( unsigned layer = 0; layer < images->ImagesMaxCount(); ++layer )
+    {
+        GERBER_FILE_IMAGE* gerber = images->GetGbrImage( layer );
+
+        if( gerber == NULL )    // Graphic layer not yet used
+            continue;
+
+        for( GERBER_DRAW_ITEM* item = gerber->GetItemsList(); item; item = item->Next() )
+            m_view->Add( item );
+    }
+}
+
+
+void GERBVIEW_DRAW_PANEL_GAL::ClearLayout( GBR_LAYOUT* aLayout )
+{
+    // Empty the VIEW at once, then detach the items: VIEW::Remove() is cheap
+    // on an empty VIEW, and items are no longer referring to it.
+    m_view->Clear();
+
+    GERBER_FILE_IMAGE_LIST* images = aLayout->GetImagesList();
+
+    for( unsigned layer = 0; layer < images->ImagesMaxCount(); ++layer )
+    {
+        GERBER_FILE_IMAGE* gerber = images->GetGbrImage( layer );
+
+        if( gerber == NULL )
+            continue;
+
+        for( GERBER_DRAW_ITEM* item = gerber->GetItemsList(); item; item = item->Next() )
+            m_view->Remove( item );
+    }
+}
+
+
+void GERBVIEW_DRAW_PANEL_GAL::UseColorScheme( const COLORS_DESIGN_SETTINGS* aSettings )
+{
+    KIGFX::GERBVIEW_RENDER_SETTINGS* rs;
+    rs = static_cast<KIGFX::GERBVIEW_RENDER_SETTINGS*>( m_view->GetPainter()->GetSettings() );
+    rs->ImportLegacyColors( aSettings );
+}
+
+
+void GERBVIEW_DRAW_PANEL_GAL::SetTopLayer( int aLayer )
+{
+    m_view->ClearTopLayers();
+    setDefaultLayerOrder();
+    m_view->SetTopLayer( aLayer );
+
+    // D-Codes are always displayed above the draw layers
+    m_view->SetTopLayer( LAYER_DCODES );
+
+    m_view->UpdateAllLayersOrder();
+}
+
+
+void GERBVIEW_DRAW_PANEL_GAL::SyncLayersVisibility( const GERBVIEW_FRAME* aFrame )
+{
+    for( int i = 0; i < GERBER_DRAWLAYERS_COUNT; ++i )
+        m_view->SetLayerVisible( GERBER_DRAW_LAYER( i ), aFrame->IsLayerVisible( i ) );
+
+    m_view->SetLayerVisible( LAYER_DCODES, aFrame->IsElementVisible( LAYER_DCODES ) );
+
+    static_cast<KIGFX::GERBVIEW_RENDER_SETTINGS*>(
+        m_view->GetPainter()->GetSettings() )->LoadDisplayOptions( &aFrame->m_DisplayOptions );
+}
+
+
+void GERBVIEW_DRAW_PANEL_GAL::OnShow()
+{
+    GERBVIEW_FRAME* frame = dynamic_cast<GERBVIEW_FRAME*>( GetParent() );
+
+    if( frame )
+    {
+        SetTopLayer( GERBER_DRAW_LAYER( frame->getActiveLayer() ) );
+        SyncLayersVisibility( frame );
+    }
+
+    m_view->RecacheAllItems();
+}
+
+
+void GERBVIEW_DRAW_PANEL_GAL::setDefaultLayerOrder()
+{
+    for( LAYER_NUM i = 0; (unsigned) i < DIM( GERBVIEW_GAL_LAYER_ORDER ); ++i )
+    {
+        LAYER_NUM layer = GERBVIEW_GAL_LAYER_ORDER[i];
+        wxASSERT( layer < KIGFX::VIEW::VIEW_MAX_LAYERS );
+
+        m_view->SetLayerOrder( layer, i );
+    }
+}
+
+
+bool GERBVIEW_DRAW_PANEL_GAL::SwitchBackend( GAL_TYPE aGalType )
+{
+    bool rv = EDA_DRAW_PANEL_GAL::SwitchBackend( aGalType );
+    setDefaultLayerDeps();
+    setWorldUnitLength();
+    return rv;
+}
+
+
+void GERBVIEW_DRAW_PANEL_GAL::setDefaultLayerDeps()
+{
+    // caching makes no sense for Cairo and other software renderers
+    auto target = m_backend == GAL_TYPE_OPENGL ? KIGFX::TARGET_CACHED : KIGFX::TARGET_NONCACHED;
+
+    for( int i = 0; i < KIGFX::VIEW::VIEW_MAX_LAYERS; i++ )
+        m_view->SetLayerTarget( i, target );
+
+    m_view->SetLayerDisplayOnly( LAYER_DCODES );
+    m_view->SetLayerDisplayOnly( LAYER_GRID );
+}
+
+
+void GERBVIEW_DRAW_PANEL_GAL::setWorldUnitLength()
+{
+    // The GAL default world unit is the Pcbnew internal unit (1 nm).
+    // GerbView internal unit is 10 nm.
+    m_gal->SetWorldUnitLength( 2.54 / ( IU_PER_MM * 1000.0 ) );
+}
@@ -0,0 +1,97 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef GERBVIEW_DRAW_PANEL_GAL_H_
+#define GERBVIEW_DRAW_PANEL_GAL_H_
+
+#include <class_draw_panel_gal.h>
+#include <layers_id_colors_and_visibility.h>
+
+class COLORS_DESIGN_SETTINGS;
+class GBR_LAYOUT;
+class GERBVIEW_FRAME;
+
+class GERBVIEW_DRAW_PANEL_GAL : public EDA_DRAW_PANEL_GAL
+{
+public:
+    GERBVIEW_DRAW_PANEL_GAL( wxWindow* aParentWindow, wxWindowID aWindowId,
+                             const wxPoint& aPosition, const wxSize& aSize,
+                             KIGFX::GAL_DISPLAY_OPTIONS& aOptions,
+                             GAL_TYPE aGalType = GAL_TYPE_OPENGL );
+
+    virtual ~GERBVIEW_DRAW_PANEL_GAL();
+
+    /**
+     * Function DisplayLayout
+     * adds all items of the loaded gerber images to the VIEW, so they can be displayed by GAL.
+     * Items previously displayed are removed first.
+     * Items are added in file order, and drawn in this order inside a layer, so negative
+     * objects erase the positive objects drawn before them.
+     * @param aLayout is the layout to be displayed.
+     */
+    void DisplayLayout( GBR_LAYOUT* aLayout );
+
+    /**
+     * Function ClearLayout
+     * removes all items of the loaded gerber images from the VIEW.
+     * Must be called once before the items are deleted: deleting an item still owned by
+     * the VIEW removes it from the VIEW item list one by one, which is slow on large images.
+     * @param aLayout is the layout currently displayed.
+     */
+    void ClearLayout( GBR_LAYOUT* aLayout );
+
+    /**
+     * Function UseColorScheme
+     * Applies layer color settings.
+     * @param aSettings are the new settings.
+     */
+    void UseColorScheme( const COLORS_DESIGN_SETTINGS* aSettings );
+
+    ///> @copydoc EDA_DRAW_PANEL_GAL::SetTopLayer()
+    virtual void SetTopLayer( int aLayer ) override;
+
+    /**
+     * Function SyncLayersVisibility
+     * Updates "visibility" property of each draw layer and loads the display options
+     * of a given GerbView frame.
+     * @param aFrame contains layers visibility settings to be applied.
+     */
+    void SyncLayersVisibility( const GERBVIEW_FRAME* aFrame );
+
+    ///> @copydoc EDA_DRAW_PANEL_GAL::OnShow()
+    void OnShow() override;
+
+    bool SwitchBackend( GAL_TYPE aGalType ) override;
+
+protected:
+    ///> Reassigns layer order to the initial settings.
+    void setDefaultLayerOrder();
+
+    ///> Sets rendering targets & dependencies for layers.
+    void setDefaultLayerDeps();
+
+    ///> Sets the size of the GAL world unit to the GerbView internal unit.
+    void setWorldUnitLength();
+};
+
+#endif /* GERBVIEW_DRAW_PANEL_GAL_H_ */
@@ -48,6 +48,9 @@
 #include <dialog_helpers.h>
 #include <class_DCodeSelectionbox.h>
 #include <class_gerbview_layer_widget.h>
+#include <gerbview_draw_panel_gal.h>
+#include <view/view.h>
+#include <gal/graphics_abstraction_layer.h>
 
 
 // Config keywords
@@ -56,6 +59,8 @@ static const wxString   cfgShowDCodes( wxT( "ShowDCodesOpt" ) );
 static const wxString   cfgShowNegativeObjects( wxT( "ShowNegativeObjectsOpt" ) );
 static const wxString   cfgShowBorderAndTitleBlock( wxT( "ShowBorderAndTitleBlock" ) );
 
+const wxChar GERBVIEW_FRAME::CANVAS_TYPE_KEY[] = wxT( "canvas_type" );
+
 
 GERBVIEW_FRAME::GERBVIEW_FRAME( KIWAY* aKiway, wxWindow* aParent ):
     EDA_DRAW_FRAME( aKiway, aParent, FRAME_GERBER, wxT( "GerbView" ),
@@ -97,6 +102,14 @@ GERBVIEW_FRAME::GERBVIEW_FRAME( KIWAY* aKiway, wxWindow* aParent ):
 
     SetScreen( new GBR_SCREEN( GetPageSettings().GetSizeIU() ) );
 
+    // Create GAL canvas
+    EDA_DRAW_PANEL_GAL* galCanvas = new GERBVIEW_DRAW_PANEL_GAL( this, -1, wxPoint( 0, 0 ),
+                                                m_FrameSize,
+                                                GetGalDisplayOptions(),
+                                                EDA_DRAW_PANEL_GAL::GAL_TYPE_NONE );
+
+    SetGalCanvas( galCanvas );
+
     // Create the PCB_LAYER_WIDGET *after* SetLayout():
     wxFont  font = wxSystemSettings::GetFont( wxSYS_DEFAULT_GUI_FONT );
     int     pointSize       = font.GetPointSize();
@@ -170,6 +183,10 @@ GERBVIEW_FRAME::GERBVIEW_FRAME( KIWAY* aKiway, wxWindow* aParent ):
         m_auimgr.AddPane( m_canvas,
                           wxAuiPaneInfo().Name( wxT( "DrawFrame" ) ).CentrePane() );
 
+    if( GetGalCanvas() )
+        m_auimgr.AddPane( (wxWindow*) GetGalCanvas(),
+                          wxAuiPaneInfo().Name( wxT( "DrawFrameGal" ) ).CentrePane().Hide() );
+
     if( m_messagePanel )
         m_auimgr.AddPane( m_messagePanel,
                           wxAuiPaneInfo( mesg ).Name( wxT( "MsgPanel" ) ).Bottom().Layer( 10 ) );
@@ -180,17 +197,29 @@ GERBVIEW_FRAME::GERBVIEW_FRAME( KIWAY* aKiway, wxWindow* aParent ):
 
     setActiveLayer( 0, true );
     Zoom_Automatique( false );           // Gives a default zoom value
+
+    EDA_DRAW_PANEL_GAL::GAL_TYPE canvasType = LoadCanvasTypeSetting();
+
+    if( canvasType != EDA_DRAW_PANEL_GAL::GAL_TYPE_NONE )
+    {
+        if( GetGalCanvas()->SwitchBackend( canvasType ) )
+            UseGalCanvas( true );
+    }
+
     UpdateTitleAndInfo();
 }
 
 
 GERBVIEW_FRAME::~GERBVIEW_FRAME()
 {
+    // Gerber images outlive the frame: they must not refer to the GAL canvas view
+    clearGalCanvasItems();
 }
 
 
 void GERBVIEW_FRAME::OnCloseWindow( wxCloseEvent& Event )
 {
+    GetGalCanvas()->StopDrawing();
     Destroy();
 }
 
@@ -892,3 +921,181 @@ void GERBVIEW_FRAME::unitsChangeRefresh()
     EDA_DRAW_FRAME::unitsChangeRefresh();
     updateDCodeSelectBox();
 }
+
+
+void GERBVIEW_FRAME::UseGalCanvas( bool aEnable )
+{
+    EDA_DRAW_PANEL_GAL* galCanvas = GetGalCanvas();
+
+    // Items are displayed by the GAL canvas view only when it is active
+    if( !aEnable )
+        clearGalCanvasItems();
+
+    EDA_DRAW_FRAME::UseGalCanvas( aEnable );
+
+    if( aEnable )
+    {
+        loadGalCanvasItems();
+        RefreshCanvas( true );
+        galCanvas->StartDrawing();
+    }
+    else
+    {
+        galCanvas->StopDrawing();
+        m_canvas->Refresh();
+    }
+}
+
+
+void GERBVIEW_FRAME::SwitchCanvas( wxCommandEvent& aEvent )
+{
+    bool use_gal = false;
+    EDA_DRAW_PANEL_GAL::GAL_TYPE canvasType = EDA_DRAW_PANEL_GAL::GAL_TYPE_NONE;
+
+    switch( aEvent.GetId() )
+    {
+    case ID_MENU_CANVAS_LEGACY:
+        break;
+
+    case ID_MENU_CANVAS_CAIRO:
+        use_gal = GetGalCanvas()->SwitchBackend( EDA_DRAW_PANEL_GAL::GAL_TYPE_CAIRO );
+
+        if( use_gal )
+            canvasType = EDA_DRAW_PANEL_GAL::GAL_TYPE_CAIRO;
+        break;
+
+    case ID_MENU_CANVAS_OPENGL:
+        use_gal = GetGalCanvas()->SwitchBackend( EDA_DRAW_PANEL_GAL::GAL_TYPE_OPENGL );
+
+        if( use_gal )
+            canvasType = EDA_DRAW_PANEL_GAL::GAL_TYPE_OPENGL;
+        break;
+    }
+
+    SaveCanvasTypeSetting( canvasType );
+    UseGalCanvas( use_gal );
+}
+
+
+void GERBVIEW_FRAME::OnUpdateSwitchCanvas( wxUpdateUIEvent& aEvent )
+{
+    wxMenuBar* menuBar = GetMenuBar();
+    EDA_DRAW_PANEL_GAL* gal_canvas = GetGalCanvas();
+    EDA_DRAW_PANEL_GAL::GAL_TYPE canvasType = EDA_DRAW_PANEL_GAL::GAL_TYPE_NONE;
+
+    if( IsGalCanvasActive() && gal_canvas )
+        canvasType = gal_canvas->GetBackend();
+
+    struct { int menuId; int galType; } menuList[] =
+    {
+        { ID_MENU_CANVAS_LEGACY,    EDA_DRAW_PANEL_GAL::GAL_TYPE_NONE },
+        { ID_MENU_CANVAS_OPENGL,    EDA_DRAW_PANEL_GAL::GAL_TYPE_OPENGL },
+        { ID_MENU_CANVAS_CAIRO,     EDA_DRAW_PANEL_GAL::GAL_TYPE_CAIRO },
+    };
+
+    for( auto ii: menuList )
+    {
+        wxMenuItem* item = menuBar->FindItem( ii.menuId );
+        if( ii.galType == canvasType )
+            item->Check( true );
+    }
+}
+
+
+EDA_DRAW_PANEL_GAL::GAL_TYPE GERBVIEW_FRAME::LoadCanvasTypeSetting() const
+{
+    EDA_DRAW_PANEL_GAL::GAL_TYPE canvasType = EDA_DRAW_PANEL_GAL::GAL_TYPE_NONE;
+    wxConfigBase* cfg = Kiface().KifaceSettings();
+
+    if( cfg )
+        canvasType = (EDA_DRAW_PANEL_GAL::GAL_TYPE) cfg->ReadLong( CANVAS_TYPE_KEY,
+                                                                   EDA_DRAW_PANEL_GAL::GAL_TYPE_NONE );
+
+    if( canvasType < EDA_DRAW_PANEL_GAL::GAL_TYPE_NONE
+            || canvasType >= EDA_DRAW_PANEL_GAL::GAL_TYPE_LAST )
+    {
+        assert( false );
+        canvasType = EDA_DRAW_PANEL_GAL::GAL_TYPE_NONE;
+    }
+
+    return canvasType;
+}
+
+
+bool GERBVIEW_FRAME::SaveCanvasTypeSetting( EDA_DRAW_PANEL_GAL::GAL_TYPE aCanvasType )
+{
+    if( aCanvasType < EDA_DRAW_PANEL_GAL::GAL_TYPE_NONE
+            || aCanvasType >= EDA_DRAW_PANEL_GAL::GAL_TYPE_LAST )
+    {
+        assert( false );
+        return false;
+    }
+
+    wxConfigBase* cfg = Kiface().KifaceSettings();
+
+    if( cfg )
+        return cfg->Write( CANVAS_TYPE_KEY, (long) aCanvasType );
+
+    return false;
+}
+
+
+void GERBVIEW_FRAME::RefreshCanvas( bool aRecacheItems )
+{
+    if( !IsGalCanvasActive() )
+    {
+        m_canvas->Refresh();
+        return;
+    }
+
+    GERBVIEW_DRAW_PANEL_GAL* galCanvas = static_cast<GERBVIEW_DRAW_PANEL_GAL*>( GetGalCanvas() );
+    KIGFX::VIEW* view = galCanvas->GetView();
+
+    // These colors are set in RedrawActiveWindow() for the legacy canvas
+    m_DisplayOptions.m_NegativeDrawColor = GetNegativeItemsColor();
+    m_DisplayOptions.m_BgDrawColor = GetDrawBgColor();
+
+    galCanvas->UseColorScheme( m_colorsSettings );
+    galCanvas->SyncLayersVisibility( this );
+    galCanvas->SetTopLayer( GERBER_DRAW_LAYER( getActiveLayer() ) );
+    galCanvas->GetGAL()->SetGridVisibility( IsGridVisible() );
+
+    if( aRecacheItems )
+        view->RecacheAllItems();
+    else
+        view->UpdateAllLayersColor();
+
+    galCanvas->Refresh();
+}
+
+
+void GERBVIEW_FRAME::SortLayersByX2Attributes()
+{
+    // The GAL items are stored on the layer of their image: remove them before the
+    // images are renumbered, and add them again on their new layer
+    clearGalCanvasItems();
+    GetImagesList()->SortImagesByZOrder();
+    loadGalCanvasItems();
+
+    ReFillLayerWidget();
+    syncLayerBox( true );
+    RefreshCanvas();
+}
+
+
+void GERBVIEW_FRAME::loadGalCanvasItems()
+{
+    if( !IsGalCanvasActive() )
+        return;
+
+    static_cast<GERBVIEW_DRAW_PANEL_GAL*>( GetGalCanvas() )->DisplayLayout( GetGerberLayout() );
+}
+
+
+void GERBVIEW_FRAME::clearGalCanvasItems()
+{
+    if( !IsGalCanvasActive() )
+        return;
+
+    static_cast<GERBVIEW_DRAW_PANEL_GAL*>( GetGalCanvas() )->ClearLayout( GetGerberLayout() );
+}
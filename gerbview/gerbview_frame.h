@@ -33,6 +33,7 @@
 
 #include <config_params.h>
 #include <draw_frame.h>
+#include <class_draw_panel_gal.h>
 #include <layers_id_colors_and_visibility.h>
 
 #include <gerbview.h>
@@ -200,6 +201,46 @@ private:
     void            updateDCodeSelectBox();
     virtual void    unitsChangeRefresh() override;      // See class EDA_DRAW_FRAME
 
+    /**
+     * Function loadGalCanvasItems
+     * adds the items of all gerber images to the GAL canvas view, when the GAL canvas
+     * is active. Must be called after images are loaded or modified.
+     */
+    void            loadGalCanvasItems();
+
+    /**
+     * Function clearGalCanvasItems
+     * removes the items of all gerber images from the GAL canvas view.
+     * Must be called before deleting items.
+     */
+    void            clearGalCanvasItems();
+
+    /**
+     * Function loadFiles
+     * loads a list of Gerber or drill files, each file on a new graphic layer, starting
+     * at the active layer. The files are read at the same time, then the errors found
+     * in each file are displayed. The layer of a file which cannot be read is released,
+     * and used by the next files.
+     * @param aFileNames is the list of full filenames to load.
+     * @param aDrillFiles is true for drill (EXCELLON) files, false for Gerber files.
+     * @param aReporter collects the names of files not loaded because no graphic layer
+     *                  is available.
+     * @return true if all files are loaded.
+     */
+    bool            loadFiles( const std::vector<wxString>& aFileNames, bool aDrillFiles,
+                               REPORTER& aReporter );
+
+    /**
+     * Function showLoadResult
+     * displays the errors found when loading the file of an image.
+     * @param aImage is the image which has read the file.
+     * @param aFullFileName is the file name.
+     * @param aDrillFile is true for a drill (EXCELLON) file, false for a Gerber file.
+     * @return true if the file was loaded.
+     */
+    bool            showLoadResult( GERBER_FILE_IMAGE* aImage, const wxString& aFullFileName,
+                                    bool aDrillFile );
+
     // An array string to store warning messages when reading a gerber file.
     wxArrayString   m_Messages;
 
@@ -209,6 +250,50 @@ public:
 
     void    OnCloseWindow( wxCloseEvent& Event );
 
+    ///> @copydoc EDA_DRAW_FRAME::UseGalCanvas
+    virtual void UseGalCanvas( bool aEnable ) override;
+
+    /**
+     * switches currently used canvas (default / Cairo / OpenGL).
+     */
+    void    SwitchCanvas( wxCommandEvent& aEvent );
+
+    /**
+     * Update UI called when switches currently used canvas (default / Cairo / OpenGL).
+     */
+    void    OnUpdateSwitchCanvas( wxUpdateUIEvent& aEvent );
+
+    /**
+     * Function LoadCanvasTypeSetting()
+     * Returns the canvas type stored in the application settings.
+     */
+    EDA_DRAW_PANEL_GAL::GAL_TYPE LoadCanvasTypeSetting() const;
+
+    /**
+     * Function SaveCanvasTypeSetting()
+     * Stores the canvas type in the application settings.
+     */
+    bool    SaveCanvasTypeSetting( EDA_DRAW_PANEL_GAL::GAL_TYPE aCanvasType );
+
+    ///> Key in KifaceSettings to store the canvas type.
+    static const wxChar CANVAS_TYPE_KEY[];
+
+    /**
+     * Function RefreshCanvas
+     * redraws the active canvas. When the GAL canvas is active, the current display
+     * settings (layers visibility and colors, fill modes, active layer) are applied first.
+     * @param aRecacheItems = true to rebuild the cached shapes of items (needed
+     *  when a fill mode is changed), false if only colors or visibility have changed.
+     */
+    void    RefreshCanvas( bool aRecacheItems = false );
+
+    /**
+     * Function SortLayersByX2Attributes
+     * sorts the gerber images by their X2 file function (the Z order of the layers),
+     * and moves the items of the GAL canvas to the graphic layers of their image.
+     */
+    void    SortLayersByX2Attributes();
+
     bool    OpenProjectFiles( const std::vector<wxString>& aFileSet, int aCtl ) override;
 
     // Virtual basic functions:
@@ -0,0 +1,421 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <deque>
+
+#include <fctsys.h>
+#include <trigo.h>
+#include <class_colors_design_settings.h>
+#include <geometry/shape_poly_set.h>
+
+#include <gerbview.h>
+#include <class_gerber_draw_item.h>
+#include <class_gerber_file_image.h>
+#include <class_gbr_display_options.h>
+#include <class_aperture_macro.h>
+#include <dcode.h>
+
+#include <gerbview_painter.h>
+#include <gal/graphics_abstraction_layer.h>
+
+using namespace KIGFX;
+
+GERBVIEW_RENDER_SETTINGS::GERBVIEW_RENDER_SETTINGS()
+{
+    m_backgroundColor  = COLOR4D( 0.0, 0.0, 0.0, 1.0 );
+    m_negativeColor    = m_backgroundColor;
+    m_flashedItemsFill = true;
+    m_linesFill        = true;
+    m_polygonsFill     = true;
+
+    update();
+}
+
+
+void GERBVIEW_RENDER_SETTINGS::ImportLegacyColors( const COLORS_DESIGN_SETTINGS* aSettings )
+{
+    // Init draw layers colors:
+    for( int i = 0; i < GERBER_DRAWLAYERS_COUNT; i++ )
+        m_layerColors[GERBER_DRAW_LAYER( i )] = aSettings->GetLayerColor( i );
+
+    // Init specific graphic layers colors:
+    for( int i = LAYER_DCODES; i < GERBVIEW_LAYER_ID_END; i++ )
+        m_layerColors[i] = aSettings->GetItemColor( i );
+
+    // The grid is drawn by the GAL on the generic grid layer
+    m_layerColors[LAYER_GRID] = aSettings->GetItemColor( LAYER_GERBVIEW_GRID );
+
+    update();
+}
+
+
+void GERBVIEW_RENDER_SETTINGS::LoadDisplayOptions( const GBR_DISPLAY_OPTIONS* aOptions )
+{
+    if( aOptions == NULL )
+        return;
+
+    m_flashedItemsFill = aOptions->m_DisplayFlashedItemsFill;
+    m_linesFill        = aOptions->m_DisplayLinesFill;
+    m_polygonsFill     = aOptions->m_DisplayPolygonsFill;
+    m_negativeColor    = aOptions->m_NegativeDrawColor;
+    m_backgroundColor  = aOptions->m_BgDrawColor;
+}
+
+
+const COLOR4D& GERBVIEW_RENDER_SETTINGS::GetColor( const VIEW_ITEM* aItem, int aLayer ) const
+{
+    const GERBER_DRAW_ITEM* item = static_cast<const GERBER_DRAW_ITEM*>( aItem );
+
+    if( item )
+    {
+        if( item->IsSelected() )
+            return m_layerColorsSel[aLayer];
+
+        // Negative items are drawn in the "negative" color, usually the background color,
+        // so that an erasure happens
+        bool isDark = !( const_cast<GERBER_DRAW_ITEM*>( item )->GetLayerPolarity()
+                         ^ item->m_GerberImageFile->m_ImageNegative );
+
+        if( !isDark )
+            return m_negativeColor;
+    }
+
+    // Return grayish color for non-active layers in the high contrast mode
+    if( m_hiContrastEnabled && m_activeLayers.count( aLayer ) == 0 )
+        return m_hiContrastColor;
+
+    return m_layerColors[aLayer];
+}
+
+
+GERBVIEW_PAINTER::GERBVIEW_PAINTER( GAL* aGal ) :
+    PAINTER( aGal )
+{
+}
+
+
+bool GERBVIEW_PAINTER::Draw( const VIEW_ITEM* aItem, int aLayer )
+{
+    const EDA_ITEM* item = static_cast<const EDA_ITEM*>( aItem );
+
+    switch( item->Type() )
+    {
+    case TYPE_GERBER_DRAW_ITEM:
+        draw( const_cast<GERBER_DRAW_ITEM*>( static_cast<const GERBER_DRAW_ITEM*>( item ) ),
+              aLayer );
+        break;
+
+    default:
+        // Painter does not know how to draw the object
+        return false;
+    }
+
+    return true;
+}
+
+
+void GERBVIEW_PAINTER::draw( GERBER_DRAW_ITEM* aItem, int aLayer )
+{
+    const COLOR4D& color = m_gerbviewSettings.GetColor( aItem, aLayer );
+    bool isDark = !( aItem->GetLayerPolarity() ^ aItem->m_GerberImageFile->m_ImageNegative );
+    bool isFilled = m_gerbviewSettings.m_linesFill;
+
+    m_gal->SetFillColor( color );
+    m_gal->SetStrokeColor( color );
+
+    switch( aItem->m_Shape )
+    {
+    case GBR_POLYGON:
+        // Negative polygons are always filled, to erase what is under them
+        isFilled = m_gerbviewSettings.m_polygonsFill || !isDark;
+        drawPolygon( aItem, aItem->m_PolyCorners, wxPoint( 0, 0 ), isFilled );
+        break;
+
+    case GBR_CIRCLE:
+    {
+        VECTOR2D center( aItem->GetABPosition( aItem->m_Start ) );
+        double radius = GetLineLength( aItem->m_Start, aItem->m_End );
+
+        m_gal->SetIsFill( false );
+        m_gal->SetIsStroke( true );
+
+        if( !isFilled )
+        {
+            // Draw the border of the pen's path using two circles
+            double halfPenWidth = aItem->m_Size.x / 2.0;
+
+            m_gal->SetLineWidth( m_gerbviewSettings.m_outlineWidth );
+            m_gal->DrawCircle( center, radius - halfPenWidth );
+            m_gal->DrawCircle( center, radius + halfPenWidth );
+        }
+        else
+        {
+            m_gal->SetLineWidth( aItem->m_Size.x );
+            m_gal->DrawCircle( center, radius );
+        }
+
+        break;
+    }
+
+    case GBR_ARC:
+    {
+        // Currently, arcs plotted with a rectangular aperture are not supported.
+        // a round pen only is expected.
+        VECTOR2D start( aItem->GetABPosition( aItem->m_Start ) );
+        VECTOR2D end( aItem->GetABPosition( aItem->m_End ) );
+        VECTOR2D center( aItem->GetABPosition( aItem->m_ArcCentre ) );
+        double   radius = ( start - center ).EuclideanNorm();
+
+        // The legacy canvas draws the arc counterclockwise on screen from start to end,
+        // i.e. clockwise in the GAL angle convention (Y axis pointing down).
+        // A null arc (start == end) is a full circle.
+        double endAngle   = ( start - center ).Angle();
+        double startAngle = ( end - center ).Angle();
+
+        if( endAngle <= startAngle )
+            endAngle += 2 * M_PI;
+
+        if( !isFilled )
+        {
+            m_gal->SetIsFill( false );
+            m_gal->SetIsStroke( true );
+            m_gal->SetLineWidth( m_gerbviewSettings.m_outlineWidth );
+            m_gal->DrawArc( center, radius, startAngle, endAngle );
+        }
+        else
+        {
+            m_gal->SetIsFill( true );
+            m_gal->SetIsStroke( false );
+            m_gal->DrawArcSegment( center, radius, startAngle, endAngle, aItem->m_Size.x );
+        }
+
+        break;
+    }
+
+    case GBR_SPOT_CIRCLE:
+    case GBR_SPOT_RECT:
+    case GBR_SPOT_OVAL:
+    case GBR_SPOT_POLY:
+    case GBR_SPOT_MACRO:
+        drawFlashedShape( aItem, m_gerbviewSettings.m_flashedItemsFill );
+        break;
+
+    case GBR_SEGMENT:
+    {
+        D_CODE* code = aItem->GetDcodeDescr();
+
+        // Lines plotted with a rectangular pen are converted to a polygon
+        if( code && code->m_Shape == APT_RECT )
+        {
+            if( aItem->m_PolyCorners.size() == 0 )
+                aItem->ConvertSegmentToPolygon();
+
+            drawPolygon( aItem, aItem->m_PolyCorners, wxPoint( 0, 0 ), isFilled );
+            break;
+        }
+
+        VECTOR2D start( aItem->GetABPosition( aItem->m_Start ) );
+        VECTOR2D end( aItem->GetABPosition( aItem->m_End ) );
+
+        if( !isFilled )
+        {
+            m_gal->SetIsFill( false );
+            m_gal->SetIsStroke( true );
+            m_gal->SetLineWidth( m_gerbviewSettings.m_outlineWidth );
+        }
+        else
+        {
+            m_gal->SetIsFill( true );
+            m_gal->SetIsStroke( false );
+        }
+
+        m_gal->DrawSegment( start, end, aItem->m_Size.x );
+        break;
+    }
+
+    default:
+        wxASSERT_MSG( false, wxT( "GERBVIEW_PAINTER: unknown gerber item shape" ) );
+        break;
+    }
+}
+
+
+void GERBVIEW_PAINTER::drawFlashedShape( GERBER_DRAW_ITEM* aItem, bool aFilled )
+{
+    // used when a D_CODE is not found. default D_CODE to draw a flashed item
+    static D_CODE dummyD_CODE( 0 );
+    D_CODE* code = aItem->GetDcodeDescr();
+
+    if( code == NULL )
+        code = &dummyD_CODE;
+
+    const wxPoint& pos = aItem->m_Start;
+
+    if( !aFilled )
+    {
+        m_gal->SetIsFill( false );
+        m_gal->SetIsStroke( true );
+        m_gal->SetLineWidth( m_gerbviewSettings.m_outlineWidth );
+    }
+    else
+    {
+        m_gal->SetIsFill( true );
+        m_gal->SetIsStroke( false );
+    }
+
+    switch( code->m_Shape )
+    {
+    case APT_MACRO:
+    {
+        SHAPE_POLY_SET shape;
+
+        code->GetMacro()->GetApertureMacroShape( aItem, pos, shape );
+
+        if( aFilled )
+        {
+            m_gal->DrawPolygon( shape );
+        }
+        else
+        {
+            for( int ii = 0; ii < shape.OutlineCount(); ii++ )
+            {
+                SHAPE_LINE_CHAIN outline = shape.COutline( ii );
+                outline.SetClosed( true );
+                m_gal->DrawPolyline( outline );
+            }
+        }
+
+        break;
+    }
+
+    case APT_CIRCLE:
+    {
+        VECTOR2D center( aItem->GetABPosition( pos ) );
+        double radius = code->m_Size.x / 2.0;
+
+        if( !aFilled || code->m_DrillShape == APT_DEF_NO_HOLE )
+        {
+            m_gal->DrawCircle( center, radius );
+        }
+        else if( code->m_DrillShape == APT_DEF_ROUND_HOLE )
+        {
+            // A ring: the hole is not filled
+            double width = ( code->m_Size.x - code->m_Drill.x ) / 2.0;
+
+            m_gal->SetIsFill( false );
+            m_gal->SetIsStroke( true );
+            m_gal->SetLineWidth( width );
+            m_gal->DrawCircle( center, radius - width / 2 );
+        }
+        else    // rectangular hole
+        {
+            drawPolygon( aItem, code->GetShapePolygon(), pos, aFilled );
+        }
+
+        break;
+    }
+
+    case APT_RECT:
+    {
+        if( aFilled && code->m_DrillShape != APT_DEF_NO_HOLE )
+        {
+            drawPolygon( aItem, code->GetShapePolygon(), pos, aFilled );
+            break;
+        }
+
+        wxPoint start( pos.x - code->m_Size.x / 2, pos.y - code->m_Size.y / 2 );
+        wxPoint end = start + code->m_Size;
+
+        m_gal->DrawRectangle( VECTOR2D( aItem->GetABPosition( start ) ),
+                              VECTOR2D( aItem->GetABPosition( end ) ) );
+        break;
+    }
+
+    case APT_OVAL:
+    {
+        if( aFilled && code->m_DrillShape != APT_DEF_NO_HOLE )
+        {
+            drawPolygon( aItem, code->GetShapePolygon(), pos, aFilled );
+            break;
+        }
+
+        wxPoint start = pos;
+        wxPoint end   = pos;
+        int     width;
+
+        if( code->m_Size.x > code->m_Size.y )   // horizontal oval
+        {
+            int delta = ( code->m_Size.x - code->m_Size.y ) / 2;
+            start.x -= delta;
+            end.x   += delta;
+            width    = code->m_Size.y;
+        }
+        else                                    // vertical oval
+        {
+            int delta = ( code->m_Size.y - code->m_Size.x ) / 2;
+            start.y -= delta;
+            end.y   += delta;
+            width    = code->m_Size.x;
+        }
+
+        m_gal->DrawSegment( VECTOR2D( aItem->GetABPosition( start ) ),
+                            VECTOR2D( aItem->GetABPosition( end ) ), width );
+        break;
+    }
+
+    case APT_POLYGON:
+        drawPolygon( aItem, code->GetShapePolygon(), pos, aFilled );
+        break;
+    }
+}
+
+
+void GERBVIEW_PAINTER::drawPolygon( const GERBER_DRAW_ITEM* aItem,
+                                    const std::vector<wxPoint>& aPolygon,
+                                    const wxPoint& aOffset, bool aFilled )
+{
+    if( aPolygon.size() == 0 )
+        return;
+
+    std::deque<VECTOR2D> points;
+
+    for( const wxPoint& corner : aPolygon )
+        points.push_back( VECTOR2D( aItem->GetABPosition( corner + aOffset ) ) );
+
+    if( aFilled )
+    {
+        m_gal->SetIsFill( true );
+        m_gal->SetIsStroke( false );
+        m_gal->DrawPolygon( points );
+    }
+    else
+    {
+        // Close the outline
+        points.push_back( points.front() );
+
+        m_gal->SetIsFill( false );
+        m_gal->SetIsStroke( true );
+        m_gal->SetLineWidth( m_gerbviewSettings.m_outlineWidth );
+        m_gal->DrawPolyline( points );
+    }
+}
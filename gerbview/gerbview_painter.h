@@ -0,0 +1,133 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef __GERBVIEW_PAINTER_H
+#define __GERBVIEW_PAINTER_H
+
+#include <painter.h>
+
+#include <vector>
+
+
+class COLORS_DESIGN_SETTINGS;
+class GBR_DISPLAY_OPTIONS;
+class GERBER_DRAW_ITEM;
+class wxPoint;
+
+namespace KIGFX
+{
+class GAL;
+
+/**
+ * Class GERBVIEW_RENDER_SETTINGS
+ * Stores GerbView specific render settings.
+ */
+class GERBVIEW_RENDER_SETTINGS : public RENDER_SETTINGS
+{
+public:
+    friend class GERBVIEW_PAINTER;
+
+    GERBVIEW_RENDER_SETTINGS();
+
+    /// @copydoc RENDER_SETTINGS::ImportLegacyColors()
+    void ImportLegacyColors( const COLORS_DESIGN_SETTINGS* aSettings ) override;
+
+    /**
+     * Function LoadDisplayOptions
+     * Loads settings related to display options (filled or sketch modes for flashed items,
+     * lines and polygons, color of negative objects).
+     * @param aOptions are settings that you want to use for displaying items.
+     */
+    void LoadDisplayOptions( const GBR_DISPLAY_OPTIONS* aOptions );
+
+    /// @copydoc RENDER_SETTINGS::GetColor()
+    virtual const COLOR4D& GetColor( const VIEW_ITEM* aItem, int aLayer ) const override;
+
+protected:
+    ///> Flag determining if flashed items should be drawn filled or as an outline
+    bool    m_flashedItemsFill;
+
+    ///> Flag determining if lines, arcs and circles should be drawn filled or as an outline
+    bool    m_linesFill;
+
+    ///> Flag determining if polygons (regions) should be drawn filled or as an outline
+    bool    m_polygonsFill;
+
+    ///> Color used to draw negative objects (usually the background color)
+    COLOR4D m_negativeColor;
+};
+
+
+/**
+ * Class GERBVIEW_PAINTER
+ * Contains methods for drawing GerbView-specific items.
+ */
+class GERBVIEW_PAINTER : public PAINTER
+{
+public:
+    GERBVIEW_PAINTER( GAL* aGal );
+
+    /// @copydoc PAINTER::ApplySettings()
+    virtual void ApplySettings( const RENDER_SETTINGS* aSettings ) override
+    {
+        m_gerbviewSettings = *static_cast<const GERBVIEW_RENDER_SETTINGS*>( aSettings );
+    }
+
+    /// @copydoc PAINTER::GetSettings()
+    virtual GERBVIEW_RENDER_SETTINGS* GetSettings() override
+    {
+        return &m_gerbviewSettings;
+    }
+
+    /// @copydoc PAINTER::Draw()
+    virtual bool Draw( const VIEW_ITEM* aItem, int aLayer ) override;
+
+protected:
+    GERBVIEW_RENDER_SETTINGS m_gerbviewSettings;
+
+    // Drawing functions for GerbView items. Some shapes (polygons of rectangular pens,
+    // aperture polygons) are built on demand, therefore items are not const here.
+    void draw( GERBER_DRAW_ITEM* aItem, int aLayer );
+
+    /**
+     * Function drawFlashedShape
+     * Draws the D-Code shape of a flashed item, mirroring D_CODE::DrawFlashedShape().
+     * @param aItem is the flashed item.
+     * @param aFilled decides if the shape is drawn filled or in sketch mode.
+     */
+    void drawFlashedShape( GERBER_DRAW_ITEM* aItem, bool aFilled );
+
+    /**
+     * Function drawPolygon
+     * Draws a polygon given in X,Y gerber axis, converted to A,B plotter axis.
+     * @param aItem is the item owning the polygon (it gives the axis transform).
+     * @param aPolygon is the list of corners.
+     * @param aOffset is added to each corner before the transform.
+     * @param aFilled decides if the polygon is drawn filled or in sketch mode.
+     */
+    void drawPolygon( const GERBER_DRAW_ITEM* aItem, const std::vector<wxPoint>& aPolygon,
+                      const wxPoint& aOffset, bool aFilled );
+};
+} // namespace KIGFX
+
+#endif /* __GERBVIEW_PAINTER_H */
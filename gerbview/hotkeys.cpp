@@ -181,27 +181,27 @@ bool GERBVIEW_FRAME::OnHotKey( wxDC* aDC, int aHotkeyCode, const wxPoint& aPosit
 
     case HK_GBR_LINES_DISPLAY_MODE:
         CHANGE(  m_DisplayOptions.m_DisplayLinesFill );
-        m_canvas->Refresh();
+        RefreshCanvas( true );
         break;
 
     case HK_GBR_FLASHED_DISPLAY_MODE:
         CHANGE( m_DisplayOptions.m_DisplayFlashedItemsFill );
-        m_canvas->Refresh( true );
+        RefreshCanvas( true );
         break;
 
     case HK_GBR_POLYGON_DISPLAY_MODE:
         CHANGE( m_DisplayOptions.m_DisplayPolygonsFill );
-        m_canvas->Refresh();
+        RefreshCanvas( true );
         break;
 
     case HK_GBR_NEGATIVE_DISPLAY_ONOFF:
         SetElementVisibility( LAYER_NEGATIVE_OBJECTS, not IsElementVisible( LAYER_NEGATIVE_OBJECTS ) );
-        m_canvas->Refresh();
+        RefreshCanvas();
         break;
 
     case HK_GBR_DCODE_DISPLAY_ONOFF:
         SetElementVisibility( LAYER_DCODES, not IsElementVisible( LAYER_DCODES ) );
-        m_canvas->Refresh();
+        RefreshCanvas();
         break;
 
     case HK_SWITCH_LAYER_TO_PREVIOUS:
@@ -209,7 +209,7 @@ bool GERBVIEW_FRAME::OnHotKey( wxDC* aDC, int aHotkeyCode, const wxPoint& aPosit
         {
             setActiveLayer( getActiveLayer() - 1 );
             m_LayersManager->OnLayerSelected();
-            m_canvas->Refresh();
+            RefreshCanvas();
         }
         break;
 
@@ -218,7 +218,7 @@ bool GERBVIEW_FRAME::OnHotKey( wxDC* aDC, int aHotkeyCode, const wxPoint& aPosit
         {
             setActiveLayer( getActiveLayer() + 1 );
             m_LayersManager->OnLayerSelected();
-            m_canvas->Refresh();
+            RefreshCanvas();
         }
         break;
     }
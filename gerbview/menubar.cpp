@@ -168,6 +168,27 @@ void GERBVIEW_FRAME::ReCreateMenuBar()
                  _( "Close GerbView" ),
                  KiBitmap( exit_xpm ) );
 
+    // Menu View:
+    wxMenu* viewMenu = new wxMenu;
+
+    viewMenu->Append(
+        new wxMenuItem( viewMenu, ID_MENU_CANVAS_LEGACY,
+                        _( "Legacy Canva&s" ),
+                        _( "Switch canvas implementation to Legacy" ),
+                        wxITEM_RADIO ) );
+
+    viewMenu->Append(
+        new wxMenuItem( viewMenu, ID_MENU_CANVAS_OPENGL,
+                        _( "Open&GL Canvas" ),
+                        _( "Switch canvas implementation to OpenGL" ),
+                        wxITEM_RADIO ) );
+
+    viewMenu->Append(
+        new wxMenuItem( viewMenu, ID_MENU_CANVAS_CAIRO,
+                        _( "&Cairo Canvas" ),
+                        _( "Switch canvas implementation to Cairo" ),
+                        wxITEM_RADIO ) );
+
     // Menu for configuration and preferences
     wxMenu* configMenu = new wxMenu;
 
@@ -272,6 +293,7 @@ void GERBVIEW_FRAME::ReCreateMenuBar()
 
     // Append menus to the menubar
     menuBar->Append( fileMenu, _( "&File" ) );
+    menuBar->Append( viewMenu, _( "&View" ) );
     menuBar->Append( configMenu, _( "&Preferences" ) );
     menuBar->Append( miscellaneousMenu, _( "&Miscellaneous" ) );
     menuBar->Append( helpMenu, _( "&Help" ) );
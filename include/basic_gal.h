@@ -162,6 +162,6 @@ private:
 };
 
 
-extern BASIC_GAL basic_gal;
+extern thread_local BASIC_GAL basic_gal;
 
 #endif      // define BASIC_GAL_H
@@ -79,6 +79,7 @@ private:
     GRIDS       m_grids;            ///< List of valid grid sizes.
     bool        m_FlagModified;     ///< Indicates current drawing has been modified.
     bool        m_FlagSave;         ///< Indicates automatic file save.
+    unsigned    m_modifyCount;      ///< Incremented each time the drawing is modified.
     EDA_ITEM*   m_CurrentItem;      ///< Currently selected object
     GRID_TYPE   m_Grid;             ///< Current grid selection.
     wxPoint     m_scrollCenter;     ///< Current scroll center point in logical units.
@@ -321,13 +322,21 @@ public:
         }
     }
 
-    void SetModify()        { m_FlagModified = true; }
+    void SetModify()        { m_FlagModified = true; ++m_modifyCount; }
     void ClrModify()        { m_FlagModified = false; }
     void SetSave()          { m_FlagSave = true; }
     void ClrSave()          { m_FlagSave = false; }
     bool IsModify() const   { return m_FlagModified; }
     bool IsSave() const     { return m_FlagSave; }
 
+    /**
+     * Function GetModifyCount
+     * @return the number of times SetModify() has been called, so that derived data
+     *         (caches, spatial indexes) can tell whether the drawing changed since it
+     *         was built, even when the modified flag was already set.
+     */
+    unsigned GetModifyCount() const { return m_modifyCount; }
+
 
     //----<zoom stuff>---------------------------------------------------------
 
@@ -95,6 +95,17 @@ struct WXSTRING_HASH : std::unary_function<wxString, std::size_t>
 };
 
 
+/// Hash function for wxPoint, used to find items by their exact coordinates
+struct WXPOINT_HASH : std::unary_function<wxPoint, std::size_t>
+{
+    std::size_t operator()( const wxPoint& aPoint ) const
+    {
+        std::size_t hash = std::hash<int>()( aPoint.x );
+        return hash * 31 + std::hash<int>()( aPoint.y );
+    }
+};
+
+
 class NETINFO_ITEM;
 
 
@@ -285,6 +285,9 @@ enum GERBVIEW_LAYER_ID: int
     GERBVIEW_LAYER_ID_END
 };
 
+/// Macro for obtaining the GAL layer of a GerbView draw layer
+#define GERBER_DRAW_LAYER( x ) ( GERBVIEW_LAYER_ID_START + ( x ) )
+
 /// Must update this if you add any enums after GerbView!
 #define LAYER_ID_COUNT GERBVIEW_LAYER_ID_END
 
@@ -32,6 +32,8 @@
 #ifndef PLOT_COMMON_H_
 #define PLOT_COMMON_H_
 
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include <math/box2.h>
 #include <drawtxt.h>
@@ -1179,18 +1181,65 @@ protected:
     // The last aperture attribute generated (only one aperture attribute can be set)
     int           m_apertureAttribute;
 
-    FILE* workFile;
-    FILE* finalFile;
-    wxString m_workFilename;
+    /**
+     * Append a text to the gerber file, built in memory until EndPlot()
+     */
+    void emitText( const char* aText );
+
+    /**
+     * Append a printf formatted text to the gerber file, built in memory
+     * until EndPlot(). Like standalone_fprintf, it always uses '.' as
+     * decimal separator
+     */
+    void emitFormatted( const char* aFormat, ... );
+
+    /**
+     * Start a new chunk in the gerber file buffer
+     */
+    void newFileChunk();
+
+    /// Size of the chunks of the gerber file buffer
+    static const size_t GERBER_FILE_CHUNK_SIZE = 1 << 20;
+
+    /// The gerber file, written by EndPlot(). The first chunk is the header,
+    /// the aperture list is inserted after it. The body is split in chunks
+    /// to avoid reallocating and copying it while it grows.
+    std::vector<std::string> m_fileChunks;
 
     /**
      * Generate the table of D codes
+     * @param aText = the string where the table is appended
      */
-    void writeApertureList();
+    void writeApertureList( std::string& aText );
+
+    /// Hash and comparison of the aperture fields used to find an existing
+    /// aperture (the D code is not used)
+    struct APERTURE_HASH
+    {
+        size_t operator()( const APERTURE& aAperture ) const
+        {
+            size_t hash = std::hash<int>()( aAperture.m_Size.x );
+            hash = hash * 31 + std::hash<int>()( aAperture.m_Size.y );
+            hash = hash * 31 + std::hash<int>()( aAperture.m_Type );
+            return hash * 31 + std::hash<int>()( aAperture.m_ApertureAttribute );
+        }
+    };
+
+    struct APERTURE_EQUAL
+    {
+        bool operator()( const APERTURE& aFirst, const APERTURE& aSecond ) const
+        {
+            return aFirst.m_Type == aSecond.m_Type && aFirst.m_Size == aSecond.m_Size
+                   && aFirst.m_ApertureAttribute == aSecond.m_ApertureAttribute;
+        }
+    };
 
     std::vector<APERTURE>           apertures;
     std::vector<APERTURE>::iterator currentAperture;
 
+    /// Index in apertures of each aperture, to find them without a linear search
+    std::unordered_map<APERTURE, size_t, APERTURE_HASH, APERTURE_EQUAL> m_apertureIndex;
+
     bool     m_gerberUnitInch;  // true if the gerber units are inches, false for mm
     int      m_gerberUnitFmt;   // number of digits in mantissa.
                                 // usually 6 in Inches and 5 or 6  in mm
@@ -128,6 +128,9 @@ KICAD_PLUGIN_EXPORT bool CanRender( void );
  * @return a SCENEGRAPH pointer to the display structure if the model
  * was successfully loaded and NULL if there is no rendering support
  * for the model or there were problems reading the model
+ *
+ * Load() may be called from several threads at once to read different
+ * models; the caller then sets the "C" numeric locale for the duration.
  */
 KICAD_PLUGIN_EXPORT SCENEGRAPH* Load( char const* aFileName );
 
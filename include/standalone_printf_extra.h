@@ -5,5 +5,6 @@
 #include <string>
 
 int standalone_stdstringprintf(std::string *s, const char *fmt, ...);
+int standalone_vstdstringprintf(std::string *s, const char *fmt, va_list ap);
 
 #endif
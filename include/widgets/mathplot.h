@@ -635,6 +635,16 @@ protected:
      */
     void UpdateViewBoundary( wxCoord xnew, wxCoord ynew );
 
+    /** Draws the locus as lines joining the consecutive points (continuous mode).
+     *  Called by Plot() with the clipping region set to the plot area.
+     *  @param startPx Left border of the plot area, in pixels
+     *  @param endPx Right border of the plot area, in pixels
+     *  @param minYpx Top border of the plot area, in pixels
+     *  @param maxYpx Bottom border of the plot area, in pixels
+     */
+    virtual void PlotContinuous( wxDC& dc, mpWindow& w, wxCoord startPx, wxCoord endPx,
+                                 wxCoord minYpx, wxCoord maxYpx );
+
     DECLARE_DYNAMIC_CLASS( mpFXY )
 };
 
@@ -1519,6 +1529,10 @@ protected:
 // mpFXYVector - provided by Jose Luis Blanco
 // -----------------------------------------------------------------------------
 
+/** Number of items of a level of the mpFXYVector multi-resolution cache summarized by
+ *  an item of the next level. */
+#define mpLOD_FACTOR 4
+
 /** A class providing graphs functionality for a 2D plot (either continuous or a set of points), from vectors of data.
  *  This class can be used directly, the user does not need to derive any new class. Simply pass the data as two vectors
  *  with the same length containing the X and Y coordinates to the method SetData.
@@ -1572,6 +1586,42 @@ protected:
      */
     double m_minX, m_maxX, m_minY, m_maxY;
 
+    /** True if m_xs is in ascending order, which is required to draw a decimated locus.
+     *  Loaded at SetData
+     */
+    bool m_sortedX;
+
+    /** A level of the multi-resolution cache: the Y extremes of consecutive blocks of
+     *  the level below (of m_ys for the first level), mpLOD_FACTOR items per block.
+     */
+    struct LEVEL
+    {
+        std::vector<double> m_min, m_max;
+    };
+
+    /** Multi-resolution cache of m_ys, each level being mpLOD_FACTOR times smaller than
+     *  the previous one. Loaded at SetData, if m_sortedX is true.
+     */
+    std::vector<LEVEL> m_levels;
+
+    /** Builds m_levels from m_ys.
+     */
+    void BuildLevels();
+
+    /** Returns the Y extremes of the points in the index range [first, last], reading
+     *  the largest blocks of m_levels that the range covers, instead of every point.
+     */
+    void GetRangeMinMax( size_t first, size_t last, double& minY, double& maxY ) const;
+
+    /** Draws the locus in continuous mode.
+     *  When the visible points outnumber the pixel columns, each column is drawn as a
+     *  vertical line between the extremes of its points, so the cost depends on the
+     *  plot width instead of the number of points.
+     *  Overridden in this implementation.
+     */
+    void PlotContinuous( wxDC& dc, mpWindow& w, wxCoord startPx, wxCoord endPx,
+                         wxCoord minYpx, wxCoord maxYpx ) override;
+
     /** Rewind value enumeration with mpFXY::GetNextXY.
      *  Overridden in this implementation.
      */
@@ -43,6 +43,11 @@
 #include <dialog_plot.h>
 #include <macros.h>
 #include <build_version.h>
+#include <sync_queue.h>
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
 
 
 const wxString GetGerberProtelExtension( LAYER_NUM aLayer )
@@ -456,31 +461,145 @@ bool PLOT_CONTROLLER::OpenPlotfile( const wxString &aSuffix,
 
     // Now compute the full filename for the output and start the plot
     // (after ensuring the output directory is OK)
+    if( buildPlotFileName( m_plotFile, GetLayer(), aSuffix ) )
+    {
+        m_plotter = StartPlotBoard( m_board, &GetPlotOptions(), ToLAYER_ID( GetLayer() ),
+                                    m_plotFile.GetFullPath(), aSheetDesc );
+    }
+
+    return( m_plotter != NULL );
+}
+
+
+bool PLOT_CONTROLLER::buildPlotFileName( wxFileName& aPlotFile, LAYER_NUM aLayer,
+                                         const wxString& aSuffix )
+{
     wxString outputDirName = GetPlotOptions().GetOutputDirectory() ;
     wxFileName outputDir = wxFileName::DirName( outputDirName );
     wxString boardFilename = m_board->GetFileName();
 
-    if( EnsureFileDirectoryExists( &outputDir, boardFilename ) )
+    if( !EnsureFileDirectoryExists( &outputDir, boardFilename ) )
+        return false;
+
+    // outputDir contains now the full path of plot files
+    aPlotFile = boardFilename;
+    aPlotFile.SetPath( outputDir.GetPath() );
+    wxString fileExt = GetDefaultPlotExtension( GetPlotOptions().GetFormat() );
+
+    // Gerber format can use specific file ext, depending on layers
+    // (now not a good practice, because the official file ext is .gbr)
+    if( GetPlotOptions().GetFormat() == PLOT_FORMAT_GERBER &&
+        GetPlotOptions().GetUseGerberProtelExtensions() )
+        fileExt = GetGerberProtelExtension( aLayer );
+
+    // Build plot filenames from the board name and layer names:
+    BuildPlotFileName( &aPlotFile, outputDir.GetPath(), aSuffix, fileExt );
+
+    return true;
+}
+
+
+void PLOT_CONTROLLER::AddLayerToBatch( LAYER_NUM aLayer, const wxString& aSuffix,
+                                       const wxString& aSheetDesc )
+{
+    BATCH_ITEM item;
+
+    item.m_Layer = aLayer;
+    item.m_Suffix = aSuffix;
+    item.m_SheetDesc = aSheetDesc;
+
+    m_batch.push_back( item );
+}
+
+
+bool PLOT_CONTROLLER::PlotLayers( PlotFormat aFormat )
+{
+    GetPlotOptions().SetFormat( aFormat );
+
+    ClosePlot();
+
+    // File names and output directory are handled here, the workers only
+    // create and write their own plot file
+    for( BATCH_ITEM& item : m_batch )
     {
-        // outputDir contains now the full path of plot files
-        m_plotFile = boardFilename;
-        m_plotFile.SetPath( outputDir.GetPath() );
-        wxString fileExt = GetDefaultPlotExtension( aFormat );
+        if( !buildPlotFileName( item.m_PlotFile, item.m_Layer, item.m_Suffix ) )
+            return false;
+    }
 
-        // Gerber format can use specific file ext, depending on layers
-        // (now not a good practice, because the official file ext is .gbr)
-        if( GetPlotOptions().GetFormat() == PLOT_FORMAT_GERBER &&
-            GetPlotOptions().GetUseGerberProtelExtensions() )
-            fileExt = GetGerberProtelExtension( GetLayer() );
+    // Like after a serial plot, the current plot file is the last one
+    if( !m_batch.empty() )
+        m_plotFile = m_batch.back().m_PlotFile;
 
-        // Build plot filenames from the board name and layer names:
-        BuildPlotFileName( &m_plotFile, outputDir.GetPath(), aSuffix, fileExt );
+    // The board and the plot options are only read by the workers
+    PCB_PLOT_PARAMS* plotOpts = &GetPlotOptions();
 
-        m_plotter = StartPlotBoard( m_board, &GetPlotOptions(), ToLAYER_ID( GetLayer() ),
-                                    m_plotFile.GetFullPath(), aSheetDesc );
+    SYNC_QUEUE<size_t> queue;
+
+    for( size_t ii = 0; ii < m_batch.size(); ++ii )
+        queue.push( ii );
+
+    std::vector<char> plotted( m_batch.size(), false );
+    std::mutex startLock;
+
+    auto plotJob = [&]()
+    {
+        size_t ii;
+
+        while( queue.pop( ii ) )
+        {
+            const BATCH_ITEM& item = m_batch[ii];
+            PLOTTER* plotter;
+
+            {
+                // Starting a plot draws the page layout, which uses
+                // global settings of the worksheet items
+                std::lock_guard<std::mutex> lock( startLock );
+
+                plotter = StartPlotBoard( m_board, plotOpts, ToLAYER_ID( item.m_Layer ),
+                                          item.m_PlotFile.GetFullPath(), item.m_SheetDesc );
+            }
+
+            if( !plotter )
+                continue;
+
+            PlotOneBoardLayer( m_board, plotter, ToLAYER_ID( item.m_Layer ), *plotOpts );
+
+            plotter->EndPlot();
+            delete plotter;
+
+            plotted[ii] = true;
+        }
+    };
+
+    size_t nthreads = std::min<size_t>( m_batch.size(), std::thread::hardware_concurrency() );
+
+    if( nthreads <= 1 )
+    {
+        plotJob();
     }
+    else
+    {
+        std::vector<std::thread> threads;
 
-    return( m_plotter != NULL );
+        for( size_t ii = 0; ii < nthreads; ++ii )
+            threads.push_back( std::thread( plotJob ) );
+
+        for( auto& thread : threads )
+            thread.join();
+    }
+
+    return std::count( plotted.begin(), plotted.end(), false ) == 0;
+}
+
+
+wxArrayString PLOT_CONTROLLER::GetBatchPlotFileNames() const
+{
+    wxArrayString names;
+
+    for( const BATCH_ITEM& item : m_batch )
+        names.Add( item.m_PlotFile.GetFullPath() );
+
+    return names;
 }
 
 
@@ -30,6 +30,7 @@
 #ifndef PLOTCONTROLLER_H_
 #define PLOTCONTROLLER_H_
 
+#include <vector>
 #include <pcb_plot_params.h>
 #include <layers_id_colors_and_visibility.h>
 
@@ -84,6 +85,36 @@ public:
      */
     bool PlotLayer();
 
+    /**
+     * Add a layer to the batch plotted by PlotLayers()
+     * @param aLayer is the layer to plot
+     * @param aSuffix is a string added to the base filename to identify
+     * the plot file, like in OpenPlotfile
+     * @param aSheetDesc is the sheet description, like in OpenPlotfile
+     */
+    void AddLayerToBatch( LAYER_NUM aLayer, const wxString& aSuffix,
+                          const wxString& aSheetDesc );
+
+    /** Remove all the layers added by AddLayerToBatch
+     */
+    void ClearBatch() { m_batch.clear(); }
+
+    /**
+     * Plot all the layers of the batch, each one on its own plot file.
+     * The layers are plotted concurrently, each one with its own plotter,
+     * and the files are the same as the ones created by a OpenPlotfile()
+     * and PlotLayer() sequence for each layer.
+     * The current plot, if any, is closed first.
+     * @param aFormat is the plot file format identifier
+     * @return true if all the plot files were created
+     */
+    bool PlotLayers( PlotFormat aFormat );
+
+    /**
+     * @return the full filenames of the batch plot files, set by PlotLayers
+     */
+    wxArrayString GetBatchPlotFileNames() const;
+
     /**
      * @return the current plot full filename, set by OpenPlotfile
      */
@@ -123,6 +154,24 @@ private:
 
     /// The current plot filename, set by OpenPlotfile
     wxFileName m_plotFile;
+
+    /// A layer plotted by PlotLayers, and its plot file
+    struct BATCH_ITEM
+    {
+        LAYER_NUM  m_Layer;
+        wxString   m_Suffix;
+        wxString   m_SheetDesc;
+        wxFileName m_PlotFile;
+    };
+
+    /// The layers to plot by PlotLayers
+    std::vector<BATCH_ITEM> m_batch;
+
+    /**
+     * Build the plot filename of a layer, and ensure the output directory exists
+     * @return false if the output directory cannot be created
+     */
+    bool buildPlotFileName( wxFileName& aPlotFile, LAYER_NUM aLayer, const wxString& aSuffix );
 };
 
 #endif
@@ -35,10 +35,17 @@
 #include <build_version.h>
 #include <class_board.h>
 #include <class_drawpanel.h>
+#include <common.h>
 #include <kicad_string.h>
 #include <io_mgr.h>
 #include <macros.h>
 #include <stdlib.h>
+#include <memory>
+#include <wx/filename.h>
+#include <wx/image.h>
+#include <3d_cache/3d_cache.h>
+#include <3d_canvas/cinfo3d_visu.h>
+#include <3d_rendering/3d_render_raytracing/c3d_render_raytracing.h>
 
 static PCB_EDIT_FRAME* PcbEditFrame = NULL;
 
@@ -93,6 +100,63 @@ bool SaveBoard( wxString& aFileName, BOARD* aBoard )
 }
 
 
+bool Render3DBoard( wxString& aFileName, BOARD* aBoard, int aWidth, int aHeight,
+                    double aRotX, double aRotY, double aRotZ, double aZoom )
+{
+    if( !aBoard || aWidth <= 0 || aHeight <= 0 || aZoom <= 0.0 )
+        return false;
+
+    CINFO3D_VISU settings;
+
+    settings.SetBoard( aBoard );
+    settings.RenderEngineSet( RENDER_ENGINE_RAYTRACING );
+    settings.SetFlag( FL_RENDER_RAYTRACING_SHADOWS, true );
+    settings.SetFlag( FL_RENDER_RAYTRACING_POST_PROCESSING, true );
+    settings.SetFlag( FL_RENDER_RAYTRACING_ANTI_ALIASING, true );
+
+    // Without a frame (standalone scripting), there is no project: use a cache of
+    // our own, that resolves the model paths relative to the board file
+    std::unique_ptr<S3D_CACHE> localCache;
+
+    if( PcbEditFrame )
+    {
+        settings.Set3DCacheManager( PcbEditFrame->Prj().Get3DCacheManager() );
+    }
+    else
+    {
+        localCache.reset( new S3D_CACHE );
+
+        wxFileName cfgpath;
+        cfgpath.AssignDir( GetKicadConfigPath() );
+        cfgpath.AppendDir( wxT( "3d" ) );
+        localCache->Set3DConfigDir( cfgpath.GetFullPath() );
+        localCache->SetProjectDir( wxFileName( aBoard->GetFileName() ).GetPath() );
+
+        settings.Set3DCacheManager( localCache.get() );
+    }
+
+    CCAMERA& camera = settings.CameraGet();
+
+    camera.SetCurWindowSize( wxSize( aWidth, aHeight ) );
+    camera.RotateX( glm::radians( (float) aRotX ) );
+    camera.RotateY( glm::radians( (float) aRotY ) );
+    camera.RotateZ( glm::radians( (float) aRotZ ) );
+    camera.Zoom( (float) aZoom );
+
+    C3D_RENDER_RAYTRACING render( settings );
+    wxImage image;
+
+    render.ReloadRequest();
+    render.RenderToImage( image, wxSize( aWidth, aHeight ) );
+
+    // The image handlers are added by PGM_BASE, which standalone scripting does not run
+    if( !wxImage::FindHandler( wxBITMAP_TYPE_PNG ) )
+        wxImage::AddHandler( new wxPNGHandler );
+
+    return image.SaveFile( aFileName, wxBITMAP_TYPE_PNG );
+}
+
+
 void Refresh()
 {
     // first argument is erase background, second is a wxRect
@@ -49,6 +49,14 @@ BOARD*  LoadBoard( wxString& aFileName );
 // so no option to choose the file format.
 bool    SaveBoard( wxString& aFileName, BOARD* aBoard );
 
+// Render the board with the 3D raytracing engine, without a display, and save
+// it as a PNG file. The default top view camera is rotated by the given angles
+// (in degrees) and zoomed by aZoom. When there is no PCB_EDIT_FRAME (standalone
+// scripting), the 3D model paths are resolved relative to the board file.
+bool    Render3DBoard( wxString& aFileName, BOARD* aBoard, int aWidth, int aHeight,
+                       double aRotX = 0.0, double aRotY = 0.0, double aRotZ = 0.0,
+                       double aZoom = 1.0 );
+
 void    Refresh();
 void    WindowZoom( int xl, int yl, int width, int height );
 
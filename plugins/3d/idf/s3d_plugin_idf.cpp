@@ -23,6 +23,8 @@
 
 // Note: the board's bottom side is at Z = 0
 
+#include <atomic>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <cmath>
@@ -74,15 +76,24 @@ static SCENEGRAPH* vrmlToSG( VRML_LAYER& vpcb, int idxColor, SGNODE* aParent, do
 
 class LOCALESWITCH
 {
+    bool m_switched;
+
 public:
     LOCALESWITCH()
     {
-        setlocale( LC_NUMERIC, "C" );
+        // The locale is global: when several models are loaded at once, the caller
+        // sets the "C" locale for all of them, and it must not be switched here.
+        const char* locale = setlocale( LC_NUMERIC, 0 );
+        m_switched = !locale || strcmp( locale, "C" ) != 0;
+
+        if( m_switched )
+            setlocale( LC_NUMERIC, "C" );
     }
 
     ~LOCALESWITCH()
     {
-        setlocale( LC_NUMERIC, "" );
+        if( m_switched )
+            setlocale( LC_NUMERIC, "" );
     }
 };
 
@@ -91,11 +102,12 @@ static SGNODE* getColor( IFSG_SHAPE& shape, int colorIdx )
 {
     IFSG_APPEARANCE material( shape );
 
-    static int cidx = 1;
+    // cycles from 1..NCOLORS; models can be loaded on several threads
+    static std::atomic<unsigned> cidx( 0 );
     int idx;
 
     if( colorIdx == -1 )
-        idx = cidx;
+        idx = cidx++ % NCOLORS + 1;
     else
         idx = colorIdx;
 
@@ -165,9 +177,6 @@ static SGNODE* getColor( IFSG_SHAPE& shape, int colorIdx )
         break;
     }
 
-    if( ( colorIdx == -1 ) && ( ++cidx > NCOLORS ) )
-        cidx = 1;
-
     return material.GetRawPtr();
 };
 
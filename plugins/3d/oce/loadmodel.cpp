@@ -27,6 +27,8 @@
 #include <string>
 #include <cstring>
 #include <map>
+#include <mutex>
+#include <atomic>
 #include <vector>
 #include <wx/string.h>
 #include <wx/wfstream.h>
@@ -390,8 +392,38 @@ void addItems( SGNODE* parent, std::vector< SGNODE* >* lp )
 }
 
 
+// Models are loaded on several threads.  Each load has its own reader and document, but
+// the application (which lists the documents) is shared: it is only used under this lock.
+static std::mutex s_appLock;
+
+
+// The translators register their static data when the first reader is created, and the
+// precision parameters are global: both are set once, before any file is read.
+static bool initTranslators()
+{
+    static std::once_flag initFlag;
+    static bool initOk = false;
+
+    std::call_once( initFlag, []()
+    {
+        STEPCAFControl_Reader stepReader;
+        IGESCAFControl_Reader igesReader;
+
+        // Enable user-defined shape precision, and set the shape conversion precision to
+        // USER_PREC (default 0.0001 has too many triangles)
+        initOk = Interface_Static::SetIVal( "read.precision.mode", 1 )
+                 && Interface_Static::SetRVal( "read.precision.val", USER_PREC );
+    } );
+
+    return initOk;
+}
+
+
 bool readIGES( Handle(TDocStd_Document)& m_doc, const char* fname )
 {
+    if( !initTranslators() )
+        return false;
+
     IGESCAFControl_Reader reader;
     IFSelect_ReturnStatus stat  = reader.ReadFile( fname );
     reader.PrintCheckLoad( Standard_False, IFSelect_ItemsByEntity );
@@ -399,14 +431,6 @@ bool readIGES( Handle(TDocStd_Document)& m_doc, const char* fname )
     if( stat != IFSelect_RetDone )
         return false;
 
-    // Enable user-defined shape precision
-    if( !Interface_Static::SetIVal( "read.precision.mode", 1 ) )
-        return false;
-
-    // Set the shape conversion precision to USER_PREC (default 0.0001 has too many triangles)
-    if( !Interface_Static::SetRVal( "read.precision.val", USER_PREC ) )
-        return false;
-
     // set other translation options
     reader.SetColorMode(true);  // use model colors
     reader.SetNameMode(false);  // don't use IGES label names
@@ -425,20 +449,15 @@ bool readIGES( Handle(TDocStd_Document)& m_doc, const char* fname )
 
 bool readSTEP( Handle(TDocStd_Document)& m_doc, const char* fname )
 {
+    if( !initTranslators() )
+        return false;
+
     STEPCAFControl_Reader reader;
     IFSelect_ReturnStatus stat  = reader.ReadFile( fname );
 
     if( stat != IFSelect_RetDone )
         return false;
 
-    // Enable user-defined shape precision
-    if( !Interface_Static::SetIVal( "read.precision.mode", 1 ) )
-        return false;
-
-    // Set the shape conversion precision to USER_PREC (default 0.0001 has too many triangles)
-    if( !Interface_Static::SetRVal( "read.precision.val", USER_PREC ) )
-        return false;
-
     // set other translation options
     reader.SetColorMode(true);  // use model colors
     reader.SetNameMode(false);  // don't use label names
@@ -446,6 +465,7 @@ bool readSTEP( Handle(TDocStd_Document)& m_doc, const char* fname )
 
     if ( !reader.Transfer( m_doc ) )
     {
+        std::lock_guard< std::mutex > lock( s_appLock );
         m_doc->Close();
         return false;
     }
@@ -462,8 +482,12 @@ SCENEGRAPH* LoadModel( char const* filename )
 {
     DATA data;
 
-    Handle(XCAFApp_Application) m_app = XCAFApp_Application::GetApplication();
-    m_app->NewDocument( "MDTV-XCAF", data.m_doc );
+    {
+        std::lock_guard< std::mutex > lock( s_appLock );
+        Handle(XCAFApp_Application) m_app = XCAFApp_Application::GetApplication();
+        m_app->NewDocument( "MDTV-XCAF", data.m_doc );
+    }
+
     FormatType modelFmt = fileType( filename );
 
     switch( modelFmt )
@@ -570,7 +594,7 @@ bool processSolid( const TopoDS_Shape& shape, DATA& data, SGNODE* parent,
 
     if( label.IsNull() )
     {
-        static int i = 0;
+        static std::atomic<int> i( 0 );
         std::ostringstream ostr;
         ostr << "KMISC_" << i++;
         partID = ostr.str();
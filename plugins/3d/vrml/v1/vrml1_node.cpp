@@ -24,6 +24,7 @@
 
 #include <set>
 #include <map>
+#include <mutex>
 #include <utility>
 #include <iterator>
 #include <cctype>
@@ -85,6 +86,7 @@ WRL1NODE* NAMEREGISTER::FindName( const std::string& aName )
 typedef std::pair< std::string, WRL1NODES > NODEITEM;
 typedef std::map< std::string, WRL1NODES > NODEMAP;
 static NODEMAP nodenames;
+static std::once_flag nodenamesInit;
 
 #if defined( DEBUG_VRML1 ) && ( DEBUG_VRML1 > 2 )
 std::string WRL1NODE::tabs = "";
@@ -97,7 +99,8 @@ WRL1NODE::WRL1NODE( NAMEREGISTER* aDictionary )
     m_Type = WRL1_END;
     m_dictionary = aDictionary;
 
-    if( nodenames.empty() )
+    // the name tables are shared by the models loaded on several threads
+    std::call_once( nodenamesInit, []()
     {
         nodenames.insert( NODEITEM( "AsciiText", WRL1_ASCIITEXT ) );
         nodenames.insert( NODEITEM( "Cone", WRL1_CONE ) );
@@ -134,7 +137,7 @@ WRL1NODE::WRL1NODE( NAMEREGISTER* aDictionary )
         nodenames.insert( NODEITEM( "Translation", WRL1_TRANSLATION ) );
         nodenames.insert( NODEITEM( "WWWAnchor", WRL1_WWWANCHOR ) );
         nodenames.insert( NODEITEM( "WWWInline", WRL1_WWWINLINE ) );
-    }
+    } );
 
     return;
 }
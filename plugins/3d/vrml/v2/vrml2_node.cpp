@@ -24,6 +24,7 @@
 
 #include <set>
 #include <map>
+#include <mutex>
 #include <utility>
 #include <iterator>
 #include <cctype>
@@ -36,10 +37,12 @@
 
 
 static std::set< std::string > badNames;
+static std::once_flag badNamesInit;
 
 typedef std::pair< std::string, WRL2NODES > NODEITEM;
 typedef std::map< std::string, WRL2NODES > NODEMAP;
 static NODEMAP nodenames;
+static std::once_flag nodenamesInit;
 
 
 WRL2NODE::WRL2NODE()
@@ -48,7 +51,8 @@ WRL2NODE::WRL2NODE()
     m_Parent = NULL;
     m_Type = WRL2_END;
 
-    if( badNames.empty() )
+    // the name tables are shared by the models loaded on several threads
+    std::call_once( badNamesInit, []()
     {
         badNames.insert( "DEF" );
         badNames.insert( "EXTERNPROTO" );
@@ -64,9 +68,9 @@ WRL2NODE::WRL2NODE()
         badNames.insert( "eventOut" );
         badNames.insert( "exposedField" );
         badNames.insert( "field" );
-    }
+    } );
 
-    if( nodenames.empty() )
+    std::call_once( nodenamesInit, []()
     {
         nodenames.insert( NODEITEM( "Anchor", WRL2_ANCHOR ) );
         nodenames.insert( NODEITEM( "Appearance", WRL2_APPEARANCE ) );
@@ -122,7 +126,7 @@ WRL2NODE::WRL2NODE()
         nodenames.insert( NODEITEM( "ViewPoint", WRL2_VIEWPOINT ) );
         nodenames.insert( NODEITEM( "VisibilitySensor", WRL2_VISIBILITYSENSOR ) );
         nodenames.insert( NODEITEM( "WorldInfo", WRL2_WORLDINFO ) );
-    }
+    } );
 
     return;
 }
@@ -32,6 +32,7 @@
  */
 
 #include <locale.h>
+#include <cstring>
 #include <wx/log.h>
 #include <wx/filename.h>
 #include "richio.h"
@@ -160,17 +161,27 @@ class LOCALESWITCH
 {
     // Store the user locale name, to restore this locale later, in dtor
     std::string m_locale;
+    bool m_switched;
 
 public:
     LOCALESWITCH()
     {
-        m_locale = setlocale( LC_NUMERIC, 0 );
-        setlocale( LC_NUMERIC, "C" );
+        // The locale is global: when several models are loaded at once, the caller
+        // sets the "C" locale for all of them, and it must not be switched here.
+        const char* locale = setlocale( LC_NUMERIC, 0 );
+        m_switched = !locale || strcmp( locale, "C" ) != 0;
+
+        if( m_switched )
+        {
+            m_locale = locale ? locale : "";
+            setlocale( LC_NUMERIC, "C" );
+        }
     }
 
     ~LOCALESWITCH()
     {
-        setlocale( LC_NUMERIC, m_locale.c_str() );
+        if( m_switched )
+            setlocale( LC_NUMERIC, m_locale.c_str() );
     }
 };
 
@@ -21,8 +21,11 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
  */
 
+#include <cfloat>
+#include <climits>
 #include <iostream>
 #include <sstream>
+#include <stdint.h>
 #include <wx/filename.h>
 #include <wx/string.h>
 #include <wx/log.h>
@@ -46,6 +49,201 @@
     } } while( 0 )
 
 
+// powers of 10 which are exactly represented by a double
+static const double s_pow10[] =
+{
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#define MAX_POW10 22
+
+// the characters which may follow a number in a VRML field
+static inline bool isNumberEnd( char aChar )
+{
+    return aChar <= 0x20 || ',' == aChar || '[' == aChar || ']' == aChar
+           || '{' == aChar || '}' == aChar;
+}
+
+
+// parseFloat reads a plain decimal float (sign, digits, fraction and exponent)
+// from a NUL terminated buffer and returns a pointer to the first character
+// after the number, or NULL if the text is not such a number or its value
+// is out of the range handled here; the caller then falls back to the
+// iostream parser which also produces the error messages.
+static const char* parseFloat( const char* aText, float& aValue )
+{
+    const char* cp = aText;
+    bool negative = false;
+
+    if( '-' == *cp || '+' == *cp )
+        negative = '-' == *cp++;
+
+    uint64_t mantissa = 0;
+    int nDigits = 0;            // significant digits in the mantissa
+    int exponent = 0;
+    bool hasDigits = false;
+
+    for( ; *cp >= '0' && *cp <= '9'; ++cp )
+    {
+        hasDigits = true;
+
+        if( nDigits < 19 )
+        {
+            mantissa = mantissa * 10 + ( *cp - '0' );
+
+            if( mantissa )
+                ++nDigits;
+        }
+        else
+        {
+            ++exponent;
+        }
+    }
+
+    if( '.' == *cp )
+    {
+        for( ++cp; *cp >= '0' && *cp <= '9'; ++cp )
+        {
+            hasDigits = true;
+
+            if( nDigits < 19 )
+            {
+                mantissa = mantissa * 10 + ( *cp - '0' );
+                --exponent;
+
+                if( mantissa )
+                    ++nDigits;
+            }
+        }
+    }
+
+    if( !hasDigits )
+        return NULL;
+
+    if( 'e' == *cp || 'E' == *cp )
+    {
+        ++cp;
+        bool negExp = false;
+
+        if( '-' == *cp || '+' == *cp )
+            negExp = '-' == *cp++;
+
+        if( *cp < '0' || *cp > '9' )
+            return NULL;
+
+        int exp = 0;
+
+        for( ; *cp >= '0' && *cp <= '9'; ++cp )
+        {
+            if( exp < 1000 )
+                exp = exp * 10 + ( *cp - '0' );
+        }
+
+        exponent += negExp ? -exp : exp;
+    }
+
+    if( !isNumberEnd( *cp ) )
+        return NULL;
+
+    double value = (double) mantissa;
+
+    if( mantissa )
+    {
+        if( exponent < -MAX_POW10 || exponent > MAX_POW10 )
+            return NULL;
+
+        if( exponent < 0 )
+            value /= s_pow10[-exponent];
+        else
+            value *= s_pow10[exponent];
+
+        if( value > FLT_MAX )
+            return NULL;
+    }
+
+    aValue = (float)( negative ? -value : value );
+    return cp;
+}
+
+
+// parseInt reads a decimal integer; hexadecimal values and values out of
+// the int range are left to the iostream parser
+static const char* parseInt( const char* aText, int& aValue )
+{
+    const char* cp = aText;
+    bool negative = false;
+
+    if( '-' == *cp || '+' == *cp )
+        negative = '-' == *cp++;
+
+    if( *cp < '0' || *cp > '9' )
+        return NULL;
+
+    int64_t value = 0;
+
+    for( ; *cp >= '0' && *cp <= '9'; ++cp )
+    {
+        value = value * 10 + ( *cp - '0' );
+
+        if( value > (int64_t) INT_MAX + 1 )
+            return NULL;
+    }
+
+    if( !isNumberEnd( *cp ) )
+        return NULL;
+
+    if( negative )
+        value = -value;
+
+    if( value > INT_MAX || value < INT_MIN )
+        return NULL;
+
+    aValue = (int) value;
+    return cp;
+}
+
+
+// skipSeparator skips the separators between two values of a MF field:
+// blank space and at most one comma
+static inline const char* skipSeparator( const char* aText )
+{
+    while( *aText && *aText <= 0x20 )
+        ++aText;
+
+    if( ',' == *aText )
+    {
+        ++aText;
+
+        while( *aText && *aText <= 0x20 )
+            ++aText;
+    }
+
+    return aText;
+}
+
+
+// parseFloatGroup reads aCount floats of a MF field in place, including the
+// comma which may follow each of them; NULL is returned if the group is not
+// complete on the current line or needs the generic parser
+static const char* parseFloatGroup( const char* aText, float* aValues, int aCount )
+{
+    for( int i = 0; i < aCount; ++i )
+    {
+        aText = parseFloat( skipSeparator( aText ), aValues[i] );
+
+        if( NULL == aText )
+            return NULL;
+
+        if( ',' == *aText )
+            ++aText;
+    }
+
+    return aText;
+}
+
+
+
 WRLPROC::WRLPROC( LINE_READER* aLineReader )
 {
     m_fileVersion = VRML_INVALID;
@@ -218,6 +416,113 @@ RETRY:
 }
 
 
+bool WRLPROC::fastReadFloat( float& aValue )
+{
+    const char* start = m_buf.c_str() + m_bufpos;
+    const char* end = parseFloat( start, aValue );
+
+    if( NULL == end )
+        return false;
+
+    m_bufpos += end - start;
+
+    // a trailing comma is consumed as in ReadGlob()
+    if( m_bufpos < m_buf.size() && ',' == m_buf[m_bufpos] )
+        ++m_bufpos;
+
+    return true;
+}
+
+
+bool WRLPROC::fastReadInt( int& aValue )
+{
+    const char* start = m_buf.c_str() + m_bufpos;
+    const char* end = parseInt( start, aValue );
+
+    if( NULL == end )
+        return false;
+
+    m_bufpos += end - start;
+
+    if( m_bufpos < m_buf.size() && ',' == m_buf[m_bufpos] )
+        ++m_bufpos;
+
+    return true;
+}
+
+
+void WRLPROC::readFloatRun( std::vector< float >& aMFFloat )
+{
+    const char* cp = m_buf.c_str() + m_bufpos;
+    const char* np;
+    float value;
+
+    while( NULL != ( np = parseFloatGroup( cp, &value, 1 ) ) )
+    {
+        aMFFloat.push_back( value );
+        cp = np;
+    }
+
+    m_bufpos = cp - m_buf.c_str();
+}
+
+
+void WRLPROC::readIntRun( std::vector< int >& aMFInt32 )
+{
+    const char* cp = m_buf.c_str() + m_bufpos;
+    const char* np;
+    int value;
+
+    while( NULL != ( np = parseInt( skipSeparator( cp ), value ) ) )
+    {
+        if( ',' == *np )
+            ++np;
+
+        aMFInt32.push_back( value );
+        cp = np;
+    }
+
+    m_bufpos = cp - m_buf.c_str();
+}
+
+
+void WRLPROC::readVec2fRun( std::vector< WRLVEC2F >& aMFVec2f )
+{
+    const char* cp = m_buf.c_str() + m_bufpos;
+    const char* np;
+    float value[2];
+
+    while( NULL != ( np = parseFloatGroup( cp, value, 2 ) ) )
+    {
+        aMFVec2f.push_back( WRLVEC2F( value[0], value[1] ) );
+        cp = np;
+    }
+
+    m_bufpos = cp - m_buf.c_str();
+}
+
+
+void WRLPROC::readVec3fRun( std::vector< WRLVEC3F >& aMFVec3f, bool aColor )
+{
+    const char* cp = m_buf.c_str() + m_bufpos;
+    const char* np;
+    float value[3];
+
+    while( NULL != ( np = parseFloatGroup( cp, value, 3 ) ) )
+    {
+        // invalid colors are left to ReadSFColor() which reports them
+        if( aColor && ( value[0] < 0.0 || value[0] > 1.0 || value[1] < 0.0
+            || value[1] > 1.0 || value[2] < 0.0 || value[2] > 1.0 ) )
+            break;
+
+        aMFVec3f.push_back( WRLVEC3F( value[0], value[1], value[2] ) );
+        cp = np;
+    }
+
+    m_bufpos = cp - m_buf.c_str();
+}
+
+
 WRLVERSION WRLPROC::GetVRMLType( void )
 {
     return m_fileVersion;
@@ -811,6 +1116,9 @@ bool WRLPROC::ReadSFFloat( float& aSFFloat )
             break;
     }
 
+    if( fastReadFloat( aSFFloat ) )
+        return true;
+
     std::string tmp;
 
     if( !ReadGlob( tmp ) )
@@ -871,6 +1179,9 @@ bool WRLPROC::ReadSFInt( int& aSFInt32 )
             break;
     }
 
+    if( fastReadInt( aSFInt32 ) )
+        return true;
+
     std::string tmp;
 
     if( !ReadGlob( tmp ) )
@@ -950,6 +1261,9 @@ bool WRLPROC::ReadSFRotation( WRLROTATION& aSFRotation )
 
     for( int i = 0; i < 4; ++i )
     {
+        if( EatSpace() && fastReadFloat( trot[i] ) )
+            continue;
+
         if( !ReadGlob( tmp ) )
         {
             std::ostringstream ostr;
@@ -1023,6 +1337,9 @@ bool WRLPROC::ReadSFVec2f( WRLVEC2F& aSFVec2f )
 
     for( int i = 0; i < 2; ++i )
     {
+        if( EatSpace() && fastReadFloat( tcol[i] ) )
+            continue;
+
         if( !ReadGlob( tmp ) )
         {
             std::ostringstream ostr;
@@ -1095,6 +1412,18 @@ bool WRLPROC::ReadSFVec3f( WRLVEC3F& aSFVec3f )
 
     for( int i = 0; i < 3; ++i )
     {
+        if( EatSpace() && fastReadFloat( tcol[i] ) )
+        {
+            // ignore any commas
+            if( !EatSpace() )
+                return false;
+
+            if( ',' == m_buf[m_bufpos] )
+                Pop();
+
+            continue;
+        }
+
         if( !ReadGlob( tmp ) )
         {
             std::ostringstream ostr;
@@ -1347,6 +1676,9 @@ bool WRLPROC::ReadMFColor( std::vector< WRLVEC3F >& aMFColor )
 
         aMFColor.push_back( lcolor );
 
+        // the values which follow on the current line are parsed in place
+        readVec3fRun( aMFColor, true );
+
         if( !EatSpace() )
         {
             std::ostringstream ostr;
@@ -1459,6 +1791,9 @@ bool WRLPROC::ReadMFFloat( std::vector< float >& aMFFloat )
 
         aMFFloat.push_back( temp );
 
+        // the values which follow on the current line are parsed in place
+        readFloatRun( aMFFloat );
+
         if( !EatSpace() )
         {
             std::ostringstream ostr;
@@ -1571,6 +1906,9 @@ bool WRLPROC::ReadMFInt( std::vector< int >& aMFInt32 )
 
         aMFInt32.push_back( temp );
 
+        // the values which follow on the current line are parsed in place
+        readIntRun( aMFInt32 );
+
         if( !EatSpace() )
         {
             std::ostringstream ostr;
@@ -1795,6 +2133,9 @@ bool WRLPROC::ReadMFVec2f( std::vector< WRLVEC2F >& aMFVec2f )
 
         aMFVec2f.push_back( lvec2f );
 
+        // the values which follow on the current line are parsed in place
+        readVec2fRun( aMFVec2f );
+
         if( !EatSpace() )
         {
             std::ostringstream ostr;
@@ -1907,6 +2248,9 @@ bool WRLPROC::ReadMFVec3f( std::vector< WRLVEC3F >& aMFVec3f )
 
         aMFVec3f.push_back( lvec3f );
 
+        // the values which follow on the current line are parsed in place
+        readVec3fRun( aMFVec3f, false );
+
         if( !EatSpace() )
         {
             std::ostringstream ostr;
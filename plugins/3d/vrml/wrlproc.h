@@ -58,6 +58,19 @@ private:
     // parameters are updated as appropriate.
     bool getRawLine( void );
 
+    // fastReadFloat and fastReadInt parse a plain decimal number in place at
+    // the current position. On failure nothing is consumed and the caller
+    // falls back to ReadGlob() and the iostream parser.
+    bool fastReadFloat( float& aValue );
+    bool fastReadInt( int& aValue );
+
+    // the run readers append to an array the values which follow on the
+    // current line, up to the first one which needs the generic readers
+    void readFloatRun( std::vector< float >& aMFFloat );
+    void readIntRun( std::vector< int >& aMFInt32 );
+    void readVec2fRun( std::vector< WRLVEC2F >& aMFVec2f );
+    void readVec3fRun( std::vector< WRLVEC3F >& aMFVec3f, bool aColor );
+
 public:
     WRLPROC( LINE_READER* aLineReader );
     ~WRLPROC();
@@ -428,6 +428,11 @@ bool KICAD_PLUGIN_LDR_3D::CanRender( void )
 
 SCENEGRAPH* KICAD_PLUGIN_LDR_3D::Load( char const* aFileName )
 {
+    // models may be loaded on several threads at once: once the plugin
+    // is open the loader state is only read on this path
+    if( ok && NULL != m_load )
+        return m_load( aFileName );
+
     m_error.clear();
 
     if( !ok && !reopen() )
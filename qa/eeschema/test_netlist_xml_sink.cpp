@@ -0,0 +1,207 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <netlist_exporter_generic.h>
+#include <richio.h>
+
+#include <wx/mstream.h>
+
+#include <algorithm>
+#include <functional>
+#include <string>
+
+/// Text with all the characters escaped in the text or in the attribute values.
+static const wxString SPECIAL = wxT( "a<b>c&d \"quoted\"\ttab\nline\r\ncrlf\rcr" );
+
+
+/**
+ * Sends \a aFeed to an XNODE_TREE_SINK and saves the tree as the netlist exporter
+ * did before, with wxXmlDocument::Save() and an indentation of 2.
+ */
+static std::string saveTree( const std::function<void( NETLIST_XML_SINK& )>& aFeed )
+{
+    XNODE_TREE_SINK sink;
+    aFeed( sink );
+
+    wxXmlDocument doc;
+    doc.SetRoot( sink.ReleaseRoot() );
+
+    wxMemoryOutputStream stream;
+    BOOST_REQUIRE( doc.Save( stream, 2 ) );
+
+    std::string bytes( stream.GetLength(), '\0' );
+
+    if( bytes.size() )
+        stream.CopyTo( &bytes[0], bytes.size() );
+
+    return bytes;
+}
+
+
+/**
+ * Sends \a aFeed to an XML_STREAM_SINK and returns the written text.
+ */
+static std::string streamXml( const std::function<void( NETLIST_XML_SINK& )>& aFeed )
+{
+    STRING_FORMATTER formatter;
+    XML_STREAM_SINK sink( &formatter );
+
+    aFeed( sink );
+    sink.Flush();
+
+    return formatter.GetString();
+}
+
+
+/**
+ * Checks that both sinks give the same bytes for \a aFeed, and reports the first
+ * difference.
+ */
+static void checkSameBytes( const std::function<void( NETLIST_XML_SINK& )>& aFeed )
+{
+    const std::string expected = saveTree( aFeed );
+    const std::string result = streamXml( aFeed );
+
+    size_t common = std::min( result.size(), expected.size() );
+    size_t offset = std::mismatch( result.begin(), result.begin() + common,
+                                   expected.begin() ).first - result.begin();
+
+    BOOST_CHECK_MESSAGE( result == expected,
+                         "first difference at byte " << offset << " of " << expected.size()
+                         << ": \"" << result.substr( offset, 40 ) << "\" instead of \""
+                         << expected.substr( offset, 40 ) << "\"" );
+}
+
+
+BOOST_AUTO_TEST_SUITE( NetlistXmlSink )
+
+/**
+ * Checks the escaping of the text and of the attribute values.
+ */
+BOOST_AUTO_TEST_CASE( Escaping )
+{
+    checkSameBytes( []( NETLIST_XML_SINK& aSink ) {
+        aSink.StartElement( wxT( "export" ) );
+        aSink.AddAttribute( wxT( "version" ), wxT( "D" ) );
+
+        aSink.Element( wxT( "text" ), SPECIAL );
+
+        aSink.StartElement( wxT( "attribute" ) );
+        aSink.AddAttribute( wxT( "value" ), SPECIAL );
+        aSink.EndElement();
+
+        aSink.StartElement( wxT( "both" ) );
+        aSink.AddAttribute( wxT( "name" ), SPECIAL );
+        aSink.AddText( SPECIAL );
+        aSink.EndElement();
+
+        // Multibyte UTF8 characters are written as they are
+        aSink.Element( wxT( "value" ), wxString::FromUTF8( "4.7\xc2\xb5" "F 10\xce\xa9" ) );
+
+        aSink.EndElement();
+    } );
+}
+
+/**
+ * Checks the indentation of nested, empty and mixed content elements.
+ */
+BOOST_AUTO_TEST_CASE( Layout )
+{
+    checkSameBytes( []( NETLIST_XML_SINK& aSink ) {
+        aSink.StartElement( wxT( "export" ) );
+
+        // Empty elements, with and without attributes, and an empty text which is ignored
+        aSink.Element( wxT( "empty" ) );
+
+        aSink.StartElement( wxT( "comp" ) );
+        aSink.AddAttribute( wxT( "ref" ), wxT( "R1" ) );
+        aSink.AddAttribute( wxT( "part" ), wxT( "" ) );
+        aSink.EndElement();
+
+        // Nested elements
+        aSink.StartElement( wxT( "design" ) );
+        aSink.StartElement( wxT( "sheet" ) );
+        aSink.AddAttribute( wxT( "number" ), wxT( "1" ) );
+        aSink.StartElement( wxT( "title_block" ) );
+        aSink.Element( wxT( "title" ), wxT( "Title" ) );
+        aSink.Element( wxT( "company" ) );
+        aSink.EndElement();
+        aSink.EndElement();
+        aSink.EndElement();
+
+        // Text before and after a child element
+        aSink.StartElement( wxT( "mixed" ) );
+        aSink.AddText( wxT( "before" ) );
+        aSink.Element( wxT( "child" ), wxT( "inner" ) );
+        aSink.AddText( wxT( "after" ) );
+        aSink.EndElement();
+
+        aSink.StartElement( wxT( "mixed" ) );
+        aSink.Element( wxT( "child" ) );
+        aSink.AddText( SPECIAL );
+        aSink.EndElement();
+
+        aSink.EndElement();
+    } );
+
+    // A root element alone
+    checkSameBytes( []( NETLIST_XML_SINK& aSink ) {
+        aSink.Element( wxT( "export" ) );
+    } );
+}
+
+/**
+ * Checks a document larger than the buffer of XML_STREAM_SINK, which is written to
+ * the formatter in several parts.
+ */
+BOOST_AUTO_TEST_CASE( LargeDocument )
+{
+    checkSameBytes( []( NETLIST_XML_SINK& aSink ) {
+        aSink.StartElement( wxT( "export" ) );
+        aSink.StartElement( wxT( "nets" ) );
+
+        for( int net = 0; net < 2000; ++net )
+        {
+            aSink.StartElement( wxT( "net" ) );
+            aSink.AddAttribute( wxT( "code" ), wxString::Format( wxT( "%d" ), net + 1 ) );
+            aSink.AddAttribute( wxT( "name" ), wxString::Format( wxT( "/N<%d>" ), net ) );
+
+            for( int node = 0; node < 3; ++node )
+            {
+                aSink.StartElement( wxT( "node" ) );
+                aSink.AddAttribute( wxT( "ref" ), wxString::Format( wxT( "U%d" ), net ) );
+                aSink.AddAttribute( wxT( "pin" ), wxString::Format( wxT( "%d" ), node + 1 ) );
+                aSink.EndElement();
+            }
+
+            aSink.EndElement();
+        }
+
+        aSink.EndElement();
+        aSink.EndElement();
+    } );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,515 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <class_libentry.h>
+#include <lib_id.h>
+#include <sch_component.h>
+#include <sch_reference_list.h>
+#include <sch_sheet_path.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+/**
+ * A reference to annotate, in the state left by SCH_REFERENCE::Split(): the prefix
+ * without number, and a number of -1 and a new flag for the references to annotate.
+ */
+struct TEST_REF
+{
+    std::string prefix;
+    std::string value;
+    std::string libName;
+    int         unitCount;
+    bool        unitsLocked;
+    int         sheetNum;
+    int         numRef;
+    int         unit;
+    bool        isNew;
+    int         flag;
+};
+
+/// The locked units, by group name: the index of each reference in the list and its unit.
+typedef std::map< std::string, std::vector< std::pair<size_t, int> > > LOCKED_UNITS;
+
+
+static TEST_REF makeRef( const std::string& aPrefix, int aNumRef, int aUnit,
+                         const std::string& aValue, const std::string& aLibName,
+                         int aUnitCount, bool aUnitsLocked, int aSheetNum )
+{
+    TEST_REF ref;
+
+    ref.prefix      = aPrefix;
+    ref.value       = aValue;
+    ref.libName     = aLibName;
+    ref.unitCount   = aUnitCount;
+    ref.unitsLocked = aUnitsLocked;
+    ref.sheetNum    = aSheetNum;
+    ref.numRef      = aNumRef;
+    ref.isNew       = aNumRef < 0;
+    ref.flag        = 0;
+
+    // As in SCH_REFERENCE::Split(), the unit of a new reference is only kept when
+    // the units are locked.
+    ref.unit = ( ref.isNew && !aUnitsLocked ) ? 0x7FFFFFFF : aUnit;
+
+    return ref;
+}
+
+
+static std::string describe( const TEST_REF& aRef )
+{
+    std::string ref = aRef.prefix;
+
+    ref += aRef.numRef < 0 ? std::string( "?" ) : std::to_string( aRef.numRef );
+
+    return ref + " unit " + std::to_string( aRef.unit );
+}
+
+
+/**
+ * The previous SCH_REFERENCE_LIST::GetRefsInUse().
+ */
+static std::vector<int> referenceRefsInUse( const std::vector<TEST_REF>& aRefs, size_t aIndex,
+                                            int aMinRefId )
+{
+    std::vector<int> idList;
+
+    for( const TEST_REF& ref : aRefs )
+    {
+        if( ref.prefix == aRefs[aIndex].prefix && ref.numRef >= aMinRefId )
+            idList.push_back( ref.numRef );
+    }
+
+    std::sort( idList.begin(), idList.end() );
+    idList.erase( std::unique( idList.begin(), idList.end() ), idList.end() );
+
+    return idList;
+}
+
+
+/**
+ * The previous SCH_REFERENCE_LIST::CreateFirstFreeRefId().
+ */
+static int referenceFirstFreeRefId( std::vector<int>& aIdList, int aFirstValue )
+{
+    int expectedId = aFirstValue;
+    size_t ii = 0;
+
+    while( ii < aIdList.size() && expectedId > aIdList[ii] )
+        ii++;
+
+    for( ; ii < aIdList.size(); ii++ )
+    {
+        if( expectedId != aIdList[ii] )
+        {
+            aIdList.insert( aIdList.begin() + ii, expectedId );
+            return expectedId;
+        }
+
+        expectedId++;
+    }
+
+    aIdList.push_back( expectedId );
+    return expectedId;
+}
+
+
+/**
+ * The previous SCH_REFERENCE_LIST::FindUnit().
+ */
+static bool referenceHasUnit( const std::vector<TEST_REF>& aRefs, size_t aIndex, int aUnit )
+{
+    for( size_t ii = 0; ii < aRefs.size(); ii++ )
+    {
+        if( ii == aIndex || aRefs[ii].isNew || aRefs[ii].numRef != aRefs[aIndex].numRef
+          || aRefs[ii].prefix != aRefs[aIndex].prefix )
+            continue;
+
+        if( aRefs[ii].unit == aUnit )
+            return true;
+    }
+
+    return false;
+}
+
+
+/**
+ * The previous SCH_REFERENCE_LIST::Annotate(), which searched the whole list for the
+ * numbers in use, the units and the locked units of each reference.
+ */
+static void referenceAnnotate( std::vector<TEST_REF>& aRefs, bool aUseSheetNum,
+                               int aSheetIntervalId, const LOCKED_UNITS& aLockedUnits )
+{
+    if( aRefs.empty() )
+        return;
+
+    for( TEST_REF& ref : aRefs )
+    {
+        if( ref.prefix[0] == '#' )
+        {
+            ref.isNew  = true;
+            ref.numRef = 0;
+        }
+    }
+
+    size_t first = 0;
+    int minRefId = aUseSheetNum ? aRefs[first].sheetNum * aSheetIntervalId + 1 : 1;
+    std::vector<int> idList = referenceRefsInUse( aRefs, first, minRefId );
+
+    for( size_t ii = 0; ii < aRefs.size(); ii++ )
+    {
+        if( aRefs[ii].flag )
+            continue;
+
+        const std::vector< std::pair<size_t, int> >* lockedList = NULL;
+
+        for( const auto& group : aLockedUnits )
+        {
+            for( const auto& locked : group.second )
+            {
+                if( locked.first == ii )
+                {
+                    lockedList = &group.second;
+                    break;
+                }
+            }
+
+            if( lockedList )
+                break;
+        }
+
+        if( aRefs[first].prefix != aRefs[ii].prefix
+          || ( aUseSheetNum && aRefs[first].sheetNum != aRefs[ii].sheetNum ) )
+        {
+            first = ii;
+            minRefId = aUseSheetNum ? aRefs[ii].sheetNum * aSheetIntervalId + 1 : 1;
+            idList = referenceRefsInUse( aRefs, first, minRefId );
+        }
+
+        TEST_REF& ref = aRefs[ii];
+
+        if( ref.unitCount <= 1 )
+        {
+            if( ref.isNew )
+                ref.numRef = referenceFirstFreeRefId( idList, minRefId );
+
+            ref.unit  = 1;
+            ref.flag  = 1;
+            ref.isNew = false;
+            continue;
+        }
+
+        if( ref.isNew )
+        {
+            ref.numRef = referenceFirstFreeRefId( idList, minRefId );
+
+            if( !ref.unitsLocked )
+                ref.unit = 1;
+
+            ref.flag = 1;
+        }
+
+        if( lockedList )
+        {
+            for( const auto& locked : *lockedList )
+            {
+                if( locked.first == ii )
+                    ref.unit = locked.second;
+
+                const TEST_REF& lockedRef = aRefs[locked.first];
+
+                if( lockedRef.value != ref.value || lockedRef.libName != ref.libName )
+                    continue;
+
+                if( locked.first > ii )
+                {
+                    aRefs[locked.first].numRef = ref.numRef;
+                    aRefs[locked.first].unit   = locked.second;
+                    aRefs[locked.first].isNew  = false;
+                    aRefs[locked.first].flag   = 1;
+                }
+            }
+        }
+        else
+        {
+            for( int unit = 1; unit <= ref.unitCount; unit++ )
+            {
+                if( ref.unit == unit || referenceHasUnit( aRefs, ii, unit ) )
+                    continue;
+
+                for( size_t jj = ii + 1; jj < aRefs.size(); jj++ )
+                {
+                    TEST_REF& other = aRefs[jj];
+
+                    if( other.flag || other.prefix != ref.prefix || other.value != ref.value
+                      || other.libName != ref.libName || !other.isNew )
+                        continue;
+
+                    if( !other.unitsLocked || other.unit == unit )
+                    {
+                        other.numRef = ref.numRef;
+                        other.unit   = unit;
+                        other.flag   = 1;
+                        other.isNew  = false;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+/**
+ * Annotates the references with SCH_REFERENCE_LIST::Annotate(), through one component
+ * per reference, and returns the references and units of the components.
+ */
+static std::vector<std::string> annotate( const std::vector<TEST_REF>& aRefs, bool aUseSheetNum,
+                                          int aSheetIntervalId, const LOCKED_UNITS& aLockedUnits )
+{
+    std::vector< std::unique_ptr<LIB_PART> > parts;
+    std::vector< std::unique_ptr<SCH_COMPONENT> > components;
+    SCH_SHEET_PATH sheetPath;
+    SCH_REFERENCE_LIST list;
+
+    for( size_t ii = 0; ii < aRefs.size(); ii++ )
+    {
+        const TEST_REF& ref = aRefs[ii];
+        LIB_PART* part = new LIB_PART( wxString::FromUTF8( ref.libName.c_str() ) );
+        SCH_COMPONENT* component = new SCH_COMPONENT();
+
+        part->SetUnitCount( ref.unitCount );
+        part->LockUnits( ref.unitsLocked );
+        parts.emplace_back( part );
+        components.emplace_back( component );
+
+        std::string text = ref.prefix;
+
+        if( !ref.isNew )
+            text += std::to_string( ref.numRef );
+
+        component->SetTimeStamp( ii + 1 );
+        component->SetLibId( LIB_ID( wxString::FromUTF8( ref.libName.c_str() ) ) );
+        component->GetField( VALUE )->SetText( wxString::FromUTF8( ref.value.c_str() ) );
+        component->SetRef( &sheetPath, wxString::FromUTF8( text.c_str() ) );
+        component->SetUnitSelection( &sheetPath, ref.unit == 0x7FFFFFFF ? 1 : ref.unit );
+
+        SCH_REFERENCE schRef( component, part, sheetPath );
+        schRef.SetSheetNumber( ref.sheetNum );
+        list.AddItem( schRef );
+    }
+
+    list.SplitReferences();
+
+    SCH_MULTI_UNIT_REFERENCE_MAP lockedUnitMap;
+
+    for( const auto& group : aLockedUnits )
+    {
+        wxString name = wxString::FromUTF8( group.first.c_str() );
+        SCH_REFERENCE_LIST& lockedList = lockedUnitMap[ name ];
+
+        for( const auto& locked : group.second )
+        {
+            SCH_COMPONENT* component = components[locked.first].get();
+
+            // The unit of a locked reference is the unit selection of the component
+            component->SetUnitSelection( &sheetPath, locked.second );
+
+            SCH_REFERENCE lockedRef( component, parts[locked.first].get(), sheetPath );
+            lockedList.AddItem( lockedRef );
+        }
+    }
+
+    list.Annotate( aUseSheetNum, aSheetIntervalId, lockedUnitMap );
+    list.UpdateAnnotation();
+
+    std::vector<std::string> result;
+
+    for( const auto& component : components )
+    {
+        result.push_back( std::string( component->GetRef( &sheetPath ).ToUTF8() ) + " unit "
+                          + std::to_string( component->GetUnitSelection( &sheetPath ) ) );
+    }
+
+    return result;
+}
+
+
+static std::vector<std::string> describe( const std::vector<TEST_REF>& aRefs )
+{
+    std::vector<std::string> desc;
+
+    for( const TEST_REF& ref : aRefs )
+        desc.push_back( describe( ref ) );
+
+    return desc;
+}
+
+
+BOOST_AUTO_TEST_SUITE( SchematicAnnotate )
+
+/**
+ * Checks the annotation of new references with the sheet numbers, of the units of
+ * multi-unit parts and of locked units.
+ */
+BOOST_AUTO_TEST_CASE( FixedReferences )
+{
+    const std::vector<TEST_REF> refs = {
+        makeRef( "#PWR", 7, 1, "GND", "GND", 1, false, 1 ),
+        makeRef( "R", -1, 1, "10k", "R", 1, false, 1 ),
+        makeRef( "R", 102, 1, "10k", "R", 1, false, 1 ),
+        makeRef( "R", -1, 1, "10k", "R", 1, false, 1 ),
+        makeRef( "R", -1, 1, "1k", "R", 1, false, 2 ),
+        makeRef( "U", -1, 1, "TL072", "OPAMP", 2, false, 1 ),
+        makeRef( "U", -1, 1, "TL072", "OPAMP", 2, false, 1 ),
+        makeRef( "U", -1, 1, "TL072", "OPAMP", 2, false, 1 ),
+        makeRef( "U", 101, 1, "LM324", "QUAD", 4, false, 1 ),
+        makeRef( "U", -1, 1, "LM324", "QUAD", 4, false, 1 ),
+        makeRef( "U", -1, 2, "RELAY", "LOCK2", 2, true, 2 ),
+        makeRef( "U", -1, 1, "RELAY", "LOCK2", 2, true, 2 ),
+    };
+
+    // The two units of the relay are kept together, with their units swapped
+    const LOCKED_UNITS locked = { { "K", { { 10, 1 }, { 11, 2 } } } };
+
+    const std::vector<std::string> expected = {
+        "#PWR101 unit 1",
+        "R101 unit 1",
+        "R102 unit 1",
+        "R103 unit 1",
+        "R201 unit 1",
+        "U102 unit 1",
+        "U102 unit 2",
+        "U103 unit 1",
+        "U101 unit 1",
+        "U101 unit 2",
+        "U201 unit 1",
+        "U201 unit 2",
+    };
+
+    std::vector<TEST_REF> reference = refs;
+    referenceAnnotate( reference, true, 100, locked );
+
+    const std::vector<std::string> refResult = describe( reference );
+
+    BOOST_CHECK_EQUAL_COLLECTIONS( refResult.begin(), refResult.end(),
+                                   expected.begin(), expected.end() );
+
+    const std::vector<std::string> result = annotate( refs, true, 100, locked );
+
+    BOOST_CHECK_EQUAL_COLLECTIONS( result.begin(), result.end(),
+                                   expected.begin(), expected.end() );
+}
+
+/**
+ * Checks that random lists of references are annotated as by the previous algorithm,
+ * with and without the sheet numbers, and with and without locked units.
+ */
+BOOST_AUTO_TEST_CASE( SameAsReference )
+{
+    struct PART_DEF
+    {
+        const char* libName;
+        int         unitCount;
+        bool        unitsLocked;
+    };
+
+    const PART_DEF partDefs[] = {
+        { "R", 1, false }, { "OPAMP", 2, false }, { "QUAD", 4, false },
+        { "LOCK3", 3, true }, { "LOCK2", 2, true }
+    };
+    const char* values[] = { "10k", "1k", "TL072" };
+    const char* prefixes[] = { "R", "U", "#PWR", "IC" };
+
+    std::mt19937 rng( 7 );
+
+    for( int pass = 0; pass < 50; ++pass )
+    {
+        int count = 1 + rng() % 40;
+        std::vector<TEST_REF> refs;
+
+        for( int ii = 0; ii < count; ++ii )
+        {
+            const PART_DEF& def = partDefs[ rng() % 5 ];
+            const char* prefix = prefixes[ rng() % 4 ];
+            const char* value = values[ rng() % 3 ];
+            int sheetNum = 1 + rng() % 3;
+            int unit = 1 + rng() % def.unitCount;
+            int numRef = -1;
+
+            // Annotated references, in the range of the sheet numbers or not
+            if( rng() % 2 )
+                numRef = ( rng() % 4 == 0 ) ? 100 + rng() % 20 : 1 + rng() % 12;
+
+            refs.push_back( makeRef( prefix, numRef, unit, value, def.libName, def.unitCount,
+                                     def.unitsLocked, sheetNum ) );
+        }
+
+        // Annotate() expects the references grouped by prefix, then by sheet
+        std::stable_sort( refs.begin(), refs.end(),
+                          []( const TEST_REF& a, const TEST_REF& b ) {
+                              if( a.prefix != b.prefix )
+                                  return a.prefix < b.prefix;
+
+                              return a.sheetNum < b.sheetNum;
+                          } );
+
+        LOCKED_UNITS locked;
+
+        if( pass % 2 )
+        {
+            for( int group = 0; group < 4; ++group )
+            {
+                std::vector< std::pair<size_t, int> > units;
+                int unitCount = 1 + rng() % 3;
+
+                for( int ii = 0; ii < unitCount; ++ii )
+                    units.push_back( std::make_pair( rng() % count, 1 + rng() % 4 ) );
+
+                locked[ "L" + std::to_string( rng() % 3 ) ] = units;
+            }
+        }
+
+        for( int useSheetNum = 0; useSheetNum < 2; ++useSheetNum )
+        {
+            std::vector<TEST_REF> reference = refs;
+            referenceAnnotate( reference, useSheetNum, 100, locked );
+
+            const std::vector<std::string> expected = describe( reference );
+            const std::vector<std::string> result = annotate( refs, useSheetNum, 100, locked );
+
+            BOOST_CHECK_EQUAL_COLLECTIONS( result.begin(), result.end(),
+                                           expected.begin(), expected.end() );
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,276 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <class_sch_screen.h>
+#include <sch_junction.h>
+#include <sch_line.h>
+
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+static SCH_LINE* addLine( SCH_SCREEN& aScreen, int aX1, int aY1, int aX2, int aY2,
+                          int aLayer = LAYER_WIRE )
+{
+    SCH_LINE* line = new SCH_LINE( wxPoint( aX1, aY1 ), aLayer );
+    line->SetEndPoint( wxPoint( aX2, aY2 ) );
+    aScreen.Append( line );
+
+    return line;
+}
+
+
+static SCH_JUNCTION* addJunction( SCH_SCREEN& aScreen, int aX, int aY )
+{
+    SCH_JUNCTION* junction = new SCH_JUNCTION( wxPoint( aX, aY ) );
+    aScreen.Append( junction );
+
+    return junction;
+}
+
+
+/**
+ * Describes the draw list of a screen, one line per item. The ends of a line are
+ * sorted, as the direction of a line is not significant.
+ */
+static std::vector<std::string> describe( const SCH_SCREEN& aScreen )
+{
+    std::vector<std::string> desc;
+
+    for( SCH_ITEM* item = aScreen.GetDrawItems(); item; item = item->Next() )
+    {
+        std::ostringstream out;
+
+        if( item->Type() == SCH_LINE_T )
+        {
+            SCH_LINE* line = (SCH_LINE*) item;
+            wxPoint start = line->GetStartPoint();
+            wxPoint end = line->GetEndPoint();
+
+            if( end.x < start.x || ( end.x == start.x && end.y < start.y ) )
+                std::swap( start, end );
+
+            out << ( line->GetLayer() == LAYER_BUS ? "bus " : "wire " )
+                << start.x << "," << start.y << " " << end.x << "," << end.y;
+        }
+        else if( item->Type() == SCH_JUNCTION_T )
+        {
+            out << "junction " << item->GetPosition().x << "," << item->GetPosition().y;
+        }
+
+        desc.push_back( out.str() );
+    }
+
+    return desc;
+}
+
+
+/**
+ * The previous SCH_SCREEN::SchematicCleanUp(), which compared each item to all the
+ * next ones and started again from the beginning of the list after each change.
+ */
+static bool referenceCleanUp( SCH_SCREEN& aScreen )
+{
+    bool modified = false;
+
+    for( SCH_ITEM* item = aScreen.GetDrawItems(); item; item = item->Next() )
+    {
+        if( ( item->Type() != SCH_LINE_T ) && ( item->Type() != SCH_JUNCTION_T ) )
+            continue;
+
+        bool restart;
+
+        for( SCH_ITEM* testItem = item->Next(); testItem;
+             testItem = restart ? aScreen.GetDrawItems() : testItem->Next() )
+        {
+            restart = false;
+
+            if( ( item->Type() == SCH_LINE_T ) && ( testItem->Type() == SCH_LINE_T ) )
+            {
+                if( ( (SCH_LINE*) item )->MergeOverlap( (SCH_LINE*) testItem ) )
+                {
+                    item->SetFlags( testItem->GetFlags() );
+                    aScreen.DeleteItem( testItem );
+                    restart = true;
+                    modified = true;
+                }
+            }
+            else if( ( item->Type() == SCH_JUNCTION_T )
+                     && ( testItem->Type() == SCH_JUNCTION_T ) && ( testItem != item ) )
+            {
+                if( testItem->HitTest( item->GetPosition() ) )
+                {
+                    item->SetFlags( testItem->GetFlags() );
+                    aScreen.DeleteItem( testItem );
+                    restart = true;
+                    modified = true;
+                }
+            }
+        }
+    }
+
+    return modified;
+}
+
+
+BOOST_AUTO_TEST_SUITE( SchematicCleanUp )
+
+/**
+ * Checks the draw list after the clean up of collinear, overlapping, diagonal and
+ * duplicate lines, and of duplicate junctions.
+ */
+BOOST_AUTO_TEST_CASE( FixedItems )
+{
+    SCH_SCREEN screen( NULL );
+
+    // Collinear wires with a common end, the flags of the deleted one are kept
+    SCH_LINE* merged = addLine( screen, 0, 0, 100, 0 );
+    addLine( screen, 100, 0, 200, 0 )->SetFlags( SELECTED );
+
+    // Overlapping wires
+    addLine( screen, 300, 0, 300, 200 );
+    addLine( screen, 300, 0, 300, 100 );
+
+    // Collinear diagonal wires, then diagonal and horizontal wires which are not merged
+    addLine( screen, 0, 300, 100, 400 );
+    addLine( screen, 100, 400, 200, 500 );
+    addLine( screen, 500, 0, 600, 100 );
+    addLine( screen, 600, 100, 700, 100 );
+
+    // The same wire, drawn in both directions
+    addLine( screen, 0, 600, 100, 600 );
+    addLine( screen, 100, 600, 0, 600 );
+
+    // A bus and a wire are never merged
+    addLine( screen, 1000, 0, 1100, 0, LAYER_BUS );
+    addLine( screen, 1100, 0, 1200, 0 );
+
+    // A chain of three wires: the first one is extended twice
+    addLine( screen, 0, 800, 100, 800 );
+    addLine( screen, 200, 800, 300, 800 );
+    addLine( screen, 100, 800, 200, 800 );
+
+    // Collinear wires without a common end
+    addLine( screen, 0, 1000, 100, 1000 );
+    addLine( screen, 200, 1000, 300, 1000 );
+
+    // Duplicate junctions, at the same position and covering the position of the first one
+    addJunction( screen, 100, 0 );
+    addJunction( screen, 100, 0 );
+    addJunction( screen, 110, 0 );
+    addJunction( screen, 2000, 2000 );
+
+    BOOST_CHECK( screen.SchematicCleanUp() );
+
+    const std::vector<std::string> expected = {
+        "wire 0,0 200,0",
+        "wire 300,0 300,200",
+        "wire 0,300 200,500",
+        "wire 500,0 600,100",
+        "wire 600,100 700,100",
+        "wire 0,600 100,600",
+        "bus 1000,0 1100,0",
+        "wire 1100,0 1200,0",
+        "wire 0,800 300,800",
+        "wire 0,1000 100,1000",
+        "wire 200,1000 300,1000",
+        "junction 100,0",
+        "junction 2000,2000",
+    };
+
+    const std::vector<std::string> result = describe( screen );
+
+    BOOST_CHECK_EQUAL_COLLECTIONS( result.begin(), result.end(),
+                                   expected.begin(), expected.end() );
+    BOOST_CHECK( merged->GetFlags() & SELECTED );
+
+    // Nothing is left to clean up
+    BOOST_CHECK( !screen.SchematicCleanUp() );
+}
+
+/**
+ * Checks that random sets of lines and junctions give the same draw list as the
+ * previous algorithm.
+ */
+BOOST_AUTO_TEST_CASE( SameAsReference )
+{
+    const int grid = 50;
+    const int directions[][2] = { { 1, 0 }, { 0, 1 }, { 1, 1 }, { 1, -1 }, { 2, 1 } };
+
+    std::mt19937 rng( 1 );
+    std::uniform_int_distribution<int> coord( 0, 10 );
+    std::uniform_int_distribution<int> length( -3, 3 );
+    std::uniform_int_distribution<int> direction( 0, 4 );
+    std::uniform_int_distribution<int> percent( 0, 99 );
+
+    for( int pass = 0; pass < 20; ++pass )
+    {
+        SCH_SCREEN screen( NULL );
+        SCH_SCREEN reference( NULL );
+
+        for( int i = 0; i < 200; ++i )
+        {
+            int x = coord( rng ) * grid;
+            int y = coord( rng ) * grid;
+
+            if( percent( rng ) < 20 )
+            {
+                // Junctions slightly off the grid cover a junction on the grid
+                int offset = percent( rng ) < 50 ? 10 : 0;
+
+                addJunction( screen, x + offset, y );
+                addJunction( reference, x + offset, y );
+                continue;
+            }
+
+            int len = length( rng );
+
+            if( len == 0 )
+                len = 1;
+
+            const int* dir = directions[ direction( rng ) ];
+            int layer = percent( rng ) < 10 ? LAYER_BUS : LAYER_WIRE;
+
+            addLine( screen, x, y, x + dir[0] * len * grid, y + dir[1] * len * grid, layer );
+            addLine( reference, x, y, x + dir[0] * len * grid, y + dir[1] * len * grid,
+                     layer );
+        }
+
+        bool modified = screen.SchematicCleanUp();
+        bool refModified = referenceCleanUp( reference );
+
+        BOOST_CHECK_EQUAL( modified, refModified );
+
+        const std::vector<std::string> result = describe( screen );
+        const std::vector<std::string> expected = describe( reference );
+
+        BOOST_CHECK_EQUAL_COLLECTIONS( result.begin(), result.end(),
+                                       expected.begin(), expected.end() );
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
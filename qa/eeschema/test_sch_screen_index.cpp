@@ -0,0 +1,97 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <class_sch_screen.h>
+#include <sch_junction.h>
+
+/**
+ * A screen holding one junction, with the spatial index already built.
+ */
+struct ScreenIndexFixture
+{
+    ScreenIndexFixture() :
+        m_screen( NULL ),
+        m_oldPos( 1000, 1000 ),
+        m_newPos( 3000, 2000 )
+    {
+        m_junction = new SCH_JUNCTION( m_oldPos );
+        m_screen.Append( m_junction );
+
+        // The first search builds the index
+        BOOST_REQUIRE_EQUAL( m_screen.GetItem( m_oldPos, 0, SCH_JUNCTION_T ), m_junction );
+    }
+
+    SCH_SCREEN    m_screen;
+    SCH_JUNCTION* m_junction;
+    wxPoint       m_oldPos;
+    wxPoint       m_newPos;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( SchScreenIndex, ScreenIndexFixture )
+
+/**
+ * Checks that a move ended by SetModify() only, as done by
+ * SCH_EDIT_FRAME::addCurrentItemToList(), does not leave a stale index.
+ */
+BOOST_AUTO_TEST_CASE( MoveThenSetModify )
+{
+    m_junction->SetPosition( m_newPos );
+    m_screen.SetModify();
+
+    BOOST_CHECK( m_screen.GetItem( m_oldPos, 0, SCH_JUNCTION_T ) == NULL );
+    BOOST_CHECK_EQUAL( m_screen.GetItem( m_newPos, 0, SCH_JUNCTION_T ), m_junction );
+}
+
+/**
+ * Checks that the current item is found at its new position while it is moving,
+ * before the screen is told about the change.
+ */
+BOOST_AUTO_TEST_CASE( CurrentItemMoving )
+{
+    m_screen.SetCurItem( m_junction );
+    m_junction->Move( m_newPos - m_oldPos );
+
+    BOOST_CHECK( m_screen.GetItem( m_oldPos, 0, SCH_JUNCTION_T ) == NULL );
+    BOOST_CHECK_EQUAL( m_screen.GetItem( m_newPos, 0, SCH_JUNCTION_T ), m_junction );
+
+    m_screen.SetCurItem( NULL );
+}
+
+/**
+ * Checks that deleting an item keeps the index usable for the remaining items.
+ */
+BOOST_AUTO_TEST_CASE( DeleteKeepsIndex )
+{
+    SCH_JUNCTION* other = new SCH_JUNCTION( m_newPos );
+    m_screen.Append( other );
+
+    m_screen.DeleteItem( m_junction );
+
+    BOOST_CHECK( m_screen.GetItem( m_oldPos, 0, SCH_JUNCTION_T ) == NULL );
+    BOOST_CHECK_EQUAL( m_screen.GetItem( m_newPos, 0, SCH_JUNCTION_T ), other );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,172 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <sim/sim_batch.h>
+#include <sim/fake_simulator.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+static const char NETLIST[] = "RC filter\nr1 1 2 1k\nc1 2 0 100n\nv1 1 0 ac 1\n.end\n";
+
+
+/**
+ * Runs a batch with \a aCount fake simulators, and returns its results in run order.
+ */
+static std::vector<SIM_BATCH_RESULT> runBatch( unsigned aCount,
+        const std::vector<SIM_BATCH_VARIANT>& aVariants )
+{
+    std::vector< std::unique_ptr<FAKE_SIMULATOR> > simulators;
+    std::vector<SPICE_SIMULATOR*> simPtrs;
+
+    for( unsigned i = 0; i < aCount; ++i )
+    {
+        simulators.emplace_back( new FAKE_SIMULATOR( 100, 1 ) );
+        simPtrs.push_back( simulators.back().get() );
+    }
+
+    const std::vector<SIM_BATCH_PROBE> probes = {
+        { "V(2)", SPT_AC_MAG }, { "V(2)", SPT_AC_PHASE }, { "@r1[i]", SPT_AC_MAG }
+    };
+
+    SIM_BATCH batch( simPtrs );
+    BOOST_REQUIRE( batch.Start( NETLIST, ST_AC, aVariants, probes ) );
+    batch.Wait();
+
+    BOOST_CHECK( !batch.IsRunning() );
+    BOOST_CHECK_EQUAL( batch.GetFinishedCount(), (int) aVariants.size() );
+
+    std::vector<SIM_BATCH_RESULT> results;
+    SIM_BATCH_RESULT result;
+
+    while( batch.GetResult( result ) )
+        results.push_back( result );
+
+    std::sort( results.begin(), results.end(),
+               []( const SIM_BATCH_RESULT& a, const SIM_BATCH_RESULT& b ) {
+                   return a.m_run < b.m_run;
+               } );
+
+    return results;
+}
+
+
+BOOST_AUTO_TEST_SUITE( SimBatch )
+
+/**
+ * Checks that a batch gives the same vectors whatever the number of simulators.
+ */
+BOOST_AUTO_TEST_CASE( SameResultsForAnySimulatorCount )
+{
+    std::vector<double> values;
+
+    for( int i = 0; i < 24; ++i )
+        values.push_back( 100.0 * ( i + 1 ) );
+
+    const std::vector< std::vector<SIM_BATCH_VARIANT> > analyses = {
+        SIM_BATCH::MakeSweep( "r1", values ),
+        SIM_BATCH::MakeMonteCarlo( { { "r1", 1e3 }, { "c1", 1e-7 } }, 0.05, 24, 1 )
+    };
+
+    for( const auto& variants : analyses )
+    {
+        const std::vector<SIM_BATCH_RESULT> reference = runBatch( 1, variants );
+
+        BOOST_REQUIRE_EQUAL( reference.size(), variants.size() );
+
+        for( size_t run = 0; run < reference.size(); ++run )
+        {
+            BOOST_CHECK_EQUAL( reference[run].m_run, (int) run );
+            BOOST_CHECK( reference[run].m_success );
+            BOOST_CHECK_EQUAL( reference[run].m_y.size(), 3u );
+        }
+
+        // Different runs give different vectors
+        BOOST_CHECK( reference[0].m_y != reference[1].m_y );
+
+        for( unsigned count = 2; count <= 6; ++count )
+        {
+            const std::vector<SIM_BATCH_RESULT> results = runBatch( count, variants );
+
+            BOOST_REQUIRE_EQUAL( results.size(), reference.size() );
+
+            for( size_t run = 0; run < results.size(); ++run )
+            {
+                BOOST_CHECK_EQUAL( results[run].m_run, reference[run].m_run );
+                BOOST_CHECK_EQUAL( results[run].m_success, reference[run].m_success );
+                BOOST_CHECK( results[run].m_x == reference[run].m_x );
+                BOOST_CHECK( results[run].m_y == reference[run].m_y );
+            }
+        }
+    }
+}
+
+/**
+ * Checks that a stopped batch does not start new runs, and that the runs finished
+ * before are all reported.
+ */
+BOOST_AUTO_TEST_CASE( Cancel )
+{
+    const int runs = 200;
+    const int runTime = 10;
+    std::vector<double> values( runs, 1e3 );
+
+    FAKE_SIMULATOR sim1( 100, runTime ), sim2( 100, runTime );
+    SIM_BATCH batch( { &sim1, &sim2 } );
+
+    BOOST_REQUIRE( batch.Start( NETLIST, ST_TRANSIENT, SIM_BATCH::MakeSweep( "r1", values ),
+                                { { "V(2)", SPT_VOLTAGE } } ) );
+    BOOST_CHECK( batch.IsRunning() );
+
+    std::this_thread::sleep_for( std::chrono::milliseconds( runTime * 3 ) );
+    batch.Stop();
+
+    BOOST_CHECK( !batch.IsRunning() );
+
+    int finished = batch.GetFinishedCount();
+    BOOST_CHECK_GT( finished, 0 );
+    BOOST_CHECK_LT( finished, runs );
+
+    int count = 0;
+    SIM_BATCH_RESULT result;
+
+    while( batch.GetResult( result ) )
+    {
+        BOOST_CHECK( result.m_success );
+        ++count;
+    }
+
+    BOOST_CHECK_EQUAL( count, finished );
+
+    // A stopped batch can be started again
+    BOOST_CHECK( batch.Start( NETLIST, ST_TRANSIENT, SIM_BATCH::MakeSweep( "r1", { 1e3 } ),
+                              { { "V(2)", SPT_VOLTAGE } } ) );
+    batch.Wait();
+    BOOST_CHECK_EQUAL( batch.GetFinishedCount(), 1 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,32 @@
+import os
+import tempfile
+import unittest
+import pcbnew
+
+
+class TestRender3D(unittest.TestCase):
+
+    def setUp(self):
+        self.pcb = pcbnew.LoadBoard("data/complex_hierarchy.kicad_pcb")
+        self.FILENAME = tempfile.mktemp() + ".png"
+
+    def test_render_without_frame(self):
+        # There is no PCB_EDIT_FRAME when running from a standalone script, the
+        # 3D models must be looked up without the project of a frame
+        self.assertEqual(pcbnew.GetBoard(), None)
+
+        result = pcbnew.Render3DBoard(self.FILENAME, self.pcb, 160, 120)
+
+        self.assertTrue(result)
+        self.assertTrue(os.path.exists(self.FILENAME))
+
+    def test_render_bad_size(self):
+        self.assertFalse(pcbnew.Render3DBoard(self.FILENAME, self.pcb, 0, 120))
+
+    def tearDown(self):
+        if os.path.exists(self.FILENAME):
+            os.remove(self.FILENAME)
+
+
+if __name__ == '__main__':
+    unittest.main()
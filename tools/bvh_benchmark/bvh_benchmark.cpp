@@ -0,0 +1,345 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file  bvh_benchmark.cpp
+ * @brief Measures the construction time of the raytracing CBVH_PBRT accelerator
+ * for scenes of increasing size.
+ *
+ * The scenes are made of clusters of small triangles, similar to the 3D models
+ * of the footprints of a board. A fixed set of rays is traced after each build
+ * and the hits are accumulated, so the results of a serial build (OMP_NUM_THREADS=1)
+ * and of a parallel build can be compared.
+ *
+ * The board is then rendered with ray packets, using the scalar and the SIMD
+ * bounding box tests: the hit object and distance of every pixel must be the
+ * same with both, and the speedup of the SIMD tests is reported.
+ */
+
+#include <wx/wx.h>
+
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <3d_rendering/3d_render_raytracing/accelerators/cbvh_packet_simd.h>
+#include <3d_rendering/3d_render_raytracing/accelerators/cbvh_pbrt.h>
+#include <3d_rendering/3d_render_raytracing/accelerators/ccontainer.h>
+#include <3d_rendering/3d_render_raytracing/shapes3D/ctriangle.h>
+#include <3d_rendering/ctrack_ball.h>
+
+
+using CLOCK = std::chrono::steady_clock;
+using TIME_PT = std::chrono::time_point<CLOCK>;
+
+
+struct BENCH_REPORT
+{
+    /// Accumulator of the hit distances of the test rays
+    double hitAcc;
+
+    /// Number of test rays that hit an object
+    unsigned hits;
+
+    std::chrono::milliseconds buildDurMs;
+};
+
+
+struct PACKET_REPORT
+{
+    /// Accumulator of the hit distances of the camera rays
+    double hitAcc;
+
+    /// Number of camera rays that hit an object
+    unsigned hits;
+
+    /// The image: object hit by the ray of each pixel (NULL if none) and its distance
+    std::vector<const COBJECT*> hitObjects;
+    std::vector<float> hitDistances;
+
+    std::chrono::milliseconds traceDurMs;
+};
+
+
+/**
+ * Fill a container with aNrTriangles triangles, grouped in clusters
+ * randomly placed on a 100x100 board.
+ */
+static void createScene( CCONTAINER& aContainer, unsigned aNrTriangles )
+{
+    std::mt19937 rng( 1 );
+    std::uniform_real_distribution<float> board( 0.0f, 100.0f );
+    std::uniform_real_distribution<float> cluster( -1.0f, 1.0f );
+
+    const unsigned trianglesPerCluster = 256;
+
+    SFVEC3F center;
+
+    for( unsigned i = 0; i < aNrTriangles; ++i )
+    {
+        if( ( i % trianglesPerCluster ) == 0 )
+            center = SFVEC3F( board( rng ), board( rng ), 0.0f );
+
+        const SFVEC3F v1 = center + SFVEC3F( cluster( rng ), cluster( rng ), cluster( rng ) );
+        const SFVEC3F v2 = v1 + SFVEC3F( cluster( rng ), cluster( rng ), cluster( rng ) ) * 0.1f;
+        const SFVEC3F v3 = v1 + SFVEC3F( cluster( rng ), cluster( rng ), cluster( rng ) ) * 0.1f;
+
+        aContainer.Add( new CTRIANGLE( v1, v2, v3 ) );
+    }
+}
+
+
+static BENCH_REPORT executeBenchMark( const CCONTAINER& aContainer, SPLITMETHOD aSplitMethod )
+{
+    BENCH_REPORT report = {};
+
+    TIME_PT start = CLOCK::now();
+    CBVH_PBRT accelerator( aContainer, 8, aSplitMethod );
+    TIME_PT end = CLOCK::now();
+
+    using std::chrono::milliseconds;
+    using std::chrono::duration_cast;
+
+    report.buildDurMs = duration_cast<milliseconds>( end - start );
+
+    // Trace a grid of vertical rays over the board
+    const int gridSize = 256;
+
+    for( int y = 0; y < gridSize; ++y )
+    {
+        for( int x = 0; x < gridSize; ++x )
+        {
+            RAY ray;
+            ray.Init( SFVEC3F( x * 100.0f / gridSize, y * 100.0f / gridSize, 10.0f ),
+                      SFVEC3F( 0.0f, 0.0f, -1.0f ) );
+
+            HITINFO hitInfo;
+            hitInfo.m_tHit = std::numeric_limits<float>::infinity();
+
+            if( accelerator.Intersect( ray, hitInfo ) )
+            {
+                report.hits++;
+                report.hitAcc += hitInfo.m_tHit;
+            }
+        }
+    }
+
+    return report;
+}
+
+
+/**
+ * Render the whole board from above with ray packets, using the bounding box
+ * tests of aSimdLevel.
+ */
+static PACKET_REPORT executePacketBenchMark( const CBVH_PBRT& aAccelerator,
+                                             RAYPACKET_SIMD_LEVEL aSimdLevel )
+{
+    PACKET_REPORT report = {};
+
+    const int windowSize = 512;
+
+    report.hitObjects.reserve( windowSize * windowSize );
+    report.hitDistances.reserve( windowSize * windowSize );
+
+    CTRACK_BALL camera( 100.0f );
+    camera.SetBoardLookAtPos( SFVEC3F( 50.0f, 50.0f, 0.0f ) );
+    camera.SetCurWindowSize( wxSize( windowSize, windowSize ) );
+
+    RAYPACKET_SetSimdLevel( aSimdLevel );
+
+    TIME_PT start = CLOCK::now();
+
+    for( int y = 0; y < windowSize; y += RAYPACKET_DIM )
+    {
+        for( int x = 0; x < windowSize; x += RAYPACKET_DIM )
+        {
+            const RAYPACKET packet( camera, SFVEC2I( x, y ) );
+
+            HITINFO_PACKET hitInfoPacket[RAYPACKET_RAYS_PER_PACKET];
+
+            for( unsigned int i = 0; i < RAYPACKET_RAYS_PER_PACKET; ++i )
+            {
+                hitInfoPacket[i].m_HitInfo.m_tHit = std::numeric_limits<float>::infinity();
+                hitInfoPacket[i].m_hitresult = false;
+            }
+
+            aAccelerator.Intersect( packet, hitInfoPacket );
+
+            for( unsigned int i = 0; i < RAYPACKET_RAYS_PER_PACKET; ++i )
+            {
+                const HITINFO& hitInfo = hitInfoPacket[i].m_HitInfo;
+
+                if( hitInfoPacket[i].m_hitresult )
+                {
+                    report.hits++;
+                    report.hitAcc += hitInfo.m_tHit;
+                }
+
+                report.hitObjects.push_back( hitInfoPacket[i].m_hitresult ?
+                                             hitInfo.pHitObject : NULL );
+                report.hitDistances.push_back( hitInfoPacket[i].m_hitresult ?
+                                               hitInfo.m_tHit : 0.0f );
+            }
+        }
+    }
+
+    TIME_PT end = CLOCK::now();
+
+    using std::chrono::milliseconds;
+    using std::chrono::duration_cast;
+
+    report.traceDurMs = duration_cast<milliseconds>( end - start );
+
+    return report;
+}
+
+
+/**
+ * @return the number of pixels of the packet renders which differ, either by the
+ * object hit or by its distance.
+ */
+static unsigned compareImages( const PACKET_REPORT& aRef, const PACKET_REPORT& aOther )
+{
+    unsigned diffs = 0;
+
+    for( size_t i = 0; i < aRef.hitObjects.size(); ++i )
+    {
+        if( aRef.hitObjects[i] != aOther.hitObjects[i]
+            || aRef.hitDistances[i] != aOther.hitDistances[i] )
+            diffs++;
+    }
+
+    return diffs;
+}
+
+
+enum RET_CODES
+{
+    BAD_ARGS = 1,
+    IMAGE_MISMATCH = 2,
+};
+
+
+int main( int argc, char* argv[] )
+{
+    auto& os = std::cout;
+
+    std::vector<long> sizes;
+
+    for( int i = 1; i < argc; ++i )
+    {
+        long size = 0;
+
+        if( !wxString( argv[i] ).ToLong( &size ) || size <= 0 )
+        {
+            os << "Usage: " << argv[0] << " [NR_TRIANGLES...]\n";
+            return BAD_ARGS;
+        }
+
+        sizes.push_back( size );
+    }
+
+    if( sizes.empty() )
+        sizes = { 1000, 10000, 100000, 1000000 };
+
+    os << "BVH Bench Mark Util" << std::endl;
+    os << std::endl;
+
+    for( long size : sizes )
+    {
+        CCONTAINER container;
+
+        createScene( container, size );
+
+        const struct
+        {
+            SPLITMETHOD method;
+            const char* name;
+        } splitMethods[] =
+        {
+            { SPLIT_SAH,   "SAH" },
+            { SPLIT_HLBVH, "HLBVH" },
+        };
+
+        for( auto& split : splitMethods )
+        {
+            BENCH_REPORT report = executeBenchMark( container, split.method );
+
+            os << wxString::Format( "%8ld triangles %-6s built in %6d ms, %u hits, acc: %.3f",
+                    size, split.name, (int) report.buildDurMs.count(),
+                    report.hits, report.hitAcc )
+                << std::endl;
+        }
+
+        CBVH_PBRT accelerator( container, 8, SPLIT_SAH );
+
+        const RAYPACKET_SIMD_LEVEL bestLevel = RAYPACKET_SetSimdLevel( RAYPACKET_SIMD_AVX2 );
+
+        const struct
+        {
+            RAYPACKET_SIMD_LEVEL level;
+            const char* name;
+        } simdLevels[] =
+        {
+            { RAYPACKET_SIMD_NONE, "scalar" },
+            { bestLevel,           bestLevel == RAYPACKET_SIMD_AVX2 ? "AVX2" :
+                                   bestLevel == RAYPACKET_SIMD_SSE2 ? "SSE2" : "scalar" },
+        };
+
+        PACKET_REPORT reports[2];
+
+        for( int i = 0; i < 2; ++i )
+        {
+            PACKET_REPORT& report = reports[i];
+            report = executePacketBenchMark( accelerator, simdLevels[i].level );
+
+            os << wxString::Format( "%8ld triangles %-6s packets in %6d ms, %u hits, acc: %.3f",
+                    size, simdLevels[i].name, (int) report.traceDurMs.count(),
+                    report.hits, report.hitAcc )
+                << std::endl;
+        }
+
+        RAYPACKET_SetSimdLevel( bestLevel );
+
+        unsigned diffs = compareImages( reports[0], reports[1] );
+
+        if( diffs )
+        {
+            os << wxString::Format( "%u pixels differ between the scalar and %s renders",
+                    diffs, simdLevels[1].name )
+                << std::endl;
+            return IMAGE_MISMATCH;
+        }
+
+        if( reports[1].traceDurMs.count() > 0 )
+            os << wxString::Format( "%8ld triangles %-6s packet speedup: %.2f", size,
+                    simdLevels[1].name,
+                    (double) reports[0].traceDurMs.count() / reports[1].traceDurMs.count() )
+                << std::endl;
+    }
+
+    return 0;
+}
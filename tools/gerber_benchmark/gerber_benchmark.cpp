@@ -0,0 +1,170 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file  gerber_benchmark.cpp
+ * @brief Measures the time needed by the GERBER_PLOTTER to plot a copper
+ * layer made of a large number of pad flashes and tracks.
+ *
+ * The flashes use many different apertures, like the pads of a large board,
+ * so the aperture lookup and the file output are both exercised.
+ */
+
+#include <wx/wx.h>
+#include <wx/filename.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include <plot_common.h>
+
+
+using CLOCK = std::chrono::steady_clock;
+using TIME_PT = std::chrono::time_point<CLOCK>;
+
+
+struct BENCH_REPORT
+{
+    std::chrono::milliseconds plotDurMs;
+
+    /// Time needed by EndPlot, i.e. to write the file
+    std::chrono::milliseconds writeDurMs;
+
+    wxULongLong fileSize;
+};
+
+
+/**
+ * Plot aNrFlashes pads using aNrApertures different sizes, and a track
+ * between each pair of pads, on a 300x300 mm board.
+ */
+static bool executeBenchMark( const wxString& aFileName, unsigned aNrFlashes,
+                              unsigned aNrApertures, BENCH_REPORT& aReport )
+{
+    // Internal units are nanometers, like in Pcbnew
+    const double iuPerDecimil = 2540.0;
+    const int    boardSize = 300 * 1000000;
+
+    std::mt19937 rng( 1 );
+    std::uniform_int_distribution<int> position( 0, boardSize );
+    std::uniform_int_distribution<unsigned> aperture( 0, aNrApertures - 1 );
+
+    GERBER_PLOTTER plotter;
+
+    plotter.SetViewport( wxPoint( 0, 0 ), iuPerDecimil, 1.0, false );
+    plotter.SetGerberCoordinatesFormat( 6 );
+    plotter.SetDefaultLineWidth( 100000 );
+    plotter.SetCreator( wxT( "gerber_benchmark" ) );
+
+    if( !plotter.OpenFile( aFileName ) )
+        return false;
+
+    TIME_PT start = CLOCK::now();
+
+    plotter.StartPlot();
+
+    wxPoint previous( 0, 0 );
+
+    for( unsigned i = 0; i < aNrFlashes; ++i )
+    {
+        // Sizes from 0.2 mm, in 10 um steps
+        const int size = 200000 + aperture( rng ) * 10000;
+        const wxPoint pos( position( rng ), position( rng ) );
+
+        if( i % 2 )
+            plotter.FlashPadCircle( pos, size, FILLED, NULL );
+        else
+            plotter.FlashPadRect( pos, wxSize( size, size / 2 ), 0.0, FILLED, NULL );
+
+        if( i % 4 == 0 )
+            plotter.ThickSegment( previous, pos, 150000 + ( i / 4 ) % 16 * 10000,
+                                  FILLED, NULL );
+
+        previous = pos;
+    }
+
+    TIME_PT plotted = CLOCK::now();
+
+    plotter.EndPlot();
+
+    TIME_PT end = CLOCK::now();
+
+    using std::chrono::milliseconds;
+    using std::chrono::duration_cast;
+
+    aReport.plotDurMs = duration_cast<milliseconds>( plotted - start );
+    aReport.writeDurMs = duration_cast<milliseconds>( end - plotted );
+    aReport.fileSize = wxFileName::GetSize( aFileName );
+
+    return true;
+}
+
+
+enum RET_CODES
+{
+    BAD_ARGS = 1,
+    PLOT_FAILED = 2,
+};
+
+
+int main( int argc, char* argv[] )
+{
+    auto& os = std::cout;
+
+    if( argc < 2 )
+    {
+        os << "Usage: " << argv[0] << " OUTPUT_FILE [NR_FLASHES [NR_APERTURES]]\n";
+        return BAD_ARGS;
+    }
+
+    long nrFlashes = 2000000;
+    long nrApertures = 1000;
+
+    if( ( argc > 2 && ( !wxString( argv[2] ).ToLong( &nrFlashes ) || nrFlashes <= 0 ) )
+        || ( argc > 3 && ( !wxString( argv[3] ).ToLong( &nrApertures ) || nrApertures <= 0 ) ) )
+    {
+        os << "Usage: " << argv[0] << " OUTPUT_FILE [NR_FLASHES [NR_APERTURES]]\n";
+        return BAD_ARGS;
+    }
+
+    os << "Gerber Bench Mark Util" << std::endl;
+    os << std::endl;
+
+    BENCH_REPORT report;
+
+    if( !executeBenchMark( wxString::FromUTF8( argv[1] ), nrFlashes, nrApertures, report ) )
+    {
+        os << "Cannot create " << argv[1] << std::endl;
+        return PLOT_FAILED;
+    }
+
+    os << wxString::Format( "%ld flashes, %ld apertures: plotted in %d ms, written in %d ms, "
+                            "%s bytes",
+            nrFlashes, nrApertures,
+            (int) report.plotDurMs.count(), (int) report.writeDurMs.count(),
+            report.fileSize.ToString() )
+        << std::endl;
+
+    return 0;
+}
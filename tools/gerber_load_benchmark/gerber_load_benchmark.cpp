@@ -0,0 +1,268 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file  gerber_load_benchmark.cpp
+ * @brief Measures the time needed by GerbView to read a set of Gerber files,
+ * one file at a time and with GERBER_FILE_IMAGE_LIST::LoadFiles(), which reads
+ * the files in parallel.
+ *
+ * The files are given on the command line, or a job of about 100 MB is
+ * generated in a temporary folder with the GERBER_PLOTTER: one file per copper
+ * layer, made of pad flashes with many apertures and of tracks.
+ */
+
+#include <wx/wx.h>
+#include <wx/filename.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <plot_common.h>
+
+#include <class_gerber_file_image.h>
+#include <class_gerber_file_image_list.h>
+#include <class_gerber_draw_item.h>
+
+
+using CLOCK = std::chrono::steady_clock;
+using TIME_PT = std::chrono::time_point<CLOCK>;
+
+
+/**
+ * Write a Gerber file of about aSize bytes on a 300x300 mm board.
+ */
+static bool writeGerberFile( const wxString& aFileName, unsigned aSeed, wxULongLong aSize )
+{
+    // Internal units are nanometers, like in Pcbnew
+    const double iuPerDecimil = 2540.0;
+    const int    boardSize = 300 * 1000000;
+
+    // A flash with its aperture selection and a quarter of a track take about
+    // 40 bytes in the file
+    const unsigned nrFlashes = ( aSize / 40 ).GetLo();
+
+    std::mt19937 rng( aSeed );
+    std::uniform_int_distribution<int> position( 0, boardSize );
+    std::uniform_int_distribution<unsigned> aperture( 0, 999 );
+
+    GERBER_PLOTTER plotter;
+
+    plotter.SetViewport( wxPoint( 0, 0 ), iuPerDecimil, 1.0, false );
+    plotter.SetGerberCoordinatesFormat( 6 );
+    plotter.SetDefaultLineWidth( 100000 );
+    plotter.SetCreator( wxT( "gerber_load_benchmark" ) );
+
+    if( !plotter.OpenFile( aFileName ) )
+        return false;
+
+    plotter.StartPlot();
+
+    wxPoint previous( 0, 0 );
+
+    for( unsigned i = 0; i < nrFlashes; ++i )
+    {
+        // Sizes from 0.2 mm, in 10 um steps
+        const int size = 200000 + aperture( rng ) * 10000;
+        const wxPoint pos( position( rng ), position( rng ) );
+
+        if( i % 2 )
+            plotter.FlashPadCircle( pos, size, FILLED, NULL );
+        else
+            plotter.FlashPadRect( pos, wxSize( size, size / 2 ), 0.0, FILLED, NULL );
+
+        if( i % 4 == 0 )
+            plotter.ThickSegment( previous, pos, 150000 + ( i / 4 ) % 16 * 10000,
+                                  FILLED, NULL );
+
+        previous = pos;
+    }
+
+    plotter.EndPlot();
+
+    return true;
+}
+
+
+/**
+ * Read the files in aImages; each file is read alone if aSerial is true, else
+ * they are all read at once by GERBER_FILE_IMAGE_LIST::LoadFiles().
+ *
+ * @return the time needed in ms, and the count of items read in aItemCount
+ */
+static int loadFiles( GERBER_FILE_IMAGE_LIST& aImages, const std::vector<wxString>& aFiles,
+                      bool aSerial, int& aLoadedCount, long& aItemCount )
+{
+    aImages.DeleteAllImages();
+
+    std::vector<int> layers;
+
+    for( size_t ii = 0; ii < aFiles.size(); ++ii )
+        layers.push_back( aImages.AddGbrImage( new GERBER_FILE_IMAGE( ii ), ii ) );
+
+    aLoadedCount = 0;
+
+    TIME_PT start = CLOCK::now();
+
+    if( aSerial )
+    {
+        for( size_t ii = 0; ii < aFiles.size(); ++ii )
+            aLoadedCount += aImages.LoadFiles( { layers[ii] }, { aFiles[ii] } );
+    }
+    else
+    {
+        aLoadedCount = aImages.LoadFiles( layers, aFiles );
+    }
+
+    TIME_PT end = CLOCK::now();
+
+    aItemCount = 0;
+
+    for( int layer : layers )
+    {
+        for( GERBER_DRAW_ITEM* item = aImages.GetGbrImage( layer )->GetItemsList(); item;
+             item = item->Next() )
+            aItemCount++;
+    }
+
+    using std::chrono::milliseconds;
+    using std::chrono::duration_cast;
+
+    return duration_cast<milliseconds>( end - start ).count();
+}
+
+
+enum RET_CODES
+{
+    BAD_ARGS = 1,
+    WRITE_FAILED = 2,
+    LOAD_FAILED = 3,
+    MISMATCH = 4,
+};
+
+
+int main( int argc, char* argv[] )
+{
+    auto& os = std::cout;
+
+    std::vector<wxString> files;
+    wxString path;
+    long totalMb = 100;
+    long nrLayers = 8;
+
+    if( argc > 1 && wxFileName::FileExists( argv[1] ) )
+    {
+        for( int i = 1; i < argc && files.size() < GERBER_DRAWLAYERS_COUNT; ++i )
+            files.push_back( wxString::FromUTF8( argv[i] ) );
+    }
+    else if( ( argc > 1 && ( !wxString( argv[1] ).ToLong( &totalMb ) || totalMb <= 0 ) )
+        || ( argc > 2 && ( !wxString( argv[2] ).ToLong( &nrLayers ) || nrLayers <= 0
+                           || nrLayers > GERBER_DRAWLAYERS_COUNT ) ) )
+    {
+        os << "Usage: " << argv[0] << " [TOTAL_MB [NR_LAYERS]]\n";
+        os << "       " << argv[0] << " GERBER_FILE...\n";
+        return BAD_ARGS;
+    }
+
+    os << "Gerber Load Bench Mark Util" << std::endl;
+    os << std::endl;
+
+    if( files.empty() )
+    {
+        path = wxFileName::CreateTempFileName( "gerber_load_benchmark" );
+
+        wxRemoveFile( path );
+        wxFileName::Mkdir( path );
+
+        wxULongLong layerSize = wxULongLong( totalMb ) * 1024 * 1024 / nrLayers;
+
+        for( long ii = 0; ii < nrLayers; ++ii )
+        {
+            wxString file = path + wxFileName::GetPathSeparator()
+                            + wxString::Format( "layer%ld.gbr", ii + 1 );
+
+            if( !writeGerberFile( file, ii + 1, layerSize ) )
+            {
+                os << "Cannot create " << file << std::endl;
+                wxFileName::Rmdir( path, wxPATH_RMDIR_RECURSIVE );
+                return WRITE_FAILED;
+            }
+
+            files.push_back( file );
+        }
+    }
+
+    wxULongLong totalSize = 0;
+
+    for( const wxString& file : files )
+        totalSize += wxFileName::GetSize( file );
+
+    double megaBytes = totalSize.ToDouble() / ( 1024.0 * 1024.0 );
+
+    os << wxString::Format( "%u files, %.1f MB", (unsigned) files.size(), megaBytes )
+       << std::endl;
+
+    GERBER_FILE_IMAGE_LIST images;
+    int  serialLoaded, parallelLoaded;
+    long serialItems, parallelItems;
+
+    // Read the files once, so both loads find them in the file system cache
+    loadFiles( images, files, false, parallelLoaded, parallelItems );
+
+    int serialTime = loadFiles( images, files, true, serialLoaded, serialItems );
+
+    os << wxString::Format( "serial load:   %6d ms, %.1f MB/s, %ld items", serialTime,
+                            serialTime > 0 ? megaBytes * 1000.0 / serialTime : 0.0,
+                            serialItems )
+       << std::endl;
+
+    int parallelTime = loadFiles( images, files, false, parallelLoaded, parallelItems );
+
+    os << wxString::Format( "parallel load: %6d ms, %.1f MB/s, %ld items (%u threads)",
+                            parallelTime,
+                            parallelTime > 0 ? megaBytes * 1000.0 / parallelTime : 0.0,
+                            parallelItems, std::thread::hardware_concurrency() )
+       << std::endl;
+
+    images.DeleteAllImages();
+
+    if( !path.IsEmpty() )
+        wxFileName::Rmdir( path, wxPATH_RMDIR_RECURSIVE );
+
+    if( serialLoaded != (int) files.size() || parallelLoaded != (int) files.size() )
+    {
+        os << "Some files could not be read" << std::endl;
+        return LOAD_FAILED;
+    }
+
+    if( serialItems != parallelItems )
+    {
+        os << "Both loads did not read the same items" << std::endl;
+        return MISMATCH;
+    }
+
+    return 0;
+}
@@ -0,0 +1,239 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file  gerbview_benchmark.cpp
+ * @brief Measures the cost of the KIGFX::VIEW used by the GerbView GAL canvas:
+ * adding the items of a large panelized job, querying the items visible in a
+ * viewport, and emptying the view, compared to the linear walk through all
+ * items done by the legacy canvas on each redraw.
+ *
+ * No GAL is needed: only the R-tree index of the view is exercised.
+ * The items are stand-ins for GERBER_DRAW_ITEMs: a bounding box on a
+ * GerbView draw layer, with the sizes of flashes and tracks.
+ */
+
+#include <wx/wx.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <layers_id_colors_and_visibility.h>
+#include <view/view.h>
+#include <view/view_item.h>
+
+
+using CLOCK = std::chrono::steady_clock;
+using TIME_PT = std::chrono::time_point<CLOCK>;
+
+
+class BENCH_ITEM : public KIGFX::VIEW_ITEM
+{
+public:
+    BENCH_ITEM( const BOX2I& aBBox, int aLayer ) :
+        m_bbox( aBBox ), m_layer( aLayer )
+    {
+    }
+
+    const BOX2I ViewBBox() const override
+    {
+        return m_bbox;
+    }
+
+    void ViewGetLayers( int aLayers[], int& aCount ) const override
+    {
+        aLayers[0] = GERBER_DRAW_LAYER( m_layer );
+        aCount = 1;
+    }
+
+    BOX2I   m_bbox;
+    int     m_layer;
+};
+
+
+struct BENCH_REPORT
+{
+    std::chrono::milliseconds addDurMs;
+    std::chrono::milliseconds queryDurMs;
+    std::chrono::milliseconds scanDurMs;
+    std::chrono::milliseconds clearDurMs;
+
+    /// Number of items found in all viewports (same for the view and the linear scan)
+    unsigned long foundCount;
+    unsigned long scannedCount;
+};
+
+
+/**
+ * Build aNrItems items on aNrLayers layers of a 500x500 mm panel,
+ * then query aNrQueries random viewports, of aViewSize mm.
+ */
+static void executeBenchMark( unsigned aNrItems, unsigned aNrLayers, unsigned aNrQueries,
+                              int aViewSize, BENCH_REPORT& aReport )
+{
+    // GerbView internal units are 10 nm
+    const int iuPerMm = 100000;
+    const int panelSize = 500 * iuPerMm;
+    const int viewSize = aViewSize * iuPerMm;
+
+    std::mt19937 rng( 1 );
+    std::uniform_int_distribution<int> position( 0, panelSize );
+    std::uniform_int_distribution<int> viewPosition( 0, panelSize - viewSize );
+    std::uniform_int_distribution<int> flashSize( iuPerMm / 5, 2 * iuPerMm );
+    std::uniform_int_distribution<int> trackLength( -5 * iuPerMm, 5 * iuPerMm );
+
+    std::vector<BENCH_ITEM*> items;
+    items.reserve( aNrItems );
+
+    for( unsigned i = 0; i < aNrItems; ++i )
+    {
+        VECTOR2I pos( position( rng ), position( rng ) );
+        BOX2I    bbox;
+
+        if( i % 4 == 0 )    // track
+        {
+            bbox = BOX2I( pos, VECTOR2I( trackLength( rng ), trackLength( rng ) ) );
+            bbox.Normalize();
+            bbox.Inflate( iuPerMm / 10 );
+        }
+        else                // flash
+        {
+            int size = flashSize( rng );
+            bbox = BOX2I( pos - VECTOR2I( size / 2, size / 2 ), VECTOR2I( size, size ) );
+        }
+
+        items.push_back( new BENCH_ITEM( bbox, i % aNrLayers ) );
+    }
+
+    std::vector<BOX2I> viewports;
+
+    for( unsigned i = 0; i < aNrQueries; ++i )
+        viewports.push_back( BOX2I( VECTOR2I( viewPosition( rng ), viewPosition( rng ) ),
+                                    VECTOR2I( viewSize, viewSize ) ) );
+
+    KIGFX::VIEW view( true );
+    view.UseDrawPriority( true );
+
+    TIME_PT start = CLOCK::now();
+
+    for( BENCH_ITEM* item : items )
+        view.Add( item );
+
+    TIME_PT added = CLOCK::now();
+
+    aReport.foundCount = 0;
+
+    for( const BOX2I& viewport : viewports )
+    {
+        std::vector<KIGFX::VIEW::LAYER_ITEM_PAIR> found;
+        aReport.foundCount += view.Query( viewport, found );
+    }
+
+    TIME_PT queried = CLOCK::now();
+
+    // The legacy canvas tests the bounding box of each item against the clip box
+    aReport.scannedCount = 0;
+
+    for( const BOX2I& viewport : viewports )
+    {
+        for( const BENCH_ITEM* item : items )
+        {
+            if( viewport.Intersects( item->m_bbox ) )
+                aReport.scannedCount++;
+        }
+    }
+
+    TIME_PT scanned = CLOCK::now();
+
+    // Same as GERBVIEW_DRAW_PANEL_GAL::ClearLayout(): empty the view, then detach the items,
+    // so deleting them does not remove them one by one from the view
+    view.Clear();
+
+    for( BENCH_ITEM* item : items )
+        view.Remove( item );
+
+    TIME_PT end = CLOCK::now();
+
+    for( BENCH_ITEM* item : items )
+        delete item;
+
+    using std::chrono::milliseconds;
+    using std::chrono::duration_cast;
+
+    aReport.addDurMs = duration_cast<milliseconds>( added - start );
+    aReport.queryDurMs = duration_cast<milliseconds>( queried - added );
+    aReport.scanDurMs = duration_cast<milliseconds>( scanned - queried );
+    aReport.clearDurMs = duration_cast<milliseconds>( end - scanned );
+}
+
+
+enum RET_CODES
+{
+    BAD_ARGS = 1,
+};
+
+
+int main( int argc, char* argv[] )
+{
+    auto& os = std::cout;
+
+    long nrItems = 2000000;
+    long nrLayers = GERBER_DRAWLAYERS_COUNT;
+    long nrQueries = 100;
+
+    if( ( argc > 1 && ( !wxString( argv[1] ).ToLong( &nrItems ) || nrItems <= 0 ) )
+        || ( argc > 2 && ( !wxString( argv[2] ).ToLong( &nrLayers ) || nrLayers <= 0
+                           || nrLayers > GERBER_DRAWLAYERS_COUNT ) )
+        || ( argc > 3 && ( !wxString( argv[3] ).ToLong( &nrQueries ) || nrQueries <= 0 ) ) )
+    {
+        os << "Usage: " << argv[0] << " [NR_ITEMS [NR_LAYERS [NR_QUERIES]]]\n";
+        return BAD_ARGS;
+    }
+
+    os << "GerbView View Bench Mark Util" << std::endl;
+    os << std::endl;
+
+    os << wxString::Format( "%ld items on %ld layers", nrItems, nrLayers ) << std::endl;
+
+    // Viewport sizes in mm: a zoomed view, a board of the panel, the whole panel
+    const int viewSizes[] = { 10, 100, 500 };
+
+    for( int viewSize : viewSizes )
+    {
+        BENCH_REPORT report;
+
+        executeBenchMark( nrItems, nrLayers, nrQueries, viewSize, report );
+
+        os << wxString::Format( "%3d mm view: add %d ms, %ld queries %d ms (%lu items), "
+                                "linear scan %d ms (%lu items), clear %d ms",
+                viewSize, (int) report.addDurMs.count(), nrQueries,
+                (int) report.queryDurMs.count(), report.foundCount,
+                (int) report.scanDurMs.count(), report.scannedCount,
+                (int) report.clearDurMs.count() )
+            << std::endl;
+    }
+
+    return 0;
+}
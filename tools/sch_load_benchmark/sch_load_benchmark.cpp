@@ -0,0 +1,321 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file  sch_load_benchmark.cpp
+ * @brief Measures the schematic hierarchy load of SCH_LEGACY_PLUGIN, with the sheet
+ * files parsed one at a time (SCH_LEGACY_PLUGIN::PropSerialLoad) and in parallel.
+ *
+ * The schematic is loaded through SCH_IO_MGR::Load(), as eeschema does.  It is either
+ * given on the command line, or a deep hierarchy of legacy .sch files is generated in
+ * a temporary folder.  In the generated hierarchy each file has sub-sheets of its own,
+ * and a sub-sheet shared by all the files of its level, which is parsed only once.
+ */
+
+#include <wx/wx.h>
+#include <wx/filename.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <macros.h>
+#include <richio.h>
+#include <kiway.h>
+#include <properties.h>
+
+#include <sch_io_mgr.h>
+#include <sch_legacy_plugin.h>
+#include <sch_sheet.h>
+#include <class_sch_screen.h>
+
+
+using CLOCK = std::chrono::steady_clock;
+using TIME_PT = std::chrono::time_point<CLOCK>;
+
+
+/// What is found in a loaded schematic.
+struct LOAD_STATS
+{
+    int sheets = 0;     ///< The number of sheets, the root sheet included.
+    int screens = 0;    ///< The number of sheet files.
+    int items = 0;      ///< The number of items of all the sheet files.
+
+    bool operator==( const LOAD_STATS& aOther ) const
+    {
+        return sheets == aOther.sheets && screens == aOther.screens && items == aOther.items;
+    }
+};
+
+
+/**
+ * Write a sheet file with aNrComponents components and the sheet symbols of aSubSheets.
+ */
+static void writeSheetFile( const wxString& aFileName, const std::vector<wxString>& aSubSheets,
+                            int aNrComponents )
+{
+    FILE_OUTPUTFORMATTER out( aFileName );
+
+    out.Print( 0, "EESchema Schematic File Version 2\n" );
+    out.Print( 0, "LIBS:power\nLIBS:device\nEELAYER 25 0\nEELAYER END\n" );
+    out.Print( 0, "$Descr A3 16535 11693\nencoding utf-8\nSheet 1 1\nTitle \"\"\n" );
+    out.Print( 0, "Date \"\"\nRev \"\"\nComp \"\"\nComment1 \"\"\nComment2 \"\"\n" );
+    out.Print( 0, "Comment3 \"\"\nComment4 \"\"\n$EndDescr\n" );
+
+    for( int i = 0; i < aNrComponents; ++i )
+    {
+        int x = 1000 + ( i % 40 ) * 300;
+        int y = 1000 + ( i / 40 ) * 400;
+
+        out.Print( 0, "$Comp\nL R R%d\nU 1 1 %8.8X\n", i + 1, 0x59000000 + i );
+        out.Print( 0, "P %d %d\n", x, y );
+        out.Print( 0, "F 0 \"R%d\" H %d %d 50  0000 C CNN\n", i + 1, x + 80, y );
+        out.Print( 0, "F 1 \"10k\" V %d %d 50  0000 C CNN\n", x, y );
+        out.Print( 0, "F 2 \"\" V %d %d 50  0001 C CNN\n", x - 70, y );
+        out.Print( 0, "F 3 \"\" H %d %d 50  0001 C CNN\n", x, y );
+        out.Print( 0, "\t1    %d %d\n\t1    0    0    -1\n$EndComp\n", x, y );
+        out.Print( 0, "Wire Wire Line\n\t%d %d %d %d\n", x, y + 150, x, y + 300 );
+    }
+
+    for( size_t i = 0; i < aSubSheets.size(); ++i )
+    {
+        int x = 1000 + (int) i * 2000;
+
+        out.Print( 0, "$Sheet\nS %d 9000 1500 1000\nU %8.8X\n", x, 0x5A000000 + (int) i );
+        out.Print( 0, "F0 \"Sheet%d\" 60\n", (int) i + 1 );
+        out.Print( 0, "F1 \"%s\" 60\n", TO_UTF8( aSubSheets[i] ) );
+        out.Print( 0, "$EndSheet\n" );
+    }
+
+    out.Print( 0, "$EndSCHEMATC\n" );
+}
+
+
+/**
+ * Generate a hierarchy of aDepth levels below the root file, each file having aFanOut
+ * sub-sheets, and a sheet shared by the files of its level.
+ * @return the number of files.
+ */
+static int generateHierarchy( const wxString& aPath, int aDepth, int aFanOut,
+                              int aNrComponents )
+{
+    int                     count = 0;
+    std::vector<wxString>   level( 1, wxString( "root.sch" ) );
+
+    for( int depth = 0; depth <= aDepth; ++depth )
+    {
+        std::vector<wxString> nextLevel;
+        wxString shared = wxString::Format( "shared_%d.sch", depth + 1 );
+
+        for( const wxString& file : level )
+        {
+            std::vector<wxString> subSheets;
+
+            if( depth < aDepth )
+            {
+                for( int i = 0; i < aFanOut; ++i )
+                {
+                    subSheets.push_back( wxString::Format( "%s_%d.sch",
+                                                           file.BeforeLast( '.' ), i + 1 ) );
+                    nextLevel.push_back( subSheets.back() );
+                }
+
+                subSheets.push_back( shared );
+            }
+
+            writeSheetFile( aPath + wxFileName::GetPathSeparator() + file, subSheets,
+                            aNrComponents );
+            count++;
+        }
+
+        if( depth < aDepth )
+        {
+            writeSheetFile( aPath + wxFileName::GetPathSeparator() + shared,
+                            std::vector<wxString>(), aNrComponents );
+            count++;
+        }
+
+        level.swap( nextLevel );
+    }
+
+    return count;
+}
+
+
+/**
+ * Count the sheets, sheet files and items of the hierarchy below aSheet.
+ */
+static void countItems( SCH_SHEET* aSheet, std::set<SCH_SCREEN*>& aScreens,
+                        LOAD_STATS& aStats )
+{
+    SCH_SCREEN* screen = aSheet->GetScreen();
+
+    aStats.sheets++;
+
+    // A shared sheet file is counted once
+    if( !screen || !aScreens.insert( screen ).second )
+        return;
+
+    aStats.screens++;
+
+    for( SCH_ITEM* item = screen->GetDrawItems(); item; item = item->Next() )
+    {
+        aStats.items++;
+
+        if( item->Type() == SCH_SHEET_T )
+            countItems( (SCH_SHEET*) item, aScreens, aStats );
+    }
+}
+
+
+/**
+ * Load a schematic hierarchy with SCH_IO_MGR::Load().
+ * @param aSerial is true to parse the sheet files one at a time.
+ * @return the time spent in the load, in milliseconds.
+ */
+static int loadSchematic( const wxString& aFileName, KIWAY& aKiway, bool aSerial,
+                          LOAD_STATS& aStats )
+{
+    PROPERTIES props;
+
+    if( aSerial )
+        props[ SCH_LEGACY_PLUGIN::PropSerialLoad ] = "";
+
+    TIME_PT start = CLOCK::now();
+
+    std::unique_ptr<SCH_SHEET> root( SCH_IO_MGR::Load( SCH_IO_MGR::SCH_LEGACY, aFileName,
+                                                       &aKiway, NULL, &props ) );
+
+    TIME_PT loaded = CLOCK::now();
+
+    std::set<SCH_SCREEN*> screens;
+
+    aStats = LOAD_STATS();
+    countItems( root.get(), screens, aStats );
+
+    return (int) std::chrono::duration_cast<std::chrono::milliseconds>(
+            loaded - start ).count();
+}
+
+
+enum RET_CODES
+{
+    BAD_ARGS = 1,
+    IO_ERROR_CODE,
+    MISMATCH
+};
+
+
+int main( int argc, char* argv[] )
+{
+    auto& os = std::cout;
+
+    wxString fileName;
+    wxString path;
+    long depth = 3;
+    long fanOut = 4;
+    long nrComponents = 300;
+
+    if( argc > 1 && wxFileName::FileExists( argv[1] ) )
+    {
+        wxFileName fn( argv[1] );
+
+        // The plugin needs an absolute path to find the sub-sheets
+        fn.MakeAbsolute();
+        fileName = fn.GetFullPath();
+    }
+    else if( ( argc > 1 && ( !wxString( argv[1] ).ToLong( &depth ) || depth < 0 ) )
+        || ( argc > 2 && ( !wxString( argv[2] ).ToLong( &fanOut ) || fanOut <= 0 ) )
+        || ( argc > 3 && ( !wxString( argv[3] ).ToLong( &nrComponents ) || nrComponents < 0 ) ) )
+    {
+        os << "Usage: " << argv[0] << " [DEPTH [FAN_OUT [NR_COMPONENTS]]]\n";
+        os << "       " << argv[0] << " SCHEMATIC_FILE\n";
+        return BAD_ARGS;
+    }
+
+    os << "Schematic Hierarchy Load Bench Mark Util" << std::endl;
+    os << std::endl;
+
+    // The plugin only uses the KIWAY for the screens it creates
+    KIWAY kiway( NULL, KFCTL_STANDALONE );
+    LOAD_STATS serial;
+    LOAD_STATS parallel;
+
+    try
+    {
+        if( fileName.IsEmpty() )
+        {
+            path = wxFileName::CreateTempFileName( "sch_load_benchmark" );
+
+            wxRemoveFile( path );
+            wxFileName::Mkdir( path );
+
+            int count = generateHierarchy( path, depth, fanOut, nrComponents );
+
+            fileName = path + wxFileName::GetPathSeparator() + "root.sch";
+
+            os << wxString::Format( "%d files, %ld levels below the root, "
+                                    "%ld components per file",
+                                    count, depth, nrComponents ) << std::endl;
+        }
+
+        // Load the schematic once, so both loads find the files in the file system cache.
+        loadSchematic( fileName, kiway, true, serial );
+
+        os << wxString::Format( "%s: %d sheets, %d files, %d items",
+                                fileName, serial.sheets, serial.screens, serial.items )
+           << std::endl;
+
+        int serialTime = loadSchematic( fileName, kiway, true, serial );
+
+        os << wxString::Format( "serial load:   %d ms", serialTime ) << std::endl;
+
+        int parallelTime = loadSchematic( fileName, kiway, false, parallel );
+
+        os << wxString::Format( "parallel load: %d ms (%u threads)", parallelTime,
+                                std::thread::hardware_concurrency() ) << std::endl;
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        os << TO_UTF8( ioe.What() ) << std::endl;
+
+        if( !path.IsEmpty() )
+            wxFileName::Rmdir( path, wxPATH_RMDIR_RECURSIVE );
+
+        return IO_ERROR_CODE;
+    }
+
+    if( !path.IsEmpty() )
+        wxFileName::Rmdir( path, wxPATH_RMDIR_RECURSIVE );
+
+    if( !( serial == parallel ) )
+    {
+        os << "Both loads did not build the same schematic" << std::endl;
+        return MISMATCH;
+    }
+
+    return 0;
+}
@@ -0,0 +1,219 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file  sim_batch_benchmark.cpp
+ * @brief Measures the SIM_BATCH scheduler with the FAKE_SIMULATOR backend, so it
+ * runs without ngspice.
+ *
+ * A parameter sweep and a Monte Carlo analysis are run with an increasing number
+ * of simulators.  Each fake run sleeps for a given time, as a real simulation
+ * would take, and the results of every batch must be the same as the ones of the
+ * batch using a single simulator.  A cancelled batch must stop before its end.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <fake_simulator.h>
+#include <sim_batch.h>
+
+
+using CLOCK = std::chrono::steady_clock;
+using TIME_PT = std::chrono::time_point<CLOCK>;
+
+
+static const char* netlist =
+        "* sim_batch_benchmark\n"
+        "V1 in 0 sin(0 1 1k)\n"
+        "R1 in out 1k\n"
+        "C1 out 0 100n\n"
+        ".save V(in)\n"
+        ".save V(out)\n"
+        ".tran 1u 10m\n"
+        ".end\n";
+
+
+/// Runs a batch, and returns the results sorted by run, or an empty list if one is missing.
+static std::vector<SIM_BATCH_RESULT> runBatch( int aSimulators, int aPoints, int aRunTime,
+        const std::vector<SIM_BATCH_VARIANT>& aVariants, int& aElapsed )
+{
+    std::vector<std::unique_ptr<FAKE_SIMULATOR>> owners;
+    std::vector<SPICE_SIMULATOR*> simulators;
+
+    for( int i = 0; i < aSimulators; ++i )
+    {
+        owners.emplace_back( new FAKE_SIMULATOR( aPoints, aRunTime ) );
+        simulators.push_back( owners.back().get() );
+    }
+
+    const std::vector<SIM_BATCH_PROBE> probes =
+    {
+        { "V(in)", SPT_VOLTAGE }, { "V(out)", SPT_VOLTAGE }, { "@r1[i]", SPT_CURRENT }
+    };
+
+    SIM_BATCH batch( simulators );
+    std::vector<SIM_BATCH_RESULT> results( aVariants.size() );
+    SIM_BATCH_RESULT result;
+    size_t received = 0;
+
+    TIME_PT start = CLOCK::now();
+
+    batch.Start( netlist, ST_TRANSIENT, aVariants, probes );
+
+    // Take the results as they come, as the plot frame does
+    while( received < aVariants.size() )
+    {
+        // Read before taking the results, as the workers queue them before they exit
+        bool running = batch.IsRunning();
+
+        if( batch.GetResult( result ) )
+        {
+            results[result.m_run] = result;
+            ++received;
+        }
+        else if( !running )
+        {
+            break;
+        }
+        else
+        {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+        }
+    }
+
+    batch.Wait();
+
+    aElapsed = (int) std::chrono::duration_cast<std::chrono::milliseconds>(
+            CLOCK::now() - start ).count();
+
+    if( received != aVariants.size() )
+        results.clear();
+
+    return results;
+}
+
+
+static bool sameResults( const std::vector<SIM_BATCH_RESULT>& aFirst,
+        const std::vector<SIM_BATCH_RESULT>& aSecond )
+{
+    if( aFirst.size() != aSecond.size() )
+        return false;
+
+    for( size_t i = 0; i < aFirst.size(); ++i )
+    {
+        if( !aFirst[i].m_success || !aSecond[i].m_success
+                || aFirst[i].m_x != aSecond[i].m_x || aFirst[i].m_y != aSecond[i].m_y )
+            return false;
+    }
+
+    return true;
+}
+
+
+enum RET_CODES
+{
+    BAD_ARGS = 1,
+    MISMATCH,
+    NOT_CANCELLED,
+};
+
+
+int main( int argc, char* argv[] )
+{
+    auto& os = std::cout;
+
+    int runs = 200;
+    int runTime = 5;
+    int points = 2000;
+
+    if( ( argc > 1 && ( runs = atoi( argv[1] ) ) <= 0 )
+        || ( argc > 2 && ( runTime = atoi( argv[2] ) ) < 0 )
+        || ( argc > 3 && ( points = atoi( argv[3] ) ) <= 0 ) )
+    {
+        os << "Usage: " << argv[0] << " [NR_RUNS [RUN_TIME_MS [NR_POINTS]]]\n";
+        return BAD_ARGS;
+    }
+
+    os << "Simulation Batch Bench Mark Util" << std::endl;
+    os << std::endl;
+    os << runs << " runs of " << runTime << " ms, " << points << " points per vector"
+       << std::endl;
+
+    std::vector<double> values;
+
+    for( int i = 0; i < runs; ++i )
+        values.push_back( 100.0 * ( i + 1 ) );
+
+    const std::vector<std::pair<const char*, std::vector<SIM_BATCH_VARIANT>>> analyses =
+    {
+        { "sweep", SIM_BATCH::MakeSweep( "r1", values ) },
+        { "monte carlo", SIM_BATCH::MakeMonteCarlo( { { "r1", 1e3 }, { "c1", 1e-7 } },
+                                                    0.05, runs, 1 ) }
+    };
+
+    unsigned maxSimulators = std::max( 1u, std::thread::hardware_concurrency() );
+
+    for( const auto& analysis : analyses )
+    {
+        std::vector<SIM_BATCH_RESULT> reference;
+        int elapsed;
+
+        for( unsigned count = 1; count <= maxSimulators; count *= 2 )
+        {
+            std::vector<SIM_BATCH_RESULT> results = runBatch( count, points, runTime,
+                                                              analysis.second, elapsed );
+
+            os << analysis.first << ", " << count << " simulator(s): " << elapsed << " ms"
+               << std::endl;
+
+            if( count == 1 )
+                reference = results;
+
+            if( results.empty() || !sameResults( reference, results ) )
+            {
+                os << "The results differ from the ones of a single simulator" << std::endl;
+                return MISMATCH;
+            }
+        }
+    }
+
+    // A stopped batch finishes the running simulations only
+    FAKE_SIMULATOR sim( points, runTime );
+    SIM_BATCH batch( { &sim } );
+
+    batch.Start( netlist, ST_TRANSIENT, analyses[0].second, {} );
+    std::this_thread::sleep_for( std::chrono::milliseconds( runTime * 2 ) );
+    batch.Stop();
+
+    os << "stopped after " << batch.GetFinishedCount() << " of " << runs << " runs" << std::endl;
+
+    if( runs > 4 && batch.GetFinishedCount() == runs )
+        return NOT_CANCELLED;
+
+    return 0;
+}
@@ -0,0 +1,288 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file  vrml_benchmark.cpp
+ * @brief Measures the time needed by the VRML plugin to load a corpus of
+ * 3D models.
+ *
+ * For each VRML file, the parse alone (WRLPROC and the VRML1/VRML2 node
+ * readers) and the complete load (parse and translation to a scene graph)
+ * are timed. X3D files are only loaded.
+ *
+ * The whole corpus is then loaded again by one thread per core, as the 3D
+ * cache does when it preloads the models of a board, to check that the
+ * models are parsed concurrently.
+ */
+
+#include <wx/wx.h>
+#include <wx/dir.h>
+#include <wx/filename.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <clocale>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <richio.h>
+#include <plugins/kicad_plugin.h>
+#include <plugins/3dapi/ifsg_api.h>
+
+#include "wrlproc.h"
+#include "vrml1_base.h"
+#include "vrml2_base.h"
+
+
+using CLOCK = std::chrono::steady_clock;
+using TIME_PT = std::chrono::time_point<CLOCK>;
+
+
+class SCENEGRAPH;
+
+// the entry point of the plugin, see plugins/3d/3d_plugin.h
+KICAD_PLUGIN_EXPORT SCENEGRAPH* Load( char const* aFileName );
+
+
+struct BENCH_REPORT
+{
+    /// Time needed by the parser alone; 0 for the X3D files
+    std::chrono::milliseconds parseDurMs;
+
+    /// Time needed by the plugin Load() function
+    std::chrono::milliseconds loadDurMs;
+
+    bool parsed;
+    bool loaded;
+};
+
+
+/**
+ * Parse a VRML file without translating it to a scene graph; the Inline{}
+ * nodes are not followed.
+ */
+static bool parseVRML( const wxString& aFileName )
+{
+    FILE_LINE_READER modelFile( aFileName, 0, 8388608 );
+    WRLPROC proc( &modelFile );
+
+    if( proc.GetVRMLType() == VRML_V1 )
+    {
+        WRL1BASE bp;
+        return bp.Read( proc );
+    }
+
+    WRL2BASE bp;
+    bp.SetEnableInline( false );
+
+    return bp.Read( proc );
+}
+
+
+static BENCH_REPORT executeBenchMark( const wxString& aFileName )
+{
+    using std::chrono::milliseconds;
+    using std::chrono::duration_cast;
+
+    BENCH_REPORT report = {};
+    wxString ext = wxFileName( aFileName ).GetExt().Lower();
+
+    if( ext != "x3d" )
+    {
+        TIME_PT start = CLOCK::now();
+
+        try
+        {
+            report.parsed = parseVRML( aFileName );
+        }
+        catch( const IO_ERROR& )
+        {
+            report.parsed = false;
+        }
+
+        report.parseDurMs = duration_cast<milliseconds>( CLOCK::now() - start );
+    }
+
+    TIME_PT start = CLOCK::now();
+    SCENEGRAPH* scene = Load( aFileName.ToUTF8() );
+    report.loadDurMs = duration_cast<milliseconds>( CLOCK::now() - start );
+
+    report.loaded = scene != NULL;
+
+    if( scene )
+        S3D::DestroyNode( (SGNODE*) scene );
+
+    return report;
+}
+
+
+/**
+ * Load all the files with \a aThreadCount threads.
+ *
+ * @return the wall clock time needed to load all the files.
+ */
+static std::chrono::milliseconds loadConcurrently( const wxArrayString& aFiles,
+                                                   unsigned aThreadCount )
+{
+    using std::chrono::milliseconds;
+    using std::chrono::duration_cast;
+
+    // the names are converted before the threads start: wxString is not thread safe
+    std::vector<std::string> names;
+
+    for( const wxString& file : aFiles )
+        names.push_back( std::string( file.ToUTF8() ) );
+
+    std::atomic<size_t> next( 0 );
+    std::vector<std::thread> threads;
+
+    // the locale is global: set it once for all the threads, as the 3D cache does
+    std::string oldLocale = setlocale( LC_NUMERIC, NULL );
+    setlocale( LC_NUMERIC, "C" );
+
+    TIME_PT start = CLOCK::now();
+
+    for( unsigned i = 0; i < aThreadCount; ++i )
+    {
+        threads.push_back( std::thread( [&names, &next]() {
+            for( size_t idx = next++; idx < names.size(); idx = next++ )
+            {
+                SCENEGRAPH* scene = Load( names[idx].c_str() );
+
+                if( scene )
+                    S3D::DestroyNode( (SGNODE*) scene );
+            }
+        } ) );
+    }
+
+    for( auto& thr : threads )
+        thr.join();
+
+    milliseconds duration = duration_cast<milliseconds>( CLOCK::now() - start );
+
+    setlocale( LC_NUMERIC, oldLocale.c_str() );
+
+    return duration;
+}
+
+
+enum RET_CODES
+{
+    BAD_ARGS = 1,
+    NO_MODELS = 2,
+};
+
+
+int main( int argc, char* argv[] )
+{
+    auto& os = std::cout;
+
+    if( argc < 2 )
+    {
+        os << "Usage: " << argv[0] << " MODEL_FILE_OR_DIR...\n";
+        return BAD_ARGS;
+    }
+
+    wxArrayString files;
+
+    for( int i = 1; i < argc; ++i )
+    {
+        wxString path = wxString::FromUTF8( argv[i] );
+
+        if( wxDirExists( path ) )
+        {
+            wxDir::GetAllFiles( path, &files, "*.wrl" );
+            wxDir::GetAllFiles( path, &files, "*.x3d" );
+        }
+        else if( wxFileExists( path ) )
+        {
+            files.Add( path );
+        }
+        else
+        {
+            os << "Cannot find " << argv[i] << std::endl;
+            return BAD_ARGS;
+        }
+    }
+
+    if( files.IsEmpty() )
+    {
+        os << "No model found" << std::endl;
+        return NO_MODELS;
+    }
+
+    os << "VRML Bench Mark Util" << std::endl;
+    os << std::endl;
+
+    wxULongLong totalSize = 0;
+    long long totalParseMs = 0;
+    long long totalLoadMs = 0;
+    unsigned failures = 0;
+
+    for( const wxString& file : files )
+    {
+        BENCH_REPORT report = executeBenchMark( file );
+        wxULongLong size = wxFileName::GetSize( file );
+
+        totalSize += size;
+        totalParseMs += report.parseDurMs.count();
+        totalLoadMs += report.loadDurMs.count();
+
+        if( !report.loaded )
+            failures++;
+
+        os << wxString::Format( "%10s bytes: parsed in %6d ms, loaded in %6d ms%s  %s",
+                size.ToString(), (int) report.parseDurMs.count(),
+                (int) report.loadDurMs.count(), report.loaded ? "" : " (failed)",
+                wxFileName( file ).GetFullName() )
+            << std::endl;
+    }
+
+    double megaBytes = totalSize.ToDouble() / ( 1024.0 * 1024.0 );
+
+    os << std::endl;
+    os << wxString::Format( "%u models, %.1f MB: parsed in %lld ms, loaded in %lld ms, "
+                            "%u failures",
+            (unsigned) files.GetCount(), megaBytes, totalParseMs, totalLoadMs, failures )
+        << std::endl;
+
+    if( totalLoadMs > 0 )
+        os << wxString::Format( "load throughput: %.2f MB/s", megaBytes * 1000.0 / totalLoadMs )
+            << std::endl;
+
+    unsigned nThreads = std::max( 1u, std::thread::hardware_concurrency() );
+    long long serialMs = loadConcurrently( files, 1 ).count();
+    long long parallelMs = loadConcurrently( files, nThreads ).count();
+
+    os << wxString::Format( "loaded by 1 thread in %lld ms, by %u threads in %lld ms",
+            serialMs, nThreads, parallelMs )
+        << std::endl;
+
+    if( parallelMs > 0 )
+        os << wxString::Format( "concurrent load speedup: %.2f", (double) serialMs / parallelMs )
+            << std::endl;
+
+    return 0;
+}